@@ -0,0 +1,501 @@
+// Headless throughput benchmark for the LBM solver.
+// Runs every solver backend available on this GPU over a sweep of lattice sizes and
+// simulation configurations, and reports mega lattice updates per second (MLUPS) as JSON,
+// together with the per-pass achieved bandwidth against a measured bandwidth ceiling.
+// Given a baseline written by an earlier run, it also checks the results for performance regressions
+// and exits with status 2 if any configuration or pass became significantly slower.
+// Every lattice starts from a procedural scene, so that the numbers are comparable across builds and machines.
+// Given an input trace recorded in the app, every run replays its inputs step for step in a loop.
+//
+// Usage: lbm_bench [--steps N] [--warmup N] [--runs N] [--min-size N] [--max-size N]
+//                  [--memory-limit MB] [--backend fragment|compute|inplace|all] [--output PATH]
+//                  [--baseline PATH] [--threshold PERCENT] [--significance P] [--replay PATH]
+//                  [--scene blobs|cylinder|cavity|porous|channels|mixing] [--porosity F] [--seed N]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include "core/app_state.h"
+#include "core/headless.h"
+#include "core/input_trace.h"
+#include "core/io.h"
+#include "core/json.h"
+#include "gl/bandwidth_probe.h"
+#include "gl/gl_extensions.h"
+#include "gl/gpu_profiler.h"
+#include "gl/memory_tracker.h"
+#include "lbm/lbm.h"
+#include "regression.h"
+
+struct BenchOptions {
+  unsigned int steps = 200;
+  unsigned int warmupSteps = 20;
+  unsigned int runs = 5;
+  unsigned int minSize = 256;
+  unsigned int maxSize = 0;     // 0: limited by memory and the maximum texture size only
+  unsigned int memoryLimit = 0; // MiB, 0: query the driver or fall back to DEFAULT_MEMORY_LIMIT
+  std::string backend = "all";
+  std::string outputPath;
+  std::string baselinePath;  // Results of an earlier run to check for regressions against
+  double threshold = 5.;     // Percent, slowdowns below this are treated as noise
+  double significance = 0.05; // Level of the one-sided test a slowdown must pass
+  std::string replayPath;    // Input trace replayed before every step
+  SceneType scene = SceneType::Blobs;
+  SceneParameters sceneParameters;
+};
+
+struct Configuration {
+  const char* name;
+  bool areSolutesEnabled;
+  bool isReactionEnabled;
+};
+
+struct PassResult {
+  std::string name;
+  float averageTime;       // ms
+  float achievedBandwidth; // GB/s
+  float achievedFlops;     // GFLOP/s
+  std::vector<float> samples; // ms per profiled step
+};
+
+struct BenchResult {
+  std::string backend;
+  std::string configuration;
+  unsigned int size;
+  std::vector<double> mlups; // One sample per run
+  double bytesPerUpdate;
+  std::vector<PassResult> passes;
+  size_t allocatedBytes; // GPU memory registered with the memory tracker while the lattice existed
+};
+
+static const unsigned int DEFAULT_MEMORY_LIMIT = 2048;
+static const Configuration CONFIGURATIONS[] = {
+  {"fluid", false, false},
+  {"fluid+solutes", true, false},
+  {"fluid+solutes+reaction", true, true},
+};
+
+static unsigned int queryMemoryLimit() {
+  // Report what the driver exposes, otherwise assume a conservative budget
+  MemoryTracker::DeviceMemory memory = MemoryTracker::getInstance().queryDeviceMemory();
+  size_t bytes = memory.totalBytes > 0 ? memory.totalBytes : memory.availableBytes;
+  return bytes > 0 ? static_cast<unsigned int>(bytes / (1024 * 1024)) : DEFAULT_MEMORY_LIMIT;
+}
+
+static double getBytesPerNode(SolverBackend backend) {
+  // Device memory allocated per lattice node, used to stop the size sweep before running out of memory
+  const double texelSize = 4 * sizeof(GLfloat);
+  const double distributionSize = Fluid::DISTRIBUTION_COUNT * sizeof(GLfloat);
+  double bytes = 2 * texelSize + texelSize; // Node IDs (double buffered) and output image
+  if (backend == SolverBackend::FragmentShader) {
+    bytes += 2 * 4 * texelSize;     // Fluid distributions and macroscopic data
+    bytes += 3 * 2 * 3 * texelSize; // Solute distributions and macroscopic data
+    bytes += 4;                     // Wall stencil
+  } else {
+    double copies = (backend == SolverBackend::InPlaceComputeShader) ? 1 : 2;
+    bytes += copies * distributionSize + 2 * texelSize;    // Fluid
+    bytes += 3 * (copies * distributionSize + texelSize);  // Solutes
+  }
+  return bytes;
+}
+
+static double getBytesPerUpdate(const Configuration& configuration) {
+  // Minimum traffic of a lattice update: every distribution is read and written once,
+  // and the macroscopic fields the passes publish are written once
+  const double distributionTraffic = 2 * Fluid::DISTRIBUTION_COUNT * sizeof(GLfloat);
+  double bytes = distributionTraffic + 4 * sizeof(GLfloat); // Fluid velocity, force density and density
+  if (configuration.areSolutesEnabled) {
+    bytes += 3 * (distributionTraffic + 2 * sizeof(GLfloat)); // Solute concentration and source
+  }
+  return bytes;
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--steps" && hasValue) {
+      options.steps = std::max(1, atoi(argv[++i]));
+    } else if (arg == "--warmup" && hasValue) {
+      options.warmupSteps = std::max(0, atoi(argv[++i]));
+    } else if (arg == "--runs" && hasValue) {
+      options.runs = std::max(1, atoi(argv[++i]));
+    } else if (arg == "--min-size" && hasValue) {
+      options.minSize = std::max(16, atoi(argv[++i]));
+    } else if (arg == "--max-size" && hasValue) {
+      options.maxSize = std::max(0, atoi(argv[++i]));
+    } else if (arg == "--memory-limit" && hasValue) {
+      options.memoryLimit = std::max(0, atoi(argv[++i]));
+    } else if (arg == "--backend" && hasValue) {
+      options.backend = argv[++i];
+    } else if (arg == "--output" && hasValue) {
+      options.outputPath = argv[++i];
+    } else if (arg == "--baseline" && hasValue) {
+      options.baselinePath = argv[++i];
+    } else if (arg == "--threshold" && hasValue) {
+      options.threshold = std::max(0., atof(argv[++i]));
+    } else if (arg == "--significance" && hasValue) {
+      options.significance = std::clamp(atof(argv[++i]), 0., 1.);
+    } else if (arg == "--replay" && hasValue) {
+      options.replayPath = argv[++i];
+    } else if (arg == "--scene" && hasValue) {
+      if (!parseSceneName(argv[++i], options.scene)) {
+        std::cerr << "Unknown scene: " << argv[i] << std::endl;
+        return false;
+      }
+    } else if (arg == "--porosity" && hasValue) {
+      options.sceneParameters.porosity = std::clamp(static_cast<float>(atof(argv[++i])), 0.1f, 1.f);
+    } else if (arg == "--seed" && hasValue) {
+      options.sceneParameters.seed = static_cast<unsigned int>(std::max(0, atoi(argv[++i])));
+    } else {
+      std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+static double measureRun(LBM& lbm, unsigned int steps, unsigned int size) {
+  // Drain the queue before and after so that the wall clock covers exactly the GPU work of the run
+  glFinish();
+  auto start = std::chrono::steady_clock::now();
+  InputTrace& inputTrace = InputTrace::getInstance();
+  for (unsigned int i = 0; i < steps; i++) {
+    inputTrace.update(lbm);
+    lbm.updateSimulation();
+  }
+  glFinish();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(size) * size * steps / seconds * 1e-6;
+}
+
+static std::vector<PassResult> profilePasses(LBM& lbm, unsigned int steps) {
+  // Time each step as one profiler frame, then submit empty frames until the last one has been collected
+  GPUProfiler& profiler = GPUProfiler::getInstance();
+  profiler.resetStatistics();
+  for (unsigned int i = 0; i < std::min<unsigned int>(steps, GPUProfiler::HISTORY_SIZE); i++) {
+    profiler.beginFrame();
+    InputTrace::getInstance().update(lbm);
+    lbm.updateSimulation();
+    profiler.endFrame();
+  }
+  glFinish();
+  for (int i = 0; i < 2; i++) {
+    profiler.beginFrame();
+    profiler.endFrame();
+  }
+
+  // Support for timer queries is only known once the first frame has begun
+  std::vector<PassResult> passes;
+  if (!profiler.isSupported()) {
+    return passes;
+  }
+  for (const auto& pass : profiler.getPassTimings()) {
+    if (!profiler.hasPassCost(pass)) {
+      continue;
+    }
+    passes.push_back({pass.name, profiler.getAveragePassTime(pass), profiler.getAchievedBandwidth(pass), profiler.getAchievedFlops(pass),
+                      profiler.getPassTimeSamples(pass)});
+  }
+  return passes;
+}
+
+static void writeJSON(std::ostream& out, const BenchOptions& options, const std::vector<BenchResult>& results) {
+  float peakBandwidth = GPUProfiler::getInstance().getPeakBandwidth();
+  out << "{\n";
+  out << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n";
+  out << "  \"glVersion\": \"" << glGetString(GL_VERSION) << "\",\n";
+  out << "  \"probeBandwidthGBs\": " << peakBandwidth << ",\n";
+  out << "  \"steps\": " << options.steps << ",\n";
+  out << "  \"warmupSteps\": " << options.warmupSteps << ",\n";
+  out << "  \"runs\": " << options.runs << ",\n";
+  out << "  \"scene\": \"" << getSceneName(options.scene) << "\",\n";
+  if (!options.replayPath.empty()) {
+    out << "  \"replay\": \"" << options.replayPath << "\",\n";
+  }
+  out << "  \"results\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult& result = results[i];
+    const auto& samples = result.mlups;
+    double mean = 0.;
+    for (double sample : samples) {
+      mean += sample;
+    }
+    mean /= samples.size();
+    double variance = 0.;
+    for (double sample : samples) {
+      variance += (sample - mean) * (sample - mean);
+    }
+    variance = samples.size() > 1 ? variance / (samples.size() - 1) : 0.;
+    double stddev = std::sqrt(variance);
+
+    out << (i > 0 ? "," : "") << "\n    {\n";
+    out << "      \"backend\": \"" << result.backend << "\",\n";
+    out << "      \"configuration\": \"" << result.configuration << "\",\n";
+    out << "      \"width\": " << result.size << ",\n";
+    out << "      \"height\": " << result.size << ",\n";
+    out << "      \"mlups\": {\"mean\": " << mean << ", \"stddev\": " << stddev << ", \"variance\": " << variance
+        << ", \"min\": " << *std::min_element(samples.begin(), samples.end())
+        << ", \"max\": " << *std::max_element(samples.begin(), samples.end()) << ", \"samples\": [";
+    for (size_t j = 0; j < samples.size(); j++) {
+      out << (j > 0 ? ", " : "") << samples[j];
+    }
+    out << "]},\n";
+    out << "      \"bytesPerUpdate\": " << result.bytesPerUpdate << ",\n";
+    out << "      \"allocatedBytes\": " << result.allocatedBytes << ",\n";
+    out << "      \"effectiveBandwidthGBs\": " << mean * result.bytesPerUpdate * 1e-3 << ",\n";
+    out << "      \"passes\": [";
+    for (size_t j = 0; j < result.passes.size(); j++) {
+      const PassResult& pass = result.passes[j];
+      out << (j > 0 ? "," : "") << "\n        {\"name\": \"" << pass.name << "\", \"averageMs\": " << pass.averageTime
+          << ", \"achievedBandwidthGBs\": " << pass.achievedBandwidth << ", \"achievedGFLOPs\": " << pass.achievedFlops
+          << ", \"fractionOfProbe\": " << (peakBandwidth > 0.f ? pass.achievedBandwidth / peakBandwidth : 0.f) << ", \"samples\": [";
+      for (size_t k = 0; k < pass.samples.size(); k++) {
+        out << (k > 0 ? ", " : "") << pass.samples[k];
+      }
+      out << "]}";
+    }
+    out << (result.passes.empty() ? "]\n" : "\n      ]\n");
+    out << "    }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+static std::vector<double> getSamples(const JsonValue* samples) {
+  std::vector<double> values;
+  if (samples != nullptr) {
+    for (const JsonValue& sample : samples->array) {
+      if (sample.isNumber()) {
+        values.push_back(sample.number);
+      }
+    }
+  }
+  return values;
+}
+
+static const JsonValue* findBaselineResult(const JsonValue& baseline, const BenchResult& result) {
+  const JsonValue* results = baseline.find("results");
+  if (results == nullptr) {
+    return nullptr;
+  }
+  for (const JsonValue& entry : results->array) {
+    if (entry.getString("backend", "") == result.backend && entry.getString("configuration", "") == result.configuration &&
+        entry.getNumber("width", 0.) == result.size) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+static const JsonValue* findBaselinePass(const JsonValue* passes, const std::string& name) {
+  if (passes == nullptr) {
+    return nullptr;
+  }
+  for (const JsonValue& pass : passes->array) {
+    if (pass.getString("name", "") == name) {
+      return &pass;
+    }
+  }
+  return nullptr;
+}
+
+static void printComparison(const std::string& label, const Comparison& comparison, const char* unit) {
+  char pValue[16] = "n/a";
+  if (comparison.hasSignificanceTest) {
+    snprintf(pValue, sizeof(pValue), "%.4f", comparison.pValue);
+  }
+  char line[256];
+  snprintf(line, sizeof(line), "%-52s %10.3f -> %10.3f %-6s %+7.1f%%  p=%-7s %s", label.c_str(), comparison.baselineMean,
+           comparison.currentMean, unit, 100. * comparison.relativeChange, pValue, comparison.isRegression ? "REGRESSION" : "ok");
+  std::cerr << line << std::endl;
+}
+
+static bool hasRegressions(const BenchOptions& options, const JsonValue& baseline, const std::vector<BenchResult>& results) {
+  // Compare every configuration's MLUPS and every pass's GPU time, slower means lower MLUPS or longer passes
+  std::string renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+  if (baseline.getString("renderer", renderer) != renderer) {
+    std::cerr << "Warning: the baseline was recorded on " << baseline.getString("renderer", "") << std::endl;
+  }
+  std::string scene = getSceneName(options.scene);
+  if (baseline.getString("scene", scene) != scene) {
+    std::cerr << "Warning: the baseline was recorded with the " << baseline.getString("scene", "") << " scene" << std::endl;
+  }
+  std::cerr << "Comparing against " << options.baselinePath << " (threshold " << options.threshold
+            << "%, significance " << options.significance << ")" << std::endl;
+
+  double threshold = options.threshold * 0.01;
+  unsigned int regressionCount = 0;
+  for (const BenchResult& result : results) {
+    std::string label = result.backend + " " + std::to_string(result.size) + "^2 " + result.configuration;
+    const JsonValue* entry = findBaselineResult(baseline, result);
+    if (entry == nullptr) {
+      std::cerr << label << ": not in the baseline" << std::endl;
+      continue;
+    }
+    const JsonValue* mlups = entry->find("mlups");
+    Comparison comparison = compareSamples(getSamples(mlups ? mlups->find("samples") : nullptr), result.mlups, true, threshold,
+                                           options.significance);
+    printComparison(label, comparison, "MLUPS");
+    regressionCount += comparison.isRegression ? 1 : 0;
+
+    const JsonValue* passes = entry->find("passes");
+    for (const PassResult& pass : result.passes) {
+      const JsonValue* baselinePass = findBaselinePass(passes, pass.name);
+      if (baselinePass == nullptr) {
+        continue;
+      }
+      std::vector<double> samples(pass.samples.begin(), pass.samples.end());
+      comparison = compareSamples(getSamples(baselinePass->find("samples")), samples, false, threshold, options.significance);
+      printComparison("  " + pass.name, comparison, "ms");
+      regressionCount += comparison.isRegression ? 1 : 0;
+    }
+  }
+  std::cerr << regressionCount << " regression(s) found" << std::endl;
+  return regressionCount > 0;
+}
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    return 1;
+  }
+
+  // Load the baseline up front so that a bad path fails before the sweep
+  JsonValue baseline;
+  if (!options.baselinePath.empty()) {
+    std::string error;
+    if (!readJSONFile(options.baselinePath, baseline, error)) {
+      std::cerr << "Failed to read baseline: " << error << std::endl;
+      return 1;
+    }
+  }
+  if (!options.replayPath.empty()) {
+    if (!InputTrace::getInstance().startReplay(options.replayPath)) {
+      return 1;
+    }
+    std::cerr << "Replaying " << InputTrace::getInstance().getStepCount() << " steps from " << options.replayPath << std::endl;
+    InputTrace::getInstance().stop();
+  }
+
+  GLFWwindow* window = createHeadlessContext("lbm_bench");
+  if (window == nullptr) {
+    std::cerr << "Failed to create an OpenGL context" << std::endl;
+    return 1;
+  }
+  std::cerr << "GPU: " << glGetString(GL_RENDERER) << std::endl;
+  std::cerr << "Active OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+
+  // Measure the bandwidth ceiling that the per-pass results are compared against
+  GPUProfiler::getInstance().setPeakBandwidth(measureMemoryBandwidth(getExecutablePath().parent_path() / "shaders"));
+  std::cerr << "Memory bandwidth probe: " << GPUProfiler::getInstance().getPeakBandwidth() << " GB/s" << std::endl;
+
+  // Select the backends to sweep
+  std::vector<SolverBackend> backends;
+  for (SolverBackend backend : {SolverBackend::FragmentShader, SolverBackend::ComputeShader, SolverBackend::InPlaceComputeShader}) {
+    if (options.backend != "all" && options.backend != getBackendName(backend)) {
+      continue;
+    }
+    if (backend != SolverBackend::FragmentShader && !hasGLVersion(4, 3)) {
+      std::cerr << "Skipping " << getBackendName(backend) << " backend, it requires OpenGL 4.3" << std::endl;
+      continue;
+    }
+    backends.push_back(backend);
+  }
+
+  // Bound the sweep by memory and the maximum texture and storage block sizes
+  GLint maxTextureSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  GLint64 maxStorageBlockSize = 0;
+  if (hasGLVersion(4, 3)) {
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxStorageBlockSize);
+  }
+  double memoryLimit = (options.memoryLimit > 0 ? options.memoryLimit : queryMemoryLimit()) * 1024. * 1024.;
+  unsigned int maxSize = options.maxSize > 0 ? std::min<unsigned int>(options.maxSize, maxTextureSize) : maxTextureSize;
+
+  AppState& appState = AppState::getInstance();
+  appState.scene = options.scene;
+  appState.scenePorosity = options.sceneParameters.porosity;
+  appState.sceneSeed = options.sceneParameters.seed;
+  std::vector<BenchResult> results;
+  for (SolverBackend backend : backends) {
+    appState.solverBackend = backend;
+    for (unsigned int size = options.minSize; size <= maxSize; size *= 2) {
+      double nodeCount = static_cast<double>(size) * size;
+      if (nodeCount * getBytesPerNode(backend) > memoryLimit) {
+        std::cerr << "Stopping " << getBackendName(backend) << " sweep at " << size << "^2, it exceeds the memory limit" << std::endl;
+        break;
+      }
+      if (backend != SolverBackend::FragmentShader && nodeCount * Fluid::DISTRIBUTION_COUNT * sizeof(GLfloat) > maxStorageBlockSize) {
+        std::cerr << "Stopping " << getBackendName(backend) << " sweep at " << size << "^2, it exceeds the maximum storage block size" << std::endl;
+        break;
+      }
+
+      bool isOutOfMemory = false;
+      for (const Configuration& configuration : CONFIGURATIONS) {
+        appState.reset();
+        appState.isReactionEnabled = configuration.isReactionEnabled;
+        LBM lbm(size, size);
+        lbm.setSolutesEnabled(configuration.areSolutesEnabled);
+        loadScene(lbm);
+        if (!options.replayPath.empty()) {
+          // Every configuration replays the trace from its first step, cursor inputs are relative to the lattice
+          InputTrace::getInstance().startReplay(options.replayPath, true);
+        }
+        if (glGetError() == GL_OUT_OF_MEMORY) {
+          isOutOfMemory = true;
+          break;
+        }
+
+        BenchResult result{getBackendName(backend), configuration.name, size, {}, getBytesPerUpdate(configuration), {},
+                           MemoryTracker::getInstance().getDeviceBytes()};
+        if (options.warmupSteps > 0) {
+          measureRun(lbm, options.warmupSteps, size);
+        }
+        for (unsigned int run = 0; run < options.runs; run++) {
+          result.mlups.push_back(measureRun(lbm, options.steps, size));
+        }
+        result.passes = profilePasses(lbm, options.steps);
+        InputTrace::getInstance().stop();
+        if (glGetError() == GL_OUT_OF_MEMORY) {
+          isOutOfMemory = true;
+          break;
+        }
+        std::cerr << result.backend << " " << size << "^2 " << result.configuration << ": " << result.mlups.back() << " MLUPS" << std::endl;
+        results.push_back(std::move(result));
+      }
+      if (isOutOfMemory) {
+        std::cerr << "Stopping " << getBackendName(backend) << " sweep at " << size << "^2, the GPU ran out of memory" << std::endl;
+        break;
+      }
+    }
+  }
+
+  // Report results on stdout or into the requested file
+  if (options.outputPath.empty()) {
+    writeJSON(std::cout, options, results);
+  } else {
+    std::ofstream file(options.outputPath);
+    if (!file.is_open()) {
+      std::cerr << "Failed to open output file: " << options.outputPath << std::endl;
+      return 1;
+    }
+    writeJSON(file, options, results);
+  }
+  bool isRegressed = !options.baselinePath.empty() && hasRegressions(options, baseline, results);
+
+  GPUProfiler::getInstance().releaseQueries();
+  destroyHeadlessContext(window);
+  return isRegressed ? 2 : 0;
+}
@@ -0,0 +1,107 @@
+#include "regression.h"
+
+#include <cmath>
+
+namespace {
+
+void getMeanAndVariance(const std::vector<double>& samples, double& mean, double& variance) {
+  mean = 0.;
+  for (double sample : samples) {
+    mean += sample;
+  }
+  mean /= samples.size();
+  variance = 0.;
+  for (double sample : samples) {
+    variance += (sample - mean) * (sample - mean);
+  }
+  variance = samples.size() > 1 ? variance / (samples.size() - 1) : 0.;
+}
+
+double getBetaContinuedFraction(double a, double b, double x) {
+  // Lentz's method for the continued fraction of the incomplete beta function
+  const int MAX_ITERATIONS = 200;
+  const double EPSILON = 1e-12;
+  const double TINY = 1e-300;
+  double c = 1.;
+  double d = 1. - (a + b) * x / (a + 1.);
+  d = 1. / (std::fabs(d) < TINY ? TINY : d);
+  double fraction = d;
+  for (int m = 1; m <= MAX_ITERATIONS; m++) {
+    // Even step
+    double numerator = m * (b - m) * x / ((a + 2. * m - 1.) * (a + 2. * m));
+    d = 1. + numerator * d;
+    d = 1. / (std::fabs(d) < TINY ? TINY : d);
+    c = 1. + numerator / c;
+    c = std::fabs(c) < TINY ? TINY : c;
+    fraction *= d * c;
+
+    // Odd step
+    numerator = -(a + m) * (a + b + m) * x / ((a + 2. * m) * (a + 2. * m + 1.));
+    d = 1. + numerator * d;
+    d = 1. / (std::fabs(d) < TINY ? TINY : d);
+    c = 1. + numerator / c;
+    c = std::fabs(c) < TINY ? TINY : c;
+    double delta = d * c;
+    fraction *= delta;
+    if (std::fabs(delta - 1.) < EPSILON) {
+      break;
+    }
+  }
+  return fraction;
+}
+
+double getRegularizedIncompleteBeta(double a, double b, double x) {
+  if (x <= 0.) {
+    return 0.;
+  }
+  if (x >= 1.) {
+    return 1.;
+  }
+  double logFront = std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1. - x);
+  // The continued fraction converges quickly below the mean of the distribution, use the symmetry otherwise
+  if (x < (a + 1.) / (a + b + 2.)) {
+    return std::exp(logFront) * getBetaContinuedFraction(a, b, x) / a;
+  }
+  return 1. - std::exp(logFront) * getBetaContinuedFraction(b, a, 1. - x) / b;
+}
+
+} // namespace
+
+double getStudentTUpperTail(double t, double degreesOfFreedom) {
+  double tail = 0.5 * getRegularizedIncompleteBeta(0.5 * degreesOfFreedom, 0.5, degreesOfFreedom / (degreesOfFreedom + t * t));
+  return t > 0. ? tail : 1. - tail;
+}
+
+Comparison compareSamples(const std::vector<double>& baseline, const std::vector<double>& current, bool isHigherBetter,
+                          double threshold, double significance) {
+  Comparison comparison;
+  if (baseline.empty() || current.empty()) {
+    return comparison;
+  }
+  double baselineVariance, currentVariance;
+  getMeanAndVariance(baseline, comparison.baselineMean, baselineVariance);
+  getMeanAndVariance(current, comparison.currentMean, currentVariance);
+  if (comparison.baselineMean == 0.) {
+    return comparison;
+  }
+
+  // Express the change so that positive values always mean slower
+  double change = (comparison.currentMean - comparison.baselineMean) / comparison.baselineMean;
+  comparison.relativeChange = isHigherBetter ? -change : change;
+
+  // Welch's t-test with the Welch-Satterthwaite degrees of freedom
+  double baselineError = baselineVariance / baseline.size();
+  double currentError = currentVariance / current.size();
+  double standardError = std::sqrt(baselineError + currentError);
+  if (baseline.size() > 1 && current.size() > 1 && standardError > 0.) {
+    double t = (comparison.currentMean - comparison.baselineMean) / standardError;
+    double degreesOfFreedom = (baselineError + currentError) * (baselineError + currentError) /
+                              (baselineError * baselineError / (baseline.size() - 1) + currentError * currentError / (current.size() - 1));
+    comparison.pValue = getStudentTUpperTail(isHigherBetter ? -t : t, degreesOfFreedom);
+    comparison.hasSignificanceTest = true;
+  }
+
+  bool isBeyondNoise = comparison.relativeChange > threshold;
+  comparison.isRegression = isBeyondNoise && (!comparison.hasSignificanceTest || comparison.pValue < significance);
+  return comparison;
+}
@@ -0,0 +1,26 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include <vector>
+
+// Outcome of comparing a metric's samples from the current build against a baseline
+struct Comparison {
+  double baselineMean = 0.;
+  double currentMean = 0.;
+  double relativeChange = 0.;       // Signed change of the mean relative to the baseline, positive is slower
+  double pValue = 1.;               // One-sided p-value of the slowdown, 1 if it could not be tested
+  bool hasSignificanceTest = false; // Both sample sets had enough spread and size for a t-test
+  bool isRegression = false;
+};
+
+// Compares two sets of repeated measurements with a one-sided Welch's t-test.
+// A regression requires the mean to be worse than the baseline by more than the noise threshold (a fraction)
+// and, if the test applies, the slowdown to be significant at the given level. Without enough samples
+// for the test the threshold alone decides.
+Comparison compareSamples(const std::vector<double>& baseline, const std::vector<double>& current, bool isHigherBetter,
+                          double threshold, double significance);
+
+// Probability that Student's t-distribution with the given degrees of freedom exceeds t
+double getStudentTUpperTail(double t, double degreesOfFreedom);
+
+#endif // REGRESSION_H
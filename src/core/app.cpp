@@ -2,37 +2,53 @@
 
 #include <algorithm>
 #include <cstdlib>
+#if !defined(_WIN32)
+  #include <csignal>
+#endif
 #include <memory>
 #include <string>
 #include "imgui_internal.h"
 #include "imgui_toggle.h"
 #include "imgui_toggle_presets.h"
 
+#include "core/headless.h"
 #include "core/io.h"
 
 static void glfw_error_callback(int error, const char* description) {
   fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
-App::App() {
+App::App(const RunConfig& config) : config(config) {
+#if !defined(_WIN32)
+  // A capture encoder that exits early must fail the write to its pipe instead of killing the app
+  std::signal(SIGPIPE, SIG_IGN);
+#endif
+
   // Set up app window
   glfwSetErrorCallback(glfw_error_callback);
   if (!glfwInit())
     exit(1);
 
-  // Request GL 3.3 + GLSL 330
+  // Request GL 4.3 for the compute backend, the UI itself only needs GLSL 330
   const char* glsl_version = "#version 330";
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);  // 3.2+ only
 #if defined(__APPLE__)
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);  // Required on Mac
 #endif
-  printf("Requested OpenGL version: 3.3\n");
+  printf("Requested OpenGL version: 4.3\n");
   printf("Requested GLSL version: 330\n");
 
   // Create window with graphics context
   this->window = glfwCreateWindow(1280, 900, "Lattice Boltzmann Simulator", nullptr, nullptr);
+  if (this->window == nullptr) {
+    // Fall back to GL 3.3 for the fragment shader backend
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    printf("Requested OpenGL version: 3.3\n");
+    this->window = glfwCreateWindow(1280, 900, "Lattice Boltzmann Simulator", nullptr, nullptr);
+  }
   if (this->window == nullptr)
     exit(1);
   glfwMakeContextCurrent(this->window);
@@ -46,6 +62,7 @@ App::App() {
     std::cout << "Failed to initialize GLAD" << std::endl;
     exit(1);
   }
+  loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
   // Log active GPU and OpenGL version
   printf("GPU: %s\n", glGetString(GL_RENDERER));
@@ -54,6 +71,19 @@ App::App() {
   // Check all required features are supported
   checkFeatureSupport();
 
+  // Measure the attainable memory bandwidth, which the Performance window uses as the roofline ceiling
+  float peakBandwidth = measureMemoryBandwidth(getExecutablePath().parent_path() / "shaders");
+  GPUProfiler::getInstance().setPeakBandwidth(peakBandwidth);
+  printf("Memory bandwidth probe: %.1f GB/s\n", peakBandwidth);
+
+  // Select the configured solver backend, or the fastest one this context supports
+  std::string error;
+  if (!selectBackend(config, error)) {
+    std::cerr << error << std::endl;
+    exit(1);
+  }
+  printf("Solver backend: %s\n", getBackendName(AppState::getInstance().solverBackend));
+
   // Set up viewport
   int bufferWidth, bufferHeight;
   glfwGetFramebufferSize(this->window, &bufferWidth, &bufferHeight);
@@ -76,7 +106,27 @@ App::App() {
 }
 
 App::~App() {
+  // Write out the trace of this session if one is being recorded
+  Tracer& tracer = Tracer::getInstance();
+  if (tracer.isEnabled()) {
+    tracer.setEnabled(false);
+    if (tracer.exportTrace(TRACE_FILE_NAME)) {
+      printf("Trace written to %s\n", TRACE_FILE_NAME);
+    }
+  }
+
+  // Stop steering before the simulation goes away
+  steeringServer.reset();
+
+  // Write the auto-checkpoints, field snapshots and captured frames still being read back while the context is current
+  windows.clear();
+  autoCheckpoint.reset();
+  fieldWriter.reset();
+  fieldPublisher.reset();
+  frameCapture.reset();
+
   // Cleanup
+  GPUProfiler::getInstance().releaseQueries();
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
@@ -91,35 +141,80 @@ void App::run() {
   init();
 
   // Main loop
+  GPUProfiler& profiler = GPUProfiler::getInstance();
+  FrameStats& frameStats = FrameStats::getInstance();
   while(!glfwWindowShouldClose(this->window)) {
-    // Poll and handle events (inputs, window resize, etc.)
-    glfwPollEvents();
+    profiler.beginFrame();
+    frameStats.beginFrame(profiler.getFrameIndex());
 
-    // Start the Dear ImGui frame
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    // GPU times of earlier frames become available once their queries have been collected
+    GPUProfiler::CollectedFrame collectedFrame;
+    if (profiler.takeCollectedFrame(collectedFrame)) {
+      frameStats.setGPUTime(collectedFrame.frameIndex, collectedFrame.gpuTime, collectedFrame.slowestPass, collectedFrame.slowestPassExcess);
+    }
 
-    // Update GUI and process user input
-    updateUI();
+    // Poll and handle events (inputs, window resize, etc.)
+    {
+      Tracer::Scope scope("Poll events");
+      glfwPollEvents();
+    }
+
+    // Start the Dear ImGui frame, then update GUI and process user input
+    {
+      Tracer::Scope scope("UI");
+      ImGui_ImplOpenGL3_NewFrame();
+      ImGui_ImplGlfw_NewFrame();
+      ImGui::NewFrame();
+      updateUI();
+    }
 
     // Update LBM simulation
     if (isInitialised) {
+      Tracer::Scope scope("Simulate");
+      InputTrace& inputTrace = InputTrace::getInstance();
       for (int i = 0; i < AppState::getInstance().stepsPerFrame; i++) {
+        steeringServer->update(*lbm);
+        inputTrace.update(*lbm);
         lbm->updateSimulation();
+        fieldWriter->update();
+        fieldPublisher->update();
       }
       lbm->updateAnimationPhase();
+      frameStats.setStepCount(AppState::getInstance().stepsPerFrame);
+    }
+
+    // Take the periodic tiled checkpoints, their readback and writing complete in later frames
+    if (isInitialised) {
+      Tracer::Scope scope("Auto-checkpoint");
+      autoCheckpoint->update();
+    }
+
+    // Capture the output image of this frame, it is encoded and written in later frames
+    if (isInitialised) {
+      Tracer::Scope scope("Frame capture");
+      frameCapture->update();
     }
 
     // Render GUI + viewport
-    ImGui::Render();
-    int display_w, display_h;
-    glfwGetFramebufferSize(this->window, &display_w, &display_h);
-    glViewport(0, 0, display_w, display_h);
-    glClearColor(this->clearColor.x, this->clearColor.y, this->clearColor.z, this->clearColor.w);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-    glfwSwapBuffers(this->window);
+    {
+      Tracer::Scope scope("Render");
+      ImGui::Render();
+      int display_w, display_h;
+      glfwGetFramebufferSize(this->window, &display_w, &display_h);
+      glViewport(0, 0, display_w, display_h);
+      glClearColor(this->clearColor.x, this->clearColor.y, this->clearColor.z, this->clearColor.w);
+      glClear(GL_COLOR_BUFFER_BIT);
+      profiler.beginPass("ImGui", false);
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+      profiler.endPass();
+    }
+    profiler.endFrame();
+    {
+      Tracer::Scope scope("Swap buffers");
+      frameStats.beginSwap();
+      glfwSwapBuffers(this->window);
+      frameStats.endSwap();
+    }
 
     // Render one GUI frame before initialisation is complete
     if (!isInitialised) {
@@ -133,14 +228,32 @@ void App::init() {
   this->clearColor = ImVec4(0.95f, 0.95f, 0.95f, 1.00f);
 
   // Set up LBM simulation
-  lbm = std::make_shared<LBM>(SIMULATION_WIDTH, SIMULATION_HEIGHT);
+  const glm::ivec2 latticeSize = AppState::getInstance().latticeSize;
+  lbm = std::make_shared<LBM>(latticeSize.x, latticeSize.y);
+  autoCheckpoint = std::make_shared<AutoCheckpoint>(lbm);
+  fieldWriter = std::make_shared<FieldWriter>(lbm);
+  fieldPublisher = std::make_shared<FieldPublisher>(lbm);
+  frameCapture = std::make_shared<FrameCapture>(lbm);
+  steeringServer = std::make_shared<SteeringServer>();
+
+  // Load the configured scene and start the configured outputs, which can be restarted from the UI on failure
+  std::string error;
+  if (!startRun(config, *lbm, *fieldWriter, *fieldPublisher, *frameCapture, error)) {
+    std::cerr << error << std::endl;
+  }
+  if (!config.steeringSocket.empty() && !steeringServer->start(config.steeringSocket, error)) {
+    std::cerr << error << std::endl;
+  }
 
   // Set up windows
-  windows.reserve(7);
+  windows.reserve(10);
   windows.push_back(std::make_shared<ToolbarWindow>(lbm));
   windows.push_back(std::make_shared<ViewportWindow>(lbm, window));
-  windows.push_back(std::make_shared<FluidSettingsWindow>(lbm));
+  windows.push_back(std::make_shared<FluidSettingsWindow>(lbm, autoCheckpoint, fieldWriter, fieldPublisher));
   windows.push_back(std::make_shared<ReactionSettingsWindow>(lbm));
+  windows.push_back(std::make_shared<PerformanceWindow>(lbm, frameCapture));
+  windows.push_back(std::make_shared<FramePacingWindow>());
+  windows.push_back(std::make_shared<MemoryWindow>(lbm));
   windows.push_back(std::make_shared<SoluteSettingsWindow>(lbm, 0));
   windows.push_back(std::make_shared<SoluteSettingsWindow>(lbm, 1));
   windows.push_back(std::make_shared<SoluteSettingsWindow>(lbm, 2));
@@ -188,6 +301,9 @@ void App::updateUI() {
     ImGui::DockBuilderDockWindow("Viewport", dock_id_left);
     ImGui::DockBuilderDockWindow("Fluid Settings", dock_id_right_top);
     ImGui::DockBuilderDockWindow("Reaction Settings", dock_id_right_top);
+    ImGui::DockBuilderDockWindow("Performance", dock_id_right_top);
+    ImGui::DockBuilderDockWindow("Frame Pacing", dock_id_right_top);
+    ImGui::DockBuilderDockWindow("Memory", dock_id_right_top);
 
 
     // For Solute settings, we dock multiple windows to the same ID to create tabs
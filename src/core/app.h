@@ -11,29 +11,50 @@
 #include <iostream>
 #define GL_SILENCE_DEPRECATION
 // #include <GLFW/glfw3.h> // Will drag system OpenGL headers
+#include "lbm/auto_checkpoint.h"
+#include "lbm/field_publisher.h"
+#include "lbm/field_writer.h"
 #include "lbm/lbm.h"
 #include "core/app_state.h"
+#include "core/frame_capture.h"
+#include "core/frame_stats.h"
+#include "core/input_trace.h"
+#include "core/run_config.h"
+#include "core/steering_server.h"
+#include "core/tracer.h"
+#include "gl/bandwidth_probe.h"
+#include "gl/gl_extensions.h"
+#include "gl/gpu_profiler.h"
 #include "ui/toolbar_window.h"
 #include "ui/viewport_window.h"
 #include "ui/fluid_settings_window.h"
+#include "ui/frame_pacing_window.h"
+#include "ui/memory_window.h"
 #include "ui/reaction_settings_window.h"
+#include "ui/performance_window.h"
 #include "ui/solute_settings_window.h"
 
 class App {
 public:
   using WindowList = std::vector<std::shared_ptr<Window>>;
 
-  App();
+  App(const RunConfig& config);
   ~App();
 
   void run();
 
 private:
+  RunConfig config;
   GLFWwindow* window;
   ImGuiIO* io;
   ImVec4 clearColor;
   bool isInitialised = false;
   std::shared_ptr<LBM> lbm;
+  std::shared_ptr<AutoCheckpoint> autoCheckpoint;
+  std::shared_ptr<FieldWriter> fieldWriter;
+  std::shared_ptr<FieldPublisher> fieldPublisher;
+  std::shared_ptr<FrameCapture> frameCapture;
+  std::shared_ptr<SteeringServer> steeringServer;
 
   // UI elements
   WindowList windows;
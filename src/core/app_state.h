@@ -1,13 +1,16 @@
 #ifndef APP_STATE_H
 #define APP_STATE_H
 
+#include <cstdint>
 #include <vector>
+#include <glad/glad.h>
 #include "glm.hpp"
 #include "imgui.h"
 
-// Simulation constants
+// Simulation constants, the lattice size and initial parameters can be overridden by a run configuration
 const GLint SIMULATION_WIDTH = 256;
 const GLint SIMULATION_HEIGHT = 256;
+const unsigned int INIT_STEPS_PER_FRAME = 1;
 const GLfloat SPEED_OF_SOUND = 0.3;
 
 const GLfloat INIT_FLUID_DENSITY = 1.0;
@@ -21,17 +24,27 @@ const GLfloat INIT_SOLUTE_DIFFUSIVITY_2 = 0.02;
 const glm::vec3 INIT_SOLUTE_COLOR_0 = {1., 0.78, 0.};
 const glm::vec3 INIT_SOLUTE_COLOR_1 = {0.39, 0., 1.};
 const glm::vec3 INIT_SOLUTE_COLOR_2 = {0.39, 1., 0.78};
-const glm::vec2 INIT_SOLUTE_CENTER_0 = {0.4, 0.4};
-const glm::vec2 INIT_SOLUTE_CENTER_1 = {0.5, 0.6};
-const glm::vec2 INIT_SOLUTE_CENTER_2 = {0.6, 0.4};
-const GLfloat INIT_SOLUTE_RADIUS_0 = 0.2;
-const GLfloat INIT_SOLUTE_RADIUS_1 = 0.2;
-const GLfloat INIT_SOLUTE_RADIUS_2 = 0.2;
 
 const std::vector<GLfloat> REACTION_MOLAR_MASSES = {1, 1, 1};
 const std::vector<GLint> REACTION_STOICHIOMETRIC_COEFFS = {-1, -1, 1};
 const GLfloat INIT_REACTION_RATE = 0.01;
 
+const GLfloat INIT_SCENE_POROSITY = 0.6;
+const GLfloat INIT_SCENE_FEATURE_SIZE = 0.1;
+const GLfloat INIT_SCENE_FLOW_SPEED = 0.05;
+const unsigned int INIT_SCENE_SEED = 1;
+
+// Disc of solute in the blobs scene
+struct SoluteBlob {
+  unsigned int soluteID;
+  glm::vec2 center;       // In UV coordinates
+  GLfloat radius;         // In UV coordinates
+  GLfloat concentration;
+};
+const std::vector<SoluteBlob> INIT_SCENE_BLOBS = {{0, {0.4f, 0.4f}, 0.2f, 1.f},
+                                                  {1, {0.5f, 0.6f}, 0.2f, 1.f},
+                                                  {2, {0.6f, 0.4f}, 0.2f, 1.f}};
+
 // GUI and interaction constants
 const unsigned int MIN_APP_WIDTH = 800;
 const unsigned int MIN_APP_HEIGHT = 400;
@@ -42,6 +55,37 @@ const unsigned int TOOL_SIZE_SLIDER_WIDTH = 130;
 const GLfloat CURSOR_FORCE_MULTIPLIER = 6.f;
 const GLfloat TOOL_SIZE_MULTIPLIER = 0.5f;
 
+// Diagnostics constants
+const char* const TRACE_FILE_NAME = "lbm_trace.json";
+const char* const FRAME_STATS_FILE_NAME = "lbm_frames.csv";
+const char* const MEMORY_FILE_NAME = "lbm_memory.json";
+const char* const INPUT_TRACE_FILE_NAME = "lbm_input.trace";
+const char* const RUN_CONFIG_FILE_NAME = "lbm_config.json"; // Read on start-up if present
+
+// Geometry import constants
+const char* const GEOMETRY_FILE_NAME = "lbm_geometry.png"; // Default wall mask
+
+// Checkpoint constants
+const char* const CHECKPOINT_FILE_NAME = "lbm_checkpoint.lbmc";
+const char* const AUTO_CHECKPOINT_DIRECTORY = "lbm_autosave";
+const unsigned int INIT_AUTO_CHECKPOINT_INTERVAL = 1000;       // Steps
+const GLfloat INIT_AUTO_CHECKPOINT_THRESHOLD = 1e-3f;          // Largest change of a field that leaves a tile out of a delta
+const unsigned int INIT_AUTO_CHECKPOINT_KEYFRAME_INTERVAL = 10; // Auto-checkpoints per keyframe
+
+// Field output constants
+const char* const FIELD_OUTPUT_FILE_NAME = "lbm_fields.lbmf";
+const char* const SHARED_FIELDS_NAME = "/lbm_fields"; // POSIX shared memory object the fields are published to
+const unsigned int INIT_FIELD_OUTPUT_INTERVAL = 100; // Steps
+const uint32_t INIT_FIELD_OUTPUT_MASK = 0x3F;         // All fields
+const GLfloat INIT_FIELD_OUTPUT_ERROR_BOUND = 0.f;    // Raw floats
+
+// Frame capture constants
+const char* const CAPTURE_DIRECTORY = "lbm_capture";
+const unsigned int INIT_CAPTURE_INTERVAL = 1; // Frames
+// Encoder reading raw RGBA frames from its standard input, {width} and {height} are replaced by the frame size
+const char* const INIT_CAPTURE_COMMAND = "ffmpeg -y -loglevel error -f rawvideo -pixel_format rgba -video_size {width}x{height} "
+                                         "-framerate 60 -i - -vf \"pad=ceil(iw/2)*2:ceil(ih/2)*2\" -pix_fmt yuv420p lbm_capture.mp4";
+
 enum class ToolType {
   Force,
   AddWall,
@@ -56,6 +100,30 @@ enum class OverlayType {
   Arrows,
 };
 
+enum class SceneType {
+  Blobs,             // Three solute blobs in a periodic box
+  CylinderWake,      // Channel flow past a cylinder
+  ShearDrivenCavity, // Square cavity below a driven channel
+  PorousPacking,     // Channel filled with randomly placed discs
+  ChannelNetwork,    // Parallel channels joined by random cross-links
+  MixingChamber,     // Three solute streams through a baffled channel
+};
+
+enum class SolverBackend {
+  FragmentShader, // Render-to-texture passes, requires OpenGL 3.3
+  ComputeShader,  // Compute dispatches on shader storage buffers, requires OpenGL 4.3
+  InPlaceComputeShader, // Compute dispatches streaming in place on a single storage buffer (AA pattern), requires OpenGL 4.3
+};
+
+// Parameters restored by Reset All
+struct SimulationDefaults {
+  unsigned int stepsPerFrame = INIT_STEPS_PER_FRAME;
+  GLfloat fluidViscosity = INIT_FLUID_VISCOSITY;
+  bool isReactionEnabled = false;
+  GLfloat reactionRate = INIT_REACTION_RATE;
+  std::vector<GLfloat> soluteDiffusivities = {INIT_SOLUTE_DIFFUSIVITY_0, INIT_SOLUTE_DIFFUSIVITY_1, INIT_SOLUTE_DIFFUSIVITY_2};
+};
+
 struct AppState {
   // Cursor input
   glm::vec2 cursorPos;        // Cursor position relative to interactive simulation area
@@ -69,9 +137,20 @@ struct AppState {
   GLfloat toolSize;           // Size of the tool
 
   // Simulation state
+  glm::ivec2 latticeSize;     // Size of the lattice the simulation is created with
+  SimulationDefaults defaults; // Initial parameters, from the run configuration
   bool hasVerticalWalls;      // Does the simulation have vertical boundary walls
   bool hasHorizontalWalls;    // Does the simulation have horizontal boundary walls
   unsigned int stepsPerFrame; // Number of simulation steps per rendered frame
+  SolverBackend solverBackend; // Backend used to run the simulation passes
+
+  // Scene state
+  SceneType scene;            // Scene loaded on start-up and by Reset All
+  GLfloat scenePorosity;      // Fluid fraction of the porous packing
+  GLfloat sceneFeatureSize;   // Obstacle, cavity and channel size relative to the lattice height
+  GLfloat sceneFlowSpeed;     // Target peak velocity of the driven scenes in lattice units
+  unsigned int sceneSeed;     // Seed of the randomly generated scenes
+  std::vector<SoluteBlob> sceneBlobs; // Solute discs of the blobs scene
 
   // Visualization state
   glm::vec2 viewportScale;    // Content scale of interactive viewport
@@ -85,11 +164,29 @@ struct AppState {
   // Reaction params
   bool isReactionEnabled;     // Is the reaction between solutes enabled
   GLfloat reactionRate;       // Rate of reaction between solutes
+  std::vector<GLfloat> reactionMolarMasses;        // Molar mass of every solute
+  std::vector<GLint> reactionStoichiometricCoeffs; // Negative for reactants, positive for products
 
   // Solutes params
   std::vector<GLfloat> soluteDiffusivities; // Solute diffusivities
   std::vector<glm::vec3> soluteColors;      // Solute colors
 
+  // Auto-checkpoint params
+  bool isAutoCheckpointEnabled;             // Are tiled checkpoints written periodically in the background
+  unsigned int autoCheckpointInterval;      // Simulation steps between auto-checkpoints
+  GLfloat autoCheckpointThreshold;          // Change of the macroscopic fields above which a tile is checkpointed
+  unsigned int autoCheckpointKeyframeInterval; // Auto-checkpoints per keyframe holding every tile
+
+  // Field output params
+  unsigned int fieldOutputInterval;         // Simulation steps between field snapshots
+  uint32_t fieldOutputMask;                 // Bit per FieldType written at every snapshot
+  unsigned int fieldOutputStride;           // Nodes between samples in both dimensions
+  glm::ivec4 fieldOutputRegion;             // Sampled region of the lattice (x, y, width, height), the whole lattice if empty
+  GLfloat fieldOutputErrorBound;            // Absolute error of compressed field snapshots, 0 to write raw floats
+
+  // Frame capture params
+  unsigned int captureInterval;             // Frames between captured output images
+
   // AppState access method
   static AppState& getInstance() {
     static AppState instance;
@@ -108,12 +205,12 @@ struct AppState {
     toolSize = 0.2f;
     hasVerticalWalls = false;
     hasHorizontalWalls = false;
-    stepsPerFrame = 1;
+    stepsPerFrame = defaults.stepsPerFrame;
     activeOverlay = OverlayType::Lines;
-    fluidViscosity = INIT_FLUID_VISCOSITY;
-    isReactionEnabled = false;
-    reactionRate = INIT_REACTION_RATE;
-    soluteDiffusivities = {INIT_SOLUTE_DIFFUSIVITY_0, INIT_SOLUTE_DIFFUSIVITY_1, INIT_SOLUTE_DIFFUSIVITY_2};
+    fluidViscosity = defaults.fluidViscosity;
+    isReactionEnabled = defaults.isReactionEnabled;
+    reactionRate = defaults.reactionRate;
+    soluteDiffusivities = defaults.soluteDiffusivities;
     soluteColors = {INIT_SOLUTE_COLOR_0, INIT_SOLUTE_COLOR_1, INIT_SOLUTE_COLOR_2};
   }
 
@@ -128,9 +225,29 @@ private:
     isSimulationFocussed = false;
     isCursorActive = false;
     activeSolute = 0;
+    latticeSize = {SIMULATION_WIDTH, SIMULATION_HEIGHT};
+    reactionMolarMasses = REACTION_MOLAR_MASSES;
+    reactionStoichiometricCoeffs = REACTION_STOICHIOMETRIC_COEFFS;
+    solverBackend = SolverBackend::FragmentShader;
+    scene = SceneType::Blobs;
+    scenePorosity = INIT_SCENE_POROSITY;
+    sceneFeatureSize = INIT_SCENE_FEATURE_SIZE;
+    sceneFlowSpeed = INIT_SCENE_FLOW_SPEED;
+    sceneSeed = INIT_SCENE_SEED;
+    sceneBlobs = INIT_SCENE_BLOBS;
     viewportScale = {1.f, 1.f};
     viewportSize = {0.f, 0.f};
     aspectRatio = {1.f, 1.f};
+    isAutoCheckpointEnabled = false;
+    autoCheckpointInterval = INIT_AUTO_CHECKPOINT_INTERVAL;
+    autoCheckpointThreshold = INIT_AUTO_CHECKPOINT_THRESHOLD;
+    autoCheckpointKeyframeInterval = INIT_AUTO_CHECKPOINT_KEYFRAME_INTERVAL;
+    fieldOutputInterval = INIT_FIELD_OUTPUT_INTERVAL;
+    fieldOutputMask = INIT_FIELD_OUTPUT_MASK;
+    fieldOutputStride = 1;
+    fieldOutputRegion = {0, 0, 0, 0};
+    fieldOutputErrorBound = INIT_FIELD_OUTPUT_ERROR_BOUND;
+    captureInterval = INIT_CAPTURE_INTERVAL;
   }
 };
 
@@ -0,0 +1,147 @@
+#include "core/batch_run.h"
+
+#include <algorithm>
+#include <chrono>
+#if !defined(_WIN32)
+  #include <csignal>
+#endif
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "core/frame_capture.h"
+#include "core/headless.h"
+#include "core/input_trace.h"
+#include "core/steering_server.h"
+#include "lbm/auto_checkpoint.h"
+#include "lbm/checkpoint.h"
+#include "lbm/field_publisher.h"
+#include "lbm/field_writer.h"
+#include "lbm/lbm.h"
+
+namespace {
+
+bool simulate(const RunConfig& config, std::string& error) {
+  AppState& appState = AppState::getInstance();
+  auto lbm = std::make_shared<LBM>(appState.latticeSize.x, appState.latticeSize.y);
+  auto autoCheckpoint = std::make_shared<AutoCheckpoint>(lbm);
+  auto fieldWriter = std::make_shared<FieldWriter>(lbm);
+  auto fieldPublisher = std::make_shared<FieldPublisher>(lbm);
+  auto frameCapture = std::make_shared<FrameCapture>(lbm);
+  if (!startRun(config, *lbm, *fieldWriter, *fieldPublisher, *frameCapture, error)) {
+    return false;
+  }
+  SteeringServer steeringServer;
+  if (!config.steeringSocket.empty()) {
+    if (!steeringServer.start(config.steeringSocket, error)) {
+      return false;
+    }
+    std::cerr << "Steering on " << config.steeringSocket << std::endl;
+  }
+
+  // Same order as the frame loop of the app
+  InputTrace& inputTrace = InputTrace::getInstance();
+  glFinish();
+  auto start = std::chrono::steady_clock::now();
+  uint64_t step = 0;
+  while (step < config.steps) {
+    const uint64_t frameSteps = std::min<uint64_t>(std::max(appState.stepsPerFrame, 1u), config.steps - step);
+    for (uint64_t i = 0; i < frameSteps; i++) {
+      steeringServer.update(*lbm);
+      inputTrace.update(*lbm);
+      lbm->updateSimulation();
+      fieldWriter->update();
+      fieldPublisher->update();
+      step++;
+      if (config.reportInterval > 0 && step % config.reportInterval == 0) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "Step " << step << "/" << config.steps << ", " << seconds << " s" << std::endl;
+      }
+    }
+    lbm->updateAnimationPhase();
+    autoCheckpoint->update();
+    frameCapture->update();
+  }
+  glFinish();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double mlups = static_cast<double>(appState.latticeSize.x) * appState.latticeSize.y * config.steps / std::max(seconds, 1e-9) * 1e-6;
+  std::cerr << "Ran " << config.steps << " steps of " << appState.latticeSize.x << "x" << appState.latticeSize.y << " in " << seconds
+            << " s (" << mlups << " MLUPS)" << std::endl;
+
+  // Write out everything still in flight before reporting
+  if (!config.replayPath.empty()) {
+    std::cerr << "Replayed " << inputTrace.getStepIndex() << " of " << inputTrace.getStepCount() << " steps from " << config.replayPath
+              << std::endl;
+    inputTrace.stop();
+  }
+  steeringServer.stop();
+  fieldWriter->stop();
+  fieldPublisher->stop();
+  frameCapture->stop();
+  autoCheckpoint.reset();
+  bool isSuccessful = true;
+  if (!config.fieldOutputPath.empty()) {
+    FieldWriter::Status status = fieldWriter->getStatus();
+    std::cerr << "Wrote " << status.snapshotCount << " field snapshots to " << config.fieldOutputPath << " (" << status.bytes
+              << " bytes for " << status.fieldBytes << " bytes of fields), dropped " << status.droppedCount << std::endl;
+    if (!status.error.empty()) {
+      error = status.error;
+      isSuccessful = false;
+    }
+  }
+  if (!config.sharedFieldsName.empty()) {
+    FieldPublisher::Status status = fieldPublisher->getStatus();
+    std::cerr << "Published " << status.snapshotCount << " field snapshots to " << config.sharedFieldsName << ", dropped "
+              << status.droppedCount << std::endl;
+    if (!status.error.empty()) {
+      error = status.error;
+      isSuccessful = false;
+    }
+  }
+  if (!config.captureDirectory.empty() || !config.captureCommand.empty()) {
+    FrameCapture::Status status = frameCapture->getStatus();
+    std::cerr << "Captured " << status.frameCount << " frames, dropped " << status.droppedCount << std::endl;
+    if (!status.error.empty()) {
+      error = status.error;
+      isSuccessful = false;
+    }
+  }
+  if (!config.checkpointPath.empty()) {
+    if (!Checkpoint::save(*lbm, config.checkpointPath, error)) {
+      return false;
+    }
+    std::cerr << "Checkpoint written to " << config.checkpointPath << std::endl;
+  }
+  return isSuccessful;
+}
+
+} // namespace
+
+int runBatch(const RunConfig& config) {
+#if !defined(_WIN32)
+  // Writes to a capture pipe whose reader has gone report EPIPE rather than ending the run
+  std::signal(SIGPIPE, SIG_IGN);
+#endif
+  GLFWwindow* window = createHeadlessContext("lbm");
+  if (window == nullptr) {
+    std::cerr << "Failed to create an OpenGL context" << std::endl;
+    return 1;
+  }
+  std::cerr << "GPU: " << glGetString(GL_RENDERER) << std::endl;
+  std::cerr << "Active OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+
+  // The output image covers the lattice, one pixel per node
+  AppState& appState = AppState::getInstance();
+  appState.viewportSize = glm::vec2(appState.latticeSize);
+  std::string error;
+  bool isSuccessful = selectBackend(config, error);
+  if (isSuccessful) {
+    std::cerr << "Solver backend: " << getBackendName(appState.solverBackend) << std::endl;
+    isSuccessful = simulate(config, error);
+  }
+  if (!isSuccessful) {
+    std::cerr << error << std::endl;
+  }
+  destroyHeadlessContext(window);
+  return isSuccessful ? 0 : 1;
+}
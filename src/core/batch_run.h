@@ -0,0 +1,11 @@
+#ifndef BATCH_RUN_H
+#define BATCH_RUN_H
+
+#include "core/run_config.h"
+
+// Runs the configured number of steps without a window, driving the configured field output, frame capture and
+// auto-checkpoints as the app does, a frame being AppState::stepsPerFrame steps. Writes a final checkpoint if one is
+// configured and returns the exit status of the process.
+int runBatch(const RunConfig& config);
+
+#endif // BATCH_RUN_H
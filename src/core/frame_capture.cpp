@@ -0,0 +1,317 @@
+#include "core/frame_capture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+#if defined(_WIN32)
+  #include <stdio.h>
+#else
+  #include <sys/wait.h>
+#endif
+
+#include "core/io.h"
+
+namespace {
+
+bool isSignalled(GLsync fence) {
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void replaceAll(std::string& text, const std::string& pattern, const std::string& replacement) {
+  for (size_t position = text.find(pattern); position != std::string::npos;
+       position = text.find(pattern, position + replacement.size())) {
+    text.replace(position, pattern.size(), replacement);
+  }
+}
+
+FILE* openPipe(const std::string& command) {
+#if defined(_WIN32)
+  return _popen(command.c_str(), "wb");
+#else
+  // SIGPIPE is ignored at startup, so an encoder that exits early shows up as a failed write
+  return popen(command.c_str(), "w");
+#endif
+}
+
+// Returns the exit status of the process
+int closePipe(FILE* pipe) {
+#if defined(_WIN32)
+  return _pclose(pipe);
+#else
+  int status = pclose(pipe);
+  return (status != -1 && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+} // namespace
+
+FrameCapture::FrameCapture(std::shared_ptr<LBM> lbm) : lbm(lbm) {
+  glGenFramebuffers(1, &readFramebuffer);
+  for (Readback& readback : readbacks) {
+    glGenBuffers(1, &readback.buffer);
+  }
+}
+
+FrameCapture::~FrameCapture() {
+  stop();
+  for (Readback& readback : readbacks) {
+    glDeleteBuffers(1, &readback.buffer);
+  }
+  glDeleteFramebuffers(1, &readFramebuffer);
+}
+
+bool FrameCapture::startImages(const fs::path& directory, std::string& error) {
+  stop();
+  std::error_code errorCode;
+  fs::create_directories(directory, errorCode);
+  if (errorCode) {
+    error = "Failed to create " + directory.string() + ": " + errorCode.message();
+    return false;
+  }
+  this->directory = directory;
+  return start(error);
+}
+
+bool FrameCapture::startPipe(const std::string& command, std::string& error) {
+  stop();
+  const glm::ivec2 size = lbm->getOutputSize();
+  std::string resolvedCommand = command;
+  replaceAll(resolvedCommand, "{width}", std::to_string(size.x));
+  replaceAll(resolvedCommand, "{height}", std::to_string(size.y));
+  pipe = openPipe(resolvedCommand);
+  if (pipe == nullptr) {
+    error = "Failed to run " + resolvedCommand;
+    return false;
+  }
+  return start(error);
+}
+
+bool FrameCapture::start(std::string& error) {
+  updateCount = 0;
+  nextFrameIndex = 0;
+  status = Status();
+  isStopping = false;
+
+  const glm::ivec2 size = lbm->getOutputSize();
+  if (size.x <= 0 || size.y <= 0) {
+    error = "The simulation has no output image to capture";
+    cancelStart();
+    return false;
+  }
+  resizeReadbacks(size);
+  if (glGetError() == GL_OUT_OF_MEMORY) {
+    error = "Out of GPU memory for the " + std::to_string(size.x) + "x" + std::to_string(size.y) + " frame readback buffers";
+    cancelStart();
+    return false;
+  }
+
+  // Frames of a pipe have to arrive in order, image files can be encoded in parallel
+  const unsigned int workerCount = (pipe != nullptr) ? 1 : std::clamp(std::thread::hardware_concurrency() / 2, 1u, MAX_WORKER_COUNT);
+  try {
+    for (unsigned int i = 0; i < workerCount; i++) {
+      workers.emplace_back(&FrameCapture::writeFrames, this);
+    }
+  } catch (const std::system_error& exception) {
+    error = std::string("Failed to start the frame writers: ") + exception.what();
+    cancelStart();
+    return false;
+  }
+  return true;
+}
+
+void FrameCapture::cancelStart() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+  condition.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  if (pipe != nullptr) {
+    closePipe(pipe);
+    pipe = nullptr;
+  }
+  resizeReadbacks({0, 0});
+}
+
+void FrameCapture::stop() {
+  if (!isCapturing()) {
+    return;
+  }
+  finishReadbacks(true);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+  condition.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+
+  if (pipe != nullptr) {
+    const int exitStatus = closePipe(pipe);
+    pipe = nullptr;
+    if (exitStatus != 0 && status.error.empty()) {
+      status.error = "The encoder exited with status " + std::to_string(exitStatus);
+    }
+  }
+  resizeReadbacks({0, 0});
+}
+
+bool FrameCapture::isCapturing() const {
+  return !workers.empty();
+}
+
+void FrameCapture::update() {
+  finishReadbacks(false);
+  if (!isCapturing() || updateCount++ % std::max(AppState::getInstance().captureInterval, 1u) != 0) {
+    return;
+  }
+
+  // Image sequences follow the output size once the readbacks in flight have completed, pipes need a fixed size
+  const glm::ivec2 size = lbm->getOutputSize();
+  if (size != frameSize) {
+    const bool isIdle = std::none_of(readbacks.begin(), readbacks.end(), [](const Readback& readback) { return readback.fence != nullptr; });
+    if (pipe != nullptr || !isIdle) {
+      std::lock_guard<std::mutex> lock(mutex);
+      status.droppedCount++;
+      if (pipe != nullptr) {
+        status.error = "The output was resized, the encoder expects " + std::to_string(frameSize.x) + "x" + std::to_string(frameSize.y);
+      }
+      return;
+    }
+    resizeReadbacks(size);
+  }
+  Readback& readback = readbacks[nextReadback];
+  if (readback.fence != nullptr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    status.droppedCount++;
+    return;
+  }
+  nextReadback = (nextReadback + 1) % READBACK_COUNT;
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+  glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lbm->getOutputTexture(), 0);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  glReadPixels(0, 0, frameSize.x, frameSize.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  readback.index = nextFrameIndex++;
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+}
+
+FrameCapture::Status FrameCapture::getStatus() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return status;
+}
+
+void FrameCapture::resizeReadbacks(const glm::ivec2& size) {
+  frameSize = size;
+  const size_t frameBytes = static_cast<size_t>(size.x) * size.y * 4;
+  for (Readback& readback : readbacks) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  allocation = (frameBytes > 0) ? TrackedAllocation(MemoryKind::Buffer, "Frame capture", "Readback buffers", "RGBA8", size.x, size.y,
+                                                    READBACK_COUNT * frameBytes)
+                                : TrackedAllocation();
+}
+
+void FrameCapture::finishReadbacks(bool isBlocking) {
+  // Readbacks complete in the order they were issued, starting with the oldest
+  const size_t frameBytes = static_cast<size_t>(frameSize.x) * frameSize.y * 4;
+  for (unsigned int i = 0; i < READBACK_COUNT; i++) {
+    Readback& readback = readbacks[(nextReadback + i) % READBACK_COUNT];
+    if (readback.fence == nullptr) {
+      continue;
+    }
+    if (isBlocking) {
+      glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    } else if (!isSignalled(readback.fence)) {
+      return;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    // Only this thread adds frames, so a queue that has room now still has room after the copy
+    bool isQueueFull;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      isQueueFull = !isBlocking && frames.size() >= MAX_QUEUED_FRAMES;
+      status.droppedCount += isQueueFull ? 1 : 0;
+    }
+    if (isQueueFull) {
+      continue;
+    }
+
+    Frame frame = {readback.index, frameSize, std::vector<uint8_t>(frameBytes)};
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT);
+    if (data != nullptr) {
+      std::memcpy(frame.pixels.data(), data, frameBytes);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (data != nullptr) {
+      frames.push_back(std::move(frame));
+      condition.notify_one();
+    } else {
+      status.error = "Failed to map the frame readback buffer";
+      status.droppedCount++;
+    }
+  }
+}
+
+void FrameCapture::writeFrames() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    condition.wait(lock, [this] { return isStopping || !frames.empty(); });
+    if (frames.empty()) {
+      break;
+    }
+    Frame frame = std::move(frames.front());
+    frames.pop_front();
+    lock.unlock();
+
+    // Frames were read back from the bottom row, images and encoders expect the top row first
+    const size_t rowSize = static_cast<size_t>(frame.size.x) * 4;
+    std::string error;
+    bool isWritten = true;
+    if (pipe != nullptr) {
+      for (int y = frame.size.y - 1; y >= 0 && isWritten; y--) {
+        isWritten = fwrite(&frame.pixels[y * rowSize], 1, rowSize, pipe) == rowSize;
+      }
+      isWritten = isWritten && fflush(pipe) == 0;
+      if (!isWritten) {
+        error = "The encoder stopped reading frames";
+      }
+    } else {
+      for (int y = 0; y < frame.size.y / 2; y++) {
+        std::swap_ranges(frame.pixels.begin() + y * rowSize, frame.pixels.begin() + (y + 1) * rowSize,
+                         frame.pixels.begin() + (frame.size.y - 1 - y) * rowSize);
+      }
+      char fileName[32];
+      snprintf(fileName, sizeof(fileName), "frame_%06llu.png", static_cast<unsigned long long>(frame.index));
+      isWritten = writePNG(directory / fileName, frame.size.x, frame.size.y, frame.pixels.data(), error);
+    }
+
+    lock.lock();
+    if (isWritten) {
+      status.frameCount++;
+    } else {
+      status.droppedCount++;
+      if (status.error.empty()) {
+        status.error = error;
+      }
+    }
+  }
+}
@@ -0,0 +1,102 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+
+#include "gl/memory_tracker.h"
+#include "lbm/lbm.h"
+
+namespace fs = std::filesystem;
+
+// Captures the output image of the simulation every AppState::captureInterval frames, either as a numbered PNG
+// sequence or as raw RGBA frames streamed to the standard input of an encoder process such as ffmpeg.
+// The image is read into one of a ring of pixel pack buffers, and once its fence has signalled it is handed to worker
+// threads that encode and write it, so capturing never waits on the GPU, the encoder or the disk. Frames that find
+// every readback in flight or the queue of the workers full are dropped and counted instead.
+// Only a current OpenGL context is required, so headless runs can capture as well.
+class FrameCapture {
+public:
+  static constexpr unsigned int READBACK_COUNT = 3;    // Frames that can be in flight on the GPU at once
+  static constexpr unsigned int MAX_QUEUED_FRAMES = 8; // Frames waiting for the workers
+  static constexpr unsigned int MAX_WORKER_COUNT = 4;  // PNG encoders, a pipe is fed by a single worker in order
+
+  struct Status {
+    uint64_t frameCount = 0; // Written to files or the pipe
+    uint64_t droppedCount = 0;
+    std::string error;
+  };
+
+  FrameCapture(std::shared_ptr<LBM> lbm);
+  ~FrameCapture(); // Stops capturing
+
+  // Disallow copy and assignment to avoid multiple deletions of OpenGL objects
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+
+  // Writes frame_000000.png, frame_000001.png, ... to the directory
+  bool startImages(const fs::path& directory, std::string& error);
+  // Runs the command through the shell and writes the frames to its standard input, top row first. The frame size
+  // replaces {width} and {height} in the command and must not change while capturing.
+  bool startPipe(const std::string& command, std::string& error);
+  // Writes the frames in flight, then waits for an encoder process to exit
+  void stop();
+  bool isCapturing() const;
+
+  // Call once per frame after the simulation has rendered its output, with the context current
+  void update();
+
+  Status getStatus() const;
+
+private:
+  struct Frame {
+    uint64_t index;
+    glm::ivec2 size;
+    std::vector<uint8_t> pixels; // RGBA rows from the bottom, as read back
+  };
+
+  struct Readback {
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    uint64_t index = 0;
+  };
+
+  std::shared_ptr<LBM> lbm;
+  glm::ivec2 frameSize = {0, 0}; // Of the readback buffers
+  GLuint readFramebuffer;
+  std::array<Readback, READBACK_COUNT> readbacks;
+  unsigned int nextReadback = 0; // Readbacks are issued and completed in ring order
+  uint64_t updateCount = 0;
+  uint64_t nextFrameIndex = 0;
+  TrackedAllocation allocation;
+
+  // Worker state, guarded by the mutex while capturing
+  std::vector<std::thread> workers;
+  fs::path directory;
+  FILE* pipe = nullptr;
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<Frame> frames;
+  bool isStopping = false;
+  Status status;
+
+  bool start(std::string& error);
+  void cancelStart(); // Undoes a start that failed, without writing any frames
+  void resizeReadbacks(const glm::ivec2& size);
+  void finishReadbacks(bool isBlocking);
+  void writeFrames();
+};
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,187 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+static float getMedian(std::vector<float> values) {
+  if (values.empty()) {
+    return 0.f;
+  }
+  auto middle = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), middle, values.end());
+  return *middle;
+}
+
+void FrameStats::beginFrame(uint64_t frameIndex) {
+  // The previous frame lasts until this one starts
+  Clock::time_point now = Clock::now();
+  if (isFrameActive) {
+    currentFrame.frameTime = std::chrono::duration<float, std::milli>(now - frameStart).count();
+    frames[frameOffset] = currentFrame;
+    frameOffset = (frameOffset + 1) % CAPACITY;
+    frameCount = std::min(frameCount + 1, CAPACITY);
+    detectHitch(currentFrame);
+  }
+  currentFrame = {frameIndex, 0.f, 0.f, -1.f, 0.f, 0};
+  frameStart = now;
+  swapStart = now;
+  isFrameActive = true;
+}
+
+void FrameStats::setStepCount(unsigned int stepCount) {
+  currentFrame.stepCount = stepCount;
+}
+
+void FrameStats::beginSwap() {
+  swapStart = Clock::now();
+  currentFrame.cpuTime = std::chrono::duration<float, std::milli>(swapStart - frameStart).count();
+}
+
+void FrameStats::endSwap() {
+  currentFrame.swapWait = std::chrono::duration<float, std::milli>(Clock::now() - swapStart).count();
+}
+
+void FrameStats::setGPUTime(uint64_t frameIndex, float gpuTime, const std::string& slowestPass, float slowestPassExcess) {
+  FrameRecord* frame = findFrame(frameIndex);
+  if (frame == nullptr) {
+    return;
+  }
+  frame->gpuTime = gpuTime;
+
+  // A hitch the CPU did not explain is blamed on the pass furthest above its average,
+  // with vsync a late GPU shows up as a longer swap
+  for (auto it = hitches.rbegin(); it != hitches.rend(); ++it) {
+    if (it->frame.frameIndex != frameIndex) {
+      continue;
+    }
+    it->frame.gpuTime = gpuTime;
+    if (slowestPassExcess > it->cpuExcess && slowestPassExcess > 0.f) {
+      it->cause = "GPU: " + slowestPass;
+    }
+    break;
+  }
+}
+
+void FrameStats::reset() {
+  frameOffset = 0;
+  frameCount = 0;
+  hitches.clear();
+}
+
+unsigned int FrameStats::getFrameCount() const {
+  return frameCount;
+}
+
+const FrameStats::FrameRecord& FrameStats::getFrame(unsigned int index) const {
+  return frames[(frameOffset + CAPACITY - frameCount + index) % CAPACITY];
+}
+
+FrameStats::Percentiles FrameStats::getPercentiles(Metric metric) const {
+  // Nearest-rank percentiles over the frames kept
+  Percentiles percentiles;
+  std::vector<float> values = getValues(metric);
+  if (values.empty()) {
+    return percentiles;
+  }
+  std::sort(values.begin(), values.end());
+  auto getPercentile = [&](float fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+  };
+  percentiles.p50 = getPercentile(0.5f);
+  percentiles.p95 = getPercentile(0.95f);
+  percentiles.p99 = getPercentile(0.99f);
+  percentiles.max = values.back();
+  return percentiles;
+}
+
+std::vector<float> FrameStats::getHistogram(unsigned int binCount, float maxTime) const {
+  // Frames beyond the range are counted in the last bin
+  std::vector<float> bins(binCount, 0.f);
+  if (binCount == 0 || maxTime <= 0.f) {
+    return bins;
+  }
+  for (unsigned int i = 0; i < frameCount; i++) {
+    unsigned int bin = static_cast<unsigned int>(getFrame(i).frameTime / maxTime * binCount);
+    bins[std::min(bin, binCount - 1)] += 1.f;
+  }
+  return bins;
+}
+
+const std::deque<FrameStats::Hitch>& FrameStats::getHitches() const {
+  return hitches;
+}
+
+bool FrameStats::exportCSV(const fs::path& path, const std::string& renderer) const {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file << "# GPU: " << renderer << "\n";
+  file << "frame,frame_ms,cpu_ms,gpu_ms,swap_wait_ms,steps,hitch_cause\n";
+  for (unsigned int i = 0; i < frameCount; i++) {
+    const FrameRecord& frame = getFrame(i);
+    file << frame.frameIndex << "," << frame.frameTime << "," << frame.cpuTime << ",";
+    if (frame.gpuTime >= 0.f) {
+      file << frame.gpuTime;
+    }
+    file << "," << frame.swapWait << "," << frame.stepCount << ",";
+    for (const Hitch& hitch : hitches) {
+      if (hitch.frame.frameIndex == frame.frameIndex) {
+        file << "\"" << hitch.cause << "\"";
+        break;
+      }
+    }
+    file << "\n";
+  }
+  return file.good();
+}
+
+FrameStats::FrameRecord* FrameStats::findFrame(uint64_t frameIndex) {
+  // GPU results lag by a few frames, so search from the newest frame
+  for (unsigned int i = 0; i < frameCount; i++) {
+    FrameRecord& frame = frames[(frameOffset + CAPACITY - 1 - i) % CAPACITY];
+    if (frame.frameIndex == frameIndex) {
+      return &frame;
+    }
+    if (frame.frameIndex < frameIndex) {
+      break;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<float> FrameStats::getValues(Metric metric) const {
+  std::vector<float> values;
+  values.reserve(frameCount);
+  for (unsigned int i = 0; i < frameCount; i++) {
+    const FrameRecord& frame = getFrame(i);
+    switch (metric) {
+      case Metric::FrameTime: values.push_back(frame.frameTime); break;
+      case Metric::CPUTime: values.push_back(frame.cpuTime); break;
+      case Metric::GPUTime:
+        if (frame.gpuTime >= 0.f) {
+          values.push_back(frame.gpuTime);
+        }
+        break;
+      case Metric::SwapWait: values.push_back(frame.swapWait); break;
+    }
+  }
+  return values;
+}
+
+void FrameStats::detectHitch(const FrameRecord& frame) {
+  if (frameCount < MIN_HITCH_FRAMES || frame.frameTime <= HITCH_FACTOR * getMedian(getValues(Metric::FrameTime))) {
+    return;
+  }
+
+  // Attribute the hitch to the CPU or the swap for now, the GPU pass is only known once it is collected
+  float cpuExcess = frame.cpuTime - getMedian(getValues(Metric::CPUTime));
+  float swapExcess = frame.swapWait - getMedian(getValues(Metric::SwapWait));
+  hitches.push_back({frame, cpuExcess, swapExcess, cpuExcess >= swapExcess ? "CPU" : "Swap wait"});
+  if (hitches.size() > MAX_HITCHES) {
+    hitches.pop_front();
+  }
+}
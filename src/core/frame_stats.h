@@ -0,0 +1,102 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Records frame pacing statistics into a ring buffer: the interval between frames, the CPU time spent
+// before presenting, the time blocked in the buffer swap (vsync), the GPU time and the number of simulation steps.
+// Frames much slower than the median are logged as hitches and attributed to the CPU, the swap
+// or the GPU pass that exceeded its average the most. GPU times arrive a few frames late, keyed by frame index.
+class FrameStats {
+public:
+  static constexpr unsigned int CAPACITY = 1024;       // Number of frames kept
+  static constexpr unsigned int MAX_HITCHES = 64;      // Number of hitches kept in the log
+  static constexpr unsigned int MIN_HITCH_FRAMES = 60; // Frames recorded before hitches are detected
+  static constexpr float HITCH_FACTOR = 1.5f;          // Frame time relative to the median that counts as a hitch
+
+  struct FrameRecord {
+    uint64_t frameIndex;
+    float frameTime; // ms from the start of this frame to the start of the next
+    float cpuTime;   // ms from the start of the frame until the swap
+    float gpuTime;   // ms, negative until the profiler has collected the frame
+    float swapWait;  // ms blocked in the buffer swap
+    unsigned int stepCount;
+  };
+
+  struct Hitch {
+    FrameRecord frame;
+    float cpuExcess;  // ms above the median
+    float swapExcess; // ms above the median
+    std::string cause;
+  };
+
+  struct Percentiles {
+    float p50 = 0.f;
+    float p95 = 0.f;
+    float p99 = 0.f;
+    float max = 0.f;
+  };
+
+  enum class Metric {
+    FrameTime,
+    CPUTime,
+    GPUTime,
+    SwapWait,
+  };
+
+  // FrameStats access method
+  static FrameStats& getInstance() {
+    static FrameStats instance;
+    return instance;
+  }
+
+  // Prevent copying or moving
+  FrameStats(const FrameStats&) = delete;
+  FrameStats& operator=(const FrameStats&) = delete;
+  FrameStats(FrameStats&&) = delete;
+  FrameStats& operator=(FrameStats&&) = delete;
+
+  void beginFrame(uint64_t frameIndex); // Completes the previous frame
+  void setStepCount(unsigned int stepCount);
+  void beginSwap();
+  void endSwap();
+  void setGPUTime(uint64_t frameIndex, float gpuTime, const std::string& slowestPass, float slowestPassExcess);
+  void reset();
+
+  unsigned int getFrameCount() const;
+  const FrameRecord& getFrame(unsigned int index) const; // 0 is the oldest frame kept
+  Percentiles getPercentiles(Metric metric) const;
+  std::vector<float> getHistogram(unsigned int binCount, float maxTime) const; // Frame time bins over [0, maxTime)
+  const std::deque<Hitch>& getHitches() const;
+  bool exportCSV(const fs::path& path, const std::string& renderer) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::array<FrameRecord, CAPACITY> frames{};
+  unsigned int frameOffset = 0; // Next slot to write
+  unsigned int frameCount = 0;
+  std::deque<Hitch> hitches;
+
+  // Frame in progress
+  FrameRecord currentFrame{};
+  Clock::time_point frameStart;
+  Clock::time_point swapStart;
+  bool isFrameActive = false;
+
+  FrameStats() = default;
+
+  FrameRecord* findFrame(uint64_t frameIndex);
+  std::vector<float> getValues(Metric metric) const;
+  void detectHitch(const FrameRecord& frame);
+};
+
+#endif // FRAME_STATS_H
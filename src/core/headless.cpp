@@ -0,0 +1,64 @@
+#include "headless.h"
+
+#include <cstdio>
+
+#include "gl/gl_extensions.h"
+
+static void glfw_error_callback(int error, const char* description) {
+  fprintf(stderr, "GLFW Error %d: %s\n", error, description);
+}
+
+GLFWwindow* createHeadlessContext(const char* title) {
+  // An invisible window provides the context, requesting GL 4.3 for the compute backends first
+  glfwSetErrorCallback(glfw_error_callback);
+  if (!glfwInit()) {
+    return nullptr;
+  }
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if defined(__APPLE__)
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+  GLFWwindow* window = glfwCreateWindow(64, 64, title, nullptr, nullptr);
+  if (window == nullptr) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    window = glfwCreateWindow(64, 64, title, nullptr, nullptr);
+  }
+  if (window == nullptr) {
+    return nullptr;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(0);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    return nullptr;
+  }
+  loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+  return window;
+}
+
+void destroyHeadlessContext(GLFWwindow* window) {
+  glfwDestroyWindow(window);
+  glfwTerminate();
+}
+
+const char* getBackendName(SolverBackend backend) {
+  switch (backend) {
+    case SolverBackend::FragmentShader: return "fragment";
+    case SolverBackend::ComputeShader: return "compute";
+    case SolverBackend::InPlaceComputeShader: return "inplace";
+  }
+  return "unknown";
+}
+
+bool parseBackendName(const std::string& name, SolverBackend& backend) {
+  for (SolverBackend candidate : {SolverBackend::FragmentShader, SolverBackend::ComputeShader, SolverBackend::InPlaceComputeShader}) {
+    if (name == getBackendName(candidate)) {
+      backend = candidate;
+      return true;
+    }
+  }
+  return false;
+}
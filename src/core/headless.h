@@ -0,0 +1,22 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <string>
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include "core/app_state.h"
+
+// Helpers shared by the headless tools (lbm_bench, lbm_validate)
+
+// Creates an invisible window whose context is made current, preferring GL 4.3 for the compute backends.
+// Returns nullptr if no context could be created or loaded.
+GLFWwindow* createHeadlessContext(const char* title);
+void destroyHeadlessContext(GLFWwindow* window);
+
+// Short backend names as accepted on the command line
+const char* getBackendName(SolverBackend backend);
+bool parseBackendName(const std::string& name, SolverBackend& backend);
+
+#endif // HEADLESS_H
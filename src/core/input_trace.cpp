@@ -0,0 +1,406 @@
+#include "input_trace.h"
+
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include "core/app_state.h"
+#include "lbm/geometry.h"
+#include "lbm/lbm.h"
+
+namespace {
+
+const char MAGIC[8] = {'L', 'B', 'M', 'T', 'R', 'A', 'C', 'E'};
+const size_t STEP_COUNT_OFFSET = sizeof(MAGIC) + 3 * sizeof(uint32_t);
+const size_t HEADER_SIZE = STEP_COUNT_OFFSET + sizeof(uint64_t);
+
+// Fields of a step record, in the order they are stored
+enum FieldBits : uint16_t {
+  CURSOR_POS = 1 << 0,
+  CURSOR_VEL = 1 << 1,
+  FLAGS = 1 << 2,
+  ACTIVE_TOOL = 1 << 3,
+  ACTIVE_SOLUTE = 1 << 4,
+  TOOL_SIZE = 1 << 5,
+  ASPECT_RATIO = 1 << 6,
+  FLUID_VISCOSITY = 1 << 7,
+  REACTION_RATE = 1 << 8,
+  SOLUTE_DIFFUSIVITIES = 1 << 9,
+  EVENTS = 1 << 10,
+  ALL_FIELDS = (1 << 11) - 1,
+};
+
+enum FlagBits : uint8_t {
+  IS_SIMULATION_FOCUSSED = 1 << 0,
+  IS_CURSOR_ACTIVE = 1 << 1,
+  HAS_VERTICAL_WALLS = 1 << 2,
+  HAS_HORIZONTAL_WALLS = 1 << 3,
+  IS_REACTION_ENABLED = 1 << 4,
+};
+
+template <typename T>
+void writeValue(std::vector<uint8_t>& buffer, const T& value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+bool readValue(const std::vector<uint8_t>& buffer, size_t& offset, T& value) {
+  if (offset + sizeof(T) > buffer.size()) {
+    return false;
+  }
+  std::memcpy(&value, buffer.data() + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+} // namespace
+
+bool InputTrace::startRecording(const fs::path& path, const glm::ivec2& latticeSize) {
+  stop();
+  recordFile.open(path, std::ios::binary | std::ios::trunc);
+  if (!recordFile.is_open()) {
+    std::cerr << "Failed to open input trace for writing: " << path << std::endl;
+    return false;
+  }
+
+  // The step count is patched in when the recording stops
+  std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+  writeValue(header, VERSION);
+  writeValue(header, static_cast<uint32_t>(latticeSize.x));
+  writeValue(header, static_cast<uint32_t>(latticeSize.y));
+  writeValue(header, static_cast<uint64_t>(0));
+  recordFile.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+  mode = Recording;
+  this->latticeSize = latticeSize;
+  state = StepState();
+  stepIndex = 0;
+  stepCount = 0;
+  return true;
+}
+
+bool InputTrace::startReplay(const fs::path& path, bool isLooping) {
+  stop();
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open input trace: " << path << std::endl;
+    return false;
+  }
+  replayData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+  // Validate the header
+  size_t offset = sizeof(MAGIC);
+  uint32_t version = 0, width = 0, height = 0;
+  if (replayData.size() < HEADER_SIZE || std::memcmp(replayData.data(), MAGIC, sizeof(MAGIC)) != 0) {
+    std::cerr << "Not an input trace: " << path << std::endl;
+    replayData.clear();
+    return false;
+  }
+  readValue(replayData, offset, version);
+  readValue(replayData, offset, width);
+  readValue(replayData, offset, height);
+  readValue(replayData, offset, stepCount);
+  if (version != 1 && version != VERSION) {
+    std::cerr << "Unsupported input trace version " << version << ": " << path << std::endl;
+    replayData.clear();
+    return false;
+  }
+
+  mode = Replaying;
+  replayVersion = version;
+  this->isLooping = isLooping;
+  latticeSize = {width, height};
+  replayStart = offset;
+  replayOffset = offset;
+  state = StepState();
+  stepIndex = 0;
+  return true;
+}
+
+void InputTrace::stop() {
+  if (mode == Recording) {
+    recordFile.seekp(STEP_COUNT_OFFSET);
+    recordFile.write(reinterpret_cast<const char*>(&stepCount), sizeof(stepCount));
+    recordFile.close();
+  }
+  replayData.clear();
+  pendingEvents.clear();
+  mode = Idle;
+}
+
+bool InputTrace::isRecording() const {
+  return mode == Recording;
+}
+
+bool InputTrace::isReplaying() const {
+  return mode == Replaying;
+}
+
+void InputTrace::recordEvent(TraceEvent event, uint8_t argument) {
+  if (mode == Recording) {
+    bool isLoadingScene = event == TraceEvent::ResetAll || event == TraceEvent::LoadScene;
+    pendingEvents.push_back({event, argument, isLoadingScene ? captureSceneParameters() : std::vector<uint8_t>()});
+  }
+}
+
+void InputTrace::recordLoadGeometry(const fs::path& path, const GeometryOptions& options) {
+  if (mode == Recording) {
+    Event event = {TraceEvent::LoadGeometry, static_cast<uint8_t>(options.isInverted ? 1 : 0), {}};
+    writeValue(event.payload, options.rawSize);
+    std::string pathString = path.string();
+    event.payload.insert(event.payload.end(), pathString.begin(), pathString.end());
+    pendingEvents.push_back(std::move(event));
+  }
+}
+
+void InputTrace::update(LBM& lbm) {
+  if (mode == Recording) {
+    recordStep(lbm);
+  } else if (mode == Replaying && !replayStep(lbm)) {
+    stop();
+  }
+}
+
+uint64_t InputTrace::getStepIndex() const {
+  return stepIndex;
+}
+
+uint64_t InputTrace::getStepCount() const {
+  return stepCount;
+}
+
+glm::ivec2 InputTrace::getLatticeSize() const {
+  return latticeSize;
+}
+
+InputTrace::StepState InputTrace::captureState(const LBM& lbm) {
+  // The tool is the one the step applies, which may have been injected by a steering stroke instead of the cursor
+  const AppState& appState = AppState::getInstance();
+  const LBM::ToolInput toolInput = lbm.getToolInput();
+  StepState current;
+  current.cursorPos = toolInput.position;
+  current.cursorVel = toolInput.velocity;
+  current.flags = (toolInput.isActive || appState.isSimulationFocussed ? IS_SIMULATION_FOCUSSED : 0) |
+                  (toolInput.isActive ? IS_CURSOR_ACTIVE : 0) |
+                  (appState.hasVerticalWalls ? HAS_VERTICAL_WALLS : 0) | (appState.hasHorizontalWalls ? HAS_HORIZONTAL_WALLS : 0) |
+                  (appState.isReactionEnabled ? IS_REACTION_ENABLED : 0);
+  current.activeTool = static_cast<uint8_t>(toolInput.tool);
+  current.activeSolute = static_cast<uint8_t>(toolInput.soluteID);
+  current.toolSize = toolInput.size;
+  current.aspectRatio = appState.aspectRatio;
+  current.fluidViscosity = appState.fluidViscosity;
+  current.reactionRate = appState.reactionRate;
+  for (unsigned int i = 0; i < current.soluteDiffusivities.size(); i++) {
+    current.soluteDiffusivities[i] = appState.soluteDiffusivities[i];
+  }
+  return current;
+}
+
+std::vector<uint8_t> InputTrace::captureSceneParameters() {
+  // Porosity, feature size, flow speed and seed, then a u32 count and the blobs
+  const AppState& appState = AppState::getInstance();
+  std::vector<uint8_t> payload;
+  writeValue(payload, appState.scenePorosity);
+  writeValue(payload, appState.sceneFeatureSize);
+  writeValue(payload, appState.sceneFlowSpeed);
+  writeValue(payload, static_cast<uint32_t>(appState.sceneSeed));
+  writeValue(payload, static_cast<uint32_t>(appState.sceneBlobs.size()));
+  for (const SoluteBlob& blob : appState.sceneBlobs) {
+    writeValue(payload, static_cast<uint32_t>(blob.soluteID));
+    writeValue(payload, blob.center);
+    writeValue(payload, blob.radius);
+    writeValue(payload, blob.concentration);
+  }
+  return payload;
+}
+
+bool InputTrace::applySceneParameters(const std::vector<uint8_t>& payload) {
+  // Version 1 traces hold no parameters and load the scene with the current ones
+  if (payload.empty()) {
+    return true;
+  }
+  AppState& appState = AppState::getInstance();
+  size_t offset = 0;
+  uint32_t seed = 0, blobCount = 0;
+  bool isValid = readValue(payload, offset, appState.scenePorosity) && readValue(payload, offset, appState.sceneFeatureSize) &&
+                 readValue(payload, offset, appState.sceneFlowSpeed) && readValue(payload, offset, seed) &&
+                 readValue(payload, offset, blobCount);
+  appState.sceneSeed = seed;
+  appState.sceneBlobs.clear();
+  for (uint32_t i = 0; isValid && i < blobCount; i++) {
+    SoluteBlob blob;
+    uint32_t soluteID = 0;
+    isValid = readValue(payload, offset, soluteID) && readValue(payload, offset, blob.center) &&
+              readValue(payload, offset, blob.radius) && readValue(payload, offset, blob.concentration);
+    blob.soluteID = soluteID;
+    appState.sceneBlobs.push_back(blob);
+  }
+  return isValid;
+}
+
+void InputTrace::recordStep(const LBM& lbm) {
+  // The first step stores every field, later steps only what changed
+  StepState current = captureState(lbm);
+  uint16_t mask = stepIndex == 0 ? ALL_FIELDS & ~EVENTS : 0;
+  mask |= current.cursorPos != state.cursorPos ? CURSOR_POS : 0;
+  mask |= current.cursorVel != state.cursorVel ? CURSOR_VEL : 0;
+  mask |= current.flags != state.flags ? FLAGS : 0;
+  mask |= current.activeTool != state.activeTool ? ACTIVE_TOOL : 0;
+  mask |= current.activeSolute != state.activeSolute ? ACTIVE_SOLUTE : 0;
+  mask |= current.toolSize != state.toolSize ? TOOL_SIZE : 0;
+  mask |= current.aspectRatio != state.aspectRatio ? ASPECT_RATIO : 0;
+  mask |= current.fluidViscosity != state.fluidViscosity ? FLUID_VISCOSITY : 0;
+  mask |= current.reactionRate != state.reactionRate ? REACTION_RATE : 0;
+  mask |= current.soluteDiffusivities != state.soluteDiffusivities ? SOLUTE_DIFFUSIVITIES : 0;
+  mask |= pendingEvents.empty() ? 0 : EVENTS;
+
+  std::vector<uint8_t> record;
+  writeValue(record, mask);
+  if (mask & CURSOR_POS) writeValue(record, current.cursorPos);
+  if (mask & CURSOR_VEL) writeValue(record, current.cursorVel);
+  if (mask & FLAGS) writeValue(record, current.flags);
+  if (mask & ACTIVE_TOOL) writeValue(record, current.activeTool);
+  if (mask & ACTIVE_SOLUTE) writeValue(record, current.activeSolute);
+  if (mask & TOOL_SIZE) writeValue(record, current.toolSize);
+  if (mask & ASPECT_RATIO) writeValue(record, current.aspectRatio);
+  if (mask & FLUID_VISCOSITY) writeValue(record, current.fluidViscosity);
+  if (mask & REACTION_RATE) writeValue(record, current.reactionRate);
+  if (mask & SOLUTE_DIFFUSIVITIES) writeValue(record, current.soluteDiffusivities);
+  if (mask & EVENTS) {
+    writeValue(record, static_cast<uint8_t>(pendingEvents.size()));
+    for (const Event& event : pendingEvents) {
+      writeValue(record, event.type);
+      writeValue(record, event.argument);
+      writeValue(record, static_cast<uint16_t>(event.payload.size()));
+      record.insert(record.end(), event.payload.begin(), event.payload.end());
+    }
+  }
+  recordFile.write(reinterpret_cast<const char*>(record.data()), record.size());
+
+  state = current;
+  pendingEvents.clear();
+  stepIndex++;
+  stepCount++;
+}
+
+bool InputTrace::replayStep(LBM& lbm) {
+  if (replayOffset >= replayData.size() || stepIndex >= stepCount) {
+    if (!isLooping || stepIndex == 0) {
+      return false;
+    }
+    replayOffset = replayStart;
+    state = StepState();
+    stepIndex = 0;
+  }
+
+  // Decode the fields that changed, events are applied after the inputs like the UI does
+  uint16_t mask = 0;
+  bool isValid = readValue(replayData, replayOffset, mask);
+  if (isValid && (mask & CURSOR_POS)) isValid = readValue(replayData, replayOffset, state.cursorPos);
+  if (isValid && (mask & CURSOR_VEL)) isValid = readValue(replayData, replayOffset, state.cursorVel);
+  if (isValid && (mask & FLAGS)) isValid = readValue(replayData, replayOffset, state.flags);
+  if (isValid && (mask & ACTIVE_TOOL)) isValid = readValue(replayData, replayOffset, state.activeTool);
+  if (isValid && (mask & ACTIVE_SOLUTE)) isValid = readValue(replayData, replayOffset, state.activeSolute);
+  if (isValid && (mask & TOOL_SIZE)) isValid = readValue(replayData, replayOffset, state.toolSize);
+  if (isValid && (mask & ASPECT_RATIO)) isValid = readValue(replayData, replayOffset, state.aspectRatio);
+  if (isValid && (mask & FLUID_VISCOSITY)) isValid = readValue(replayData, replayOffset, state.fluidViscosity);
+  if (isValid && (mask & REACTION_RATE)) isValid = readValue(replayData, replayOffset, state.reactionRate);
+  if (isValid && (mask & SOLUTE_DIFFUSIVITIES)) isValid = readValue(replayData, replayOffset, state.soluteDiffusivities);
+  std::vector<Event> events;
+  uint8_t eventCount = 0;
+  if (isValid && (mask & EVENTS)) {
+    isValid = readValue(replayData, replayOffset, eventCount);
+    for (uint8_t i = 0; isValid && i < eventCount; i++) {
+      Event event;
+      uint16_t payloadSize = 0;
+      isValid = readValue(replayData, replayOffset, event.type) && readValue(replayData, replayOffset, event.argument) &&
+                (replayVersion < 2 || readValue(replayData, replayOffset, payloadSize)) &&
+                replayOffset + payloadSize <= replayData.size();
+      if (isValid) {
+        event.payload.assign(replayData.begin() + replayOffset, replayData.begin() + replayOffset + payloadSize);
+        replayOffset += payloadSize;
+      }
+      events.push_back(std::move(event));
+    }
+  }
+  if (!isValid || mask > ALL_FIELDS) {
+    std::cerr << "Input trace is truncated or corrupt at step " << stepIndex << std::endl;
+    return false;
+  }
+
+  applyState(lbm);
+  for (const Event& event : events) {
+    switch (event.type) {
+      case TraceEvent::ResetAll:
+        lbm.resetAll();
+        AppState::getInstance().scene = static_cast<SceneType>(event.argument);
+        if (!applySceneParameters(event.payload)) {
+          std::cerr << "Input trace holds corrupt scene parameters at step " << stepIndex << std::endl;
+          break;
+        }
+        loadScene(lbm);
+        break;
+      case TraceEvent::ResetFluid: lbm.resetFluid(); break;
+      case TraceEvent::ResetNodeIDs: lbm.resetNodeIDs(); break;
+      case TraceEvent::ResetSolute:
+        if (event.argument < state.soluteDiffusivities.size()) {
+          lbm.resetSolute(event.argument);
+        }
+        break;
+      case TraceEvent::LoadScene:
+        AppState::getInstance().scene = static_cast<SceneType>(event.argument);
+        if (!applySceneParameters(event.payload)) {
+          std::cerr << "Input trace holds corrupt scene parameters at step " << stepIndex << std::endl;
+          break;
+        }
+        loadScene(lbm);
+        break;
+      case TraceEvent::LoadGeometry: {
+        GeometryOptions options;
+        options.isInverted = event.argument != 0;
+        size_t payloadOffset = 0;
+        std::string error = "The event holds no mask path";
+        if (!readValue(event.payload, payloadOffset, options.rawSize) ||
+            !loadGeometry(lbm, std::string(event.payload.begin() + payloadOffset, event.payload.end()), options, error)) {
+          std::cerr << "Failed to replay the geometry import at step " << stepIndex << ": " << error << std::endl;
+        }
+        break;
+      }
+    }
+  }
+  stepIndex++;
+  return true;
+}
+
+void InputTrace::applyState(LBM& lbm) const {
+  // Every input is reapplied each step, so that UI changes during a replay do not leak into it
+  AppState& appState = AppState::getInstance();
+  appState.cursorPos = state.cursorPos;
+  appState.cursorVel = state.cursorVel;
+  appState.isSimulationFocussed = state.flags & IS_SIMULATION_FOCUSSED;
+  appState.isCursorActive = state.flags & IS_CURSOR_ACTIVE;
+  appState.hasVerticalWalls = state.flags & HAS_VERTICAL_WALLS;
+  appState.hasHorizontalWalls = state.flags & HAS_HORIZONTAL_WALLS;
+  appState.isReactionEnabled = state.flags & IS_REACTION_ENABLED;
+  appState.activeTool = static_cast<ToolType>(state.activeTool);
+  appState.activeSolute = state.activeSolute;
+  appState.toolSize = state.toolSize;
+  appState.aspectRatio = state.aspectRatio;
+
+  // Parameters only reach the solver through their setters
+  if (appState.fluidViscosity != state.fluidViscosity) {
+    appState.fluidViscosity = state.fluidViscosity;
+    lbm.setViscosity(state.fluidViscosity);
+  }
+  if (appState.reactionRate != state.reactionRate) {
+    appState.reactionRate = state.reactionRate;
+    lbm.setReactionRate(state.reactionRate);
+  }
+  for (unsigned int i = 0; i < state.soluteDiffusivities.size(); i++) {
+    if (appState.soluteDiffusivities[i] != state.soluteDiffusivities[i]) {
+      appState.soluteDiffusivities[i] = state.soluteDiffusivities[i];
+      lbm.setSoluteDiffusivity(i, state.soluteDiffusivities[i]);
+    }
+  }
+}
@@ -0,0 +1,120 @@
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "glm.hpp"
+
+namespace fs = std::filesystem;
+
+class LBM;
+struct GeometryOptions;
+
+// Discrete user actions that change the simulation outside of the per-step inputs
+// Events that load a scene carry the scene parameters of the AppState as their payload.
+enum class TraceEvent : uint8_t {
+  ResetAll,    // The argument is the scene type after the reset
+  ResetFluid,
+  ResetNodeIDs,
+  ResetSolute, // The argument is the solute ID
+  LoadScene,   // The argument is the scene type
+  LoadGeometry, // The argument is 1 if the mask is inverted, the payload holds the raw size and the mask path
+};
+
+// Records the AppState inputs that drive the simulation once per step into a compact binary trace and plays them back
+// step for step, so that interactive workloads can be reproduced in benchmarks and validation runs.
+//
+// File layout (little endian): the magic "LBMTRACE", u32 version, u32 lattice width and height, u64 step count,
+// then one record per step: a u16 mask of the fields that changed since the previous step, followed by those fields
+// in mask bit order. Events are stored as a u8 count and (u8 type, u8 argument, u16 payload size, payload) records,
+// version 1 traces have no payloads. An idle step costs two bytes.
+class InputTrace {
+public:
+  static constexpr uint32_t VERSION = 2;
+
+  // InputTrace access method
+  static InputTrace& getInstance() {
+    static InputTrace instance;
+    return instance;
+  }
+
+  // Prevent copying or moving
+  InputTrace(const InputTrace&) = delete;
+  InputTrace& operator=(const InputTrace&) = delete;
+  InputTrace(InputTrace&&) = delete;
+  InputTrace& operator=(InputTrace&&) = delete;
+
+  bool startRecording(const fs::path& path, const glm::ivec2& latticeSize);
+  bool startReplay(const fs::path& path, bool isLooping = false);
+  void stop();
+  bool isRecording() const;
+  bool isReplaying() const;
+
+  // Queues an event for the next recorded step, ignored unless recording
+  void recordEvent(TraceEvent event, uint8_t argument = 0);
+  // Queues a LoadGeometry event, the replay reads the mask again from the same path
+  void recordLoadGeometry(const fs::path& path, const GeometryOptions& options);
+
+  // Call once before every simulation step: records the current inputs or applies the next recorded ones
+  void update(LBM& lbm);
+
+  uint64_t getStepIndex() const;
+  uint64_t getStepCount() const;  // Steps recorded so far or contained in the replayed trace
+  glm::ivec2 getLatticeSize() const; // Lattice the trace was recorded on
+
+private:
+  // Simulation inputs of one step
+  struct StepState {
+    glm::vec2 cursorPos = {0.5f, 0.5f};
+    glm::vec2 cursorVel = {0.f, 0.f};
+    uint8_t flags = 0;
+    uint8_t activeTool = 0;
+    uint8_t activeSolute = 0;
+    float toolSize = 0.f;
+    glm::vec2 aspectRatio = {1.f, 1.f};
+    float fluidViscosity = 0.f;
+    float reactionRate = 0.f;
+    std::array<float, 3> soluteDiffusivities = {0.f, 0.f, 0.f};
+  };
+
+  struct Event {
+    TraceEvent type;
+    uint8_t argument;
+    std::vector<uint8_t> payload;
+  };
+
+  enum Mode {
+    Idle,
+    Recording,
+    Replaying,
+  };
+
+  Mode mode = Idle;
+  bool isLooping = false;
+  std::ofstream recordFile;
+  std::vector<uint8_t> replayData;
+  uint32_t replayVersion = VERSION;
+  size_t replayOffset = 0;
+  size_t replayStart = 0; // Offset of the first step record
+  StepState state;        // Last recorded or replayed inputs
+  std::vector<Event> pendingEvents;
+  uint64_t stepIndex = 0;
+  uint64_t stepCount = 0;
+  glm::ivec2 latticeSize = {0, 0};
+
+  InputTrace() = default;
+
+  static StepState captureState(const LBM& lbm);
+  static std::vector<uint8_t> captureSceneParameters();
+  static bool applySceneParameters(const std::vector<uint8_t>& payload);
+  void recordStep(const LBM& lbm);
+  bool replayStep(LBM& lbm);
+  void applyState(LBM& lbm) const;
+};
+
+#endif // INPUT_TRACE_H
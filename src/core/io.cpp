@@ -1,10 +1,190 @@
 #include "io.h"
 
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h" 
 
+namespace {
+
+// zlib stream of a single deflate block with the fixed Huffman codes, whose matches are found through hash chains
+// over the last 32 KiB. It compresses rendered images well at a fraction of the cost of a full deflate encoder.
+class DeflateEncoder {
+public:
+  std::vector<uint8_t> compress(const std::vector<uint8_t>& data) {
+    static const int LENGTH_BASES[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+                                       131, 163, 195, 227, 258};
+    static const int LENGTH_EXTRA_BITS[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const int DISTANCE_BASES[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+                                         2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static const int DISTANCE_EXTRA_BITS[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    output.clear();
+    output.push_back(0x78); // Deflate with a 32 KiB window
+    output.push_back(0x01); // No preset dictionary, fastest compression level
+    writeBits(3, 3);        // Final block, fixed Huffman codes
+
+    const int size = static_cast<int>(data.size());
+    std::vector<int> head(HASH_SIZE, -1);
+    std::vector<int> previous(WINDOW_SIZE, -1);
+    auto insert = [&](int position) {
+      if (position + MIN_MATCH <= size) {
+        unsigned int hash = getHash(&data[position]);
+        previous[position % WINDOW_SIZE] = head[hash];
+        head[hash] = position;
+      }
+    };
+    for (int position = 0; position < size;) {
+      // Find the longest match among the latest positions with the same hash
+      int bestLength = 0;
+      int bestDistance = 0;
+      if (position + MIN_MATCH <= size) {
+        const int maxLength = std::min(MAX_MATCH, size - position);
+        int candidate = head[getHash(&data[position])];
+        for (int chain = 0; chain < MAX_CHAIN && candidate >= 0 && position - candidate <= WINDOW_SIZE; chain++) {
+          int length = 0;
+          while (length < maxLength && data[candidate + length] == data[position + length]) {
+            length++;
+          }
+          if (length > bestLength) {
+            bestLength = length;
+            bestDistance = position - candidate;
+            if (length == maxLength) {
+              break;
+            }
+          }
+          candidate = previous[candidate % WINDOW_SIZE];
+        }
+      }
+
+      if (bestLength < MIN_MATCH) {
+        writeSymbol(data[position]);
+        insert(position++);
+        continue;
+      }
+      int lengthCode = 0;
+      while (lengthCode < 28 && LENGTH_BASES[lengthCode + 1] <= bestLength) {
+        lengthCode++;
+      }
+      writeSymbol(257 + lengthCode);
+      writeBits(bestLength - LENGTH_BASES[lengthCode], LENGTH_EXTRA_BITS[lengthCode]);
+      int distanceCode = 0;
+      while (distanceCode < 29 && DISTANCE_BASES[distanceCode + 1] <= bestDistance) {
+        distanceCode++;
+      }
+      writeCode(distanceCode, 5);
+      writeBits(bestDistance - DISTANCE_BASES[distanceCode], DISTANCE_EXTRA_BITS[distanceCode]);
+      for (int i = 0; i < bestLength; i++) {
+        insert(position++);
+      }
+    }
+    writeSymbol(256); // End of block
+    if (bitCount > 0) {
+      output.push_back(static_cast<uint8_t>(bitBuffer));
+    }
+    bitBuffer = 0;
+    bitCount = 0;
+
+    // Adler-32 checksum of the uncompressed data, big endian
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : data) {
+      a = (a + byte) % 65521;
+      b = (b + a) % 65521;
+    }
+    const uint32_t checksum = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      output.push_back(static_cast<uint8_t>(checksum >> shift));
+    }
+    return std::move(output);
+  }
+
+private:
+  static constexpr int WINDOW_SIZE = 32768;
+  static constexpr int HASH_SIZE = 1 << 15;
+  static constexpr int MIN_MATCH = 3;
+  static constexpr int MAX_MATCH = 258;
+  static constexpr int MAX_CHAIN = 32; // Candidates compared per position
+
+  std::vector<uint8_t> output;
+  uint32_t bitBuffer = 0;
+  int bitCount = 0;
+
+  static unsigned int getHash(const uint8_t* bytes) {
+    return ((bytes[0] << 16 | bytes[1] << 8 | bytes[2]) * 2654435761u) >> (32 - 15);
+  }
+
+  // Deflate packs values from the least significant bit up
+  void writeBits(uint32_t value, int count) {
+    bitBuffer |= value << bitCount;
+    bitCount += count;
+    while (bitCount >= 8) {
+      output.push_back(static_cast<uint8_t>(bitBuffer));
+      bitBuffer >>= 8;
+      bitCount -= 8;
+    }
+  }
+
+  // Huffman codes are packed from their most significant bit
+  void writeCode(uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+      reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    writeBits(reversed, length);
+  }
+
+  // Literal, end of block or length symbol with its fixed Huffman code
+  void writeSymbol(int symbol) {
+    if (symbol < 144) {
+      writeCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+      writeCode(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+      writeCode(symbol - 256, 7);
+    } else {
+      writeCode(0xC0 + symbol - 280, 8);
+    }
+  }
+};
+
+uint32_t getCRC(const uint8_t* bytes, size_t size, uint32_t crc = 0) {
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> values;
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t value = i;
+      for (int bit = 0; bit < 8; bit++) {
+        value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+      }
+      values[i] = value;
+    }
+    return values;
+  }();
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+void writePNGChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data) {
+  auto writeU32 = [&](uint32_t value) {
+    const char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16), static_cast<char>(value >> 8),
+                           static_cast<char>(value)};
+    file.write(bytes, 4);
+  };
+  writeU32(static_cast<uint32_t>(data.size()));
+  file.write(type, 4);
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  writeU32(getCRC(data.data(), data.size(), getCRC(reinterpret_cast<const uint8_t*>(type), 4)));
+}
+
+} // namespace
+
 fs::path getExecutablePath() {
 #if defined(_WIN32)
   char path[MAX_PATH];
@@ -45,3 +225,94 @@ ImTextureID loadPNG(const fs::path& imagePath) {
   stbi_image_free(imageData);
   return reinterpret_cast<void*>(static_cast<intptr_t>(textureID));
 }
+
+bool loadLuminance(const fs::path& imagePath, int& width, int& height, std::vector<uint8_t>& pixels, std::string& error) {
+  int channels;
+  unsigned char* imageData = stbi_load(imagePath.string().c_str(), &width, &height, &channels, STBI_grey_alpha);
+  if (!imageData) {
+    error = "Failed to load " + imagePath.string() + ": " + stbi_failure_reason();
+    return false;
+  }
+
+  // Composite over white
+  pixels.resize(static_cast<size_t>(width) * height);
+  for (size_t i = 0; i < pixels.size(); i++) {
+    const int grey = imageData[2 * i];
+    const int alpha = imageData[2 * i + 1];
+    pixels[i] = static_cast<uint8_t>(255 - (255 - grey) * alpha / 255);
+  }
+  stbi_image_free(imageData);
+  return true;
+}
+
+bool writePNG(const fs::path& imagePath, int width, int height, const uint8_t* pixels, std::string& error) {
+  // Filter every row with the PNG filter that leaves the smallest residuals, which suits the smooth gradients of the
+  // rendered fields, and prefix it with the filter type
+  const int BYTES_PER_PIXEL = 4;
+  const size_t rowSize = static_cast<size_t>(width) * BYTES_PER_PIXEL;
+  std::vector<uint8_t> filtered((rowSize + 1) * height);
+  std::vector<uint8_t> candidate(rowSize);
+  const std::vector<uint8_t> zeroRow(rowSize, 0);
+  for (int y = 0; y < height; y++) {
+    const uint8_t* row = pixels + y * rowSize;
+    const uint8_t* above = (y > 0) ? row - rowSize : zeroRow.data();
+    uint8_t* output = &filtered[y * (rowSize + 1)];
+    unsigned long bestCost = ~0ul;
+    for (uint8_t filter = 0; filter < 5; filter++) {
+      unsigned long cost = 0;
+      for (size_t i = 0; i < rowSize; i++) {
+        const int left = (i >= BYTES_PER_PIXEL) ? row[i - BYTES_PER_PIXEL] : 0;
+        const int up = above[i];
+        const int upLeft = (i >= BYTES_PER_PIXEL) ? above[i - BYTES_PER_PIXEL] : 0;
+        int prediction = 0;
+        if (filter == 1) {
+          prediction = left;
+        } else if (filter == 2) {
+          prediction = up;
+        } else if (filter == 3) {
+          prediction = (left + up) / 2;
+        } else if (filter == 4) {
+          const int estimate = left + up - upLeft;
+          const int leftDistance = std::abs(estimate - left);
+          const int upDistance = std::abs(estimate - up);
+          const int upLeftDistance = std::abs(estimate - upLeft);
+          prediction = (leftDistance <= upDistance && leftDistance <= upLeftDistance) ? left
+                     : (upDistance <= upLeftDistance)                              ? up
+                                                                                   : upLeft;
+        }
+        candidate[i] = static_cast<uint8_t>(row[i] - prediction);
+        cost += std::abs(static_cast<int8_t>(candidate[i]));
+      }
+      if (cost < bestCost) {
+        bestCost = cost;
+        output[0] = filter;
+        std::copy(candidate.begin(), candidate.end(), output + 1);
+      }
+    }
+  }
+
+  // 8-bit RGBA without interlacing
+  std::vector<uint8_t> header(13, 0);
+  for (int i = 0; i < 4; i++) {
+    header[i] = static_cast<uint8_t>(width >> (24 - 8 * i));
+    header[4 + i] = static_cast<uint8_t>(height >> (24 - 8 * i));
+  }
+  header[8] = 8;
+  header[9] = 6;
+
+  std::ofstream file(imagePath, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    error = "Failed to open " + imagePath.string();
+    return false;
+  }
+  const char SIGNATURE[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1A', '\n'};
+  file.write(SIGNATURE, sizeof(SIGNATURE));
+  writePNGChunk(file, "IHDR", header);
+  writePNGChunk(file, "IDAT", DeflateEncoder().compress(filtered));
+  writePNGChunk(file, "IEND", {});
+  if (!file) {
+    error = "Failed to write " + imagePath.string();
+    return false;
+  }
+  return true;
+}
@@ -1,4 +1,7 @@
+#include <cstdint>
 #include <filesystem>
+#include <string>
+#include <vector>
 #if defined(_WIN32)
   #define NOMINMAX
   #include <windows.h>
@@ -17,3 +20,7 @@ namespace fs = std::filesystem;
 
 fs::path getExecutablePath();
 ImTextureID loadPNG(const fs::path& imagePath);
+// Loads any image stb_image reads (PNG, binary PGM, ...) as 8-bit luminance row by row from the top, transparent pixels are white
+bool loadLuminance(const fs::path& imagePath, int& width, int& height, std::vector<uint8_t>& pixels, std::string& error);
+// Encodes 8-bit RGBA pixels, given row by row from the top, as a PNG file
+bool writePNG(const fs::path& imagePath, int width, int height, const uint8_t* pixels, std::string& error);
@@ -0,0 +1,253 @@
+#include "json.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Recursive descent parser over the whole text
+class JsonParser {
+public:
+  JsonParser(const std::string& text) : text(text) {}
+
+  bool parse(JsonValue& value, std::string& error) {
+    if (!parseValue(value, 0)) {
+      error = this->error;
+      return false;
+    }
+    skipWhitespace();
+    if (position != text.size()) {
+      error = "Unexpected trailing characters at offset " + std::to_string(position);
+      return false;
+    }
+    return true;
+  }
+
+private:
+  static constexpr unsigned int MAX_DEPTH = 64;
+
+  const std::string& text;
+  size_t position = 0;
+  std::string error;
+
+  bool fail(const std::string& message) {
+    error = message + " at offset " + std::to_string(position);
+    return false;
+  }
+
+  void skipWhitespace() {
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) {
+      position++;
+    }
+  }
+
+  bool consumeLiteral(const char* literal) {
+    size_t length = std::char_traits<char>::length(literal);
+    if (text.compare(position, length, literal) != 0) {
+      return false;
+    }
+    position += length;
+    return true;
+  }
+
+  bool parseValue(JsonValue& value, unsigned int depth) {
+    if (depth > MAX_DEPTH) {
+      return fail("Nesting too deep");
+    }
+    skipWhitespace();
+    if (position >= text.size()) {
+      return fail("Unexpected end of input");
+    }
+    char c = text[position];
+    if (c == '{') {
+      return parseObject(value, depth);
+    } else if (c == '[') {
+      return parseArray(value, depth);
+    } else if (c == '"') {
+      value.type = JsonValue::Type::String;
+      return parseString(value.string);
+    } else if (consumeLiteral("true")) {
+      value.type = JsonValue::Type::Bool;
+      value.boolean = true;
+      return true;
+    } else if (consumeLiteral("false")) {
+      value.type = JsonValue::Type::Bool;
+      value.boolean = false;
+      return true;
+    } else if (consumeLiteral("null")) {
+      value.type = JsonValue::Type::Null;
+      return true;
+    }
+    return parseNumber(value);
+  }
+
+  bool parseObject(JsonValue& value, unsigned int depth) {
+    value.type = JsonValue::Type::Object;
+    position++; // Opening brace
+    skipWhitespace();
+    if (position < text.size() && text[position] == '}') {
+      position++;
+      return true;
+    }
+    while (true) {
+      skipWhitespace();
+      if (position >= text.size() || text[position] != '"') {
+        return fail("Expected member name");
+      }
+      std::string key;
+      if (!parseString(key)) {
+        return false;
+      }
+      skipWhitespace();
+      if (position >= text.size() || text[position] != ':') {
+        return fail("Expected ':'");
+      }
+      position++;
+      value.members.emplace_back(std::move(key), JsonValue());
+      if (!parseValue(value.members.back().second, depth + 1)) {
+        return false;
+      }
+      skipWhitespace();
+      if (position < text.size() && text[position] == ',') {
+        position++;
+      } else if (position < text.size() && text[position] == '}') {
+        position++;
+        return true;
+      } else {
+        return fail("Expected ',' or '}'");
+      }
+    }
+  }
+
+  bool parseArray(JsonValue& value, unsigned int depth) {
+    value.type = JsonValue::Type::Array;
+    position++; // Opening bracket
+    skipWhitespace();
+    if (position < text.size() && text[position] == ']') {
+      position++;
+      return true;
+    }
+    while (true) {
+      value.array.emplace_back();
+      if (!parseValue(value.array.back(), depth + 1)) {
+        return false;
+      }
+      skipWhitespace();
+      if (position < text.size() && text[position] == ',') {
+        position++;
+      } else if (position < text.size() && text[position] == ']') {
+        position++;
+        return true;
+      } else {
+        return fail("Expected ',' or ']'");
+      }
+    }
+  }
+
+  bool parseString(std::string& string) {
+    position++; // Opening quote
+    while (position < text.size()) {
+      char c = text[position++];
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        string += c;
+        continue;
+      }
+      if (position >= text.size()) {
+        break;
+      }
+      char escape = text[position++];
+      switch (escape) {
+        case '"': string += '"'; break;
+        case '\\': string += '\\'; break;
+        case '/': string += '/'; break;
+        case 'b': string += '\b'; break;
+        case 'f': string += '\f'; break;
+        case 'n': string += '\n'; break;
+        case 'r': string += '\r'; break;
+        case 't': string += '\t'; break;
+        case 'u': {
+          // Basic multilingual plane only, encoded as UTF-8
+          if (position + 4 > text.size()) {
+            return fail("Incomplete unicode escape");
+          }
+          unsigned long codePoint = std::strtoul(text.substr(position, 4).c_str(), nullptr, 16);
+          position += 4;
+          if (codePoint < 0x80) {
+            string += static_cast<char>(codePoint);
+          } else if (codePoint < 0x800) {
+            string += static_cast<char>(0xC0 | (codePoint >> 6));
+            string += static_cast<char>(0x80 | (codePoint & 0x3F));
+          } else {
+            string += static_cast<char>(0xE0 | (codePoint >> 12));
+            string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            string += static_cast<char>(0x80 | (codePoint & 0x3F));
+          }
+          break;
+        }
+        default:
+          return fail("Invalid escape sequence");
+      }
+    }
+    return fail("Unterminated string");
+  }
+
+  bool parseNumber(JsonValue& value) {
+    const char* start = text.c_str() + position;
+    char* end = nullptr;
+    double number = std::strtod(start, &end);
+    if (end == start) {
+      return fail("Unexpected character");
+    }
+    position += end - start;
+    value.type = JsonValue::Type::Number;
+    value.number = number;
+    return true;
+  }
+};
+
+} // namespace
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+  for (const auto& member : members) {
+    if (member.first == key) {
+      return &member.second;
+    }
+  }
+  return nullptr;
+}
+
+double JsonValue::getNumber(const std::string& key, double fallback) const {
+  const JsonValue* member = find(key);
+  return (member && member->isNumber()) ? member->number : fallback;
+}
+
+bool JsonValue::getBool(const std::string& key, bool fallback) const {
+  const JsonValue* member = find(key);
+  return (member && member->isBool()) ? member->boolean : fallback;
+}
+
+std::string JsonValue::getString(const std::string& key, const std::string& fallback) const {
+  const JsonValue* member = find(key);
+  return (member && member->isString()) ? member->string : fallback;
+}
+
+bool parseJSON(const std::string& text, JsonValue& value, std::string& error) {
+  value = JsonValue();
+  JsonParser parser(text);
+  return parser.parse(value, error);
+}
+
+bool readJSONFile(const fs::path& path, JsonValue& value, std::string& error) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    error = "Failed to open " + path.string();
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return parseJSON(buffer.str(), value, error);
+}
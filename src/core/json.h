@@ -0,0 +1,50 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Minimal JSON document model and reader for the files the tools write and read back
+// (benchmark baselines, configuration). Numbers are parsed as doubles and object members keep their order.
+struct JsonValue {
+  enum class Type {
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object,
+  };
+
+  Type type = Type::Null;
+  bool boolean = false;
+  double number = 0.;
+  std::string string;
+  std::vector<JsonValue> array;
+  std::vector<std::pair<std::string, JsonValue>> members;
+
+  bool isNull() const { return type == Type::Null; }
+  bool isBool() const { return type == Type::Bool; }
+  bool isNumber() const { return type == Type::Number; }
+  bool isString() const { return type == Type::String; }
+  bool isArray() const { return type == Type::Array; }
+  bool isObject() const { return type == Type::Object; }
+
+  // Returns the member with the given key, or nullptr if this is not an object or has no such member
+  const JsonValue* find(const std::string& key) const;
+
+  // Typed member access, falling back if the member is missing or of another type
+  double getNumber(const std::string& key, double fallback) const;
+  bool getBool(const std::string& key, bool fallback) const;
+  std::string getString(const std::string& key, const std::string& fallback) const;
+};
+
+// Parses a complete JSON text, on failure error describes the first problem and its byte offset
+bool parseJSON(const std::string& text, JsonValue& value, std::string& error);
+bool readJSONFile(const fs::path& path, JsonValue& value, std::string& error);
+
+#endif // JSON_H
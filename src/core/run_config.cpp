@@ -0,0 +1,451 @@
+#include "core/run_config.h"
+
+#include <cctype>
+#include <cmath>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/app_state.h"
+#include "core/frame_capture.h"
+#include "core/headless.h"
+#include "core/input_trace.h"
+#include "core/json.h"
+#include "gl/gl_extensions.h"
+#include "lbm/field_publisher.h"
+#include "lbm/field_writer.h"
+#include "lbm/geometry.h"
+#include "lbm/lbm.h"
+#include "lbm/scene.h"
+
+namespace {
+
+const char* const USAGE =
+  "Usage: lbm [CONFIG.json] [--config PATH] [--headless | --gui] [--backend auto|fragment|compute|inplace]\n"
+  "           [--steps N] [--report-interval N] [--width N] [--height N]\n"
+  "           [--scene blobs|cylinder|cavity|porous|channels|mixing] [--porosity F] [--feature-size F] [--flow-speed F]\n"
+  "           [--seed N] [--blobs JSON] [--geometry PATH] [--invert-geometry BOOL]\n"
+  "           [--viscosity F] [--diffusivities F|[F, F, F]] [--steps-per-frame N]\n"
+  "           [--reaction BOOL] [--reaction-rate F] [--molar-masses [F, F, F]] [--stoichiometric-coeffs [N, N, N]]\n"
+  "           [--field-output PATH] [--shared-fields NAME] [--field-interval N] [--field-stride N] [--field-mask N]\n"
+  "           [--field-region [X, Y, W, H]] [--field-error-bound F] [--capture-directory PATH] [--capture-command CMD]\n"
+  "           [--capture-interval N] [--auto-checkpoint BOOL] [--auto-checkpoint-interval N] [--auto-checkpoint-threshold F]\n"
+  "           [--checkpoint PATH] [--steering-socket PATH] [--replay PATH]\n";
+
+const unsigned int SOLUTE_COUNT = 3;
+const int MAX_LATTICE_SIZE = 16384;
+
+// --steps-per-frame to stepsPerFrame
+std::string getKey(const std::string& flag) {
+  std::string key;
+  bool isWordStart = false;
+  for (char c : flag) {
+    if (c == '-') {
+      isWordStart = true;
+    } else {
+      key += isWordStart ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+      isWordStart = false;
+    }
+  }
+  return key;
+}
+
+bool readNumber(const std::string& key, const JsonValue& value, double min, double max, double& number, std::string& error) {
+  if (!value.isNumber() || !(value.number >= min && value.number <= max)) {
+    std::ostringstream message;
+    message << key << " must be a number between " << min << " and " << max;
+    error = message.str();
+    return false;
+  }
+  number = value.number;
+  return true;
+}
+
+template <typename T>
+bool readInteger(const std::string& key, const JsonValue& value, double min, double max, T& integer, std::string& error) {
+  double number;
+  if (!readNumber(key, value, min, max, number, error)) {
+    return false;
+  }
+  if (number != std::floor(number)) {
+    error = key + " must be an integer";
+    return false;
+  }
+  integer = static_cast<T>(number);
+  return true;
+}
+
+bool readFloat(const std::string& key, const JsonValue& value, double min, double max, GLfloat& result, std::string& error) {
+  double number;
+  if (!readNumber(key, value, min, max, number, error)) {
+    return false;
+  }
+  result = static_cast<GLfloat>(number);
+  return true;
+}
+
+bool readBool(const std::string& key, const JsonValue& value, bool& result, std::string& error) {
+  if (!value.isBool()) {
+    error = key + " must be true or false";
+    return false;
+  }
+  result = value.boolean;
+  return true;
+}
+
+bool readString(const std::string& key, const JsonValue& value, std::string& result, std::string& error) {
+  if (!value.isString()) {
+    error = key + " must be a string";
+    return false;
+  }
+  result = value.string;
+  return true;
+}
+
+// One value per solute, a single number applies to all of them
+template <typename T>
+bool readPerSolute(const std::string& key, const JsonValue& value, double min, double max, std::vector<T>& result,
+                   std::string& error) {
+  std::vector<JsonValue> elements = value.isArray() ? value.array : std::vector<JsonValue>(SOLUTE_COUNT, value);
+  if (elements.size() != SOLUTE_COUNT) {
+    error = key + " must have " + std::to_string(SOLUTE_COUNT) + " elements";
+    return false;
+  }
+  result.resize(SOLUTE_COUNT);
+  for (unsigned int i = 0; i < SOLUTE_COUNT; i++) {
+    if constexpr (std::is_integral_v<T>) {
+      if (!readInteger(key, elements[i], min, max, result[i], error)) {
+        return false;
+      }
+    } else if (!readFloat(key, elements[i], min, max, result[i], error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool readBlobs(const std::string& key, const JsonValue& value, std::vector<SoluteBlob>& blobs, std::string& error) {
+  // [{"solute": 1, "center": [0.4, 0.4], "radius": 0.2, "concentration": 1}, ...] with solutes numbered from 1
+  if (!value.isArray()) {
+    error = key + " must be an array of blobs";
+    return false;
+  }
+  blobs.clear();
+  for (const JsonValue& element : value.array) {
+    const JsonValue* solute = element.find("solute");
+    const JsonValue* center = element.find("center");
+    const JsonValue* radius = element.find("radius");
+    const JsonValue* concentration = element.find("concentration");
+    SoluteBlob blob = {0, {0.5f, 0.5f}, 0.2f, 1.f};
+    if (solute == nullptr || center == nullptr || !center->isArray() || center->array.size() != 2) {
+      error = key + " must have a solute and a center [x, y] in every blob";
+      return false;
+    }
+    if (!readInteger(key + " solute", *solute, 1, SOLUTE_COUNT, blob.soluteID, error) ||
+        !readFloat(key + " center", center->array[0], -1., 2., blob.center.x, error) ||
+        !readFloat(key + " center", center->array[1], -1., 2., blob.center.y, error) ||
+        (radius != nullptr && !readFloat(key + " radius", *radius, 0., 2., blob.radius, error)) ||
+        (concentration != nullptr && !readFloat(key + " concentration", *concentration, 0., 1e3, blob.concentration, error))) {
+      return false;
+    }
+    blob.soluteID--;
+    blobs.push_back(blob);
+  }
+  return true;
+}
+
+bool applyMember(const std::string& key, const JsonValue& value, RunConfig& config, std::string& error) {
+  AppState& appState = AppState::getInstance();
+  SimulationDefaults& defaults = appState.defaults;
+  std::string text;
+
+  // Run
+  if (key == "mode") {
+    if (!readString(key, value, text, error)) {
+      return false;
+    }
+    if (text != "gui" && text != "headless") {
+      error = "mode must be gui or headless";
+      return false;
+    }
+    config.isHeadless = text == "headless";
+    return true;
+  }
+  if (key == "headless") {
+    return readBool(key, value, config.isHeadless, error);
+  }
+  if (key == "backend") {
+    SolverBackend backend;
+    if (!readString(key, value, text, error)) {
+      return false;
+    }
+    if (text != "auto" && !parseBackendName(text, backend)) {
+      error = "Unknown backend: " + text;
+      return false;
+    }
+    config.backend = text;
+    return true;
+  }
+  if (key == "steps") {
+    return readInteger(key, value, 0., 1e15, config.steps, error);
+  }
+  if (key == "reportInterval") {
+    return readInteger(key, value, 0., 1e15, config.reportInterval, error);
+  }
+
+  // Lattice and scene
+  if (key == "width") {
+    return readInteger(key, value, 16., MAX_LATTICE_SIZE, appState.latticeSize.x, error);
+  }
+  if (key == "height") {
+    return readInteger(key, value, 16., MAX_LATTICE_SIZE, appState.latticeSize.y, error);
+  }
+  if (key == "scene") {
+    if (!readString(key, value, text, error)) {
+      return false;
+    }
+    if (!parseSceneName(text, appState.scene)) {
+      error = "Unknown scene: " + text;
+      return false;
+    }
+    return true;
+  }
+  if (key == "porosity") {
+    return readFloat(key, value, 0.1, 1., appState.scenePorosity, error);
+  }
+  if (key == "featureSize") {
+    return readFloat(key, value, 0.02, 0.5, appState.sceneFeatureSize, error);
+  }
+  if (key == "flowSpeed") {
+    return readFloat(key, value, 0., SPEED_OF_SOUND, appState.sceneFlowSpeed, error);
+  }
+  if (key == "seed") {
+    return readInteger(key, value, 0., 4294967295., appState.sceneSeed, error);
+  }
+  if (key == "blobs") {
+    return readBlobs(key, value, appState.sceneBlobs, error);
+  }
+  if (key == "geometry") {
+    return readString(key, value, config.geometryPath, error);
+  }
+  if (key == "invertGeometry") {
+    return readBool(key, value, config.isGeometryInverted, error);
+  }
+
+  // Simulation parameters
+  if (key == "viscosity") {
+    return readFloat(key, value, 1e-6, 10., defaults.fluidViscosity, error);
+  }
+  if (key == "diffusivities") {
+    return readPerSolute(key, value, 1e-6, 10., defaults.soluteDiffusivities, error);
+  }
+  if (key == "stepsPerFrame") {
+    return readInteger(key, value, 1., 10000., defaults.stepsPerFrame, error);
+  }
+  if (key == "reaction") {
+    return readBool(key, value, defaults.isReactionEnabled, error);
+  }
+  if (key == "reactionRate") {
+    return readFloat(key, value, 0., 1e3, defaults.reactionRate, error);
+  }
+  if (key == "molarMasses") {
+    return readPerSolute(key, value, 1e-6, 1e6, appState.reactionMolarMasses, error);
+  }
+  if (key == "stoichiometricCoeffs") {
+    return readPerSolute(key, value, -100., 100., appState.reactionStoichiometricCoeffs, error);
+  }
+
+  // Outputs
+  if (key == "fieldOutput") {
+    return readString(key, value, config.fieldOutputPath, error);
+  }
+  if (key == "sharedFields") {
+    return readString(key, value, config.sharedFieldsName, error);
+  }
+  if (key == "steeringSocket") {
+    return readString(key, value, config.steeringSocket, error);
+  }
+  if (key == "replay") {
+    return readString(key, value, config.replayPath, error);
+  }
+  if (key == "fieldInterval") {
+    return readInteger(key, value, 1., 4294967295., appState.fieldOutputInterval, error);
+  }
+  if (key == "fieldStride") {
+    return readInteger(key, value, 1., MAX_LATTICE_SIZE, appState.fieldOutputStride, error);
+  }
+  if (key == "fieldMask") {
+    return readInteger(key, value, 1., 63., appState.fieldOutputMask, error);
+  }
+  if (key == "fieldRegion") {
+    if (!value.isArray() || value.array.size() != 4) {
+      error = key + " must be [x, y, width, height]";
+      return false;
+    }
+    for (int i = 0; i < 4; i++) {
+      if (!readInteger(key, value.array[i], 0., MAX_LATTICE_SIZE, appState.fieldOutputRegion[i], error)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (key == "fieldErrorBound") {
+    return readFloat(key, value, 0., 1e6, appState.fieldOutputErrorBound, error);
+  }
+  if (key == "captureDirectory") {
+    return readString(key, value, config.captureDirectory, error);
+  }
+  if (key == "captureCommand") {
+    return readString(key, value, config.captureCommand, error);
+  }
+  if (key == "captureInterval") {
+    return readInteger(key, value, 1., 4294967295., appState.captureInterval, error);
+  }
+  if (key == "autoCheckpoint") {
+    return readBool(key, value, appState.isAutoCheckpointEnabled, error);
+  }
+  if (key == "autoCheckpointInterval") {
+    return readInteger(key, value, 1., 4294967295., appState.autoCheckpointInterval, error);
+  }
+  if (key == "autoCheckpointThreshold") {
+    return readFloat(key, value, 0., 1e3, appState.autoCheckpointThreshold, error);
+  }
+  if (key == "checkpoint") {
+    return readString(key, value, config.checkpointPath, error);
+  }
+
+  error = "Unknown setting: " + key;
+  return false;
+}
+
+} // namespace
+
+bool parseRunConfig(int argc, char** argv, RunConfig& config, std::string& error) {
+  // Collect the flags first, so that they override the file wherever they appear
+  std::string configPath;
+  std::vector<std::pair<std::string, JsonValue>> overrides;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    JsonValue value;
+    if (arg == "--help" || arg == "-h") {
+      error.clear();
+      return false;
+    } else if (arg == "--headless" || arg == "--gui") {
+      value.type = JsonValue::Type::Bool;
+      value.boolean = arg == "--headless";
+      overrides.emplace_back("headless", value);
+    } else if (arg == "--config" && hasValue) {
+      configPath = argv[++i];
+    } else if (arg.rfind("--", 0) == 0 && arg.size() > 2 && hasValue) {
+      std::string parseError;
+      if (!parseJSON(argv[++i], value, parseError)) {
+        value = JsonValue();
+        value.type = JsonValue::Type::String;
+        value.string = argv[i];
+      }
+      overrides.emplace_back(getKey(arg.substr(2)), value);
+    } else if (arg[0] != '-' && configPath.empty()) {
+      configPath = arg;
+    } else {
+      error = "Unknown or incomplete argument: " + arg;
+      return false;
+    }
+  }
+
+  if (!configPath.empty()) {
+    JsonValue file;
+    if (!readJSONFile(configPath, file, error)) {
+      error = "Failed to read " + configPath + ": " + error;
+      return false;
+    }
+    if (!file.isObject()) {
+      error = configPath + " must hold a JSON object";
+      return false;
+    }
+    for (const auto& [key, value] : file.members) {
+      if (!applyMember(key, value, config, error)) {
+        error = configPath + ": " + error;
+        return false;
+      }
+    }
+  }
+  for (const auto& [key, value] : overrides) {
+    if (!applyMember(key, value, config, error)) {
+      return false;
+    }
+  }
+
+  if (!config.captureDirectory.empty() && !config.captureCommand.empty()) {
+    error = "Frames can be captured to captureDirectory or captureCommand, not both";
+    return false;
+  }
+
+  // Start from the configured parameters
+  AppState::getInstance().reset();
+  return true;
+}
+
+const char* getRunConfigUsage() {
+  return USAGE;
+}
+
+bool selectBackend(const RunConfig& config, std::string& error) {
+  // Prefer the in-place compute backend where available, as it needs a single copy of the distributions
+  AppState& appState = AppState::getInstance();
+  if (config.backend == "auto") {
+    appState.solverBackend = hasGLVersion(4, 3) ? SolverBackend::InPlaceComputeShader : SolverBackend::FragmentShader;
+    return true;
+  }
+  SolverBackend backend;
+  if (!parseBackendName(config.backend, backend)) {
+    error = "Unknown backend: " + config.backend;
+    return false;
+  }
+  if (backend != SolverBackend::FragmentShader && !hasGLVersion(4, 3)) {
+    error = "The " + config.backend + " backend requires OpenGL 4.3";
+    return false;
+  }
+  appState.solverBackend = backend;
+  return true;
+}
+
+bool startRun(const RunConfig& config, LBM& lbm, FieldWriter& fieldWriter, FieldPublisher& fieldPublisher, FrameCapture& frameCapture,
+              std::string& error) {
+  loadScene(lbm);
+  if (!config.geometryPath.empty()) {
+    GeometryOptions options;
+    options.isInverted = config.isGeometryInverted;
+    if (!loadGeometry(lbm, config.geometryPath, options, error)) {
+      return false;
+    }
+  }
+  if (!config.fieldOutputPath.empty() && !fieldWriter.start(config.fieldOutputPath, error)) {
+    return false;
+  }
+  if (!config.sharedFieldsName.empty() && !fieldPublisher.start(config.sharedFieldsName, error)) {
+    return false;
+  }
+  if (!config.captureDirectory.empty() && !frameCapture.startImages(config.captureDirectory, error)) {
+    return false;
+  }
+  if (!config.captureCommand.empty() && !frameCapture.startPipe(config.captureCommand, error)) {
+    return false;
+  }
+
+  // The trace only reproduces the run on the lattice it was recorded on
+  if (!config.replayPath.empty()) {
+    InputTrace& inputTrace = InputTrace::getInstance();
+    if (!inputTrace.startReplay(config.replayPath)) {
+      error = "Failed to replay the input trace " + config.replayPath;
+      return false;
+    }
+    if (inputTrace.getLatticeSize() != lbm.getLatticeSize()) {
+      inputTrace.stop();
+      error = "The input trace " + config.replayPath + " was recorded on a different lattice size";
+      return false;
+    }
+  }
+  return true;
+}
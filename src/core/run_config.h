@@ -0,0 +1,46 @@
+#ifndef RUN_CONFIG_H
+#define RUN_CONFIG_H
+
+#include <cstdint>
+#include <string>
+
+class FieldPublisher;
+class FieldWriter;
+class FrameCapture;
+class LBM;
+
+// Settings of a run, read from a JSON configuration file and overridden by command-line flags.
+// Every member of the configuration object can also be given as a flag spelling its key in kebab case, so that
+// "stepsPerFrame": 4 in the file and --steps-per-frame 4 on the command line are equivalent. Flag values are parsed
+// as JSON where possible (0.02, true, [0.02, 0.01, 0.01]) and taken as strings otherwise.
+// The simulation parameters are written to the AppState, where they also become the defaults Reset All restores,
+// while the members below control the run itself.
+struct RunConfig {
+  bool isHeadless = false;
+  std::string backend = "auto";    // fragment, compute, inplace, or auto for the fastest one the context supports
+  uint64_t steps = 1000;           // Simulation steps of a headless run
+  uint64_t reportInterval = 0;     // Steps between progress reports of a headless run, 0 for none
+  std::string geometryPath;        // Wall mask loaded over the scene
+  bool isGeometryInverted = false;
+  std::string fieldOutputPath;     // Fields are recorded from the first step if set
+  std::string sharedFieldsName;    // Fields are published to this shared memory object from the first step if set
+  std::string captureDirectory;    // A PNG sequence is captured from the first frame if set
+  std::string captureCommand;      // Frames are piped to this encoder from the first frame if set
+  std::string checkpointPath;      // Written at the end of a headless run if set
+  std::string steeringSocket;      // A steering server listens on this Unix domain socket if set
+  std::string replayPath;          // Input trace replayed into the steps from the first one if set
+};
+
+// Reads the configuration file given with --config or as the only positional argument, then applies the flags.
+// Returns false with the problem in error, or with an empty error if the usage was requested with --help.
+bool parseRunConfig(int argc, char** argv, RunConfig& config, std::string& error);
+const char* getRunConfigUsage();
+
+// Sets AppState::solverBackend from the configuration, with the context current
+bool selectBackend(const RunConfig& config, std::string& error);
+
+// Loads the configured scene and geometry into the simulation, starts the configured outputs and the input replay
+bool startRun(const RunConfig& config, LBM& lbm, FieldWriter& fieldWriter, FieldPublisher& fieldPublisher, FrameCapture& frameCapture,
+              std::string& error);
+
+#endif // RUN_CONFIG_H
@@ -0,0 +1,45 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded lock-free queue between one producer thread and one consumer thread. Neither side ever waits for the
+// other: push fails when the queue is full and pop when it is empty. Each slot is only touched by the producer
+// between the consumer releasing it and the producer publishing the new tail, and by the consumer in between.
+template <typename T, size_t Capacity>
+class SPSCQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity must be a power of two");
+
+public:
+  // Producer side
+  bool push(T&& item) {
+    const size_t currentTail = tail.load(std::memory_order_relaxed);
+    if (currentTail - head.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    items[currentTail & (Capacity - 1)] = std::move(item);
+    tail.store(currentTail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T& item) {
+    const size_t currentHead = head.load(std::memory_order_relaxed);
+    if (currentHead == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = std::move(items[currentHead & (Capacity - 1)]);
+    head.store(currentHead + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::array<T, Capacity> items;
+  alignas(64) std::atomic<size_t> head = 0; // Next item to pop, written by the consumer
+  alignas(64) std::atomic<size_t> tail = 0; // Next slot to push to, written by the producer
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,489 @@
+#include "core/steering_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <vector>
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
+
+#include "core/app_state.h"
+#include "core/headless.h"
+#include "core/input_trace.h"
+#include "lbm/checkpoint.h"
+#include "lbm/geometry.h"
+#include "lbm/lbm.h"
+
+namespace {
+
+struct ToolInfo {
+  ToolType type;
+  const char* name;
+};
+
+const ToolInfo TOOLS[] = {
+  {ToolType::Force, "force"},
+  {ToolType::AddWall, "addWall"},
+  {ToolType::RemoveWall, "removeWall"},
+  {ToolType::AddSolute, "addSolute"},
+  {ToolType::RemoveSolute, "removeSolute"},
+};
+
+const unsigned int SOLUTE_COUNT = 3;
+const uint64_t MAX_STROKE_STEPS = 1000000;
+
+std::string quote(const std::string& text) {
+  std::ostringstream quoted;
+  quoted << '"';
+  for (char c : text) {
+    switch (c) {
+      case '"': quoted << "\\\""; break;
+      case '\\': quoted << "\\\\"; break;
+      case '\n': quoted << "\\n"; break;
+      case '\r': quoted << "\\r"; break;
+      case '\t': quoted << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+          quoted << c;
+        }
+    }
+  }
+  quoted << '"';
+  return quoted.str();
+}
+
+std::string getErrorReply(const std::string& error) {
+  return "{\"ok\": false, \"error\": " + quote(error) + "}\n";
+}
+
+bool readNumber(const JsonValue& command, const char* key, double min, double max, double& number, std::string& error) {
+  const JsonValue* value = command.find(key);
+  if (value == nullptr || !value->isNumber() || !(value->number >= min && value->number <= max)) {
+    std::ostringstream message;
+    message << key << " must be a number between " << min << " and " << max;
+    error = message.str();
+    return false;
+  }
+  number = value->number;
+  return true;
+}
+
+bool readSolute(const JsonValue& command, unsigned int& soluteID, std::string& error) {
+  double number;
+  if (!readNumber(command, "solute", 1, SOLUTE_COUNT, number, error) || number != static_cast<unsigned int>(number)) {
+    error = "solute must be 1, 2 or 3";
+    return false;
+  }
+  soluteID = static_cast<unsigned int>(number) - 1;
+  return true;
+}
+
+bool readVector(const JsonValue& command, const char* key, glm::vec2& vector, std::string& error) {
+  const JsonValue* value = command.find(key);
+  if (value == nullptr || !value->isArray() || value->array.size() != 2 || !value->array[0].isNumber() || !value->array[1].isNumber()) {
+    error = std::string(key) + " must be [x, y]";
+    return false;
+  }
+  vector = {static_cast<float>(value->array[0].number), static_cast<float>(value->array[1].number)};
+  return true;
+}
+
+bool readString(const JsonValue& command, const char* key, std::string& text, std::string& error) {
+  const JsonValue* value = command.find(key);
+  if (value == nullptr || !value->isString()) {
+    error = std::string(key) + " must be a string";
+    return false;
+  }
+  text = value->string;
+  return true;
+}
+
+#if !defined(_WIN32)
+struct Client {
+  int socket;
+  std::string input;  // Received bytes after the last complete line
+  std::string output; // Reply bytes the socket did not take yet
+};
+
+// Sends as much of the pending replies as the non-blocking socket takes, the rest waits for POLLOUT.
+// Returns false if the client is gone or has stopped reading, so that it cannot hold up the server thread.
+bool flushOutput(Client& client) {
+  while (!client.output.empty()) {
+    ssize_t sent = send(client.socket, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    client.output.erase(0, static_cast<size_t>(sent));
+  }
+  return client.output.size() <= SteeringServer::MAX_OUTPUT_LENGTH;
+}
+#endif
+
+} // namespace
+
+SteeringServer::~SteeringServer() {
+  stop();
+}
+
+bool SteeringServer::start(const fs::path& path, std::string& error) {
+  stop();
+#if defined(_WIN32)
+  error = "Steering requires Unix domain sockets";
+  return false;
+#else
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.string().size() >= sizeof(address.sun_path)) {
+    error = "The socket path " + path.string() + " is too long";
+    return false;
+  }
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  // Only remove a stale socket, never another kind of file or the socket of a server that still accepts connections
+  std::error_code errorCode;
+  if (fs::is_socket(path, errorCode)) {
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool isConnected = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    bool isStale = !isConnected && errno == ECONNREFUSED;
+    if (probe >= 0) {
+      close(probe);
+    }
+    if (isConnected) {
+      error = "Another process is already listening on " + path.string();
+      return false;
+    }
+    if (isStale) {
+      fs::remove(path, errorCode);
+    }
+  }
+  listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0) {
+    error = "Failed to listen on " + path.string() + ": " + std::strerror(errno);
+    if (listener >= 0) {
+      close(listener);
+      listener = -1;
+    }
+    return false;
+  }
+  int wakePipe[2];
+  if (pipe(wakePipe) != 0) {
+    error = std::string("Failed to create the wake pipe: ") + std::strerror(errno);
+    close(listener);
+    listener = -1;
+    fs::remove(path, errorCode);
+    return false;
+  }
+  wakeReader = wakePipe[0];
+  wakeWriter = wakePipe[1];
+  fcntl(wakeReader, F_SETFL, O_NONBLOCK);
+  fcntl(wakeWriter, F_SETFL, O_NONBLOCK);
+
+  this->path = path;
+  stroke = Stroke();
+  statsTime = std::chrono::steady_clock::now();
+  statsStepCount = 0;
+  isStopping = false;
+  thread = std::thread(&SteeringServer::serve, this);
+  return true;
+#endif
+}
+
+void SteeringServer::stop() {
+  if (!isRunning()) {
+    return;
+  }
+#if !defined(_WIN32)
+  isStopping = true;
+  [[maybe_unused]] ssize_t written = write(wakeWriter, "q", 1);
+  thread.join();
+  close(listener);
+  close(wakeReader);
+  close(wakeWriter);
+  listener = wakeReader = wakeWriter = -1;
+  std::error_code errorCode;
+  fs::remove(path, errorCode);
+#endif
+
+  // Drop the requests that were never applied
+  Request request;
+  while (requests.pop(request)) {}
+  Reply reply;
+  while (replies.pop(reply)) {}
+}
+
+bool SteeringServer::isRunning() const {
+  return thread.joinable();
+}
+
+void SteeringServer::update(LBM& lbm) {
+  if (!isRunning()) {
+    return;
+  }
+  if (statsStepCount == 0) {
+    statsStepCount = lbm.getStepCount();
+  }
+  Request request;
+  bool hasReplies = false;
+  while (requests.pop(request)) {
+    // A full reply queue means the server thread is far behind, the client then misses this reply
+    hasReplies = replies.push({request.clientID, execute(lbm, request.command)}) || hasReplies;
+  }
+#if !defined(_WIN32)
+  if (hasReplies) {
+    [[maybe_unused]] ssize_t written = write(wakeWriter, "r", 1);
+  }
+#endif
+  applyStroke(lbm);
+}
+
+void SteeringServer::serve() {
+#if !defined(_WIN32)
+  std::map<uint64_t, Client> clients;
+  uint64_t nextClientID = 1;
+  std::vector<pollfd> descriptors;
+  std::vector<uint64_t> clientIDs;
+  while (!isStopping) {
+    descriptors = {{listener, POLLIN, 0}, {wakeReader, POLLIN, 0}};
+    clientIDs.clear();
+    for (const auto& [clientID, client] : clients) {
+      descriptors.push_back({client.socket, static_cast<short>(client.output.empty() ? POLLIN : POLLIN | POLLOUT), 0});
+      clientIDs.push_back(clientID);
+    }
+    if (poll(descriptors.data(), descriptors.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    // Send the replies of the requests applied since
+    if (descriptors[1].revents & POLLIN) {
+      char bytes[64];
+      while (read(wakeReader, bytes, sizeof(bytes)) > 0) {}
+    }
+    Reply reply;
+    while (replies.pop(reply)) {
+      auto client = clients.find(reply.clientID);
+      if (client != clients.end()) {
+        client->second.output += reply.line;
+      }
+    }
+    if (descriptors[0].revents & POLLIN) {
+      int socket = accept(listener, nullptr, nullptr);
+      if (socket >= 0) {
+        fcntl(socket, F_SETFL, O_NONBLOCK);
+        clients[nextClientID++] = {socket, {}, {}};
+      }
+    }
+
+    // Queue every complete line as a request
+    std::vector<uint64_t> disconnectedIDs;
+    for (size_t i = 2; i < descriptors.size(); i++) {
+      if ((descriptors[i].revents & ~POLLOUT) == 0) {
+        continue;
+      }
+      Client& client = clients[clientIDs[i - 2]];
+      char data[4096];
+      ssize_t received = recv(client.socket, data, sizeof(data), 0);
+      if (received < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+        continue;
+      }
+      if (received > 0) {
+        client.input.append(data, static_cast<size_t>(received));
+        size_t lineEnd;
+        while ((lineEnd = client.input.find('\n')) != std::string::npos) {
+          std::string line = client.input.substr(0, lineEnd);
+          client.input.erase(0, lineEnd + 1);
+          if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+          }
+          if (line.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+          }
+          Request request = {clientIDs[i - 2], {}};
+          std::string error;
+          if (!parseJSON(line, request.command, error)) {
+            client.output += getErrorReply("Invalid JSON: " + error);
+          } else if (!request.command.isObject()) {
+            client.output += getErrorReply("Requests must be JSON objects");
+          } else if (!requests.push(std::move(request))) {
+            client.output += getErrorReply("Too many requests in flight");
+          }
+        }
+        if (client.input.size() <= MAX_LINE_LENGTH) {
+          continue;
+        }
+        client.output += getErrorReply("Line too long");
+        flushOutput(client);
+      }
+      disconnectedIDs.push_back(clientIDs[i - 2]);
+    }
+
+    // Send what the sockets take without blocking
+    for (auto& [clientID, client] : clients) {
+      if (!flushOutput(client) && std::find(disconnectedIDs.begin(), disconnectedIDs.end(), clientID) == disconnectedIDs.end()) {
+        disconnectedIDs.push_back(clientID);
+      }
+    }
+    for (uint64_t clientID : disconnectedIDs) {
+      close(clients[clientID].socket);
+      clients.erase(clientID);
+    }
+  }
+  for (const auto& [clientID, client] : clients) {
+    close(client.socket);
+  }
+#endif
+}
+
+std::string SteeringServer::execute(LBM& lbm, const JsonValue& command) {
+  AppState& appState = AppState::getInstance();
+  std::ostringstream results; // Members following "ok": true
+  results << std::setprecision(9);
+  std::string name;
+  std::string error;
+  bool isSuccessful = readString(command, "command", name, error);
+  double number;
+  unsigned int soluteID;
+
+  if (!isSuccessful) {
+    // Reported below
+  } else if (name == "setViscosity") {
+    isSuccessful = readNumber(command, "value", 1e-6, 10., number, error);
+    if (isSuccessful) {
+      appState.fluidViscosity = static_cast<GLfloat>(number);
+      lbm.setViscosity(appState.fluidViscosity);
+    }
+  } else if (name == "setDiffusivity") {
+    isSuccessful = readSolute(command, soluteID, error) && readNumber(command, "value", 1e-6, 10., number, error);
+    if (isSuccessful) {
+      appState.soluteDiffusivities[soluteID] = static_cast<GLfloat>(number);
+      lbm.setSoluteDiffusivity(soluteID, appState.soluteDiffusivities[soluteID]);
+    }
+  } else if (name == "setReactionRate") {
+    isSuccessful = readNumber(command, "value", 0., 1e3, number, error);
+    if (isSuccessful) {
+      appState.reactionRate = static_cast<GLfloat>(number);
+      lbm.setReactionRate(appState.reactionRate);
+      appState.isReactionEnabled = command.getBool("enabled", appState.isReactionEnabled);
+    }
+  } else if (name == "resetSolute") {
+    isSuccessful = readSolute(command, soluteID, error);
+    if (isSuccessful) {
+      lbm.resetSolute(soluteID);
+      InputTrace::getInstance().recordEvent(TraceEvent::ResetSolute, static_cast<uint8_t>(soluteID));
+    }
+  } else if (name == "stroke") {
+    std::string toolName;
+    Stroke newStroke;
+    newStroke.solute = appState.activeSolute;
+    newStroke.size = appState.toolSize;
+    newStroke.stepCount = 1;
+    isSuccessful = readString(command, "tool", toolName, error) && readVector(command, "position", newStroke.from, error);
+    const ToolInfo* tool = std::find_if(std::begin(TOOLS), std::end(TOOLS), [&](const ToolInfo& info) { return toolName == info.name; });
+    if (isSuccessful && tool == std::end(TOOLS)) {
+      error = "Unknown tool: " + toolName;
+      isSuccessful = false;
+    }
+    newStroke.to = newStroke.from;
+    isSuccessful = isSuccessful && (command.find("to") == nullptr || readVector(command, "to", newStroke.to, error)) &&
+                   (command.find("velocity") == nullptr || readVector(command, "velocity", newStroke.velocity, error)) &&
+                   (command.find("solute") == nullptr || readSolute(command, newStroke.solute, error));
+    if (isSuccessful && command.find("size") != nullptr) {
+      isSuccessful = readNumber(command, "size", 0.005, 1., number, error);
+      newStroke.size = static_cast<GLfloat>(number);
+    }
+    if (isSuccessful && command.find("steps") != nullptr) {
+      isSuccessful = readNumber(command, "steps", 1., MAX_STROKE_STEPS, number, error);
+      newStroke.stepCount = static_cast<uint64_t>(number);
+    }
+    if (isSuccessful) {
+      // Replaces a stroke still in progress
+      newStroke.tool = tool->type;
+      newStroke.stepsRemaining = newStroke.stepCount;
+      stroke = newStroke;
+    }
+  } else if (name == "loadGeometry") {
+    GeometryOptions options;
+    options.isInverted = command.getBool("invert", false);
+    std::string geometryPath;
+    isSuccessful = readString(command, "path", geometryPath, error) && loadGeometry(lbm, geometryPath, options, error);
+    if (isSuccessful) {
+      InputTrace::getInstance().recordLoadGeometry(geometryPath, options);
+    }
+  } else if (name == "checkpoint") {
+    std::string checkpointPath;
+    isSuccessful = readString(command, "path", checkpointPath, error);
+    if (isSuccessful) {
+      float errorBound = static_cast<float>(command.getNumber("errorBound", Checkpoint::DEFAULT_ERROR_BOUND));
+      isSuccessful = command.getBool("compact", false) ? Checkpoint::saveCompact(lbm, checkpointPath, std::max(errorBound, 1e-9f), error)
+                                                       : Checkpoint::save(lbm, checkpointPath, error);
+      results << ", \"stepCount\": " << lbm.getStepCount();
+    }
+  } else if (name == "stats") {
+    // Throughput since the previous stats request
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t stepCount = lbm.getStepCount();
+    const double seconds = std::chrono::duration<double>(now - statsTime).count();
+    const double stepsPerSecond = (seconds > 0.) ? (stepCount - statsStepCount) / seconds : 0.;
+    statsTime = now;
+    statsStepCount = stepCount;
+    const glm::ivec2 latticeSize = lbm.getLatticeSize();
+    results << ", \"stepCount\": " << stepCount << ", \"width\": " << latticeSize.x << ", \"height\": " << latticeSize.y
+            << ", \"backend\": " << quote(getBackendName(appState.solverBackend)) << ", \"stepsPerFrame\": " << appState.stepsPerFrame
+            << ", \"stepsPerSecond\": " << stepsPerSecond
+            << ", \"mlups\": " << stepsPerSecond * latticeSize.x * latticeSize.y * 1e-6
+            << ", \"viscosity\": " << appState.fluidViscosity << ", \"diffusivities\": [";
+    for (unsigned int i = 0; i < appState.soluteDiffusivities.size(); i++) {
+      results << (i > 0 ? ", " : "") << appState.soluteDiffusivities[i];
+    }
+    results << "], \"reactionEnabled\": " << (appState.isReactionEnabled ? "true" : "false")
+            << ", \"reactionRate\": " << appState.reactionRate;
+  } else {
+    error = "Unknown command: " + name;
+    isSuccessful = false;
+  }
+
+  // Echo the id of the request, so that clients can pipeline requests
+  std::ostringstream reply;
+  reply << std::setprecision(17) << "{";
+  const JsonValue* id = command.find("id");
+  if (id != nullptr && id->isNumber()) {
+    reply << "\"id\": " << id->number << ", ";
+  } else if (id != nullptr && id->isString()) {
+    reply << "\"id\": " << quote(id->string) << ", ";
+  }
+  if (isSuccessful) {
+    reply << "\"ok\": true" << results.str() << "}\n";
+  } else {
+    reply << "\"ok\": false, \"error\": " << quote(error) << "}\n";
+  }
+  return reply.str();
+}
+
+void SteeringServer::applyStroke(LBM& lbm) {
+  // Injects the tool into the steps of the stroke, so that the cursor and the tool selected in the UI are left alone
+  if (stroke.stepsRemaining == 0) {
+    return;
+  }
+  const uint64_t step = stroke.stepCount - stroke.stepsRemaining;
+  const float progress = (stroke.stepCount > 1) ? static_cast<float>(step) / (stroke.stepCount - 1) : 0.f;
+  lbm.injectToolInput({true, stroke.tool, glm::mix(stroke.from, stroke.to, progress), stroke.velocity, stroke.solute, stroke.size});
+  stroke.stepsRemaining--;
+}
@@ -0,0 +1,98 @@
+#ifndef STEERING_SERVER_H
+#define STEERING_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include "glm.hpp"
+
+#include "core/app_state.h"
+#include "core/json.h"
+#include "core/spsc_queue.h"
+
+namespace fs = std::filesystem;
+
+class LBM;
+
+// Local control server that steers a running simulation through a Unix domain socket.
+// Clients write one JSON object per line, such as {"command": "setViscosity", "value": 0.05, "id": 1}, and receive
+// one JSON object per line in reply with "ok", the "id" of the request if it had one, and "error" or the results.
+// A server thread accepts the connections and parses the requests into a lock-free queue, which the simulation
+// drains at the next step boundary, so steering never holds up the step loop; requests that find the queue full are
+// refused with an error right away. The replies go back through a second queue and are buffered per client on
+// non-blocking sockets, so a client that stops reading cannot hold up the others either and is disconnected once its
+// unread replies exceed MAX_OUTPUT_LENGTH. Solute resets and wall imports are recorded into an input trace being
+// recorded, like those of the UI.
+//
+// Commands (solutes are numbered from 1, positions are UV coordinates of the lattice like the cursor position):
+//   setViscosity {value}, setDiffusivity {solute, value}, setReactionRate {value, enabled?}, resetSolute {solute},
+//   stroke {tool: force|addWall|removeWall|addSolute|removeSolute, position: [x, y], to?: [x, y], velocity?: [x, y],
+//           size?, solute?, steps?}, applying the tool for steps steps while moving from position to to, in place of
+//           the cursor, whose tool stays selected in the UI,
+//   loadGeometry {path, invert?}, checkpoint {path, compact?, errorBound?}, stats.
+class SteeringServer {
+public:
+  static constexpr size_t QUEUE_CAPACITY = 256;       // Requests and replies in flight
+  static constexpr size_t MAX_LINE_LENGTH = 1 << 16;  // Clients sending longer lines are disconnected
+  static constexpr size_t MAX_OUTPUT_LENGTH = 1 << 20; // Clients leaving more reply bytes unread are disconnected
+
+  SteeringServer() = default;
+  ~SteeringServer(); // Stops the server
+
+  SteeringServer(const SteeringServer&) = delete;
+  SteeringServer& operator=(const SteeringServer&) = delete;
+
+  // Listens on the socket path, replacing a stale socket left by an earlier run but never one still in use
+  bool start(const fs::path& path, std::string& error);
+  void stop();
+  bool isRunning() const;
+
+  // Call before every simulation step, with the context current: applies the queued requests and any tool stroke
+  void update(LBM& lbm);
+
+private:
+  struct Request {
+    uint64_t clientID = 0;
+    JsonValue command;
+  };
+
+  struct Reply {
+    uint64_t clientID = 0;
+    std::string line;
+  };
+
+  struct Stroke {
+    uint64_t stepsRemaining = 0;
+    uint64_t stepCount = 0; // Of the whole stroke
+    ToolType tool = ToolType::Force;
+    glm::vec2 from = {0.f, 0.f};
+    glm::vec2 to = {0.f, 0.f};
+    glm::vec2 velocity = {0.f, 0.f};
+    unsigned int solute = 0;
+    GLfloat size = 0.f;
+  };
+
+  fs::path path;
+  int listener = -1;
+  int wakeReader = -1;  // Self-pipe waking the server thread for replies and to stop
+  int wakeWriter = -1;
+  std::thread thread;
+  std::atomic<bool> isStopping = false;
+  SPSCQueue<Request, QUEUE_CAPACITY> requests;
+  SPSCQueue<Reply, QUEUE_CAPACITY> replies;
+
+  // Simulation thread state
+  Stroke stroke;
+  std::chrono::steady_clock::time_point statsTime;
+  uint64_t statsStepCount = 0;
+
+  void serve();
+  std::string execute(LBM& lbm, const JsonValue& command);
+  void applyStroke(LBM& lbm);
+};
+
+#endif // STEERING_SERVER_H
@@ -0,0 +1,126 @@
+#include "tracer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+Tracer::Scope::Scope(const char* name, const char* category)
+  : name(name), category(category), isActive(Tracer::getInstance().isEnabled()) {
+  startTime = isActive ? Tracer::getInstance().getTime() : 0.;
+}
+
+Tracer::Scope::~Scope() {
+  if (isActive) {
+    Tracer& tracer = Tracer::getInstance();
+    tracer.recordEvent(name, category, startTime, tracer.getTime() - startTime);
+  }
+}
+
+Tracer::Tracer() : slots(std::make_unique<Slot[]>(CAPACITY)), epoch(std::chrono::steady_clock::now()) {}
+
+void Tracer::setEnabled(bool isEnabled) {
+  enabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+bool Tracer::isEnabled() const {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+double Tracer::getTime() const {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Tracer::recordEvent(const char* name, const char* category, double startTime, double duration, uint32_t threadId) {
+  if (!isEnabled()) {
+    return;
+  }
+
+  // Claim a slot, then publish the event under the slot's sequence number
+  uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots[index & (CAPACITY - 1)];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::strncpy(slot.event.name, name, MAX_NAME_LENGTH);
+  slot.event.name[MAX_NAME_LENGTH] = '\0';
+  std::strncpy(slot.event.category, category, sizeof(slot.event.category) - 1);
+  slot.event.category[sizeof(slot.event.category) - 1] = '\0';
+  slot.event.startTime = startTime;
+  slot.event.duration = duration;
+  slot.event.threadId = threadId;
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void Tracer::recordEvent(const char* name, const char* category, double startTime, double duration) {
+  recordEvent(name, category, startTime, duration, getThreadId());
+}
+
+bool Tracer::exportTrace(const fs::path& path) const {
+  // Copy out every published event, skipping slots that are mid-write
+  std::vector<Event> events;
+  events.reserve(CAPACITY);
+  uint32_t maxThreadId = 0;
+  for (unsigned int i = 0; i < CAPACITY; i++) {
+    const Slot& slot = slots[i];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence % 2 == 1) {
+      continue;
+    }
+    Event event = slot.event;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+      continue;
+    }
+    events.push_back(event);
+    maxThreadId = std::max(maxThreadId, event.threadId);
+  }
+
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open trace file: " << path << std::endl;
+    return false;
+  }
+
+  // Name the timelines, thread 1 is the first thread that recorded an event (normally the main thread)
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"lbm\"}},\n";
+  file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID << ",\"args\":{\"name\":\"GPU\"}}";
+  for (uint32_t threadId = 1; threadId <= maxThreadId; threadId++) {
+    file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId
+         << ",\"args\":{\"name\":\"" << (threadId == 1 ? "Main" : "Thread " + std::to_string(threadId)) << "\"}}";
+  }
+
+  // Names are trusted identifiers from the code, so only quotes and backslashes need escaping
+  auto writeString = [&file](const char* string) {
+    file << '"';
+    for (const char* c = string; *c; c++) {
+      if (*c == '"' || *c == '\\') {
+        file << '\\';
+      }
+      file << *c;
+    }
+    file << '"';
+  };
+
+  file.precision(3);
+  file << std::fixed;
+  for (const auto& event : events) {
+    file << ",\n{\"name\":";
+    writeString(event.name);
+    file << ",\"cat\":";
+    writeString(event.category);
+    file << ",\"ph\":\"X\",\"ts\":" << event.startTime << ",\"dur\":" << event.duration
+         << ",\"pid\":1,\"tid\":" << event.threadId << "}";
+  }
+  file << "\n]}\n";
+  return file.good();
+}
+
+uint32_t Tracer::getThreadId() {
+  // Threads are numbered in the order they first record an event, leaving 0 for the GPU
+  static std::atomic<uint32_t> nextThreadId{GPU_THREAD_ID + 1};
+  thread_local uint32_t threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+  return threadId;
+}
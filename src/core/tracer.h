@@ -0,0 +1,80 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+// Records CPU zones and GPU pass timestamps into a fixed-size lock-free ring buffer,
+// which can be written out as Chrome Trace Event JSON (viewable in Perfetto or chrome://tracing).
+// Once the ring is full the oldest events are overwritten.
+class Tracer {
+public:
+  static constexpr unsigned int CAPACITY = 1 << 16;  // Number of events kept, must be a power of two
+  static constexpr unsigned int MAX_NAME_LENGTH = 47;
+  static constexpr uint32_t GPU_THREAD_ID = 0;       // Timeline used for GPU events
+
+  struct Event {
+    char name[MAX_NAME_LENGTH + 1];
+    char category[16];
+    double startTime; // Microseconds since the tracer was created
+    double duration;  // Microseconds
+    uint32_t threadId;
+  };
+
+  // Records a CPU zone covering its own lifetime
+  class Scope {
+  public:
+    Scope(const char* name, const char* category = "app");
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    const char* name;
+    const char* category;
+    double startTime;
+    bool isActive;
+  };
+
+  // Tracer access method
+  static Tracer& getInstance() {
+    static Tracer instance;
+    return instance;
+  }
+
+  // Prevent copying or moving
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+  Tracer(Tracer&&) = delete;
+  Tracer& operator=(Tracer&&) = delete;
+
+  void setEnabled(bool isEnabled);
+  bool isEnabled() const;
+  double getTime() const;
+  void recordEvent(const char* name, const char* category, double startTime, double duration, uint32_t threadId);
+  void recordEvent(const char* name, const char* category, double startTime, double duration);
+  bool exportTrace(const fs::path& path) const;
+  static uint32_t getThreadId();
+
+private:
+  // Each slot is guarded by a sequence number: odd while being written, even once published
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    Event event;
+  };
+
+  std::atomic<bool> enabled{false};
+  std::atomic<uint64_t> writeIndex{0};
+  std::unique_ptr<Slot[]> slots;
+  const std::chrono::steady_clock::time_point epoch;
+
+  Tracer();
+};
+
+#endif // TRACER_H
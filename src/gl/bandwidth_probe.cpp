@@ -0,0 +1,83 @@
+#include "bandwidth_probe.h"
+
+#include <chrono>
+#include <memory>
+#include <utility>
+
+#include "gl/framebuffers.h"
+#include "gl/gl_extensions.h"
+#include "gl/shader_program.h"
+
+// 2048^2 RGBA32F texels are 64 MiB per texture
+static const unsigned int PROBE_SIZE = 2048;
+static const unsigned int PROBE_WARMUP_ITERATIONS = 2;
+static const unsigned int PROBE_ITERATIONS = 8;
+
+float measureMemoryBandwidth(const fs::path& shadersDir) {
+  GLfloat vertices[] = {
+      -1.0f, -1.0f, 0.0f,  // Bottom Left
+      3.0f, -1.0f, 0.0f,   // Far right, beyond viewport
+      -1.0f,  3.0f, 0.0f   // Far top, beyond viewport
+  };
+  GLuint vertexArray, vertexBuffer;
+  glGenVertexArrays(1, &vertexArray);
+  glBindVertexArray(vertexArray);
+  glGenBuffers(1, &vertexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  auto source = std::make_unique<Framebuffer>(PROBE_SIZE, PROBE_SIZE, 1, "Bandwidth probe");
+  auto destination = std::make_unique<Framebuffer>(PROBE_SIZE, PROBE_SIZE, 1, "Bandwidth probe");
+  source->clear(1.0, 0.5, 0.25, 0.125);
+  ShaderProgram copyShader(shadersDir / "vs_base.glsl", shadersDir / "fs_bandwidth_probe.glsl");
+
+  auto copy = [&]() {
+    destination->bind();
+    copyShader.use();
+    copyShader.setTextureUniform("uSource", source->getTexture(0));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    std::swap(source, destination);
+  };
+
+  for (unsigned int i = 0; i < PROBE_WARMUP_ITERATIONS; i++) {
+    copy();
+  }
+
+  // Prefer GPU timer queries, which exclude submission overhead, and fall back to the wall clock
+  double seconds = 0.;
+  bool hasTimerQueries = hasGLVersion(3, 3) && glGetQueryObjectui64v != nullptr;
+  if (hasTimerQueries) {
+    GLuint query;
+    glGenQueries(1, &query);
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    for (unsigned int i = 0; i < PROBE_ITERATIONS; i++) {
+      copy();
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    GLuint64 elapsedTime = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+    glDeleteQueries(1, &query);
+    seconds = static_cast<double>(elapsedTime) * 1e-9;
+  } else {
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < PROBE_ITERATIONS; i++) {
+      copy();
+    }
+    glFinish();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  glUseProgram(0);
+  glBindVertexArray(0);
+  Framebuffer::unbind();
+  glDeleteVertexArrays(1, &vertexArray);
+  glDeleteBuffers(1, &vertexBuffer);
+
+  // Every copied texel is read once and written once
+  double bytes = 2. * PROBE_ITERATIONS * PROBE_SIZE * PROBE_SIZE * 4 * sizeof(GLfloat);
+  return seconds > 0. ? static_cast<float>(bytes / seconds * 1e-9) : 0.f;
+}
@@ -0,0 +1,14 @@
+#ifndef BANDWIDTH_PROBE_H
+#define BANDWIDTH_PROBE_H
+
+#include <filesystem>
+
+#include <glad/glad.h>
+
+namespace fs = std::filesystem;
+
+// Measures the attainable device memory bandwidth in GB/s by repeatedly copying an RGBA32F texture
+// that is too large to stay in cache. Serves as the bandwidth ceiling for the per-pass roofline.
+float measureMemoryBandwidth(const fs::path& shadersDir);
+
+#endif // BANDWIDTH_PROBE_H
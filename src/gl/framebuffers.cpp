@@ -3,8 +3,25 @@
 #include <cstdlib>
 #include <iostream>
 
-Framebuffer::Framebuffer(unsigned int width, unsigned int height, unsigned int textureCount)
-  : width(width), height(height), textureCount(textureCount), texelSize{1.f / width, 1.f / height} {
+StencilBuffer::StencilBuffer(unsigned int width, unsigned int height, const std::string& owner)
+  : allocation(MemoryKind::Renderbuffer, owner, "Stencil buffer", MemoryTracker::getFormatName(GL_DEPTH24_STENCIL8), width, height,
+               static_cast<size_t>(width) * height * MemoryTracker::getFormatSize(GL_DEPTH24_STENCIL8)) {
+  glGenRenderbuffers(1, &rbo);
+  glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+StencilBuffer::~StencilBuffer() {
+  glDeleteRenderbuffers(1, &rbo);
+}
+
+GLuint StencilBuffer::getRenderbuffer() const {
+  return rbo;
+}
+
+Framebuffer::Framebuffer(unsigned int width, unsigned int height, unsigned int textureCount, const std::string& owner)
+  : width(width), height(height), textureCount(textureCount), texelSize{1.f / width, 1.f / height}, owner(owner) {
   glGenFramebuffers(1, &fbo);
 
   setupTextures();
@@ -49,11 +66,22 @@ void Framebuffer::resize(const glm::vec2& size) {
 
   // Clear the textures vector to repopulate it
   textures.clear();
+  allocations.clear();
 
   // Re-setup textures with the new dimensions
   setupTextures();
 }
 
+void Framebuffer::attachStencilBuffer(const StencilBuffer& stencilBuffer) {
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencilBuffer.getRenderbuffer());
+  if (!checkFramebufferComplete()) {
+    std::cerr << "Framebuffer not complete after attaching stencil buffer!" << std::endl;
+    exit(1);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 GLuint Framebuffer::getTexture(unsigned int index) const {
   if (index < textures.size()) {
     return textures[index];
@@ -87,6 +115,8 @@ void Framebuffer::setupTextures() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+    allocations.emplace_back(MemoryKind::Texture, owner, "Framebuffer texture " + std::to_string(i), MemoryTracker::getFormatName(GL_RGBA32F),
+                             width, height, static_cast<size_t>(width) * height * MemoryTracker::getFormatSize(GL_RGBA32F));
 
     drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
   }
@@ -102,12 +132,13 @@ bool Framebuffer::checkFramebufferComplete() const {
   return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
 }
 
-ReadWriteFramebuffer::ReadWriteFramebuffer(unsigned int width, unsigned int height, unsigned int textureCount)
-: readFramebuffer(std::make_unique<Framebuffer>(width, height, textureCount)),
-  writeFramebuffer(std::make_unique<Framebuffer>(width, height, textureCount)) {}
+ReadWriteFramebuffer::ReadWriteFramebuffer(unsigned int width, unsigned int height, unsigned int textureCount, const std::string& owner,
+                                           bool isDoubleBuffered)
+: readFramebuffer(std::make_unique<Framebuffer>(width, height, textureCount, owner)),
+  writeFramebuffer(isDoubleBuffered ? std::make_unique<Framebuffer>(width, height, textureCount, owner) : nullptr) {}
 
 void ReadWriteFramebuffer::bind() const {
-  writeFramebuffer->bind();
+  getWriteFramebuffer().bind();
 }
 
 void ReadWriteFramebuffer::unbind() {
@@ -116,13 +147,26 @@ void ReadWriteFramebuffer::unbind() {
 
 void ReadWriteFramebuffer::clear(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
   readFramebuffer->clear(r, g, b, a);
-  writeFramebuffer->clear(r, g, b, a);
+  if (writeFramebuffer) {
+    writeFramebuffer->clear(r, g, b, a);
+  }
+}
+
+void ReadWriteFramebuffer::attachStencilBuffer(const StencilBuffer& stencilBuffer) {
+  readFramebuffer->attachStencilBuffer(stencilBuffer);
+  if (writeFramebuffer) {
+    writeFramebuffer->attachStencilBuffer(stencilBuffer);
+  }
 }
 
 GLuint ReadWriteFramebuffer::getTexture(unsigned int index) const {
   return readFramebuffer->getTexture(index);
 }
 
+GLuint ReadWriteFramebuffer::getWriteTexture(unsigned int index) const {
+  return getWriteFramebuffer().getTexture(index);
+}
+
 std::vector<GLuint>& ReadWriteFramebuffer::getTextures() {
   return readFramebuffer->getTextures();
 }
@@ -132,5 +176,11 @@ glm::vec2 ReadWriteFramebuffer::getTexelSize() const {
 }
 
 void ReadWriteFramebuffer::swap() {
-  std::swap(readFramebuffer, writeFramebuffer);
+  if (writeFramebuffer) {
+    std::swap(readFramebuffer, writeFramebuffer);
+  }
+}
+
+Framebuffer& ReadWriteFramebuffer::getWriteFramebuffer() const {
+  return writeFramebuffer ? *writeFramebuffer : *readFramebuffer;
 }
@@ -4,11 +4,31 @@
 #include <glad/glad.h>
 #include <glm.hpp>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "gl/memory_tracker.h"
+
+class StencilBuffer {
+public:
+  StencilBuffer(unsigned int width, unsigned int height, const std::string& owner);
+  ~StencilBuffer();
+
+  // Disallow copy and assignment
+  StencilBuffer(const StencilBuffer&) = delete;
+  StencilBuffer& operator=(const StencilBuffer&) = delete;
+
+  GLuint getRenderbuffer() const;
+
+private:
+  GLuint rbo;
+  TrackedAllocation allocation;
+};
+
+
 class Framebuffer {
 public:
-  Framebuffer(unsigned int width, unsigned int height, unsigned int textureCount);
+  Framebuffer(unsigned int width, unsigned int height, unsigned int textureCount, const std::string& owner);
   ~Framebuffer();
 
   // Disallow copy and assignment
@@ -19,6 +39,7 @@ public:
   static void unbind();
   void clear(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
   void resize(const glm::vec2& size);
+  void attachStencilBuffer(const StencilBuffer& stencilBuffer);
   GLuint getTexture(unsigned int index) const;
   std::vector<GLuint>& getTextures();
   glm::vec2 getTexelSize() const;
@@ -28,6 +49,8 @@ private:
   std::vector<GLuint> textures;
   unsigned int width, height, textureCount;
   glm::vec2 texelSize;
+  std::string owner; // Reported to the memory tracker
+  std::vector<TrackedAllocation> allocations;
 
   void setupTextures();
   bool checkFramebufferComplete() const;
@@ -36,7 +59,9 @@ private:
 
 class ReadWriteFramebuffer {
 public:
-  ReadWriteFramebuffer(unsigned int width, unsigned int height, unsigned int textureCount);
+  // Single buffered instances read from and write to the same framebuffer
+  ReadWriteFramebuffer(unsigned int width, unsigned int height, unsigned int textureCount, const std::string& owner,
+                       bool isDoubleBuffered = true);
   ~ReadWriteFramebuffer() = default;
 
   // Disallow copy and assignment
@@ -46,7 +71,9 @@ public:
   void bind() const;
   static void unbind();
   void clear(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+  void attachStencilBuffer(const StencilBuffer& stencilBuffer);
   GLuint getTexture(unsigned int index) const;
+  GLuint getWriteTexture(unsigned int index) const;
   std::vector<GLuint>& getTextures();
   glm::vec2 getTexelSize() const;
   void swap();
@@ -54,6 +81,8 @@ public:
 private:
   std::unique_ptr<Framebuffer> readFramebuffer;
   std::unique_ptr<Framebuffer> writeFramebuffer;
+
+  Framebuffer& getWriteFramebuffer() const;
 };
 
 #endif // FRAMEBUFFERS_H
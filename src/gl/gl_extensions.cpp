@@ -0,0 +1,46 @@
+#include "gl_extensions.h"
+
+#include <cstring>
+
+PFNGLQUERYCOUNTERPROC glext_glQueryCounter = nullptr;
+PFNGLGETQUERYOBJECTUI64VPROC glext_glGetQueryObjectui64v = nullptr;
+PFNGLBINDIMAGETEXTUREPROC glext_glBindImageTexture = nullptr;
+PFNGLMEMORYBARRIERPROC glext_glMemoryBarrier = nullptr;
+PFNGLDISPATCHCOMPUTEPROC glext_glDispatchCompute = nullptr;
+PFNGLCLEARBUFFERDATAPROC glext_glClearBufferData = nullptr;
+PFNGLGETPROGRAMRESOURCEINDEXPROC glext_glGetProgramResourceIndex = nullptr;
+PFNGLSHADERSTORAGEBLOCKBINDINGPROC glext_glShaderStorageBlockBinding = nullptr;
+
+void loadGLExtensions(GLADloadproc load) {
+  if (hasGLVersion(3, 3)) {
+    glext_glQueryCounter = (PFNGLQUERYCOUNTERPROC)load("glQueryCounter");
+    glext_glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)load("glGetQueryObjectui64v");
+  }
+
+  if (hasGLVersion(4, 2)) {
+    glext_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)load("glBindImageTexture");
+    glext_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+  }
+
+  if (hasGLVersion(4, 3)) {
+    glext_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+    glext_glClearBufferData = (PFNGLCLEARBUFFERDATAPROC)load("glClearBufferData");
+    glext_glGetProgramResourceIndex = (PFNGLGETPROGRAMRESOURCEINDEXPROC)load("glGetProgramResourceIndex");
+    glext_glShaderStorageBlockBinding = (PFNGLSHADERSTORAGEBLOCKBINDINGPROC)load("glShaderStorageBlockBinding");
+  }
+}
+
+bool hasGLVersion(int major, int minor) {
+  return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool hasGLExtension(const char* name) {
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for (GLint i = 0; i < extensionCount; i++) {
+    if (strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
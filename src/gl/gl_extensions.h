@@ -0,0 +1,73 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// The bundled glad loader only covers the OpenGL 3.2 core profile.
+// The entry points below are loaded on top of it when the context supports them.
+
+// OpenGL 3.3 (timer queries)
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+// OpenGL 4.2 (shader image load/store)
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_PIXEL_BUFFER_BARRIER_BIT 0x00000080
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+#endif
+
+// OpenGL 4.3 (compute shaders and shader storage buffers)
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BLOCK 0x92E6
+#define GL_MAX_COMPUTE_SHARED_MEMORY_SIZE 0x8262
+#define GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS 0x90EB
+#define GL_MAX_SHADER_STORAGE_BLOCK_SIZE 0x90DE
+#endif
+
+typedef void (APIENTRYP PFNGLQUERYCOUNTERPROC)(GLuint id, GLenum target);
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUI64VPROC)(GLuint id, GLenum pname, GLuint64 *params);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (APIENTRYP PFNGLCLEARBUFFERDATAPROC)(GLenum target, GLenum internalformat, GLenum format, GLenum type, const void *data);
+typedef GLuint (APIENTRYP PFNGLGETPROGRAMRESOURCEINDEXPROC)(GLuint program, GLenum programInterface, const GLchar *name);
+typedef void (APIENTRYP PFNGLSHADERSTORAGEBLOCKBINDINGPROC)(GLuint program, GLuint storageBlockIndex, GLuint storageBlockBinding);
+
+extern PFNGLQUERYCOUNTERPROC glext_glQueryCounter;
+extern PFNGLGETQUERYOBJECTUI64VPROC glext_glGetQueryObjectui64v;
+extern PFNGLBINDIMAGETEXTUREPROC glext_glBindImageTexture;
+extern PFNGLMEMORYBARRIERPROC glext_glMemoryBarrier;
+extern PFNGLDISPATCHCOMPUTEPROC glext_glDispatchCompute;
+extern PFNGLCLEARBUFFERDATAPROC glext_glClearBufferData;
+extern PFNGLGETPROGRAMRESOURCEINDEXPROC glext_glGetProgramResourceIndex;
+extern PFNGLSHADERSTORAGEBLOCKBINDINGPROC glext_glShaderStorageBlockBinding;
+
+#define glQueryCounter glext_glQueryCounter
+#define glGetQueryObjectui64v glext_glGetQueryObjectui64v
+#define glBindImageTexture glext_glBindImageTexture
+#define glMemoryBarrier glext_glMemoryBarrier
+#define glDispatchCompute glext_glDispatchCompute
+#define glClearBufferData glext_glClearBufferData
+#define glGetProgramResourceIndex glext_glGetProgramResourceIndex
+#define glShaderStorageBlockBinding glext_glShaderStorageBlockBinding
+
+// Loads all entry points available in the current context (call after gladLoadGLLoader)
+void loadGLExtensions(GLADloadproc load);
+
+// Returns true if the current context is at least the given OpenGL version
+bool hasGLVersion(int major, int minor);
+
+// Returns true if the current context advertises the named extension
+bool hasGLExtension(const char* name);
+
+#endif // GL_EXTENSIONS_H
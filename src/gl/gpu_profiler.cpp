@@ -0,0 +1,340 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <numeric>
+
+void GPUProfiler::beginFrame() {
+  // Record the CPU time of the previous frame
+  auto frameStart = std::chrono::steady_clock::now();
+  if (hasLastFrameStart) {
+    frameTimeHistory[frameTimeHistoryOffset] = std::chrono::duration<float, std::milli>(frameStart - lastFrameStart).count();
+    frameUpdateHistory[frameTimeHistoryOffset] = static_cast<double>(lastFrameLatticeUpdates);
+    frameTimeHistoryOffset = (frameTimeHistoryOffset + 1) % HISTORY_SIZE;
+    frameTimeHistoryCount = std::min(frameTimeHistoryCount + 1, HISTORY_SIZE);
+  }
+  lastFrameStart = frameStart;
+  hasLastFrameStart = true;
+
+  // The context is only guaranteed to exist once the first frame begins
+  if (!hasCheckedSupport) {
+    hasTimerQueries = hasGLVersion(3, 3) && glGetQueryObjectui64v != nullptr;
+    hasCheckedSupport = true;
+  }
+
+  // Collect the queries issued two frames ago before their objects are reused
+  FrameQueries& frame = frames[frameParity];
+  if (frame.isPending) {
+    collectResults(frame);
+  }
+  frame.queryCount = 0;
+  frame.passIndices.clear();
+  frame.latticeUpdates = 0;
+  frame.isPending = false;
+  frame.frameIndex = frameCount++;
+
+  // Relate the GPU clock to the tracer clock, so that GPU events land on the same timeline
+  Tracer& tracer = Tracer::getInstance();
+  frame.hasTimestamps = hasTimerQueries && glQueryCounter != nullptr && tracer.isEnabled();
+  if (frame.hasTimestamps) {
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    frame.gpuClockOffset = tracer.getTime() - static_cast<double>(gpuTime) * 1e-3;
+  }
+
+  isFrameActive = true;
+  passDepth = 0;
+}
+
+void GPUProfiler::endFrame() {
+  if (!isFrameActive) {
+    return;
+  }
+
+  // Close a pass that was left open so the next frame starts from a clean state
+  if (passDepth > 0) {
+    passDepth = 1;
+    endPass();
+  }
+
+  FrameQueries& frame = frames[frameParity];
+  frame.isPending = frame.queryCount > 0;
+  lastFrameLatticeUpdates = frame.latticeUpdates;
+  isFrameActive = false;
+  frameParity ^= 1;
+}
+
+void GPUProfiler::beginPass(const std::string& name, bool isSimulationPass) {
+  if (!isFrameActive || passDepth++ > 0) {
+    return;
+  }
+  activePassIndex = getPassIndex(name, isSimulationPass);
+  Tracer& tracer = Tracer::getInstance();
+  activePassStartTime = tracer.isEnabled() ? tracer.getTime() : -1.;
+  if (!hasTimerQueries) {
+    return;
+  }
+
+  // Grow the query pools on demand, a frame issues the same passes every time once warmed up
+  FrameQueries& frame = frames[frameParity];
+  if (frame.queryCount == frame.queries.size()) {
+    GLuint query;
+    glGenQueries(1, &query);
+    frame.queries.push_back(query);
+  }
+  if (frame.hasTimestamps && frame.queryCount >= frame.timestampQueries.size()) {
+    GLuint query;
+    glGenQueries(1, &query);
+    frame.timestampQueries.push_back(query);
+  }
+  frame.passIndices.push_back(activePassIndex);
+  if (frame.hasTimestamps) {
+    glQueryCounter(frame.timestampQueries[frame.queryCount], GL_TIMESTAMP);
+  }
+  glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.queryCount++]);
+}
+
+void GPUProfiler::endPass() {
+  if (!isFrameActive || passDepth == 0 || --passDepth > 0) {
+    return;
+  }
+  if (hasTimerQueries) {
+    glEndQuery(GL_TIME_ELAPSED);
+  }
+
+  // The CPU zone covers command submission only, the GPU work is traced once its queries are collected
+  if (activePassStartTime >= 0.) {
+    Tracer& tracer = Tracer::getInstance();
+    tracer.recordEvent(passTimings[activePassIndex].name.c_str(), "pass", activePassStartTime, tracer.getTime() - activePassStartTime);
+  }
+}
+
+void GPUProfiler::addLatticeUpdates(uint64_t updateCount) {
+  if (isFrameActive) {
+    frames[frameParity].latticeUpdates += updateCount;
+  }
+}
+
+void GPUProfiler::setPassCost(const std::string& name, const PassCost& cost) {
+  passCosts[name] = cost;
+}
+
+void GPUProfiler::setPeakBandwidth(float bandwidth) {
+  peakBandwidth = bandwidth;
+}
+
+void GPUProfiler::resetStatistics() {
+  // Forget all passes and history, queries still in flight are dropped with them
+  passTimings.clear();
+  passIndices.clear();
+  for (auto& frame : frames) {
+    frame.queryCount = 0;
+    frame.passIndices.clear();
+    frame.isPending = false;
+  }
+  simulationTimeHistory.fill(0.f);
+  latticeUpdateHistory.fill(0.);
+  historyOffset = 0;
+  historyCount = 0;
+  hasNewCollectedFrame = false;
+  frameTimeHistory.fill(0.f);
+  frameUpdateHistory.fill(0.);
+  frameTimeHistoryOffset = 0;
+  frameTimeHistoryCount = 0;
+  hasLastFrameStart = false;
+}
+
+void GPUProfiler::releaseQueries() {
+  for (auto& frame : frames) {
+    if (!frame.queries.empty()) {
+      glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    }
+    if (!frame.timestampQueries.empty()) {
+      glDeleteQueries(static_cast<GLsizei>(frame.timestampQueries.size()), frame.timestampQueries.data());
+    }
+    frame = FrameQueries();
+  }
+  isFrameActive = false;
+  passDepth = 0;
+}
+
+bool GPUProfiler::isSupported() const {
+  return hasTimerQueries;
+}
+
+uint64_t GPUProfiler::getFrameIndex() const {
+  return frameCount > 0 ? frameCount - 1 : 0;
+}
+
+bool GPUProfiler::takeCollectedFrame(CollectedFrame& frame) {
+  if (!hasNewCollectedFrame) {
+    return false;
+  }
+  frame = lastCollectedFrame;
+  hasNewCollectedFrame = false;
+  return true;
+}
+
+const std::vector<GPUProfiler::PassTiming>& GPUProfiler::getPassTimings() const {
+  return passTimings;
+}
+
+const std::array<float, GPUProfiler::HISTORY_SIZE>& GPUProfiler::getFrameTimeHistory() const {
+  return frameTimeHistory;
+}
+
+unsigned int GPUProfiler::getHistoryOffset() const {
+  return historyOffset;
+}
+
+unsigned int GPUProfiler::getFrameTimeHistoryOffset() const {
+  return frameTimeHistoryOffset;
+}
+
+float GPUProfiler::getAveragePassTime(const PassTiming& pass) const {
+  // Unused history entries are zero, so summing the whole ring is safe
+  if (historyCount == 0) {
+    return 0.f;
+  }
+  return std::accumulate(pass.history.begin(), pass.history.end(), 0.f) / historyCount;
+}
+
+float GPUProfiler::getMaxPassTime(const PassTiming& pass) const {
+  return *std::max_element(pass.history.begin(), pass.history.end());
+}
+
+std::vector<float> GPUProfiler::getPassTimeSamples(const PassTiming& pass) const {
+  std::vector<float> samples;
+  unsigned int start = (historyOffset + HISTORY_SIZE - historyCount) % HISTORY_SIZE;
+  for (unsigned int i = 0; i < historyCount; i++) {
+    unsigned int index = (start + i) % HISTORY_SIZE;
+    if (pass.invocationHistory[index] > 0.f) {
+      samples.push_back(pass.history[index]);
+    }
+  }
+  return samples;
+}
+
+float GPUProfiler::getAverageGPUFrameTime() const {
+  float frameTime = 0.f;
+  for (const auto& pass : passTimings) {
+    frameTime += getAveragePassTime(pass);
+  }
+  return frameTime;
+}
+
+float GPUProfiler::getAverageFrameTime() const {
+  if (frameTimeHistoryCount == 0) {
+    return 0.f;
+  }
+  return std::accumulate(frameTimeHistory.begin(), frameTimeHistory.end(), 0.f) / frameTimeHistoryCount;
+}
+
+float GPUProfiler::getSimulationMLUPS() const {
+  // Lattice updates per GPU millisecond spent in the simulation passes, scaled to millions per second
+  float simulationTime = std::accumulate(simulationTimeHistory.begin(), simulationTimeHistory.end(), 0.f);
+  double latticeUpdates = std::accumulate(latticeUpdateHistory.begin(), latticeUpdateHistory.end(), 0.0);
+  return simulationTime > 0.f ? static_cast<float>(latticeUpdates / simulationTime * 1e-3) : 0.f;
+}
+
+float GPUProfiler::getEffectiveMLUPS() const {
+  // Lattice updates per millisecond of wall clock time, including UI, presentation and vsync
+  float frameTime = std::accumulate(frameTimeHistory.begin(), frameTimeHistory.end(), 0.f);
+  double latticeUpdates = std::accumulate(frameUpdateHistory.begin(), frameUpdateHistory.end(), 0.0);
+  return frameTime > 0.f ? static_cast<float>(latticeUpdates / frameTime * 1e-3) : 0.f;
+}
+
+bool GPUProfiler::hasPassCost(const PassTiming& pass) const {
+  return passCosts.contains(pass.name);
+}
+
+float GPUProfiler::getAchievedBandwidth(const PassTiming& pass) const {
+  auto it = passCosts.find(pass.name);
+  if (it == passCosts.end()) {
+    return 0.f;
+  }
+  float passTime = std::accumulate(pass.history.begin(), pass.history.end(), 0.f);
+  float invocations = std::accumulate(pass.invocationHistory.begin(), pass.invocationHistory.end(), 0.f);
+  return passTime > 0.f ? static_cast<float>(invocations * it->second.getBytes() / passTime * 1e-6) : 0.f;
+}
+
+float GPUProfiler::getAchievedFlops(const PassTiming& pass) const {
+  auto it = passCosts.find(pass.name);
+  if (it == passCosts.end()) {
+    return 0.f;
+  }
+  float passTime = std::accumulate(pass.history.begin(), pass.history.end(), 0.f);
+  float invocations = std::accumulate(pass.invocationHistory.begin(), pass.invocationHistory.end(), 0.f);
+  return passTime > 0.f ? static_cast<float>(invocations * it->second.flops / passTime * 1e-6) : 0.f;
+}
+
+float GPUProfiler::getPeakBandwidth() const {
+  return peakBandwidth;
+}
+
+void GPUProfiler::collectResults(FrameQueries& frame) {
+  // Queries complete in submission order, so the last one being ready means all of them are.
+  // If the GPU is still behind, the frame is dropped rather than waiting for it
+  GLint isAvailable = 0;
+  glGetQueryObjectiv(frame.queries[frame.queryCount - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+  if (!isAvailable) {
+    return;
+  }
+
+  // Sum the queries of each pass, a pass may be issued several times per frame
+  std::vector<float> passTimes(passTimings.size(), 0.f);
+  std::vector<float> passInvocations(passTimings.size(), 0.f);
+  for (unsigned int i = 0; i < frame.queryCount; i++) {
+    GLuint64 elapsedTime = 0;
+    glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsedTime);
+    passTimes[frame.passIndices[i]] += static_cast<float>(elapsedTime) * 1e-6f;
+    passInvocations[frame.passIndices[i]] += 1.f;
+
+    if (frame.hasTimestamps) {
+      GLuint64 startTime = 0;
+      glGetQueryObjectui64v(frame.timestampQueries[i], GL_QUERY_RESULT, &startTime);
+      Tracer::getInstance().recordEvent(passTimings[frame.passIndices[i]].name.c_str(), "gpu",
+                                        static_cast<double>(startTime) * 1e-3 + frame.gpuClockOffset,
+                                        static_cast<double>(elapsedTime) * 1e-3, Tracer::GPU_THREAD_ID);
+    }
+  }
+
+  // Summarise the frame for frame pacing statistics, blaming the pass furthest above its average.
+  // The averages must not include this frame yet, or a spike would partly hide itself
+  lastCollectedFrame = {frame.frameIndex, 0.f, "", 0.f};
+  for (unsigned int i = 0; i < passTimings.size(); i++) {
+    lastCollectedFrame.gpuTime += passTimes[i];
+    float excess = passTimes[i] - getAveragePassTime(passTimings[i]);
+    if (lastCollectedFrame.slowestPass.empty() || excess > lastCollectedFrame.slowestPassExcess) {
+      lastCollectedFrame.slowestPass = passTimings[i].name;
+      lastCollectedFrame.slowestPassExcess = excess;
+    }
+  }
+
+  // Advance the rolling statistics
+  float simulationTime = 0.f;
+  for (unsigned int i = 0; i < passTimings.size(); i++) {
+    passTimings[i].history[historyOffset] = passTimes[i];
+    passTimings[i].invocationHistory[historyOffset] = passInvocations[i];
+    if (passTimings[i].isSimulationPass) {
+      simulationTime += passTimes[i];
+    }
+  }
+  simulationTimeHistory[historyOffset] = simulationTime;
+  latticeUpdateHistory[historyOffset] = static_cast<double>(frame.latticeUpdates);
+  historyOffset = (historyOffset + 1) % HISTORY_SIZE;
+  historyCount = std::min(historyCount + 1, HISTORY_SIZE);
+  hasNewCollectedFrame = true;
+}
+
+unsigned int GPUProfiler::getPassIndex(const std::string& name, bool isSimulationPass) {
+  auto it = passIndices.find(name);
+  if (it != passIndices.end()) {
+    return it->second;
+  }
+
+  // Passes are listed in the order they are first issued
+  unsigned int index = static_cast<unsigned int>(passTimings.size());
+  passTimings.push_back({name, isSimulationPass, {}, {}});
+  passIndices.emplace(name, index);
+  return index;
+}
@@ -0,0 +1,145 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "core/tracer.h"
+#include "gl/gl_extensions.h"
+
+// Measures the GPU time of named passes with GL_TIME_ELAPSED queries.
+// Queries are double-buffered per frame and only read back once the frame after next begins,
+// so collecting the results never waits on the GPU. Requires OpenGL 3.3.
+// While the tracer is enabled, passes are also recorded as CPU zones and, using timestamp queries,
+// as events on the tracer's GPU timeline.
+class GPUProfiler {
+public:
+  static constexpr unsigned int HISTORY_SIZE = 120; // Number of frames kept for rolling statistics
+
+  // Memory traffic and arithmetic of one invocation of a pass
+  struct PassCost {
+    double bytesRead = 0.;
+    double bytesWritten = 0.;
+    double flops = 0.;
+
+    double getBytes() const { return bytesRead + bytesWritten; }
+    PassCost operator*(double scale) const { return {bytesRead * scale, bytesWritten * scale, flops * scale}; }
+    PassCost operator+(const PassCost& other) const {
+      return {bytesRead + other.bytesRead, bytesWritten + other.bytesWritten, flops + other.flops};
+    }
+  };
+
+  struct PassTiming {
+    std::string name;
+    bool isSimulationPass;                              // Counts towards the lattice update throughput
+    std::array<float, HISTORY_SIZE> history;            // GPU time per frame in ms, ring buffer
+    std::array<float, HISTORY_SIZE> invocationHistory;  // Number of invocations per frame, ring buffer
+  };
+
+  // GPU time of one frame, available once its queries have been collected
+  struct CollectedFrame {
+    uint64_t frameIndex = 0;
+    float gpuTime = 0.f;         // ms, summed over all passes
+    std::string slowestPass;     // Pass that exceeded its rolling average by the most
+    float slowestPassExcess = 0.f; // ms above that average
+  };
+
+  // GPUProfiler access method
+  static GPUProfiler& getInstance() {
+    static GPUProfiler instance;
+    return instance;
+  }
+
+  // Prevent copying or moving
+  GPUProfiler(const GPUProfiler&) = delete;
+  GPUProfiler& operator=(const GPUProfiler&) = delete;
+  GPUProfiler(GPUProfiler&&) = delete;
+  GPUProfiler& operator=(GPUProfiler&&) = delete;
+
+  void beginFrame();
+  void endFrame();
+  void beginPass(const std::string& name, bool isSimulationPass = true);
+  void endPass();
+  void addLatticeUpdates(uint64_t updateCount);
+  void setPassCost(const std::string& name, const PassCost& cost);
+  void setPeakBandwidth(float bandwidth);
+  void resetStatistics(); // Must be called between frames
+  void releaseQueries(); // Must be called while the GL context is still current
+
+  bool isSupported() const;
+  uint64_t getFrameIndex() const; // Index of the frame begun last
+  bool takeCollectedFrame(CollectedFrame& frame); // Returns each collected frame once
+  const std::vector<PassTiming>& getPassTimings() const;
+  const std::array<float, HISTORY_SIZE>& getFrameTimeHistory() const;
+  unsigned int getHistoryOffset() const;
+  unsigned int getFrameTimeHistoryOffset() const;
+  float getAveragePassTime(const PassTiming& pass) const;
+  float getMaxPassTime(const PassTiming& pass) const;
+  std::vector<float> getPassTimeSamples(const PassTiming& pass) const; // Frames that invoked the pass, oldest first
+  float getAverageGPUFrameTime() const;
+  float getAverageFrameTime() const;
+  float getSimulationMLUPS() const;
+  float getEffectiveMLUPS() const;
+  bool hasPassCost(const PassTiming& pass) const;
+  float getAchievedBandwidth(const PassTiming& pass) const; // GB/s
+  float getAchievedFlops(const PassTiming& pass) const;     // GFLOP/s
+  float getPeakBandwidth() const;                           // GB/s, 0 if not measured
+
+private:
+  // Queries issued during one frame, reused every other frame
+  struct FrameQueries {
+    std::vector<GLuint> queries;
+    std::vector<GLuint> timestampQueries;
+    std::vector<unsigned int> passIndices;
+    unsigned int queryCount = 0;
+    uint64_t latticeUpdates = 0;
+    bool isPending = false;
+    bool hasTimestamps = false;  // Pass start timestamps were recorded for the tracer
+    double gpuClockOffset = 0.;  // Tracer time minus GPU time in microseconds
+    uint64_t frameIndex = 0;
+  };
+
+  bool hasCheckedSupport = false;
+  bool hasTimerQueries = false;
+  bool isFrameActive = false;
+  unsigned int passDepth = 0; // Timer queries cannot nest, inner passes are attributed to the outer one
+  unsigned int frameParity = 0;
+  uint64_t frameCount = 0;
+  unsigned int activePassIndex = 0;
+  double activePassStartTime = -1.; // Tracer time of the outermost open pass, negative if not traced
+  std::array<FrameQueries, 2> frames;
+  std::unordered_map<std::string, unsigned int> passIndices;
+  std::vector<PassTiming> passTimings;
+  std::unordered_map<std::string, PassCost> passCosts;
+  float peakBandwidth = 0.f;
+
+  // GPU statistics, advanced once per collected frame
+  std::array<float, HISTORY_SIZE> simulationTimeHistory{};
+  std::array<double, HISTORY_SIZE> latticeUpdateHistory{};
+  unsigned int historyOffset = 0;
+  unsigned int historyCount = 0;
+  CollectedFrame lastCollectedFrame;
+  bool hasNewCollectedFrame = false;
+
+  // CPU frame time statistics, advanced once per frame
+  std::chrono::steady_clock::time_point lastFrameStart;
+  bool hasLastFrameStart = false;
+  std::array<float, HISTORY_SIZE> frameTimeHistory{};
+  std::array<double, HISTORY_SIZE> frameUpdateHistory{};
+  unsigned int frameTimeHistoryOffset = 0;
+  unsigned int frameTimeHistoryCount = 0;
+  uint64_t lastFrameLatticeUpdates = 0;
+
+  GPUProfiler() = default;
+
+  void collectResults(FrameQueries& frame);
+  unsigned int getPassIndex(const std::string& name, bool isSimulationPass);
+};
+
+#endif // GPU_PROFILER_H
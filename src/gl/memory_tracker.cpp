@@ -0,0 +1,200 @@
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "gl/gl_extensions.h"
+
+// Optional vendor extensions reporting video memory in KiB
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+static void writeString(std::ostream& out, const std::string& value) {
+  out << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out << '\\';
+    }
+    out << c;
+  }
+  out << '"';
+}
+
+uint64_t MemoryTracker::registerAllocation(MemoryKind kind, const std::string& owner, const std::string& name,
+                                           const std::string& format, unsigned int width, unsigned int height, size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  uint64_t id = nextId++;
+  allocations.emplace(id, Allocation{id, kind, owner, name, format, width, height, bytes});
+  size_t& total = totalBytes[static_cast<unsigned int>(kind)];
+  total += bytes;
+  size_t& peak = peakBytes[static_cast<unsigned int>(kind)];
+  peak = std::max(peak, total);
+  return id;
+}
+
+void MemoryTracker::releaseAllocation(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = allocations.find(id);
+  if (it == allocations.end()) {
+    return;
+  }
+  totalBytes[static_cast<unsigned int>(it->second.kind)] -= it->second.bytes;
+  allocations.erase(it);
+}
+
+std::vector<MemoryTracker::Allocation> MemoryTracker::getAllocations() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<Allocation> result;
+  result.reserve(allocations.size());
+  for (const auto& entry : allocations) {
+    result.push_back(entry.second);
+  }
+  return result;
+}
+
+size_t MemoryTracker::getTotalBytes(MemoryKind kind) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return totalBytes[static_cast<unsigned int>(kind)];
+}
+
+size_t MemoryTracker::getPeakBytes(MemoryKind kind) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return peakBytes[static_cast<unsigned int>(kind)];
+}
+
+size_t MemoryTracker::getDeviceBytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return totalBytes[static_cast<unsigned int>(MemoryKind::Texture)] + totalBytes[static_cast<unsigned int>(MemoryKind::Renderbuffer)] +
+         totalBytes[static_cast<unsigned int>(MemoryKind::Buffer)];
+}
+
+std::map<std::string, size_t> MemoryTracker::getBytesByOwner() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::map<std::string, size_t> owners;
+  for (const auto& entry : allocations) {
+    owners[entry.second.owner] += entry.second.bytes;
+  }
+  return owners;
+}
+
+MemoryTracker::DeviceMemory MemoryTracker::queryDeviceMemory() const {
+  DeviceMemory memory;
+  GLint values[4] = {0, 0, 0, 0};
+  if (hasGLExtension("GL_NVX_gpu_memory_info")) {
+    glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, values);
+    memory.totalBytes = static_cast<size_t>(values[0]) * 1024;
+    glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, values);
+    memory.availableBytes = static_cast<size_t>(values[0]) * 1024;
+    memory.source = "GL_NVX_gpu_memory_info";
+  } else if (hasGLExtension("GL_ATI_meminfo")) {
+    // Only the free memory in the texture pool is reported
+    glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, values);
+    memory.availableBytes = static_cast<size_t>(values[0]) * 1024;
+    memory.source = "GL_ATI_meminfo";
+  }
+  return memory;
+}
+
+void MemoryTracker::writeJSON(std::ostream& out) const {
+  // Query the driver before taking the lock, the allocations are then written from one snapshot
+  DeviceMemory device = queryDeviceMemory();
+  std::vector<Allocation> snapshot = getAllocations();
+  std::map<std::string, size_t> owners = getBytesByOwner();
+
+  out << "{\n  \"renderer\": ";
+  writeString(out, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+  out << ",\n  \"deviceMemory\": {\"source\": \"" << device.source << "\", \"totalBytes\": " << device.totalBytes
+      << ", \"availableBytes\": " << device.availableBytes << "},\n";
+  out << "  \"totals\": {";
+  for (unsigned int i = 0; i < KIND_COUNT; i++) {
+    MemoryKind kind = static_cast<MemoryKind>(i);
+    out << (i > 0 ? ", " : "") << "\"" << getKindName(kind) << "\": {\"bytes\": " << getTotalBytes(kind)
+        << ", \"peakBytes\": " << getPeakBytes(kind) << "}";
+  }
+  out << "},\n  \"deviceBytes\": " << getDeviceBytes() << ",\n";
+  out << "  \"owners\": {";
+  bool isFirst = true;
+  for (const auto& owner : owners) {
+    out << (isFirst ? "" : ", ");
+    writeString(out, owner.first);
+    out << ": " << owner.second;
+    isFirst = false;
+  }
+  out << "},\n  \"allocations\": [";
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    const Allocation& allocation = snapshot[i];
+    out << (i > 0 ? "," : "") << "\n    {\"kind\": \"" << getKindName(allocation.kind) << "\", \"owner\": ";
+    writeString(out, allocation.owner);
+    out << ", \"name\": ";
+    writeString(out, allocation.name);
+    out << ", \"format\": ";
+    writeString(out, allocation.format);
+    out << ", \"width\": " << allocation.width << ", \"height\": " << allocation.height << ", \"bytes\": " << allocation.bytes << "}";
+  }
+  out << (snapshot.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+bool MemoryTracker::exportJSON(const fs::path& path) const {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+  writeJSON(file);
+  return file.good();
+}
+
+const char* MemoryTracker::getKindName(MemoryKind kind) {
+  switch (kind) {
+    case MemoryKind::Texture: return "texture";
+    case MemoryKind::Renderbuffer: return "renderbuffer";
+    case MemoryKind::Buffer: return "buffer";
+    case MemoryKind::Host: return "host";
+  }
+  return "unknown";
+}
+
+const char* MemoryTracker::getFormatName(GLenum internalFormat) {
+  switch (internalFormat) {
+    case GL_RGBA32F: return "RGBA32F";
+    case GL_RGBA8: return "RGBA8";
+    case GL_R32F: return "R32F";
+    case GL_DEPTH24_STENCIL8: return "DEPTH24_STENCIL8";
+  }
+  return "unknown";
+}
+
+size_t MemoryTracker::getFormatSize(GLenum internalFormat) {
+  switch (internalFormat) {
+    case GL_RGBA32F: return 16;
+    case GL_RGBA8: return 4;
+    case GL_R32F: return 4;
+    case GL_DEPTH24_STENCIL8: return 4;
+  }
+  return 0;
+}
+
+TrackedAllocation::TrackedAllocation(MemoryKind kind, const std::string& owner, const std::string& name, const std::string& format,
+                                     unsigned int width, unsigned int height, size_t bytes)
+  : id(MemoryTracker::getInstance().registerAllocation(kind, owner, name, format, width, height, bytes)) {}
+
+TrackedAllocation::~TrackedAllocation() {
+  if (id != 0) {
+    MemoryTracker::getInstance().releaseAllocation(id);
+  }
+}
+
+TrackedAllocation::TrackedAllocation(TrackedAllocation&& other) noexcept : id(other.id) {
+  other.id = 0;
+}
+
+TrackedAllocation& TrackedAllocation::operator=(TrackedAllocation&& other) noexcept {
+  if (this != &other) {
+    if (id != 0) {
+      MemoryTracker::getInstance().releaseAllocation(id);
+    }
+    id = other.id;
+    other.id = 0;
+  }
+  return *this;
+}
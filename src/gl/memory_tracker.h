@@ -0,0 +1,105 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace fs = std::filesystem;
+
+enum class MemoryKind {
+  Texture,
+  Renderbuffer,
+  Buffer,
+  Host,
+};
+
+// Keeps a registry of the GPU resources and large host allocations made by the simulation, with their
+// format, dimensions, size and owner, so that the memory footprint of a lattice can be read off rather than estimated.
+// Allocations are registered through TrackedAllocation handles. Thread safe.
+class MemoryTracker {
+public:
+  static constexpr unsigned int KIND_COUNT = 4;
+
+  struct Allocation {
+    uint64_t id;
+    MemoryKind kind;
+    std::string owner;  // Simulation component the allocation belongs to, e.g. "Fluid"
+    std::string name;   // Role within the owner, e.g. "Framebuffer texture 0"
+    std::string format; // Internal format or element type
+    unsigned int width;
+    unsigned int height; // 0 for one-dimensional allocations
+    size_t bytes;
+  };
+
+  // Dedicated video memory reported by vendor extensions, zero where unavailable
+  struct DeviceMemory {
+    size_t totalBytes = 0;
+    size_t availableBytes = 0;
+    const char* source = "unavailable";
+  };
+
+  // MemoryTracker access method
+  static MemoryTracker& getInstance() {
+    static MemoryTracker instance;
+    return instance;
+  }
+
+  // Prevent copying or moving
+  MemoryTracker(const MemoryTracker&) = delete;
+  MemoryTracker& operator=(const MemoryTracker&) = delete;
+  MemoryTracker(MemoryTracker&&) = delete;
+  MemoryTracker& operator=(MemoryTracker&&) = delete;
+
+  uint64_t registerAllocation(MemoryKind kind, const std::string& owner, const std::string& name, const std::string& format,
+                              unsigned int width, unsigned int height, size_t bytes);
+  void releaseAllocation(uint64_t id);
+
+  std::vector<Allocation> getAllocations() const; // Ordered by registration
+  size_t getTotalBytes(MemoryKind kind) const;
+  size_t getPeakBytes(MemoryKind kind) const;
+  size_t getDeviceBytes() const; // Textures, renderbuffers and buffers
+  std::map<std::string, size_t> getBytesByOwner() const;
+  DeviceMemory queryDeviceMemory() const; // Must be called with a current GL context
+  void writeJSON(std::ostream& out) const;
+  bool exportJSON(const fs::path& path) const;
+
+  static const char* getKindName(MemoryKind kind);
+  static const char* getFormatName(GLenum internalFormat);
+  static size_t getFormatSize(GLenum internalFormat); // Bytes per texel
+
+private:
+  mutable std::mutex mutex;
+  std::map<uint64_t, Allocation> allocations;
+  std::array<size_t, KIND_COUNT> totalBytes{};
+  std::array<size_t, KIND_COUNT> peakBytes{};
+  uint64_t nextId = 1;
+
+  MemoryTracker() = default;
+};
+
+// Registers an allocation for its own lifetime
+class TrackedAllocation {
+public:
+  TrackedAllocation() = default;
+  TrackedAllocation(MemoryKind kind, const std::string& owner, const std::string& name, const std::string& format,
+                    unsigned int width, unsigned int height, size_t bytes);
+  ~TrackedAllocation();
+
+  TrackedAllocation(const TrackedAllocation&) = delete;
+  TrackedAllocation& operator=(const TrackedAllocation&) = delete;
+  TrackedAllocation(TrackedAllocation&& other) noexcept;
+  TrackedAllocation& operator=(TrackedAllocation&& other) noexcept;
+
+private:
+  uint64_t id = 0;
+};
+
+#endif // MEMORY_TRACKER_H
@@ -15,7 +15,7 @@ ShaderProgram::ShaderProgram(const fs::path& vertexShaderPath, const fs::path& f
   std::string fragmentShaderSource = loadShaderCode(fragmentShaderPath);
   GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
   GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-  linkProgram(vertexShader, fragmentShader);
+  linkProgram({vertexShader, fragmentShader});
 
   // Delete shaders after linking
   glDeleteShader(vertexShader);
@@ -24,6 +24,24 @@ ShaderProgram::ShaderProgram(const fs::path& vertexShaderPath, const fs::path& f
   cacheUniformLocations();
 }
 
+ShaderProgram::ShaderProgram(const fs::path& computeShaderPath) {
+  programId = glCreateProgram();
+  if(!programId) {
+    std::cout << "Error creating shader program!\n"; 
+    exit(1);
+  }
+
+  // Create compute program
+  std::string computeShaderSource = loadShaderCode(computeShaderPath);
+  GLuint computeShader = compileShader(GL_COMPUTE_SHADER, computeShaderSource);
+  linkProgram({computeShader});
+
+  // Delete shader after linking
+  glDeleteShader(computeShader);
+
+  cacheUniformLocations();
+}
+
 ShaderProgram::~ShaderProgram() {
   glDeleteProgram(programId);
 }
@@ -57,9 +75,10 @@ GLuint ShaderProgram::compileShader(GLenum type, const std::string& source) {
   return shader;
 }
 
-void ShaderProgram::linkProgram(GLuint vertexShader, GLuint fragmentShader) {
-  glAttachShader(programId, vertexShader);
-  glAttachShader(programId, fragmentShader);
+void ShaderProgram::linkProgram(const std::vector<GLuint>& shaders) {
+  for (GLuint shader : shaders) {
+    glAttachShader(programId, shader);
+  }
   glLinkProgram(programId);
 
   // Check for linking errors
@@ -72,8 +91,9 @@ void ShaderProgram::linkProgram(GLuint vertexShader, GLuint fragmentShader) {
   }
 
   // Detach shaders after linking
-  glDetachShader(programId, vertexShader);
-  glDetachShader(programId, fragmentShader);
+  for (GLuint shader : shaders) {
+    glDetachShader(programId, shader);
+  }
 }
 
 void ShaderProgram::validate(GLuint VAO) {
@@ -118,6 +138,10 @@ void ShaderProgram::setUniform(const std::string& name, const glm::vec2& value)
   glUniform2fv(uniformLocations[name], 1, &value[0]);
 }
 
+void ShaderProgram::setUniform(const std::string& name, const glm::ivec2& value) {
+  glUniform2iv(uniformLocations[name], 1, &value[0]);
+}
+
 void ShaderProgram::setUniform(const std::string& name, const glm::vec3& value) {
   glUniform3fv(uniformLocations[name], 1, &value[0]);
 }
@@ -134,6 +158,14 @@ void ShaderProgram::setUniform(const std::string& name, GLint value) {
   glUniform1i(uniformLocations[name], value);
 }
 
+void ShaderProgram::setUniform(const std::string& name, const std::vector<GLfloat>& values) {
+  glUniform1fv(uniformLocations[name], values.size(), values.data());
+}
+
+void ShaderProgram::setUniform(const std::string& name, const std::vector<GLint>& values) {
+  glUniform1iv(uniformLocations[name], values.size(), values.data());
+}
+
 void ShaderProgram::setTextureUniform(const std::string& name, GLuint textureID) {
   glActiveTexture(GL_TEXTURE0 + boundTextureCount); // Activate texture unit i
   glBindTexture(GL_TEXTURE_2D, textureID);
@@ -156,7 +188,48 @@ void ShaderProgram::setTextureUniform(const std::string& name, const std::vector
   glUniform1iv(uniformLocations[name], textureIDs.size(), &textureUnits[0]);
 }
 
+void ShaderProgram::setImageUniform(const std::string& name, GLuint textureID, GLenum access) {
+  glBindImageTexture(boundImageCount, textureID, 0, GL_FALSE, 0, access, GL_RGBA32F);
+  glUniform1i(uniformLocations[name], boundImageCount);
+  boundImageCount++;
+}
+
+void ShaderProgram::setImageUniform(const std::string& name, const std::vector<GLuint>& textureIDs, GLenum access) {
+  // Array to store image units corresponding to each texture
+  std::vector<GLint> imageUnits(textureIDs.size());
+
+  for (size_t i = 0; i < textureIDs.size(); ++i) {
+    glBindImageTexture(boundImageCount, textureIDs[i], 0, GL_FALSE, 0, access, GL_RGBA32F);
+    imageUnits[i] = boundImageCount;
+    boundImageCount++;
+  }
+
+  glUniform1iv(uniformLocations[name], textureIDs.size(), &imageUnits[0]);
+}
+
+void ShaderProgram::setStorageBuffer(const std::string& blockName, GLuint bufferID) {
+  // Look up and cache the block index, then assign it the next free binding point
+  auto it = storageBlockIndices.find(blockName);
+  if (it == storageBlockIndices.end()) {
+    it = storageBlockIndices.emplace(blockName, glGetProgramResourceIndex(programId, GL_SHADER_STORAGE_BLOCK, blockName.c_str())).first;
+  }
+  if (it->second != GL_INVALID_INDEX) {
+    glShaderStorageBlockBinding(programId, it->second, boundStorageBufferCount);
+  }
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, boundStorageBufferCount, bufferID);
+  boundStorageBufferCount++;
+}
+
+void ShaderProgram::setStorageBuffer(const std::string& blockName, const std::vector<GLuint>& bufferIDs) {
+  // Arrays of blocks are bound element by element
+  for (size_t i = 0; i < bufferIDs.size(); ++i) {
+    setStorageBuffer(blockName + "[" + std::to_string(i) + "]", bufferIDs[i]);
+  }
+}
+
 void ShaderProgram::use() {
   glUseProgram(programId);
   boundTextureCount = 0;
+  boundImageCount = 0;
+  boundStorageBufferCount = 0;
 }
@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm.hpp>
 
+#include "gl/gl_extensions.h"
+
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -17,6 +19,7 @@ namespace fs = std::filesystem;
 class ShaderProgram {
 public:
   ShaderProgram(const fs::path& vertexShaderPath, const fs::path& fragmentShaderPath);
+  explicit ShaderProgram(const fs::path& computeShaderPath); // Requires OpenGL 4.3
   ~ShaderProgram();
 
   // Disallow copy and assignment to avoid multiple deletions of OpenGL objects
@@ -28,21 +31,33 @@ public:
 
   // Uniform utility methods
   void setUniform(const std::string& name, const glm::vec2& value);
+  void setUniform(const std::string& name, const glm::ivec2& value);
   void setUniform(const std::string& name, const glm::vec3& value);
   void setUniform(const std::string& name, const glm::mat4& value);
   void setUniform(const std::string& name, GLfloat value);
   void setUniform(const std::string& name, GLint value);
+  void setUniform(const std::string& name, const std::vector<GLfloat>& values);
+  void setUniform(const std::string& name, const std::vector<GLint>& values);
   void setTextureUniform(const std::string& name, GLuint textureID);
   void setTextureUniform(const std::string& name, const std::vector<GLuint>& textureIDs);
 
+  // Compute shader utility methods
+  void setImageUniform(const std::string& name, GLuint textureID, GLenum access);
+  void setImageUniform(const std::string& name, const std::vector<GLuint>& textureIDs, GLenum access);
+  void setStorageBuffer(const std::string& blockName, GLuint bufferID);
+  void setStorageBuffer(const std::string& blockName, const std::vector<GLuint>& bufferIDs);
+
 private:
   unsigned int boundTextureCount = 0;
+  unsigned int boundImageCount = 0;
+  unsigned int boundStorageBufferCount = 0;
   GLuint programId;
   std::unordered_map<std::string, GLint> uniformLocations;
+  std::unordered_map<std::string, GLuint> storageBlockIndices;
 
   std::string loadShaderCode(const fs::path& shaderPath);
   GLuint compileShader(GLenum type, const std::string& source);
-  void linkProgram(GLuint vertexShader, GLuint fragmentShader);
+  void linkProgram(const std::vector<GLuint>& shaders);
   void cacheUniformLocations();
 };
 
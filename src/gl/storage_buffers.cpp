@@ -0,0 +1,60 @@
+#include "storage_buffers.h"
+
+#include <utility>
+
+StorageBuffer::StorageBuffer(GLsizeiptr size, const std::string& owner)
+  : size(size), allocation(MemoryKind::Buffer, owner, "Storage buffer", "float", static_cast<unsigned int>(size / sizeof(GLfloat)), 0, size) {
+  glGenBuffers(1, &ssbo);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  clear();
+}
+
+StorageBuffer::~StorageBuffer() {
+  glDeleteBuffers(1, &ssbo);
+}
+
+void StorageBuffer::clear() {
+  GLfloat zero = 0.f;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+  glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, &zero);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+GLuint StorageBuffer::getBuffer() const {
+  return ssbo;
+}
+
+GLsizeiptr StorageBuffer::getSize() const {
+  return size;
+}
+
+ReadWriteStorageBuffer::ReadWriteStorageBuffer(GLsizeiptr size, const std::string& owner, bool isDoubleBuffered)
+: readBuffer(std::make_unique<StorageBuffer>(size, owner)),
+  writeBuffer(isDoubleBuffered ? std::make_unique<StorageBuffer>(size, owner) : nullptr) {}
+
+void ReadWriteStorageBuffer::clear() {
+  readBuffer->clear();
+  if (writeBuffer) {
+    writeBuffer->clear();
+  }
+}
+
+GLuint ReadWriteStorageBuffer::getReadBuffer() const {
+  return readBuffer->getBuffer();
+}
+
+GLuint ReadWriteStorageBuffer::getWriteBuffer() const {
+  return writeBuffer ? writeBuffer->getBuffer() : readBuffer->getBuffer();
+}
+
+GLsizeiptr ReadWriteStorageBuffer::getSize() const {
+  return readBuffer->getSize();
+}
+
+void ReadWriteStorageBuffer::swap() {
+  if (writeBuffer) {
+    std::swap(readBuffer, writeBuffer);
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef STORAGE_BUFFERS_H
+#define STORAGE_BUFFERS_H
+
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+
+#include "gl/gl_extensions.h"
+#include "gl/memory_tracker.h"
+
+class StorageBuffer {
+public:
+  StorageBuffer(GLsizeiptr size, const std::string& owner);
+  ~StorageBuffer();
+
+  // Disallow copy and assignment
+  StorageBuffer(const StorageBuffer&) = delete;
+  StorageBuffer& operator=(const StorageBuffer&) = delete;
+
+  void clear();
+  GLuint getBuffer() const;
+  GLsizeiptr getSize() const;
+
+private:
+  GLuint ssbo;
+  GLsizeiptr size;
+  TrackedAllocation allocation;
+};
+
+
+class ReadWriteStorageBuffer {
+public:
+  // Single buffered instances read from and write to the same buffer
+  ReadWriteStorageBuffer(GLsizeiptr size, const std::string& owner, bool isDoubleBuffered = true);
+  ~ReadWriteStorageBuffer() = default;
+
+  // Disallow copy and assignment
+  ReadWriteStorageBuffer(const ReadWriteStorageBuffer&) = delete;
+  ReadWriteStorageBuffer& operator=(const ReadWriteStorageBuffer&) = delete;
+
+  void clear();
+  GLuint getReadBuffer() const;
+  GLuint getWriteBuffer() const;
+  GLsizeiptr getSize() const;
+  void swap();
+
+private:
+  std::unique_ptr<StorageBuffer> readBuffer;
+  std::unique_ptr<StorageBuffer> writeBuffer;
+};
+
+#endif // STORAGE_BUFFERS_H
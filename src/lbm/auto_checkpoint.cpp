@@ -0,0 +1,372 @@
+#include "lbm/auto_checkpoint.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+bool isSignalled(GLsync fence) {
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+bool parseSequence(const fs::path& path, uint64_t& sequence) {
+  unsigned long long value;
+  char extension[8] = {};
+  if (std::sscanf(path.filename().string().c_str(), "autosave_%llu.%7s", &value, extension) != 2 ||
+      std::strcmp(extension, "lbmc") != 0) {
+    return false;
+  }
+  sequence = value;
+  return true;
+}
+
+} // namespace
+
+AutoCheckpoint::AutoCheckpoint(std::shared_ptr<LBM> lbm)
+  : lbm(lbm), changeMap(lbm->getLatticeSize().x, lbm->getLatticeSize().y) {
+  // Continue the sequence of the checkpoints left by earlier sessions, so that the latest one is always restored
+  std::error_code directoryError;
+  for (const fs::directory_entry& entry : fs::directory_iterator(AUTO_CHECKPOINT_DIRECTORY, directoryError)) {
+    uint64_t sequence;
+    if (parseSequence(entry.path(), sequence)) {
+      nextSequence = std::max(nextSequence, sequence + 1);
+    }
+  }
+
+  const size_t changeSize = static_cast<size_t>(changeMap.pyramid.tileCount.x) * changeMap.pyramid.tileCount.y * sizeof(GLfloat);
+  glGenFramebuffers(1, &readFramebuffer);
+  glGenBuffers(1, &changeBuffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, changeBuffer);
+  glBufferData(GL_PIXEL_PACK_BUFFER, changeSize, nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  changeAllocation = TrackedAllocation(MemoryKind::Buffer, "Auto-checkpoint", "Change readback", "bytes", changeSize, 0, changeSize);
+  for (Readback& readback : readbacks) {
+    glGenBuffers(1, &readback.buffer);
+  }
+
+  worker = std::thread(&AutoCheckpoint::writeJobs, this);
+}
+
+AutoCheckpoint::~AutoCheckpoint() {
+  // Tiles already read back are written before the worker stops
+  finishReadbacks(true);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+  condition.notify_one();
+  worker.join();
+
+  if (changeFence != nullptr) {
+    glDeleteSync(changeFence);
+  }
+  for (Readback& readback : readbacks) {
+    glDeleteBuffers(1, &readback.buffer);
+  }
+  glDeleteBuffers(1, &changeBuffer);
+  glDeleteFramebuffers(1, &readFramebuffer);
+}
+
+void AutoCheckpoint::update() {
+  const AppState& appState = AppState::getInstance();
+  finishReadbacks(false);
+  {
+    // A chain with a missing checkpoint can only be continued by a keyframe
+    std::lock_guard<std::mutex> lock(mutex);
+    isKeyframeRequested = isKeyframeRequested || hasWriteFailed;
+    hasWriteFailed = false;
+  }
+  if (stage == Detecting) {
+    finishDetection();
+  }
+  if (!appState.isAutoCheckpointEnabled) {
+    hasStarted = false;
+    return;
+  }
+  if (stage != Idle || !isTriggered() || readbacks[nextReadback].fence != nullptr) {
+    return;
+  }
+
+  hasStarted = true;
+  lastStep = lbm->getStepCount();
+  if (isKeyframeRequested || deltaCount + 1 >= appState.autoCheckpointKeyframeInterval) {
+    std::vector<uint32_t> tiles(static_cast<size_t>(changeMap.pyramid.tileCount.x) * changeMap.pyramid.tileCount.y);
+    for (uint32_t i = 0; i < tiles.size(); i++) {
+      tiles[i] = i;
+    }
+    beginReadback(tiles, true);
+  } else {
+    beginDetection();
+  }
+}
+
+bool AutoCheckpoint::restoreLatest(std::string& error) {
+  uint64_t sequence;
+  if (!Checkpoint::loadLatestTiles(*lbm, AUTO_CHECKPOINT_DIRECTORY, sequence, error)) {
+    return false;
+  }
+
+  // A detection in flight refers to the state before the restart, and a keyframe starts a chain of the restored state
+  if (stage == Detecting) {
+    glDeleteSync(changeFence);
+    changeFence = nullptr;
+    stage = Idle;
+  }
+  isKeyframeRequested = true;
+  lastStep = lbm->getStepCount();
+  return true;
+}
+
+AutoCheckpoint::Status AutoCheckpoint::getStatus() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return status;
+}
+
+fs::path AutoCheckpoint::getPath(uint64_t sequence) {
+  char fileName[64];
+  std::snprintf(fileName, sizeof(fileName), "autosave_%08llu.lbmc", static_cast<unsigned long long>(sequence));
+  return fs::path(AUTO_CHECKPOINT_DIRECTORY) / fileName;
+}
+
+bool AutoCheckpoint::isTriggered() const {
+  // Loading an earlier state also starts a new interval
+  const uint64_t stepCount = lbm->getStepCount();
+  return !hasStarted || stepCount < lastStep || stepCount >= lastStep + AppState::getInstance().autoCheckpointInterval;
+}
+
+void AutoCheckpoint::beginDetection() {
+  lbm->updateChangeMap(changeMap);
+
+  // Queue the readback of the change per tile, the fence is polled in the following frames
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+  glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, changeMap.pyramid.levels.back()->getTexture(0), 0);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, changeBuffer);
+  glReadPixels(0, 0, changeMap.pyramid.tileCount.x, changeMap.pyramid.tileCount.y, GL_RED, GL_FLOAT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  changeFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  stage = Detecting;
+}
+
+void AutoCheckpoint::finishDetection() {
+  if (!isSignalled(changeFence) || readbacks[nextReadback].fence != nullptr) {
+    return;
+  }
+  glDeleteSync(changeFence);
+  changeFence = nullptr;
+  stage = Idle;
+
+  // Select the tiles that changed beyond the threshold
+  const size_t tileCount = static_cast<size_t>(changeMap.pyramid.tileCount.x) * changeMap.pyramid.tileCount.y;
+  const GLfloat threshold = AppState::getInstance().autoCheckpointThreshold;
+  std::vector<uint32_t> tiles;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, changeBuffer);
+  const GLfloat* changes = static_cast<const GLfloat*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, tileCount * sizeof(GLfloat), GL_MAP_READ_BIT));
+  if (changes != nullptr) {
+    for (uint32_t i = 0; i < tileCount; i++) {
+      if (!(changes[i] <= threshold)) {
+        tiles.push_back(i);
+      }
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if (tiles.empty()) {
+    std::lock_guard<std::mutex> lock(mutex);
+    status.unchangedCount++;
+    return;
+  }
+  beginReadback(tiles, false);
+}
+
+void AutoCheckpoint::beginReadback(const std::vector<uint32_t>& tiles, bool isKeyframe) {
+  Readback& readback = readbacks[nextReadback];
+  const std::string readbackName = "Tile readback " + std::to_string(nextReadback);
+  nextReadback = (nextReadback + 1) % READBACK_COUNT;
+
+  // The header and resources are those of the current step, which the tiles are read at
+  const glm::ivec2 latticeSize = lbm->getLatticeSize();
+  const size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+  Job& job = readback.job;
+  job.header = Checkpoint::createHeader(*lbm);
+  job.header.tileSize = ChangeMap::TILE_SIZE;
+  job.resources = lbm->getStateResources();
+  job.tiles = tiles;
+  if (isKeyframe) {
+    previousKeyframeSequence = keyframeSequence;
+    keyframeSequence = nextSequence;
+    deltaCount = 0;
+    isKeyframeRequested = false;
+    job.expiredSequence = previousKeyframeSequence;
+  } else {
+    job.header.flags |= Checkpoint::IS_DELTA;
+    deltaCount++;
+  }
+  job.header.sequence = nextSequence++;
+  job.header.keyframeSequence = keyframeSequence;
+
+  // Every resource of a tile follows the previous one in the readback buffer
+  std::vector<size_t> offsets;
+  size_t size = 0;
+  for (uint32_t tile : tiles) {
+    glm::ivec4 rect = Checkpoint::getTileRect(tile, ChangeMap::TILE_SIZE, latticeSize);
+    for (const LBM::StateResource& resource : job.resources) {
+      offsets.push_back(size);
+      size += static_cast<size_t>(rect.z) * rect.w * (resource.size / nodeCount);
+    }
+  }
+  job.tileData.resize(size);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  if (size > readback.capacity) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    readback.capacity = size;
+    readback.allocation = TrackedAllocation(MemoryKind::Buffer, "Auto-checkpoint", readbackName, "bytes", size, 0, size);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  // The reference of the selected tiles becomes their state as read back
+  selectTiles(tiles);
+  lbm->updateChangeReference(changeMap);
+
+  // Image and storage writes of the compute passes must be visible to the transfers
+  const bool isCompute = lbm->getBackend() != SolverBackend::FragmentShader;
+  if (isCompute) {
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+  }
+  const size_t resourceCount = job.resources.size();
+  for (size_t i = 0; i < resourceCount; i++) {
+    const LBM::StateResource& resource = job.resources[i];
+    if (resource.texture != 0) {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+      glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resource.texture, 0);
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    }
+    for (size_t j = 0; j < tiles.size(); j++) {
+      glm::ivec4 rect = Checkpoint::getTileRect(tiles[j], ChangeMap::TILE_SIZE, latticeSize);
+      size_t offset = offsets[j * resourceCount + i];
+      if (resource.texture != 0) {
+        GLenum pixelFormat = (resource.format == GL_R32F) ? GL_RED : GL_RGBA;
+        glReadPixels(rect.x, rect.y, rect.z, rect.w, pixelFormat, GL_FLOAT, reinterpret_cast<void*>(offset));
+      } else {
+        lbm->gatherTile(resource, rect, readback.buffer, offset);
+      }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  }
+  if (isCompute) {
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  }
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+}
+
+void AutoCheckpoint::finishReadbacks(bool isBlocking) {
+  // Readbacks complete in the order they were issued, starting with the oldest
+  for (unsigned int i = 0; i < READBACK_COUNT; i++) {
+    Readback& readback = readbacks[(nextReadback + i) % READBACK_COUNT];
+    if (readback.fence == nullptr) {
+      continue;
+    }
+    if (isBlocking) {
+      glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    } else if (!isSignalled(readback.fence)) {
+      return;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.job.tileData.size(), GL_MAP_READ_BIT);
+    bool isMapped = data != nullptr;
+    if (isMapped) {
+      std::memcpy(readback.job.tileData.data(), data, readback.job.tileData.size());
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isMapped) {
+      jobs.push_back(std::move(readback.job));
+      condition.notify_one();
+    } else {
+      status.error = "Failed to map the auto-checkpoint readback buffer";
+      hasWriteFailed = true;
+    }
+    readback.job = Job();
+  }
+}
+
+void AutoCheckpoint::selectTiles(const std::vector<uint32_t>& tiles) {
+  std::vector<GLfloat> selection(static_cast<size_t>(changeMap.pyramid.tileCount.x) * changeMap.pyramid.tileCount.y, 0.f);
+  for (uint32_t tile : tiles) {
+    selection[tile] = 1.f;
+  }
+  glBindTexture(GL_TEXTURE_2D, changeMap.selectedTiles->getTexture(0));
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, changeMap.pyramid.tileCount.x, changeMap.pyramid.tileCount.y, GL_RED, GL_FLOAT, selection.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void AutoCheckpoint::writeJobs() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    condition.wait(lock, [this] { return isStopping || !jobs.empty(); });
+    if (jobs.empty()) {
+      return;
+    }
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+    lock.unlock();
+
+    // Write the checkpoint, then drop the chain before the previous keyframe
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    std::error_code directoryError;
+    fs::create_directories(AUTO_CHECKPOINT_DIRECTORY, directoryError);
+    const fs::path path = getPath(job.header.sequence);
+    const bool isKeyframe = (job.header.flags & Checkpoint::IS_DELTA) == 0;
+    const bool isSaved = Checkpoint::saveTiles(path, job.header, job.resources, job.tiles, job.tileData, error);
+    if (isSaved && isKeyframe) {
+      removeExpiredCheckpoints(job.expiredSequence);
+    }
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    lock.lock();
+    if (isSaved) {
+      const uint64_t tileSize = job.header.tileSize;
+      status.hasCheckpoint = true;
+      status.sequence = job.header.sequence;
+      status.stepCount = job.header.stepCount;
+      status.isKeyframe = isKeyframe;
+      status.tileCount = job.tiles.size();
+      status.totalTileCount = ((job.header.width + tileSize - 1) / tileSize) * ((job.header.height + tileSize - 1) / tileSize);
+      status.bytes = fs::file_size(path, directoryError);
+      status.writeTime = milliseconds;
+      status.error.clear();
+    } else {
+      status.error = error;
+      hasWriteFailed = true;
+    }
+  }
+}
+
+void AutoCheckpoint::removeExpiredCheckpoints(uint64_t firstSequence) {
+  std::error_code directoryError;
+  std::vector<fs::path> expiredPaths;
+  for (const fs::directory_entry& entry : fs::directory_iterator(AUTO_CHECKPOINT_DIRECTORY, directoryError)) {
+    uint64_t sequence;
+    if (parseSequence(entry.path(), sequence) && sequence < firstSequence) {
+      expiredPaths.push_back(entry.path());
+    }
+  }
+  for (const fs::path& path : expiredPaths) {
+    fs::remove(path, directoryError);
+  }
+}
@@ -0,0 +1,128 @@
+#ifndef AUTO_CHECKPOINT_H
+#define AUTO_CHECKPOINT_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+
+#include "gl/memory_tracker.h"
+#include "lbm/change_map.h"
+#include "lbm/checkpoint.h"
+#include "lbm/lbm.h"
+
+namespace fs = std::filesystem;
+
+// Periodic tiled checkpoints of the simulation that never wait for the GPU or the disk.
+// Every AppState::autoCheckpointInterval steps the change of the macroscopic fields since each tile was last
+// checkpointed is reduced on the GPU (see ChangeMap), and the tiles whose change exceeds
+// AppState::autoCheckpointThreshold are copied into one of a ring of pixel pack buffers. Once the fence of a readback
+// has signalled in a later frame, its tiles are handed to a worker thread, which writes them as a delta to
+// AUTO_CHECKPOINT_DIRECTORY. Every AppState::autoCheckpointKeyframeInterval checkpoints hold all tiles instead.
+//
+// The change map is read back a frame after it is computed, so the tiles of a checkpoint are read some steps after
+// they were selected, and a delta combines tiles of that step with tiles last written at earlier steps that have since
+// changed less than the threshold.
+class AutoCheckpoint {
+public:
+  static constexpr unsigned int READBACK_COUNT = 3; // Checkpoints whose tiles can be in flight at once
+
+  // Outcome of the latest auto-checkpoint
+  struct Status {
+    bool hasCheckpoint = false;
+    uint64_t sequence = 0;
+    uint64_t stepCount = 0;
+    bool isKeyframe = false;
+    size_t tileCount = 0;
+    size_t totalTileCount = 0;
+    uint64_t bytes = 0;
+    double writeTime = 0.; // Milliseconds on the worker thread
+    uint64_t unchangedCount = 0; // Intervals without any changed tile, which write no checkpoint
+    std::string error;
+  };
+
+  AutoCheckpoint(std::shared_ptr<LBM> lbm);
+  ~AutoCheckpoint(); // Writes the checkpoints already read back
+
+  // Disallow copy and assignment to avoid multiple deletions of OpenGL objects
+  AutoCheckpoint(const AutoCheckpoint&) = delete;
+  AutoCheckpoint& operator=(const AutoCheckpoint&) = delete;
+
+  // Call once per frame after the simulation steps, with the context current
+  void update();
+
+  // Restores the latest checkpoint in AUTO_CHECKPOINT_DIRECTORY, the next auto-checkpoint is a keyframe
+  bool restoreLatest(std::string& error);
+
+  Status getStatus() const;
+  static fs::path getPath(uint64_t sequence);
+
+private:
+  // Tiles of one checkpoint on their way from the GPU to the worker thread
+  struct Job {
+    Checkpoint::Header header;
+    std::vector<LBM::StateResource> resources;
+    std::vector<uint32_t> tiles;
+    std::vector<uint8_t> tileData; // Every resource of a tile in turn
+    uint64_t expiredSequence = 0;  // Checkpoints before this one are removed once a keyframe is written
+  };
+
+  struct Readback {
+    GLuint buffer = 0;
+    size_t capacity = 0; // Bytes
+    GLsync fence = nullptr;
+    Job job;
+    TrackedAllocation allocation;
+  };
+
+  enum Stage {
+    Idle,
+    Detecting, // The change map is being read back
+  };
+
+  std::shared_ptr<LBM> lbm;
+  ChangeMap changeMap;
+  Stage stage = Idle;
+  bool hasStarted = false;        // Auto-checkpoints were enabled at the last update
+  uint64_t lastStep = 0;          // Step at which the last checkpoint was started
+  uint64_t nextSequence = 0;
+  uint64_t keyframeSequence = 0;  // Of the checkpoints since the latest keyframe
+  uint64_t previousKeyframeSequence = 0;
+  unsigned int deltaCount = 0;    // Since the latest keyframe
+  bool isKeyframeRequested = true; // The reference or the written chain no longer matches the simulation state
+  GLuint readFramebuffer;
+  GLuint changeBuffer;            // Pixel pack buffer receiving the coarsest change level
+  GLsync changeFence = nullptr;
+  std::array<Readback, READBACK_COUNT> readbacks;
+  unsigned int nextReadback = 0;  // Readbacks are issued and completed in ring order
+  TrackedAllocation changeAllocation;
+
+  // Worker thread state, guarded by the mutex
+  std::thread worker;
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<Job> jobs;
+  bool isStopping = false;
+  bool hasWriteFailed = false;
+  Status status;
+
+  bool isTriggered() const;
+  void beginDetection();
+  void finishDetection();
+  void beginReadback(const std::vector<uint32_t>& tiles, bool isKeyframe);
+  void finishReadbacks(bool isBlocking);
+  void selectTiles(const std::vector<uint32_t>& tiles);
+  void writeJobs();
+  static void removeExpiredCheckpoints(uint64_t firstSequence);
+};
+
+#endif // AUTO_CHECKPOINT_H
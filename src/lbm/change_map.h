@@ -0,0 +1,29 @@
+#ifndef CHANGE_MAP_H
+#define CHANGE_MAP_H
+
+#include <memory>
+
+#include "gl/framebuffers.h"
+#include "lbm/max_pyramid.h"
+
+// Coarse map of how much each lattice tile changed since it was last auto-checkpointed. The reference holds the
+// macroscopic fields of every tile as of its last checkpoint, velocity, density and node ID in the first texture and
+// the concentrations in the second. The pyramid reduces the largest change down to one value per checkpoint tile.
+struct ChangeMap {
+  ChangeMap(const unsigned int width, const unsigned int height) : pyramid(width, height, LEVEL_COUNT, "Auto-checkpoint") {
+    reference = std::make_unique<Framebuffer>(width, height, 2, "Auto-checkpoint");
+    reference->clear(0.0, 0.0, 0.0, 0.0);
+    selectedTiles = std::make_unique<Framebuffer>(pyramid.tileCount.x, pyramid.tileCount.y, 1, "Auto-checkpoint");
+    selectedTiles->clear(0.0, 0.0, 0.0, 0.0);
+  }
+  ~ChangeMap() = default;
+
+  static constexpr unsigned int LEVEL_COUNT = 3;
+  static constexpr unsigned int TILE_SIZE = MaxPyramid::getTileSize(LEVEL_COUNT);
+
+  MaxPyramid pyramid;
+  std::unique_ptr<Framebuffer> reference;
+  std::unique_ptr<Framebuffer> selectedTiles; // Tiles whose reference is updated, red above 0.5
+};
+
+#endif // CHANGE_MAP_H
@@ -0,0 +1,874 @@
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <vector>
+
+#if defined(_WIN32)
+  #include <iterator>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include "gl/gl_extensions.h"
+#include "gl/memory_tracker.h"
+#include "lbm/lbm.h"
+#include "lbm/population_codec.h"
+
+namespace {
+
+// Read-only view of a whole file, memory-mapped where the platform allows it
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile() {
+#if !defined(_WIN32)
+    if (data != nullptr) {
+      munmap(const_cast<uint8_t*>(data), size);
+    }
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const fs::path& path, std::string& error) {
+#if defined(_WIN32)
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      error = "Failed to open " + path.string();
+      return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = contents.data();
+    size = contents.size();
+    return true;
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      error = "Failed to open " + path.string();
+      return false;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+      close(descriptor);
+      error = "Failed to read " + path.string();
+      return false;
+    }
+    size = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+      error = "Failed to map " + path.string();
+      size = 0;
+      return false;
+    }
+    // Sections are read front to back exactly once
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    data = static_cast<const uint8_t*>(mapping);
+    return true;
+#endif
+  }
+
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+
+private:
+#if defined(_WIN32)
+  std::vector<uint8_t> contents;
+#endif
+};
+
+// Part of a section that is transferred through one staging buffer
+struct Chunk {
+  const LBM::StateResource* resource;
+  uint64_t fileOffset;
+  uint64_t resourceOffset; // Bytes into a storage buffer
+  size_t size;
+  GLint firstRow;          // Rows of a texture
+  GLsizei rowCount;
+};
+
+// Pair of staging buffers, so that one chunk can be transferred by the GPU while the other is copied by the CPU
+class Transfer {
+public:
+  Transfer(const glm::ivec2& latticeSize, const std::vector<Chunk>& chunks)
+    : latticeSize(latticeSize),
+      allocation(MemoryKind::Buffer, "Checkpoint", "Staging buffers", "bytes", getMaxChunkSize(chunks), 2, 2 * getMaxChunkSize(chunks)) {
+    glGenBuffers(2, stagingBuffers);
+    glGenFramebuffers(1, &readFramebuffer);
+  }
+
+  ~Transfer() {
+    glDeleteBuffers(2, stagingBuffers);
+    glDeleteFramebuffers(1, &readFramebuffer);
+  }
+
+  Transfer(const Transfer&) = delete;
+  Transfer& operator=(const Transfer&) = delete;
+
+  void beginRead(const Chunk& chunk, unsigned int slot) const {
+    // Queue the copy of a chunk from its resource into a staging buffer
+    if (chunk.resource->texture != 0) {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+      glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, chunk.resource->texture, 0);
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, stagingBuffers[slot]);
+      glBufferData(GL_PIXEL_PACK_BUFFER, chunk.size, nullptr, GL_STREAM_READ);
+      glReadPixels(0, chunk.firstRow, latticeSize.x, chunk.rowCount, getPixelFormat(*chunk.resource), GL_FLOAT, nullptr);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    } else {
+      glBindBuffer(GL_COPY_READ_BUFFER, chunk.resource->buffer);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, stagingBuffers[slot]);
+      glBufferData(GL_COPY_WRITE_BUFFER, chunk.size, nullptr, GL_STREAM_READ);
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, chunk.resourceOffset, 0, chunk.size);
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+  }
+
+  const void* mapForReading(unsigned int slot, size_t size) const {
+    // Blocks until the queued copy into this staging buffer has completed
+    glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffers[slot]);
+    return glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, GL_MAP_READ_BIT);
+  }
+
+  void unmapForReading() const {
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  }
+
+  void write(const Chunk& chunk, unsigned int slot, const uint8_t* data) const {
+    // Orphan the staging buffer, so that filling it never waits for the transfer of its previous chunk
+    glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffers[slot]);
+    glBufferData(GL_COPY_READ_BUFFER, chunk.size, nullptr, GL_STREAM_DRAW);
+    void* staging = glMapBufferRange(GL_COPY_READ_BUFFER, 0, chunk.size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    std::memcpy(staging, data, chunk.size);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    if (chunk.resource->texture != 0) {
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffers[slot]);
+      glBindTexture(GL_TEXTURE_2D, chunk.resource->texture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, chunk.firstRow, latticeSize.x, chunk.rowCount, getPixelFormat(*chunk.resource), GL_FLOAT,
+                      nullptr);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else {
+      glBindBuffer(GL_COPY_WRITE_BUFFER, chunk.resource->buffer);
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, chunk.resourceOffset, chunk.size);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+  }
+
+private:
+  glm::ivec2 latticeSize;
+  GLuint stagingBuffers[2];
+  GLuint readFramebuffer;
+  TrackedAllocation allocation;
+
+  static size_t getMaxChunkSize(const std::vector<Chunk>& chunks) {
+    size_t size = 0;
+    for (const Chunk& chunk : chunks) {
+      size = std::max(size, chunk.size);
+    }
+    return size;
+  }
+
+  static GLenum getPixelFormat(const LBM::StateResource& resource) {
+    return resource.format == GL_R32F ? GL_RED : GL_RGBA;
+  }
+};
+
+uint64_t alignSection(uint64_t offset) {
+  return (offset + Checkpoint::SECTION_ALIGNMENT - 1) / Checkpoint::SECTION_ALIGNMENT * Checkpoint::SECTION_ALIGNMENT;
+}
+
+std::vector<Chunk> getChunks(const std::vector<LBM::StateResource>& resources, const std::vector<Checkpoint::Section>& sections,
+                             const glm::ivec2& latticeSize) {
+  // Textures are split into whole rows, storage buffers into byte ranges
+  std::vector<Chunk> chunks;
+  for (size_t i = 0; i < resources.size(); i++) {
+    const LBM::StateResource& resource = resources[i];
+    if (resource.texture != 0) {
+      size_t rowSize = resource.size / latticeSize.y;
+      GLsizei rowsPerChunk = std::max<GLsizei>(1, static_cast<GLsizei>(Checkpoint::STAGING_SIZE / rowSize));
+      for (GLint row = 0; row < latticeSize.y; row += rowsPerChunk) {
+        GLsizei rowCount = std::min(rowsPerChunk, latticeSize.y - row);
+        chunks.push_back({&resource, sections[i].offset + row * rowSize, 0, rowCount * rowSize, row, rowCount});
+      }
+    } else {
+      for (uint64_t offset = 0; offset < resource.size; offset += Checkpoint::STAGING_SIZE) {
+        size_t size = std::min<uint64_t>(Checkpoint::STAGING_SIZE, resource.size - offset);
+        chunks.push_back({&resource, sections[i].offset + offset, offset, size, 0, 0});
+      }
+    }
+  }
+  return chunks;
+}
+
+bool parseHeader(const MappedFile& file, Checkpoint::Header& header, std::vector<Checkpoint::Section>& sections, std::string& error) {
+  if (file.size < sizeof(Checkpoint::Header)) {
+    error = "File is too small for a checkpoint";
+    return false;
+  }
+  std::memcpy(&header, file.data, sizeof(header));
+  if (std::memcmp(header.magic, Checkpoint::MAGIC, sizeof(Checkpoint::MAGIC)) != 0) {
+    error = "Not a checkpoint file";
+    return false;
+  }
+  if (header.version != Checkpoint::VERSION) {
+    error = "Unsupported checkpoint version " + std::to_string(header.version);
+    return false;
+  }
+  if (header.backend > static_cast<uint32_t>(SolverBackend::InPlaceComputeShader) || header.width == 0 || header.height == 0) {
+    error = "Checkpoint header is corrupt";
+    return false;
+  }
+  uint64_t tableEnd = sizeof(Checkpoint::Header) + static_cast<uint64_t>(header.sectionCount) * sizeof(Checkpoint::Section);
+  if (tableEnd > file.size) {
+    error = "Checkpoint section table is truncated";
+    return false;
+  }
+  sections.resize(header.sectionCount);
+  std::memcpy(sections.data(), file.data + sizeof(Checkpoint::Header), sections.size() * sizeof(Checkpoint::Section));
+  for (const Checkpoint::Section& section : sections) {
+    if (section.offset % Checkpoint::SECTION_ALIGNMENT != 0 || section.offset < tableEnd || section.size > file.size ||
+        section.offset > file.size - section.size) {
+      error = "Checkpoint section is truncated or misaligned";
+      return false;
+    }
+  }
+  return true;
+}
+
+// Plane of one float per node within a resource, population q of a layout is one of them
+struct Plane {
+  size_t offset; // Floats
+  size_t stride;
+};
+
+std::vector<Plane> getPlanes(const LBM::StateResource& resource, size_t nodeCount) {
+  // Texels interleave their components, storage buffers hold one plane after the other
+  size_t planeCount = resource.size / (nodeCount * sizeof(GLfloat));
+  std::vector<Plane> planes;
+  for (size_t i = 0; i < planeCount; i++) {
+    planes.push_back(resource.texture != 0 ? Plane{i, planeCount} : Plane{i * nodeCount, 1});
+  }
+  return planes;
+}
+
+bool isPopulationPlane(const std::vector<LBM::PopulationLayout>& layouts, unsigned int resource, const Plane& plane) {
+  for (const LBM::PopulationLayout& layout : layouts) {
+    for (const LBM::PopulationSlot& slot : layout.slots) {
+      if (slot.resource == resource && slot.offset == plane.offset && slot.stride == plane.stride) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+
+Checkpoint::Section makeSection(const std::string& name, uint32_t format, uint32_t encoding, const glm::ivec2& latticeSize,
+                                uint64_t size) {
+  Checkpoint::Section section;
+  std::memset(&section, 0, sizeof(section));
+  std::strncpy(section.name, name.c_str(), sizeof(section.name) - 1);
+  section.format = format;
+  section.width = latticeSize.x;
+  section.height = latticeSize.y;
+  section.encoding = encoding;
+  section.size = size;
+  return section;
+}
+
+void placeSections(std::vector<Checkpoint::Section>& sections) {
+  // Sections follow the table, each at the next aligned offset
+  uint64_t offset = alignSection(sizeof(Checkpoint::Header) + sections.size() * sizeof(Checkpoint::Section));
+  for (Checkpoint::Section& section : sections) {
+    section.offset = offset;
+    offset = alignSection(offset + section.size);
+  }
+}
+
+bool matchesResource(const Checkpoint::Section& section, const LBM::StateResource& resource) {
+  uint32_t format = resource.texture != 0 ? resource.format : 0;
+  return std::strncmp(section.name, resource.name.c_str(), sizeof(section.name)) == 0 && section.format == format;
+}
+
+bool readState(const LBM& lbm, const std::vector<Chunk>& chunks, const std::function<bool(const Chunk&, const void*)>& consume,
+               std::string& error) {
+  // Image and storage writes of the compute passes must be visible to the transfers
+  if (lbm.getBackend() != SolverBackend::FragmentShader) {
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+  }
+
+  // Read back one chunk while the previous one is consumed
+  Transfer transfer(lbm.getLatticeSize(), chunks);
+  if (!chunks.empty()) {
+    transfer.beginRead(chunks[0], 0);
+  }
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (i + 1 < chunks.size()) {
+      transfer.beginRead(chunks[i + 1], (i + 1) % 2);
+    }
+    const void* data = transfer.mapForReading(i % 2, chunks[i].size);
+    if (data == nullptr) {
+      transfer.unmapForReading();
+      error = "Failed to map the checkpoint staging buffer";
+      return false;
+    }
+    bool isConsumed = consume(chunks[i], data);
+    transfer.unmapForReading();
+    if (!isConsumed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void writeState(LBM& lbm, const std::vector<Chunk>& chunks, const std::function<const uint8_t*(const Chunk&)>& getData) {
+  // Stream the chunks into the resources, alternating between the staging buffers
+  Transfer transfer(lbm.getLatticeSize(), chunks);
+  for (size_t i = 0; i < chunks.size(); i++) {
+    transfer.write(chunks[i], i % 2, getData(chunks[i]));
+  }
+  if (lbm.getBackend() != SolverBackend::FragmentShader) {
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+}
+
+bool writeFile(const fs::path& path, const Checkpoint::Header& header, const std::vector<Checkpoint::Section>& sections,
+               const std::function<bool(std::ofstream&)>& writeSections, std::string& error) {
+  // Write next to the target first, so that an interrupted save never replaces a good checkpoint
+  fs::path temporaryPath = path;
+  temporaryPath += ".tmp";
+  std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    error = "Failed to open " + temporaryPath.string() + " for writing";
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Checkpoint::Section));
+  if (!file) {
+    error = "Failed to write the header of " + temporaryPath.string();
+  }
+  bool isWritten = file && writeSections(file);
+  file.close();
+  if (isWritten && !file) {
+    error = "Failed to write " + temporaryPath.string();
+    isWritten = false;
+  }
+
+  // Never leave a partial file behind, the next save would start from scratch anyway
+  std::error_code fileError;
+  if (isWritten) {
+    fs::rename(temporaryPath, path, fileError);
+    if (!fileError) {
+      return true;
+    }
+    error = "Failed to replace " + path.string() + ": " + fileError.message();
+  }
+  fs::remove(temporaryPath, fileError);
+  return false;
+}
+
+void padTo(std::ofstream& file, uint64_t offset) {
+  static const char padding[Checkpoint::SECTION_ALIGNMENT] = {};
+  file.write(padding, offset - static_cast<uint64_t>(file.tellp()));
+}
+
+void restoreParameters(LBM& lbm, const Checkpoint::Header& header) {
+  // Restore the parameters before the state, so that the solver picks them up for the next step
+  AppState& appState = AppState::getInstance();
+  appState.fluidViscosity = header.fluidViscosity;
+  appState.reactionRate = header.reactionRate;
+  appState.isReactionEnabled = header.flags & Checkpoint::IS_REACTION_ENABLED;
+  appState.hasVerticalWalls = header.flags & Checkpoint::HAS_VERTICAL_WALLS;
+  appState.hasHorizontalWalls = header.flags & Checkpoint::HAS_HORIZONTAL_WALLS;
+  lbm.setViscosity(header.fluidViscosity);
+  lbm.setReactionRate(header.reactionRate);
+  for (int i = 0; i < 3; i++) {
+    appState.soluteDiffusivities[i] = header.soluteDiffusivities[i];
+    lbm.setSoluteDiffusivity(i, header.soluteDiffusivities[i]);
+  }
+  lbm.setRestartState({header.stepCount, {header.bodyForce[0], header.bodyForce[1]}, header.wallAnimationPhase,
+                       (header.flags & Checkpoint::ARE_SOLUTES_ENABLED) != 0, (header.flags & Checkpoint::IS_ODD_IN_PLACE_STEP) != 0});
+}
+
+size_t getFloatsPerNode(const LBM::StateResource& resource, size_t nodeCount) {
+  return resource.size / (nodeCount * sizeof(GLfloat));
+}
+
+size_t getTileSize(const LBM::StateResource& resource, const glm::ivec4& rect, size_t nodeCount) {
+  return static_cast<size_t>(rect.z) * rect.w * getFloatsPerNode(resource, nodeCount) * sizeof(GLfloat);
+}
+
+// Host copy of every state resource, which compact checkpoints encode from and decode into
+class StateImage {
+public:
+  StateImage(const std::vector<LBM::StateResource>& resources, const glm::ivec2& latticeSize)
+    : resources(resources), latticeSize(latticeSize), nodeCount(static_cast<size_t>(latticeSize.x) * latticeSize.y),
+      images(resources.size()) {
+    size_t size = 0;
+    for (size_t i = 0; i < resources.size(); i++) {
+      images[i].resize(resources[i].size / sizeof(GLfloat));
+      size += resources[i].size;
+    }
+    allocation = TrackedAllocation(MemoryKind::Host, "Checkpoint", "State image", "float", static_cast<unsigned int>(size / sizeof(GLfloat)),
+                                   0, size);
+
+    // Chunks address the images by their offset into the resource
+    std::vector<Checkpoint::Section> sections(resources.size());
+    for (Checkpoint::Section& section : sections) {
+      section.offset = 0;
+    }
+    chunks = getChunks(resources, sections, latticeSize);
+  }
+
+  const std::vector<Chunk>& getImageChunks() const {
+    return chunks;
+  }
+
+  uint8_t* getData(const Chunk& chunk) {
+    return reinterpret_cast<uint8_t*>(images[chunk.resource - resources.data()].data()) + chunk.fileOffset;
+  }
+
+  std::vector<uint8_t> encodeResource(unsigned int resource, const std::vector<LBM::PopulationLayout>& layouts) const {
+    // The planes that are not populations, each prefixed by its encoded size
+    std::vector<uint8_t> bytes;
+    std::vector<float> values(nodeCount);
+    for (const Plane& plane : getPlanes(resources[resource], nodeCount)) {
+      if (isPopulationPlane(layouts, resource, plane)) {
+        continue;
+      }
+      for (size_t n = 0; n < nodeCount; n++) {
+        values[n] = images[resource][plane.offset + n * plane.stride];
+      }
+      std::vector<uint8_t> planeBytes = PopulationCodec::encodePlane(values);
+      uint64_t planeSize = planeBytes.size();
+      bytes.insert(bytes.end(), reinterpret_cast<const uint8_t*>(&planeSize), reinterpret_cast<const uint8_t*>(&planeSize + 1));
+      bytes.insert(bytes.end(), planeBytes.begin(), planeBytes.end());
+    }
+    return bytes;
+  }
+
+  bool decodeResource(unsigned int resource, const std::vector<LBM::PopulationLayout>& layouts, const uint8_t* data, uint64_t size) {
+    std::vector<float> values;
+    for (const Plane& plane : getPlanes(resources[resource], nodeCount)) {
+      if (isPopulationPlane(layouts, resource, plane)) {
+        continue;
+      }
+      uint64_t planeSize = 0;
+      if (size < sizeof(planeSize)) {
+        return false;
+      }
+      std::memcpy(&planeSize, data, sizeof(planeSize));
+      data += sizeof(planeSize);
+      size -= sizeof(planeSize);
+      if (planeSize > size || !PopulationCodec::decodePlane(data, planeSize, nodeCount, values)) {
+        return false;
+      }
+      data += planeSize;
+      size -= planeSize;
+      for (size_t n = 0; n < nodeCount; n++) {
+        images[resource][plane.offset + n * plane.stride] = values[n];
+      }
+    }
+    return size == 0;
+  }
+
+  std::vector<uint8_t> encodeLayout(const LBM::PopulationLayout& layout, float errorBound) const {
+    std::vector<float> populations(9 * nodeCount);
+    for (unsigned int q = 0; q < 9; q++) {
+      const LBM::PopulationSlot& slot = layout.slots[q];
+      for (size_t n = 0; n < nodeCount; n++) {
+        populations[q * nodeCount + n] = images[slot.resource][slot.offset + n * slot.stride];
+      }
+    }
+    return PopulationCodec::encodePopulations(populations, nodeCount, errorBound);
+  }
+
+  bool decodeLayout(const LBM::PopulationLayout& layout, const uint8_t* data, uint64_t size) {
+    std::vector<float> populations;
+    if (!PopulationCodec::decodePopulations(data, size, nodeCount, populations)) {
+      return false;
+    }
+    for (unsigned int q = 0; q < 9; q++) {
+      const LBM::PopulationSlot& slot = layout.slots[q];
+      for (size_t n = 0; n < nodeCount; n++) {
+        images[slot.resource][slot.offset + n * slot.stride] = populations[q * nodeCount + n];
+      }
+    }
+    return true;
+  }
+
+  void writeTile(unsigned int resource, const glm::ivec4& rect, const uint8_t* data) {
+    // Textures hold rows of interleaved texels, storage buffers the rows of one plane after the other
+    const size_t floatsPerNode = getFloatsPerNode(resources[resource], nodeCount);
+    const bool isTexture = resources[resource].texture != 0;
+    const size_t planeCount = isTexture ? 1 : floatsPerNode;
+    const size_t rowSize = rect.z * (isTexture ? floatsPerNode : 1);
+    const GLfloat* values = reinterpret_cast<const GLfloat*>(data);
+    for (size_t plane = 0; plane < planeCount; plane++) {
+      for (GLint row = 0; row < rect.w; row++) {
+        size_t node = static_cast<size_t>(rect.y + row) * latticeSize.x + rect.x;
+        size_t offset = isTexture ? node * floatsPerNode : plane * nodeCount + node;
+        std::memcpy(images[resource].data() + offset, values, rowSize * sizeof(GLfloat));
+        values += rowSize;
+      }
+    }
+  }
+
+private:
+  const std::vector<LBM::StateResource>& resources;
+  glm::ivec2 latticeSize;
+  size_t nodeCount;
+  std::vector<std::vector<GLfloat>> images;
+  std::vector<Chunk> chunks;
+  TrackedAllocation allocation;
+};
+
+} // namespace
+
+bool Checkpoint::readInfo(const fs::path& path, Info& info, std::string& error) {
+  MappedFile file;
+  Header header;
+  std::vector<Section> sections;
+  if (!file.open(path, error) || !parseHeader(file, header, sections, error)) {
+    return false;
+  }
+  info = {static_cast<SolverBackend>(header.backend), {header.width, header.height}, header.stepCount, file.size,
+          (header.flags & IS_COMPACT) != 0, header.errorBound};
+  return true;
+}
+
+Checkpoint::Header Checkpoint::createHeader(const LBM& lbm) {
+  const AppState& appState = AppState::getInstance();
+  const glm::ivec2 latticeSize = lbm.getLatticeSize();
+  const LBM::RestartState state = lbm.getRestartState();
+
+  Checkpoint::Header header = {};
+  std::memcpy(header.magic, Checkpoint::MAGIC, sizeof(Checkpoint::MAGIC));
+  header.version = Checkpoint::VERSION;
+  header.backend = static_cast<uint32_t>(lbm.getBackend());
+  header.width = latticeSize.x;
+  header.height = latticeSize.y;
+  header.flags = (appState.isReactionEnabled ? Checkpoint::IS_REACTION_ENABLED : 0u) |
+                 (appState.hasVerticalWalls ? Checkpoint::HAS_VERTICAL_WALLS : 0u) |
+                 (appState.hasHorizontalWalls ? Checkpoint::HAS_HORIZONTAL_WALLS : 0u) |
+                 (state.areSolutesEnabled ? Checkpoint::ARE_SOLUTES_ENABLED : 0u) |
+                 (state.isOddInPlaceStep ? Checkpoint::IS_ODD_IN_PLACE_STEP : 0u);
+  header.stepCount = state.stepCount;
+  header.fluidViscosity = appState.fluidViscosity;
+  for (int i = 0; i < 3; i++) {
+    header.soluteDiffusivities[i] = appState.soluteDiffusivities[i];
+  }
+  header.reactionRate = appState.reactionRate;
+  header.bodyForce[0] = state.bodyForce.x;
+  header.bodyForce[1] = state.bodyForce.y;
+  header.wallAnimationPhase = state.wallAnimationPhase;
+  return header;
+}
+
+bool Checkpoint::save(const LBM& lbm, const fs::path& path, std::string& error) {
+  const glm::ivec2 latticeSize = lbm.getLatticeSize();
+  const std::vector<LBM::StateResource> resources = lbm.getStateResources();
+  std::vector<Section> sections;
+  for (const LBM::StateResource& resource : resources) {
+    sections.push_back(makeSection(resource.name, resource.texture != 0 ? resource.format : 0, RAW, latticeSize, resource.size));
+  }
+  placeSections(sections);
+
+  // The file is written while the next chunk is read back
+  std::vector<Chunk> chunks = getChunks(resources, sections, latticeSize);
+  Header header = createHeader(lbm);
+  header.sectionCount = static_cast<uint32_t>(sections.size());
+  return writeFile(path, header, sections, [&](std::ofstream& file) {
+    return readState(lbm, chunks, [&](const Chunk& chunk, const void* data) {
+      padTo(file, chunk.fileOffset);
+      file.write(static_cast<const char*>(data), chunk.size);
+      if (!file) {
+        error = "Failed to write the " + chunk.resource->name + " section of " + path.string();
+        return false;
+      }
+      return true;
+    }, error);
+  }, error);
+}
+
+bool Checkpoint::saveCompact(const LBM& lbm, const fs::path& path, float errorBound, std::string& error) {
+  if (!(errorBound > 0.f)) {
+    error = "Compact checkpoint error bound must be positive";
+    return false;
+  }
+  const glm::ivec2 latticeSize = lbm.getLatticeSize();
+  const std::vector<LBM::StateResource> resources = lbm.getStateResources();
+  const std::vector<LBM::PopulationLayout> layouts = lbm.getPopulationLayouts();
+
+  // The populations of a node are spread over several resources, so the whole state is read back before encoding
+  StateImage image(resources, latticeSize);
+  bool isRead = readState(lbm, image.getImageChunks(), [&](const Chunk& chunk, const void* data) {
+    std::memcpy(image.getData(chunk), data, chunk.size);
+    return true;
+  }, error);
+  if (!isRead) {
+    return false;
+  }
+
+  std::vector<Section> sections;
+  std::vector<std::vector<uint8_t>> sectionData;
+  for (unsigned int i = 0; i < resources.size(); i++) {
+    sectionData.push_back(image.encodeResource(i, layouts));
+    sections.push_back(makeSection(resources[i].name, resources[i].texture != 0 ? resources[i].format : 0, PLANES, latticeSize,
+                                   sectionData.back().size()));
+  }
+  for (const LBM::PopulationLayout& layout : layouts) {
+    sectionData.push_back(image.encodeLayout(layout, errorBound));
+    sections.push_back(makeSection(layout.name, 0, POPULATIONS, latticeSize, sectionData.back().size()));
+  }
+  placeSections(sections);
+
+  Header header = createHeader(lbm);
+  header.sectionCount = static_cast<uint32_t>(sections.size());
+  header.flags |= IS_COMPACT;
+  header.errorBound = errorBound;
+  return writeFile(path, header, sections, [&](std::ofstream& file) {
+    for (size_t i = 0; i < sections.size(); i++) {
+      padTo(file, sections[i].offset);
+      file.write(reinterpret_cast<const char*>(sectionData[i].data()), sectionData[i].size());
+      if (!file) {
+        error = "Failed to write the " + std::string(sections[i].name, strnlen(sections[i].name, sizeof(sections[i].name))) + " section of " + path.string();
+        return false;
+      }
+    }
+    return true;
+  }, error);
+}
+
+bool Checkpoint::load(LBM& lbm, const fs::path& path, std::string& error) {
+  MappedFile file;
+  Header header;
+  std::vector<Section> sections;
+  if (!file.open(path, error) || !parseHeader(file, header, sections, error)) {
+    return false;
+  }
+
+  if (header.flags & IS_TILED) {
+    error = "Tiled checkpoints are restored from their directory";
+    return false;
+  }
+
+  // Sections are only valid for the GPU layout they were written from
+  const glm::ivec2 latticeSize = lbm.getLatticeSize();
+  if (static_cast<SolverBackend>(header.backend) != lbm.getBackend()) {
+    error = "Checkpoint was written by a different solver backend";
+    return false;
+  }
+  if (static_cast<GLint>(header.width) != latticeSize.x || static_cast<GLint>(header.height) != latticeSize.y) {
+    error = "Checkpoint lattice is " + std::to_string(header.width) + " x " + std::to_string(header.height);
+    return false;
+  }
+  const std::vector<LBM::StateResource> resources = lbm.getStateResources();
+  const std::vector<LBM::PopulationLayout> layouts = lbm.getPopulationLayouts();
+  const bool isCompact = header.flags & IS_COMPACT;
+  bool isMatching = sections.size() == resources.size() + (isCompact ? layouts.size() : 0);
+  for (size_t i = 0; isMatching && i < resources.size(); i++) {
+    isMatching = matchesResource(sections[i], resources[i]) &&
+                 (isCompact ? sections[i].encoding == PLANES : sections[i].encoding == RAW && sections[i].size == resources[i].size);
+  }
+  for (size_t i = 0; isMatching && isCompact && i < layouts.size(); i++) {
+    const Section& section = sections[resources.size() + i];
+    isMatching = std::strncmp(section.name, layouts[i].name.c_str(), sizeof(section.name)) == 0 && section.encoding == POPULATIONS;
+  }
+  if (!isMatching) {
+    error = "Checkpoint sections do not match the simulation state";
+    return false;
+  }
+
+  if (!isCompact) {
+    // Stream the mapped sections straight into the resources
+    restoreParameters(lbm, header);
+    writeState(lbm, getChunks(resources, sections, latticeSize), [&](const Chunk& chunk) { return file.data + chunk.fileOffset; });
+    return true;
+  }
+
+  // Decode everything before touching the simulation, so that a corrupt checkpoint leaves it unchanged
+  StateImage image(resources, latticeSize);
+  bool isDecoded = true;
+  for (unsigned int i = 0; isDecoded && i < resources.size(); i++) {
+    isDecoded = image.decodeResource(i, layouts, file.data + sections[i].offset, sections[i].size);
+  }
+  for (size_t i = 0; isDecoded && i < layouts.size(); i++) {
+    const Section& section = sections[resources.size() + i];
+    isDecoded = image.decodeLayout(layouts[i], file.data + section.offset, section.size);
+  }
+  if (!isDecoded) {
+    error = "Checkpoint data is corrupt";
+    return false;
+  }
+  restoreParameters(lbm, header);
+  writeState(lbm, image.getImageChunks(), [&](const Chunk& chunk) { return image.getData(chunk); });
+  return true;
+}
+
+glm::ivec4 Checkpoint::getTileRect(uint32_t tile, uint32_t tileSize, const glm::ivec2& latticeSize) {
+  const GLint tileCountX = (latticeSize.x + tileSize - 1) / tileSize;
+  const glm::ivec2 origin = glm::ivec2(tile % tileCountX, tile / tileCountX) * static_cast<GLint>(tileSize);
+  const glm::ivec2 size = glm::min(glm::ivec2(tileSize), latticeSize - origin);
+  return {origin.x, origin.y, size.x, size.y};
+}
+
+bool Checkpoint::saveTiles(const fs::path& path, const Header& header, const std::vector<LBM::StateResource>& resources,
+                           const std::vector<uint32_t>& tiles, const std::vector<uint8_t>& tileData, std::string& error) {
+  const glm::ivec2 latticeSize(header.width, header.height);
+  const size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+
+  // The tile data holds every resource of a tile in turn, the file every tile of a resource in turn
+  std::vector<uint64_t> sectionSizes(resources.size(), 0);
+  std::vector<uint64_t> tileOffsets;
+  uint64_t offset = 0;
+  for (uint32_t tile : tiles) {
+    glm::ivec4 rect = getTileRect(tile, header.tileSize, latticeSize);
+    tileOffsets.push_back(offset);
+    for (size_t i = 0; i < resources.size(); i++) {
+      sectionSizes[i] += getTileSize(resources[i], rect, nodeCount);
+      offset += getTileSize(resources[i], rect, nodeCount);
+    }
+  }
+  if (offset != tileData.size()) {
+    error = "Tile data does not match the tiles";
+    return false;
+  }
+
+  std::vector<Section> sections;
+  sections.push_back(makeSection("Tile indices", 0, TILE_INDICES, latticeSize, tiles.size() * sizeof(uint32_t)));
+  for (size_t i = 0; i < resources.size(); i++) {
+    sections.push_back(makeSection(resources[i].name, resources[i].texture != 0 ? resources[i].format : 0, TILES, latticeSize,
+                                   sectionSizes[i]));
+  }
+  placeSections(sections);
+
+  Header tiledHeader = header;
+  tiledHeader.sectionCount = static_cast<uint32_t>(sections.size());
+  tiledHeader.flags |= IS_TILED;
+  return writeFile(path, tiledHeader, sections, [&](std::ofstream& file) {
+    padTo(file, sections[0].offset);
+    file.write(reinterpret_cast<const char*>(tiles.data()), tiles.size() * sizeof(uint32_t));
+    for (size_t i = 0; i < resources.size(); i++) {
+      padTo(file, sections[i + 1].offset);
+      for (size_t j = 0; j < tiles.size(); j++) {
+        glm::ivec4 rect = getTileRect(tiles[j], header.tileSize, latticeSize);
+        uint64_t resourceOffset = tileOffsets[j];
+        for (size_t k = 0; k < i; k++) {
+          resourceOffset += getTileSize(resources[k], rect, nodeCount);
+        }
+        file.write(reinterpret_cast<const char*>(tileData.data() + resourceOffset), getTileSize(resources[i], rect, nodeCount));
+      }
+      if (!file) {
+        error = "Failed to write the " + resources[i].name + " section of " + path.string();
+        return false;
+      }
+    }
+    return true;
+  }, error);
+}
+
+bool Checkpoint::loadLatestTiles(LBM& lbm, const fs::path& directory, uint64_t& sequence, std::string& error) {
+  // Index the tiled checkpoints in the directory by their sequence
+  std::map<uint64_t, std::pair<fs::path, Header>> files;
+  std::error_code directoryError;
+  for (const fs::directory_entry& entry : fs::directory_iterator(directory, directoryError)) {
+    MappedFile file;
+    Header header;
+    std::vector<Section> sections;
+    std::string fileError;
+    if (entry.is_regular_file() && file.open(entry.path(), fileError) && parseHeader(file, header, sections, fileError) &&
+        (header.flags & IS_TILED)) {
+      files[header.sequence] = {entry.path(), header};
+    }
+  }
+  if (files.empty()) {
+    error = "No tiled checkpoints in " + directory.string();
+    return false;
+  }
+
+  // The chain runs from the keyframe of the latest checkpoint up to the first missing delta
+  const uint64_t keyframeSequence = files.rbegin()->second.second.keyframeSequence;
+  std::vector<fs::path> chain;
+  for (uint64_t i = keyframeSequence; files.count(i) != 0 && files[i].second.keyframeSequence == keyframeSequence; i++) {
+    chain.push_back(files[i].first);
+    sequence = i;
+  }
+  if (chain.empty() || (files[keyframeSequence].second.flags & IS_DELTA)) {
+    error = "Keyframe of the latest tiled checkpoint is missing";
+    return false;
+  }
+
+  // Apply every checkpoint of the chain to a host copy before touching the simulation
+  const glm::ivec2 latticeSize = lbm.getLatticeSize();
+  const size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+  const std::vector<LBM::StateResource> resources = lbm.getStateResources();
+  StateImage image(resources, latticeSize);
+  Header header;
+  for (const fs::path& path : chain) {
+    MappedFile file;
+    std::vector<Section> sections;
+    if (!file.open(path, error) || !parseHeader(file, header, sections, error)) {
+      return false;
+    }
+    if (static_cast<SolverBackend>(header.backend) != lbm.getBackend() || static_cast<GLint>(header.width) != latticeSize.x ||
+        static_cast<GLint>(header.height) != latticeSize.y || header.tileSize == 0) {
+      error = path.filename().string() + " was written for a different lattice or solver backend";
+      return false;
+    }
+    bool isMatching = sections.size() == resources.size() + 1 && sections[0].encoding == TILE_INDICES;
+    for (size_t i = 0; isMatching && i < resources.size(); i++) {
+      isMatching = matchesResource(sections[i + 1], resources[i]) && sections[i + 1].encoding == TILES;
+    }
+    if (!isMatching) {
+      error = path.filename().string() + " does not match the simulation state";
+      return false;
+    }
+
+    const size_t tileCount = sections[0].size / sizeof(uint32_t);
+    const glm::ivec2 tileGrid = (latticeSize + static_cast<GLint>(header.tileSize) - 1) / static_cast<GLint>(header.tileSize);
+    std::vector<uint32_t> tiles(tileCount);
+    std::memcpy(tiles.data(), file.data + sections[0].offset, tileCount * sizeof(uint32_t));
+    if (!(header.flags & IS_DELTA) && tileCount != static_cast<size_t>(tileGrid.x) * tileGrid.y) {
+      error = path.filename().string() + " is a keyframe without every tile";
+      return false;
+    }
+    for (size_t i = 0; i < resources.size(); i++) {
+      const Section& section = sections[i + 1];
+      uint64_t offset = 0;
+      for (uint32_t tile : tiles) {
+        if (tile >= static_cast<uint32_t>(tileGrid.x * tileGrid.y)) {
+          error = path.filename().string() + " is corrupt";
+          return false;
+        }
+        glm::ivec4 rect = getTileRect(tile, header.tileSize, latticeSize);
+        uint64_t size = getTileSize(resources[i], rect, nodeCount);
+        if (offset + size > section.size) {
+          error = path.filename().string() + " is corrupt";
+          return false;
+        }
+        image.writeTile(static_cast<unsigned int>(i), rect, file.data + section.offset + offset);
+        offset += size;
+      }
+    }
+  }
+
+  // The parameters are those of the latest checkpoint
+  restoreParameters(lbm, header);
+  writeState(lbm, image.getImageChunks(), [&](const Chunk& chunk) { return image.getData(chunk); });
+  return true;
+}
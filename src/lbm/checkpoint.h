@@ -0,0 +1,118 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+
+#include "core/app_state.h"
+#include "lbm/lbm.h"
+
+namespace fs = std::filesystem;
+
+// Binary checkpoint holding the complete simulation state: the node IDs, the fluid and solute populations
+// and macroscopic fields, and the parameters. The file starts with a Header, followed by one
+// Section per GPU resource and the raw little-endian float data of each section, aligned to
+// SECTION_ALIGNMENT bytes so that the file can be memory-mapped and every section used in place.
+// Sections mirror the GPU layout of the backend that wrote them, so restarts stream the mapped file
+// straight into the textures and storage buffers without any conversion.
+// Compact checkpoints trade this for size: the populations are stored as their moments and quantized
+// non-equilibrium parts (see PopulationCodec), the remaining floats of every resource losslessly.
+// Tiled checkpoints hold square tiles of every resource only, as written by AutoCheckpoint: a keyframe holds all
+// tiles, each delta the tiles that changed since the checkpoint before it, and restoring applies a keyframe and its
+// deltas in sequence.
+struct Checkpoint {
+  static constexpr char MAGIC[8] = {'L', 'B', 'M', 'C', 'K', 'P', 'T', '\0'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint64_t SECTION_ALIGNMENT = 64;
+  static constexpr size_t STAGING_SIZE = 64 * 1024 * 1024; // Bytes per transfer chunk, two chunks are in flight
+  static constexpr float DEFAULT_ERROR_BOUND = 1e-6f;       // Of compact populations, which are around 0.1
+
+  enum Flags : uint32_t {
+    IS_REACTION_ENABLED = 1 << 0,
+    HAS_VERTICAL_WALLS = 1 << 1,
+    HAS_HORIZONTAL_WALLS = 1 << 2,
+    ARE_SOLUTES_ENABLED = 1 << 3,
+    IS_ODD_IN_PLACE_STEP = 1 << 4,
+    IS_COMPACT = 1 << 5,
+    IS_TILED = 1 << 6,
+    IS_DELTA = 1 << 7,
+  };
+
+  enum Encoding : uint32_t {
+    RAW = 0,         // The resource as transferred
+    PLANES = 1,      // The floats of the resource that are not populations, as PopulationCodec planes with size prefixes
+    POPULATIONS = 2, // One population layout of the lattice, encoded by PopulationCodec
+    TILE_INDICES = 3, // Indices of the tiles in a tiled checkpoint, counted row by row from the bottom left tile
+    TILES = 4,       // The resource within each listed tile in turn, texel rows for textures, rows of each plane for buffers
+  };
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t backend;      // SolverBackend that wrote the sections
+    uint32_t width;
+    uint32_t height;
+    uint32_t sectionCount;
+    uint32_t flags;
+    uint64_t stepCount;
+    float fluidViscosity;
+    float soluteDiffusivities[3];
+    float reactionRate;
+    float bodyForce[2];
+    float wallAnimationPhase;
+    float errorBound;      // Of compact populations
+    uint32_t tileSize;     // Of tiled checkpoints
+    uint64_t sequence;     // Of tiled checkpoints, consecutive within a keyframe and its deltas
+    uint64_t keyframeSequence;
+    uint8_t reserved[32];
+  };
+
+  struct Section {
+    char name[32];
+    uint32_t format;  // GL_RGBA32F or GL_R32F texel rows from the bottom of the lattice, 0 for a raw storage buffer
+    uint32_t width;
+    uint32_t height;
+    uint32_t encoding;
+    uint64_t offset;  // From the start of the file, a multiple of SECTION_ALIGNMENT
+    uint64_t size;    // Bytes
+  };
+
+  struct Info {
+    SolverBackend backend;
+    glm::ivec2 latticeSize;
+    uint64_t stepCount;
+    uint64_t fileSize;
+    bool isCompact;
+    float errorBound;
+  };
+
+  // Reads and validates the header, so that a lattice matching the checkpoint can be created before loading it
+  static bool readInfo(const fs::path& path, Info& info, std::string& error);
+
+  // The lattice must have been created with the backend and size of the checkpoint. Loading also restores the
+  // parameters in the AppState.
+  static bool save(const LBM& lbm, const fs::path& path, std::string& error);
+  // Every population of a compact checkpoint lies within errorBound of its saved value, all other floats are exact
+  static bool saveCompact(const LBM& lbm, const fs::path& path, float errorBound, std::string& error);
+  static bool load(LBM& lbm, const fs::path& path, std::string& error);
+
+  // Header describing the current simulation, for the writers of tiled checkpoints
+  static Header createHeader(const LBM& lbm);
+  // Lattice rectangle (x, y, width, height) covered by a tile
+  static glm::ivec4 getTileRect(uint32_t tile, uint32_t tileSize, const glm::ivec2& latticeSize);
+  // Writes tiles read back from the state resources, each holding the tile of every resource in turn
+  static bool saveTiles(const fs::path& path, const Header& header, const std::vector<LBM::StateResource>& resources,
+                        const std::vector<uint32_t>& tiles, const std::vector<uint8_t>& tileData, std::string& error);
+  // Restores the latest tiled checkpoint in the directory from its keyframe and deltas
+  static bool loadLatestTiles(LBM& lbm, const fs::path& directory, uint64_t& sequence, std::string& error);
+};
+
+static_assert(sizeof(Checkpoint::Header) == 128, "The checkpoint header layout is part of the file format");
+static_assert(sizeof(Checkpoint::Section) == 64, "The checkpoint section layout is part of the file format");
+
+#endif // CHECKPOINT_H
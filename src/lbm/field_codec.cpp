@@ -0,0 +1,382 @@
+#include "lbm/field_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+namespace {
+
+constexpr unsigned int CONTEXT_COUNT = 4;
+constexpr double MAX_QUANTUM = 1099511627776.; // 2^40, so that predictions cannot overflow
+constexpr uint64_t MAX_RESIDUAL = 0xFFFFFFFFu; // Larger residuals are stored as escaped values
+
+// Binary decisions coding a residual, each with an adaptive probability per context
+enum Decision : unsigned int {
+  IS_NON_ZERO,
+  IS_ESCAPED,
+  IS_NEGATIVE,
+  LENGTH, // Unary bit length of the magnitude, one decision per bit
+  DECISION_COUNT = LENGTH + 32,
+};
+
+// Range coder with the probability model of LZMA: 11-bit probabilities of a zero bit that adapt by 1/32 of their error
+constexpr unsigned int PROBABILITY_BITS = 11;
+constexpr unsigned int ADAPTATION_SHIFT = 5;
+constexpr uint16_t INITIAL_PROBABILITY = 1u << (PROBABILITY_BITS - 1);
+constexpr uint32_t TOP = 1u << 24;
+
+using Model = std::array<std::array<uint16_t, DECISION_COUNT>, CONTEXT_COUNT>;
+
+struct StreamHeader {
+  uint32_t width;
+  uint32_t height;
+  uint32_t componentCount;
+  uint32_t tileSize;
+  float errorBound;
+  uint32_t tileCount; // Followed by the offset of every tile after the offset table, and of its end
+};
+
+class RangeEncoder {
+public:
+  explicit RangeEncoder(std::vector<uint8_t>& bytes) : bytes(bytes) {}
+
+  void encodeBit(uint16_t& probability, bool bit) {
+    const uint32_t bound = (range >> PROBABILITY_BITS) * probability;
+    if (!bit) {
+      range = bound;
+      probability += ((1u << PROBABILITY_BITS) - probability) >> ADAPTATION_SHIFT;
+    } else {
+      low += bound;
+      range -= bound;
+      probability -= probability >> ADAPTATION_SHIFT;
+    }
+    normalize();
+  }
+
+  // Bits of even probability, from the most significant one on
+  void encodeDirect(uint32_t value, unsigned int bitCount) {
+    for (unsigned int i = bitCount; i-- > 0;) {
+      range >>= 1;
+      if ((value >> i) & 1) {
+        low += range;
+      }
+      normalize();
+    }
+  }
+
+  void finish() {
+    for (int i = 0; i < 5; i++) {
+      shiftLow();
+    }
+  }
+
+private:
+  std::vector<uint8_t>& bytes;
+  uint64_t low = 0;
+  uint32_t range = 0xFFFFFFFFu;
+  uint8_t cache = 0;
+  uint64_t cacheSize = 1;
+
+  void normalize() {
+    while (range < TOP) {
+      range <<= 8;
+      shiftLow();
+    }
+  }
+
+  void shiftLow() {
+    // Runs of 0xFF bytes are held back until it is known whether a carry propagates into them
+    if (static_cast<uint32_t>(low) < 0xFF000000u || (low >> 32) != 0) {
+      const uint8_t carry = static_cast<uint8_t>(low >> 32);
+      uint8_t pending = cache;
+      do {
+        bytes.push_back(static_cast<uint8_t>(pending + carry));
+        pending = 0xFF;
+      } while (--cacheSize != 0);
+      cache = static_cast<uint8_t>(low >> 24);
+    }
+    cacheSize++;
+    low = (low & 0x00FFFFFFu) << 8;
+  }
+};
+
+class RangeDecoder {
+public:
+  RangeDecoder(const uint8_t* data, size_t size) : data(data), size(size) {
+    for (int i = 0; i < 5; i++) {
+      code = (code << 8) | nextByte();
+    }
+  }
+
+  bool decodeBit(uint16_t& probability) {
+    const uint32_t bound = (range >> PROBABILITY_BITS) * probability;
+    bool bit = code >= bound;
+    if (!bit) {
+      range = bound;
+      probability += ((1u << PROBABILITY_BITS) - probability) >> ADAPTATION_SHIFT;
+    } else {
+      code -= bound;
+      range -= bound;
+      probability -= probability >> ADAPTATION_SHIFT;
+    }
+    normalize();
+    return bit;
+  }
+
+  uint32_t decodeDirect(unsigned int bitCount) {
+    uint32_t value = 0;
+    for (unsigned int i = 0; i < bitCount; i++) {
+      range >>= 1;
+      const uint32_t bit = code >= range;
+      code -= bit * range;
+      value = (value << 1) | bit;
+      normalize();
+    }
+    return value;
+  }
+
+  // The encoder leaves off its last byte, which is always zero
+  bool isOverrun() const {
+    return position > size + 1;
+  }
+
+private:
+  const uint8_t* data;
+  size_t size;
+  size_t position = 0;
+  uint32_t code = 0;
+  uint32_t range = 0xFFFFFFFFu;
+
+  uint8_t nextByte() {
+    return (position < size) ? data[position++] : (position++, 0);
+  }
+
+  void normalize() {
+    while (range < TOP) {
+      range <<= 8;
+      code = (code << 8) | nextByte();
+    }
+  }
+};
+
+// Region of one component covered by a tile
+struct Tile {
+  uint32_t component;
+  uint32_t x;
+  uint32_t y;
+  uint32_t width;
+  uint32_t height;
+};
+
+uint32_t getTileCount(uint32_t width, uint32_t height, uint32_t componentCount, uint32_t tileSize) {
+  return ((width + tileSize - 1) / tileSize) * ((height + tileSize - 1) / tileSize) * componentCount;
+}
+
+Tile getTile(uint32_t index, uint32_t width, uint32_t height, uint32_t tileSize) {
+  const uint32_t columnCount = (width + tileSize - 1) / tileSize;
+  const uint32_t componentTileCount = columnCount * ((height + tileSize - 1) / tileSize);
+  Tile tile;
+  tile.component = index / componentTileCount;
+  tile.x = (index % componentTileCount) % columnCount * tileSize;
+  tile.y = (index % componentTileCount) / columnCount * tileSize;
+  tile.width = std::min(tileSize, width - tile.x);
+  tile.height = std::min(tileSize, height - tile.y);
+  return tile;
+}
+
+bool forEachTile(uint32_t tileCount, const std::function<bool(uint32_t)>& body) {
+  // Tiles are handed out one at a time, as their cost varies with the detail they hold
+  std::atomic<uint32_t> nextTile = 0;
+  std::atomic<bool> isSuccessful = true;
+  auto work = [&] {
+    for (uint32_t i = nextTile++; i < tileCount && isSuccessful; i = nextTile++) {
+      if (!body(i)) {
+        isSuccessful = false;
+      }
+    }
+  };
+  const uint32_t threadCount = std::min(std::max(1u, std::thread::hardware_concurrency()), tileCount);
+  std::vector<std::thread> threads;
+  for (uint32_t i = 1; i < threadCount; i++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return isSuccessful;
+}
+
+// Nearest multiple of the quantization step, or zero for values without one
+int64_t getQuantum(float value, double step) {
+  const double quantum = std::round(static_cast<double>(value) / step);
+  return (std::fabs(quantum) <= MAX_QUANTUM) ? static_cast<int64_t>(quantum) : 0;
+}
+
+float dequantize(int64_t quantum, double step) {
+  return static_cast<float>(static_cast<double>(quantum) * step);
+}
+
+// Lorenzo prediction from the quantized left, lower and lower left neighbours within the tile
+int64_t predict(const int64_t* quanta, uint32_t x, uint32_t y, uint32_t width) {
+  const size_t i = static_cast<size_t>(y) * width + x;
+  if (x > 0 && y > 0) {
+    return quanta[i - 1] + quanta[i - width] - quanta[i - width - 1];
+  }
+  return (x > 0) ? quanta[i - 1] : (y > 0) ? quanta[i - width] : 0;
+}
+
+// Residuals are coded in the context of the residual magnitudes of the left and lower neighbours
+unsigned int getContext(const uint32_t* magnitudes, uint32_t x, uint32_t y, uint32_t width) {
+  const size_t i = static_cast<size_t>(y) * width + x;
+  const uint64_t activity = static_cast<uint64_t>(x > 0 ? magnitudes[i - 1] : 0) + (y > 0 ? magnitudes[i - width] : 0);
+  return (activity == 0) ? 0 : (activity <= 2) ? 1 : (activity <= 8) ? 2 : 3;
+}
+
+void encodeTile(const std::vector<float>& values, uint32_t width, uint32_t componentCount, const Tile& tile, float errorBound,
+                std::vector<uint8_t>& bytes) {
+  const double step = 2. * errorBound;
+  Model model;
+  for (auto& probabilities : model) {
+    probabilities.fill(INITIAL_PROBABILITY);
+  }
+  std::vector<int64_t> quanta(static_cast<size_t>(tile.width) * tile.height);
+  std::vector<uint32_t> magnitudes(quanta.size());
+  RangeEncoder encoder(bytes);
+  for (uint32_t y = 0; y < tile.height; y++) {
+    for (uint32_t x = 0; x < tile.width; x++) {
+      const size_t i = static_cast<size_t>(y) * tile.width + x;
+      const float value = values[((static_cast<size_t>(tile.y) + y) * width + tile.x + x) * componentCount + tile.component];
+      const int64_t quantum = getQuantum(value, step);
+      const int64_t residual = quantum - predict(quanta.data(), x, y, tile.width);
+      const uint64_t magnitude = (residual < 0) ? -static_cast<uint64_t>(residual) : residual;
+      auto& probabilities = model[getContext(magnitudes.data(), x, y, tile.width)];
+      quanta[i] = quantum;
+
+      // Values outside the bound after quantization, including non-finite ones, are stored verbatim
+      const bool isEscaped = !(std::fabs(static_cast<double>(dequantize(quantum, step)) - value) <= errorBound) ||
+                             magnitude > MAX_RESIDUAL;
+      encoder.encodeBit(probabilities[IS_NON_ZERO], isEscaped || magnitude != 0);
+      if (isEscaped) {
+        encoder.encodeBit(probabilities[IS_ESCAPED], true);
+        encoder.encodeDirect(std::bit_cast<uint32_t>(value), 32);
+        magnitudes[i] = MAX_RESIDUAL;
+        continue;
+      }
+      magnitudes[i] = static_cast<uint32_t>(magnitude);
+      if (magnitude == 0) {
+        continue;
+      }
+
+      // Sign, bit length in unary and the bits below the leading one
+      encoder.encodeBit(probabilities[IS_ESCAPED], false);
+      encoder.encodeBit(probabilities[IS_NEGATIVE], residual < 0);
+      const unsigned int length = std::bit_width(magnitude) - 1;
+      for (unsigned int bit = 0; bit < length; bit++) {
+        encoder.encodeBit(probabilities[LENGTH + bit], true);
+      }
+      if (length < 31) {
+        encoder.encodeBit(probabilities[LENGTH + length], false);
+      }
+      encoder.encodeDirect(static_cast<uint32_t>(magnitude), length);
+    }
+  }
+  encoder.finish();
+}
+
+bool decodeTile(const uint8_t* data, size_t size, uint32_t width, uint32_t componentCount, const Tile& tile, float errorBound,
+                std::vector<float>& values) {
+  const double step = 2. * errorBound;
+  Model model;
+  for (auto& probabilities : model) {
+    probabilities.fill(INITIAL_PROBABILITY);
+  }
+  std::vector<int64_t> quanta(static_cast<size_t>(tile.width) * tile.height);
+  std::vector<uint32_t> magnitudes(quanta.size());
+  RangeDecoder decoder(data, size);
+  for (uint32_t y = 0; y < tile.height; y++) {
+    for (uint32_t x = 0; x < tile.width; x++) {
+      const size_t i = static_cast<size_t>(y) * tile.width + x;
+      float& value = values[((static_cast<size_t>(tile.y) + y) * width + tile.x + x) * componentCount + tile.component];
+      auto& probabilities = model[getContext(magnitudes.data(), x, y, tile.width)];
+      int64_t quantum = predict(quanta.data(), x, y, tile.width);
+      uint32_t magnitude = 0;
+      if (decoder.decodeBit(probabilities[IS_NON_ZERO])) {
+        if (decoder.decodeBit(probabilities[IS_ESCAPED])) {
+          value = std::bit_cast<float>(decoder.decodeDirect(32));
+          quanta[i] = getQuantum(value, step);
+          magnitudes[i] = MAX_RESIDUAL;
+          continue;
+        }
+        const bool isNegative = decoder.decodeBit(probabilities[IS_NEGATIVE]);
+        unsigned int length = 0;
+        while (length < 31 && decoder.decodeBit(probabilities[LENGTH + length])) {
+          length++;
+        }
+        magnitude = (1u << length) | decoder.decodeDirect(length);
+        quantum += isNegative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+      }
+      quanta[i] = quantum;
+      magnitudes[i] = magnitude;
+      value = dequantize(quantum, step);
+    }
+  }
+  return !decoder.isOverrun();
+}
+
+} // namespace
+
+std::vector<uint8_t> FieldCodec::encode(const std::vector<float>& values, uint32_t width, uint32_t height, uint32_t componentCount,
+                                        float errorBound) {
+  const StreamHeader header = {width, height, componentCount, TILE_SIZE, errorBound, getTileCount(width, height, componentCount, TILE_SIZE)};
+  std::vector<std::vector<uint8_t>> tiles(header.tileCount);
+  forEachTile(header.tileCount, [&](uint32_t i) {
+    encodeTile(values, width, componentCount, getTile(i, width, height, TILE_SIZE), errorBound, tiles[i]);
+    return true;
+  });
+
+  // The offset table lets every tile be decoded independently
+  std::vector<uint64_t> offsets(header.tileCount + 1, 0);
+  for (uint32_t i = 0; i < header.tileCount; i++) {
+    offsets[i + 1] = offsets[i] + tiles[i].size();
+  }
+  std::vector<uint8_t> bytes(sizeof(StreamHeader) + offsets.size() * sizeof(uint64_t));
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  std::memcpy(bytes.data() + sizeof(header), offsets.data(), offsets.size() * sizeof(uint64_t));
+  bytes.reserve(bytes.size() + offsets.back());
+  for (const std::vector<uint8_t>& tile : tiles) {
+    bytes.insert(bytes.end(), tile.begin(), tile.end());
+  }
+  return bytes;
+}
+
+bool FieldCodec::decode(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint32_t componentCount,
+                        std::vector<float>& values) {
+  StreamHeader header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (header.width != width || header.height != height || header.componentCount != componentCount || header.tileSize == 0 ||
+      !(header.errorBound > 0.f) || header.tileCount != getTileCount(width, height, componentCount, header.tileSize) ||
+      (static_cast<uint64_t>(header.tileCount) + 1) * sizeof(uint64_t) > size - sizeof(header)) {
+    return false;
+  }
+  std::vector<uint64_t> offsets(header.tileCount + 1);
+  std::memcpy(offsets.data(), data + sizeof(header), offsets.size() * sizeof(uint64_t));
+  const size_t tableSize = sizeof(header) + offsets.size() * sizeof(uint64_t);
+  if (offsets[0] != 0 || offsets.back() != size - tableSize || !std::is_sorted(offsets.begin(), offsets.end())) {
+    return false;
+  }
+
+  values.assign(static_cast<size_t>(width) * height * componentCount, 0.f);
+  return forEachTile(header.tileCount, [&](uint32_t i) {
+    return decodeTile(data + tableSize + offsets[i], offsets[i + 1] - offsets[i], width, componentCount,
+                      getTile(i, width, height, header.tileSize), header.errorBound, values);
+  });
+}
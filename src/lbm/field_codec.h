@@ -0,0 +1,26 @@
+#ifndef FIELD_CODEC_H
+#define FIELD_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Error-bounded lossy encoding of sampled fields for field series files.
+// Every value is quantized to the nearest multiple of twice the error bound, and the quantized values of each
+// component are predicted from their left, lower and lower left neighbours (Lorenzo prediction), so that smooth fields
+// leave residuals close to zero. The residuals are entropy coded by an adaptive binary range coder whose contexts
+// depend on the residuals of the neighbours. Values that the quantization cannot represent within the bound, such as
+// non-finite ones, are stored verbatim. The grid is split into square tiles per component, which are predicted and
+// coded independently on all hardware threads.
+struct FieldCodec {
+  static constexpr uint32_t TILE_SIZE = 64;
+
+  // Encodes width * height nodes of componentCount interleaved floats.
+  // Every decoded value lies within errorBound of its original value, which must be positive.
+  static std::vector<uint8_t> encode(const std::vector<float>& values, uint32_t width, uint32_t height, uint32_t componentCount,
+                                     float errorBound);
+  static bool decode(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint32_t componentCount,
+                     std::vector<float>& values);
+};
+
+#endif // FIELD_CODEC_H
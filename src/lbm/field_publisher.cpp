@@ -0,0 +1,229 @@
+#include "lbm/field_publisher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+bool isSignalled(GLsync fence) {
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+bool isFieldSelected(uint32_t fieldMask, unsigned int field) {
+  return (fieldMask & (1u << field)) != 0;
+}
+
+} // namespace
+
+FieldPublisher::FieldPublisher(std::shared_ptr<LBM> lbm) : lbm(lbm) {
+  glGenFramebuffers(1, &readFramebuffer);
+  for (Readback& readback : readbacks) {
+    glGenBuffers(1, &readback.buffer);
+  }
+}
+
+FieldPublisher::~FieldPublisher() {
+  stop();
+  for (Readback& readback : readbacks) {
+    glDeleteBuffers(1, &readback.buffer);
+  }
+  glDeleteFramebuffers(1, &readFramebuffer);
+}
+
+bool FieldPublisher::start(const std::string& name, std::string& error) {
+  stop();
+#if defined(_WIN32)
+  error = "Publishing fields requires POSIX shared memory";
+  return false;
+#else
+  const AppState& appState = AppState::getInstance();
+  const glm::ivec2 latticeSize = lbm->getLatticeSize();
+
+  // Clamp the region to the lattice, an empty region selects the whole lattice
+  glm::ivec4 region = appState.fieldOutputRegion;
+  if (region.z <= 0 || region.w <= 0) {
+    region = {0, 0, latticeSize.x, latticeSize.y};
+  }
+  glm::ivec2 regionOrigin = glm::clamp(glm::ivec2(region.x, region.y), glm::ivec2(0), latticeSize - 1);
+  glm::ivec2 regionSize = glm::min(glm::ivec2(region.z, region.w), latticeSize - regionOrigin);
+  region = {regionOrigin.x, regionOrigin.y, regionSize.x, regionSize.y};
+  const uint32_t stride = std::max(appState.fieldOutputStride, 1u);
+  const uint32_t fieldMask = appState.fieldOutputMask & ((1u << FieldSeries::FIELD_COUNT) - 1);
+  if (fieldMask == 0) {
+    error = "No fields are selected";
+    return false;
+  }
+  FieldSeries::Header grid = FieldSeries::createHeader(latticeSize, region, stride, fieldMask);
+  size_t dataSize = 0;
+  for (unsigned int i = 0; i < FieldSeries::FIELD_COUNT; i++) {
+    if (isFieldSelected(fieldMask, i)) {
+      dataSize += static_cast<size_t>(grid.width) * grid.height * FieldSeries::getComponentCount(static_cast<FieldType>(i)) * sizeof(GLfloat);
+    }
+  }
+  const size_t slotSize = sizeof(SharedFields::SlotHeader) + (dataSize + SharedFields::ALIGNMENT - 1) / SharedFields::ALIGNMENT * SharedFields::ALIGNMENT;
+
+  // A stale object left by a publisher that did not stop cleanly is replaced, readers still mapping it are unaffected
+  shm_unlink(name.c_str());
+  int descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (descriptor < 0) {
+    error = "Failed to create shared memory " + name + ": " + std::strerror(errno);
+    return false;
+  }
+  mappingSize = sizeof(SharedFields::Header) + SLOT_COUNT * slotSize;
+  void* data = (ftruncate(descriptor, mappingSize) == 0) ? mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0)
+                                                        : MAP_FAILED;
+  close(descriptor);
+  if (data == MAP_FAILED) {
+    error = "Failed to map shared memory " + name + ": " + std::strerror(errno);
+    shm_unlink(name.c_str());
+    mappingSize = 0;
+    return false;
+  }
+  this->name = name;
+  mapping = static_cast<uint8_t*>(data);
+
+  // The object is zero-filled, so every slot starts with an even sequence and no snapshot
+  SharedFields::Header& header = getHeader();
+  std::memcpy(header.magic, SharedFields::MAGIC, sizeof(header.magic));
+  header.version = SharedFields::VERSION;
+  header.slotCount = SLOT_COUNT;
+  header.slotSize = slotSize;
+  header.dataSize = dataSize;
+  header.grid = grid;
+  std::atomic_ref<uint32_t>(header.isOpen).store(1, std::memory_order_release);
+  origin = regionOrigin;
+
+  fields = std::make_unique<Framebuffer>(grid.width, grid.height, FieldSeries::FIELD_COUNT, "Shared fields");
+  for (Readback& readback : readbacks) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, dataSize, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readbackAllocation = TrackedAllocation(MemoryKind::Buffer, "Shared fields", "Readback buffers", "bytes", dataSize, READBACK_COUNT,
+                                         READBACK_COUNT * dataSize);
+  ringAllocation = TrackedAllocation(MemoryKind::Host, "Shared fields", "Shared memory ring", "bytes", slotSize, SLOT_COUNT, mappingSize);
+  status = Status();
+  return true;
+#endif
+}
+
+void FieldPublisher::stop() {
+  if (!isPublishing()) {
+    return;
+  }
+  finishReadbacks(true);
+#if !defined(_WIN32)
+  std::atomic_ref<uint32_t>(getHeader().isOpen).store(0, std::memory_order_release);
+  munmap(mapping, mappingSize);
+  shm_unlink(name.c_str());
+#endif
+  mapping = nullptr;
+  mappingSize = 0;
+  fields.reset();
+  readbackAllocation = TrackedAllocation();
+  ringAllocation = TrackedAllocation();
+}
+
+bool FieldPublisher::isPublishing() const {
+  return mapping != nullptr;
+}
+
+void FieldPublisher::update() {
+  finishReadbacks(false);
+  const uint64_t stepCount = lbm->getStepCount();
+  if (!isPublishing() || stepCount % std::max(AppState::getInstance().fieldOutputInterval, 1u) != 0) {
+    return;
+  }
+  Readback& readback = readbacks[nextReadback];
+  if (readback.fence != nullptr) {
+    status.droppedCount++;
+    return;
+  }
+  nextReadback = (nextReadback + 1) % READBACK_COUNT;
+
+  // Sample the fields, then queue the readback of the selected ones into consecutive ranges of the buffer
+  const FieldSeries::Header& grid = getHeader().grid;
+  lbm->sampleFields(*fields, origin, static_cast<GLint>(grid.stride));
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  size_t offset = 0;
+  for (unsigned int i = 0; i < FieldSeries::FIELD_COUNT; i++) {
+    if (!isFieldSelected(grid.fieldMask, i)) {
+      continue;
+    }
+    const unsigned int componentCount = FieldSeries::getComponentCount(static_cast<FieldType>(i));
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fields->getTexture(i), 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, grid.width, grid.height, (componentCount == 2) ? GL_RG : GL_RED, GL_FLOAT, reinterpret_cast<void*>(offset));
+    offset += static_cast<size_t>(grid.width) * grid.height * componentCount * sizeof(GLfloat);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  readback.stepCount = stepCount;
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+}
+
+FieldPublisher::Status FieldPublisher::getStatus() const {
+  return status;
+}
+
+SharedFields::Header& FieldPublisher::getHeader() const {
+  return *reinterpret_cast<SharedFields::Header*>(mapping);
+}
+
+void FieldPublisher::finishReadbacks(bool isBlocking) {
+  // Readbacks complete in the order they were issued, starting with the oldest
+  for (unsigned int i = 0; i < READBACK_COUNT; i++) {
+    Readback& readback = readbacks[(nextReadback + i) % READBACK_COUNT];
+    if (readback.fence == nullptr) {
+      continue;
+    }
+    if (isBlocking) {
+      glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    } else if (!isSignalled(readback.fence)) {
+      return;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, getHeader().dataSize, GL_MAP_READ_BIT);
+    if (data != nullptr) {
+      publish(readback.stepCount, data);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+      status.error = "Failed to map the field readback buffer";
+      status.droppedCount++;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+}
+
+void FieldPublisher::publish(uint64_t stepCount, const void* data) {
+  SharedFields::Header& header = getHeader();
+  const uint64_t index = header.publishedCount + 1;
+  uint8_t* slotData = mapping + SharedFields::getSlotOffset(header, static_cast<unsigned int>((index - 1) % header.slotCount));
+  SharedFields::SlotHeader& slotHeader = *reinterpret_cast<SharedFields::SlotHeader*>(slotData);
+
+  // Readers that see the odd sequence skip the slot, readers that loaded the even one before see it change afterwards
+  const uint64_t sequence = slotHeader.sequence;
+  SharedFields::store(slotHeader.sequence, sequence + 1);
+  std::atomic_thread_fence(std::memory_order_release);
+  slotHeader.stepCount = stepCount;
+  slotHeader.index = index;
+  std::memcpy(slotData + sizeof(SharedFields::SlotHeader), data, header.dataSize);
+  SharedFields::store(slotHeader.sequence, sequence + 2);
+  SharedFields::store(header.publishedCount, index);
+
+  status.snapshotCount++;
+  status.lastStep = stepCount;
+}
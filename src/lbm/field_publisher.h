@@ -0,0 +1,79 @@
+#ifndef FIELD_PUBLISHER_H
+#define FIELD_PUBLISHER_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+
+#include "gl/framebuffers.h"
+#include "gl/memory_tracker.h"
+#include "lbm/lbm.h"
+#include "lbm/shared_fields.h"
+
+// Publishes snapshots of the macroscopic fields to a SharedFields ring in POSIX shared memory, for analysis processes
+// that watch the simulation live.
+// Every AppState::fieldOutputInterval steps the fields selected for field output are sampled on the GPU like the
+// FieldWriter does and read into one of a ring of pixel pack buffers. Once the fence of a readback has signalled, the
+// mapped buffer is copied straight into the next slot of the shared ring, so readers map the snapshots without any
+// further copies. Snapshots that find every readback still in flight are dropped rather than waited for.
+class FieldPublisher {
+public:
+  static constexpr unsigned int READBACK_COUNT = 4; // Snapshots that can be in flight at once
+  static constexpr unsigned int SLOT_COUNT = 8;     // Snapshots readers can fall behind by before they are overwritten
+
+  struct Status {
+    uint64_t snapshotCount = 0; // Published to the ring
+    uint64_t lastStep = 0;      // Of the latest published snapshot
+    uint64_t droppedCount = 0;
+    std::string error;
+  };
+
+  FieldPublisher(std::shared_ptr<LBM> lbm);
+  ~FieldPublisher(); // Stops publishing
+
+  // Disallow copy and assignment to avoid multiple deletions of OpenGL objects
+  FieldPublisher(const FieldPublisher&) = delete;
+  FieldPublisher& operator=(const FieldPublisher&) = delete;
+
+  // Creates the shared memory object, replacing a stale one of the same name, with the field output parameters of
+  // the AppState. Names start with a slash, as in /lbm_fields.
+  bool start(const std::string& name, std::string& error);
+  // Publishes the snapshots in flight, marks the ring closed and unlinks it, readers keep their mappings
+  void stop();
+  bool isPublishing() const;
+
+  // Call after every simulation step, with the context current
+  void update();
+
+  Status getStatus() const;
+
+private:
+  struct Readback {
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    uint64_t stepCount = 0;
+  };
+
+  std::shared_ptr<LBM> lbm;
+  std::string name;
+  uint8_t* mapping = nullptr;          // Of the shared ring, starting with its header
+  size_t mappingSize = 0;
+  glm::ivec2 origin;
+  std::unique_ptr<Framebuffer> fields; // One texture per FieldType, one texel per sample
+  GLuint readFramebuffer;
+  std::array<Readback, READBACK_COUNT> readbacks;
+  unsigned int nextReadback = 0;       // Readbacks are issued and completed in ring order
+  TrackedAllocation readbackAllocation;
+  TrackedAllocation ringAllocation;
+  Status status;
+
+  SharedFields::Header& getHeader() const;
+  void finishReadbacks(bool isBlocking);
+  void publish(uint64_t stepCount, const void* data);
+};
+
+#endif // FIELD_PUBLISHER_H
@@ -0,0 +1,160 @@
+#include "lbm/field_series.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "lbm/field_codec.h"
+
+unsigned int FieldSeries::getComponentCount(FieldType field) {
+  return (field == FieldType::Velocity) ? 2 : 1;
+}
+
+const char* FieldSeries::getFieldName(FieldType field) {
+  switch (field) {
+    case FieldType::Velocity:
+      return "Velocity";
+    case FieldType::Density:
+      return "Density";
+    case FieldType::NodeIDs:
+      return "Node IDs";
+    case FieldType::Concentration1:
+      return "Concentration 1";
+    case FieldType::Concentration2:
+      return "Concentration 2";
+    case FieldType::Concentration3:
+      return "Concentration 3";
+  }
+  return "Unknown";
+}
+
+FieldSeries::Header FieldSeries::createHeader(const glm::ivec2& latticeSize, const glm::ivec4& region, uint32_t stride,
+                                              uint32_t fieldMask) {
+  const glm::ivec2 gridSize = getGridSize(region, stride);
+  Header header = {};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.latticeWidth = latticeSize.x;
+  header.latticeHeight = latticeSize.y;
+  for (int i = 0; i < 4; i++) {
+    header.region[i] = region[i];
+  }
+  header.stride = stride;
+  header.width = gridSize.x;
+  header.height = gridSize.y;
+  header.fieldMask = fieldMask;
+  return header;
+}
+
+glm::ivec2 FieldSeries::getGridSize(const glm::ivec4& region, uint32_t stride) {
+  const int samples = static_cast<int>(std::max(stride, 1u));
+  return (glm::ivec2(region.z, region.w) + samples - 1) / samples;
+}
+
+FieldSeries::IndexEntry FieldSeries::writeChunk(std::ofstream& file, FieldType field, uint64_t stepCount, Encoding encoding,
+                                                const std::vector<uint8_t>& data) {
+  ChunkHeader chunk = {};
+  std::memcpy(chunk.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+  chunk.field = static_cast<uint32_t>(field);
+  chunk.stepCount = stepCount;
+  chunk.encoding = encoding;
+  chunk.size = data.size();
+  file.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+  uint64_t offset = static_cast<uint64_t>(file.tellp());
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  return {stepCount, chunk.field, encoding, offset, chunk.size};
+}
+
+void FieldSeries::writeIndex(std::ofstream& file, const std::vector<IndexEntry>& entries) {
+  Footer footer = {};
+  std::memcpy(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  footer.indexOffset = static_cast<uint64_t>(file.tellp());
+  footer.entryCount = entries.size();
+  file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(IndexEntry));
+  file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+}
+
+bool FieldSeries::readIndex(const fs::path& path, Header& header, std::vector<IndexEntry>& entries, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "Failed to open " + path.string();
+    return false;
+  }
+  file.seekg(0, std::ios::end);
+  const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    error = "Not a field series file";
+    return false;
+  }
+  if (header.version != VERSION) {
+    error = "Unsupported field series version " + std::to_string(header.version);
+    return false;
+  }
+
+  // Use the index written on close if there is one
+  entries.clear();
+  Footer footer = {};
+  if (fileSize >= sizeof(Header) + sizeof(Footer)) {
+    file.seekg(fileSize - sizeof(Footer));
+    file.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+  }
+  if (file && std::memcmp(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+      footer.indexOffset + footer.entryCount * sizeof(IndexEntry) + sizeof(Footer) == fileSize) {
+    entries.resize(footer.entryCount);
+    file.seekg(footer.indexOffset);
+    if (file.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(IndexEntry))) {
+      return true;
+    }
+    error = "Field series index is corrupt";
+    return false;
+  }
+
+  // Otherwise walk the chunks up to the first incomplete one
+  file.clear();
+  uint64_t offset = sizeof(Header);
+  ChunkHeader chunk;
+  while (offset + sizeof(ChunkHeader) <= fileSize) {
+    file.seekg(offset);
+    if (!file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk)) || std::memcmp(chunk.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0 ||
+        offset + sizeof(ChunkHeader) + chunk.size > fileSize) {
+      break;
+    }
+    entries.push_back({chunk.stepCount, chunk.field, chunk.encoding, offset + sizeof(ChunkHeader), chunk.size});
+    offset += sizeof(ChunkHeader) + chunk.size;
+  }
+  return true;
+}
+
+const FieldSeries::IndexEntry* FieldSeries::findEntry(const std::vector<IndexEntry>& entries, uint64_t stepCount, FieldType field) {
+  for (const IndexEntry& entry : entries) {
+    if (entry.stepCount == stepCount && entry.field == static_cast<uint32_t>(field)) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+bool FieldSeries::readField(const fs::path& path, const Header& header, const IndexEntry& entry, std::vector<float>& values,
+                            std::string& error) {
+  const FieldType field = static_cast<FieldType>(entry.field);
+  const size_t valueCount = static_cast<size_t>(header.width) * header.height * getComponentCount(field);
+  std::vector<uint8_t> data(entry.size);
+  std::ifstream file(path, std::ios::binary);
+  file.seekg(entry.offset);
+  if (!file || !file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+    error = "Failed to read " + std::string(getFieldName(field)) + " at step " + std::to_string(entry.stepCount);
+    return false;
+  }
+  bool isValid = false;
+  if (entry.encoding == RAW && data.size() == valueCount * sizeof(float)) {
+    values.resize(valueCount);
+    std::memcpy(values.data(), data.data(), data.size());
+    isValid = true;
+  } else if (entry.encoding == ERROR_BOUNDED) {
+    isValid = FieldCodec::decode(data.data(), data.size(), header.width, header.height, getComponentCount(field), values);
+  }
+  if (!isValid) {
+    error = std::string(getFieldName(field)) + " at step " + std::to_string(entry.stepCount) + " is corrupt";
+  }
+  return isValid;
+}
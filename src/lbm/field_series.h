@@ -0,0 +1,105 @@
+#ifndef FIELD_SERIES_H
+#define FIELD_SERIES_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "glm.hpp"
+
+namespace fs = std::filesystem;
+
+// Macroscopic fields written by the FieldWriter, in the order of their bits in a field mask
+enum class FieldType : uint32_t {
+  Velocity,       // Two floats per node
+  Density,
+  NodeIDs,
+  Concentration1,
+  Concentration2,
+  Concentration3,
+};
+
+// Chunked container of field snapshots for post-processing.
+//
+// File layout (little endian): a Header describing the sampled grid, then one chunk per field and snapshot, each a
+// ChunkHeader followed by its data, then an index of all chunks and a Footer pointing at the index. The index gives
+// random access by step and field. Files whose index was never written, because the writer did not shut down cleanly,
+// are indexed by walking the chunks instead.
+// The grid samples every stride-th node of a region of the lattice, row by row from the bottom left node.
+struct FieldSeries {
+  static constexpr char MAGIC[8] = {'L', 'B', 'M', 'F', 'I', 'E', 'L', 'D'};
+  static constexpr char CHUNK_MAGIC[4] = {'C', 'H', 'N', 'K'};
+  static constexpr char INDEX_MAGIC[8] = {'L', 'B', 'M', 'F', 'I', 'N', 'D', 'X'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr unsigned int FIELD_COUNT = 6;
+
+  enum Encoding : uint32_t {
+    RAW = 0,            // The floats of the field as sampled
+    ERROR_BOUNDED = 1,  // A FieldCodec stream, every float within its error bound of the sampled one
+  };
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t latticeWidth;
+    uint32_t latticeHeight;
+    uint32_t region[4]; // Sampled region of the lattice (x, y, width, height)
+    uint32_t stride;    // Nodes between samples
+    uint32_t width;     // Of the sampled grid
+    uint32_t height;
+    uint32_t fieldMask; // Fields written at every snapshot
+    uint8_t reserved[12];
+  };
+
+  struct ChunkHeader {
+    char magic[4];
+    uint32_t field;
+    uint64_t stepCount;
+    uint32_t encoding;
+    uint32_t reserved;
+    uint64_t size; // Bytes of data following the chunk header
+  };
+
+  struct IndexEntry {
+    uint64_t stepCount;
+    uint32_t field;
+    uint32_t encoding;
+    uint64_t offset; // Of the chunk data from the start of the file
+    uint64_t size;
+  };
+
+  struct Footer {
+    char magic[8];
+    uint64_t indexOffset;
+    uint64_t entryCount;
+    uint64_t reserved;
+  };
+
+  // Floats per node of a field
+  static unsigned int getComponentCount(FieldType field);
+  static const char* getFieldName(FieldType field);
+
+  static Header createHeader(const glm::ivec2& latticeSize, const glm::ivec4& region, uint32_t stride, uint32_t fieldMask);
+  // Size of the grid sampling every stride-th node of the region
+  static glm::ivec2 getGridSize(const glm::ivec4& region, uint32_t stride);
+
+  // Appends a chunk to a file opened for writing after its header, and returns its index entry
+  static IndexEntry writeChunk(std::ofstream& file, FieldType field, uint64_t stepCount, Encoding encoding,
+                               const std::vector<uint8_t>& data);
+  static void writeIndex(std::ofstream& file, const std::vector<IndexEntry>& entries);
+
+  static bool readIndex(const fs::path& path, Header& header, std::vector<IndexEntry>& entries, std::string& error);
+  static const IndexEntry* findEntry(const std::vector<IndexEntry>& entries, uint64_t stepCount, FieldType field);
+  // Reads and decodes the field of one snapshot as width * height * getComponentCount(field) floats
+  static bool readField(const fs::path& path, const Header& header, const IndexEntry& entry, std::vector<float>& values,
+                        std::string& error);
+};
+
+static_assert(sizeof(FieldSeries::Header) == 64, "The field series header layout is part of the file format");
+static_assert(sizeof(FieldSeries::ChunkHeader) == 32, "The field series chunk layout is part of the file format");
+static_assert(sizeof(FieldSeries::IndexEntry) == 32, "The field series index layout is part of the file format");
+static_assert(sizeof(FieldSeries::Footer) == 32, "The field series footer layout is part of the file format");
+
+#endif // FIELD_SERIES_H
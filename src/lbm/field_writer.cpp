@@ -0,0 +1,245 @@
+#include "lbm/field_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "lbm/field_codec.h"
+
+namespace {
+
+bool isSignalled(GLsync fence) {
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+bool isFieldSelected(uint32_t fieldMask, unsigned int field) {
+  return (fieldMask & (1u << field)) != 0;
+}
+
+// Node IDs are small integers, which quantization steps of 0.5 reconstruct exactly
+const float NODE_ID_ERROR_BOUND = 0.25f;
+
+} // namespace
+
+FieldWriter::FieldWriter(std::shared_ptr<LBM> lbm) : lbm(lbm) {
+  glGenFramebuffers(1, &readFramebuffer);
+  for (Readback& readback : readbacks) {
+    glGenBuffers(1, &readback.buffer);
+  }
+}
+
+FieldWriter::~FieldWriter() {
+  stop();
+  for (Readback& readback : readbacks) {
+    glDeleteBuffers(1, &readback.buffer);
+  }
+  glDeleteFramebuffers(1, &readFramebuffer);
+}
+
+bool FieldWriter::start(const fs::path& path, std::string& error) {
+  stop();
+  const AppState& appState = AppState::getInstance();
+  const glm::ivec2 latticeSize = lbm->getLatticeSize();
+
+  // Clamp the region to the lattice, an empty region selects the whole lattice
+  glm::ivec4 region = appState.fieldOutputRegion;
+  if (region.z <= 0 || region.w <= 0) {
+    region = {0, 0, latticeSize.x, latticeSize.y};
+  }
+  glm::ivec2 regionOrigin = glm::clamp(glm::ivec2(region.x, region.y), glm::ivec2(0), latticeSize - 1);
+  glm::ivec2 regionSize = glm::min(glm::ivec2(region.z, region.w), latticeSize - regionOrigin);
+  region = {regionOrigin.x, regionOrigin.y, regionSize.x, regionSize.y};
+  const uint32_t stride = std::max(appState.fieldOutputStride, 1u);
+  const uint32_t fieldMask = appState.fieldOutputMask & ((1u << FieldSeries::FIELD_COUNT) - 1);
+  if (fieldMask == 0) {
+    error = "No fields are selected";
+    return false;
+  }
+
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    error = "Failed to open " + path.string();
+    return false;
+  }
+  header = FieldSeries::createHeader(latticeSize, region, stride, fieldMask);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  origin = regionOrigin;
+  errorBound = std::max(appState.fieldOutputErrorBound, 0.f);
+
+  // Size the sampled fields and the readbacks for the selected fields
+  snapshotSize = 0;
+  for (unsigned int i = 0; i < FieldSeries::FIELD_COUNT; i++) {
+    if (isFieldSelected(fieldMask, i)) {
+      snapshotSize += static_cast<size_t>(header.width) * header.height * FieldSeries::getComponentCount(static_cast<FieldType>(i)) *
+                      sizeof(GLfloat);
+    }
+  }
+  fields = std::make_unique<Framebuffer>(header.width, header.height, FieldSeries::FIELD_COUNT, "Field output");
+  for (Readback& readback : readbacks) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, snapshotSize, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  allocation = TrackedAllocation(MemoryKind::Buffer, "Field output", "Readback buffers", "bytes", snapshotSize, READBACK_COUNT,
+                                 READBACK_COUNT * snapshotSize);
+
+  status = Status();
+  isStopping = false;
+  writer = std::thread(&FieldWriter::writeSnapshots, this);
+  return true;
+}
+
+void FieldWriter::stop() {
+  if (!writer.joinable()) {
+    return;
+  }
+  finishReadbacks(true);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+  condition.notify_one();
+  writer.join();
+  fields.reset();
+  allocation = TrackedAllocation();
+}
+
+bool FieldWriter::isRecording() const {
+  return writer.joinable();
+}
+
+void FieldWriter::update() {
+  finishReadbacks(false);
+  const uint64_t stepCount = lbm->getStepCount();
+  if (!isRecording() || stepCount % std::max(AppState::getInstance().fieldOutputInterval, 1u) != 0) {
+    return;
+  }
+  Readback& readback = readbacks[nextReadback];
+  if (readback.fence != nullptr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    status.droppedCount++;
+    return;
+  }
+  nextReadback = (nextReadback + 1) % READBACK_COUNT;
+
+  // Sample the fields, then queue the readback of the selected ones into consecutive ranges of the buffer
+  lbm->sampleFields(*fields, origin, static_cast<GLint>(header.stride));
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  size_t offset = 0;
+  for (unsigned int i = 0; i < FieldSeries::FIELD_COUNT; i++) {
+    if (!isFieldSelected(header.fieldMask, i)) {
+      continue;
+    }
+    const unsigned int componentCount = FieldSeries::getComponentCount(static_cast<FieldType>(i));
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fields->getTexture(i), 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, header.width, header.height, (componentCount == 2) ? GL_RG : GL_RED, GL_FLOAT, reinterpret_cast<void*>(offset));
+    offset += static_cast<size_t>(header.width) * header.height * componentCount * sizeof(GLfloat);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  readback.stepCount = stepCount;
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+}
+
+FieldWriter::Status FieldWriter::getStatus() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return status;
+}
+
+void FieldWriter::finishReadbacks(bool isBlocking) {
+  // Readbacks complete in the order they were issued, starting with the oldest
+  for (unsigned int i = 0; i < READBACK_COUNT; i++) {
+    Readback& readback = readbacks[(nextReadback + i) % READBACK_COUNT];
+    if (readback.fence == nullptr) {
+      continue;
+    }
+    if (isBlocking) {
+      glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    } else if (!isSignalled(readback.fence)) {
+      return;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    Snapshot snapshot = {readback.stepCount, std::vector<uint8_t>(snapshotSize)};
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, snapshotSize, GL_MAP_READ_BIT);
+    if (data != nullptr) {
+      std::memcpy(snapshot.data.data(), data, snapshotSize);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (data != nullptr) {
+      snapshots.push_back(std::move(snapshot));
+      condition.notify_one();
+    } else {
+      status.error = "Failed to map the field readback buffer";
+      status.droppedCount++;
+    }
+  }
+}
+
+void FieldWriter::writeSnapshots() {
+  std::vector<FieldSeries::IndexEntry> entries;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    condition.wait(lock, [this] { return isStopping || !snapshots.empty(); });
+    if (snapshots.empty()) {
+      break;
+    }
+    Snapshot snapshot = std::move(snapshots.front());
+    snapshots.pop_front();
+    lock.unlock();
+
+    // One chunk per field, flushed so that a file that is never closed can still be indexed up to its last snapshot
+    size_t offset = 0;
+    for (unsigned int i = 0; i < FieldSeries::FIELD_COUNT; i++) {
+      if (!isFieldSelected(header.fieldMask, i)) {
+        continue;
+      }
+      const FieldType field = static_cast<FieldType>(i);
+      const unsigned int componentCount = FieldSeries::getComponentCount(field);
+      const size_t size = static_cast<size_t>(header.width) * header.height * componentCount * sizeof(GLfloat);
+      if (errorBound > 0.f) {
+        std::vector<float> values(size / sizeof(GLfloat));
+        std::memcpy(values.data(), snapshot.data.data() + offset, size);
+        const float fieldErrorBound = (field == FieldType::NodeIDs) ? NODE_ID_ERROR_BOUND : errorBound;
+        std::vector<uint8_t> data = FieldCodec::encode(values, header.width, header.height, componentCount, fieldErrorBound);
+        entries.push_back(FieldSeries::writeChunk(file, field, snapshot.stepCount, FieldSeries::ERROR_BOUNDED, data));
+      } else {
+        std::vector<uint8_t> data(snapshot.data.begin() + offset, snapshot.data.begin() + offset + size);
+        entries.push_back(FieldSeries::writeChunk(file, field, snapshot.stepCount, FieldSeries::RAW, data));
+      }
+      offset += size;
+    }
+    file.flush();
+    const bool isWritten = static_cast<bool>(file);
+    const uint64_t bytes = static_cast<uint64_t>(file.tellp());
+
+    lock.lock();
+    if (isWritten) {
+      status.snapshotCount++;
+      status.lastStep = snapshot.stepCount;
+      status.bytes = bytes;
+      status.fieldBytes += snapshot.data.size();
+    } else {
+      status.error = "Failed to write field snapshot at step " + std::to_string(snapshot.stepCount);
+    }
+  }
+  lock.unlock();
+
+  FieldSeries::writeIndex(file, entries);
+  const uint64_t bytes = static_cast<uint64_t>(file.tellp());
+  file.close();
+  lock.lock();
+  if (file) {
+    status.bytes = bytes;
+  } else {
+    status.error = "Failed to write the field series index";
+  }
+}
@@ -0,0 +1,100 @@
+#ifndef FIELD_WRITER_H
+#define FIELD_WRITER_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+
+#include "gl/framebuffers.h"
+#include "gl/memory_tracker.h"
+#include "lbm/field_series.h"
+#include "lbm/lbm.h"
+
+namespace fs = std::filesystem;
+
+// Writes snapshots of the macroscopic fields to a FieldSeries file while the simulation keeps running.
+// Every AppState::fieldOutputInterval steps the selected fields are sampled on the GPU at every
+// AppState::fieldOutputStride-th node of AppState::fieldOutputRegion and read into one of a ring of pixel pack
+// buffers. Once the fence of a readback has signalled, the snapshot is handed to an I/O thread that appends it to the
+// file, and the index is written when recording stops. Snapshots that find every readback still in flight are dropped
+// rather than waited for. With a positive AppState::fieldOutputErrorBound the I/O thread compresses every field with
+// the FieldCodec before writing it.
+class FieldWriter {
+public:
+  static constexpr unsigned int READBACK_COUNT = 4; // Snapshots that can be in flight at once
+
+  struct Status {
+    uint64_t snapshotCount = 0; // Written to the file
+    uint64_t lastStep = 0;      // Of the latest written snapshot
+    uint64_t bytes = 0;
+    uint64_t fieldBytes = 0;    // Of the written fields before compression
+    uint64_t droppedCount = 0;
+    std::string error;
+  };
+
+  FieldWriter(std::shared_ptr<LBM> lbm);
+  ~FieldWriter(); // Stops recording
+
+  // Disallow copy and assignment to avoid multiple deletions of OpenGL objects
+  FieldWriter(const FieldWriter&) = delete;
+  FieldWriter& operator=(const FieldWriter&) = delete;
+
+  // Starts a new file with the field output parameters of the AppState
+  bool start(const fs::path& path, std::string& error);
+  // Writes the snapshots in flight and the index
+  void stop();
+  bool isRecording() const;
+
+  // Call after every simulation step, with the context current
+  void update();
+
+  Status getStatus() const;
+
+private:
+  struct Snapshot {
+    uint64_t stepCount;
+    std::vector<uint8_t> data; // Selected fields in FieldType order
+  };
+
+  struct Readback {
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    uint64_t stepCount = 0;
+  };
+
+  std::shared_ptr<LBM> lbm;
+  FieldSeries::Header header;
+  glm::ivec2 origin;
+  float errorBound = 0.f;              // Of the compressed fields, 0 for raw floats
+  std::unique_ptr<Framebuffer> fields; // One texture per FieldType, one texel per sample
+  size_t snapshotSize = 0;             // Bytes
+  GLuint readFramebuffer;
+  std::array<Readback, READBACK_COUNT> readbacks;
+  unsigned int nextReadback = 0;       // Readbacks are issued and completed in ring order
+  TrackedAllocation allocation;
+
+  // I/O thread state, guarded by the mutex while recording
+  std::thread writer;
+  std::ofstream file;
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<Snapshot> snapshots;
+  bool isStopping = false;
+  Status status;
+
+  void finishReadbacks(bool isBlocking);
+  void writeSnapshots();
+};
+
+#endif // FIELD_WRITER_H
@@ -1,12 +1,23 @@
 #ifndef FLUID_H
 #define FLUID_H
 
-#include "gl/framebuffers.h"
+#include <memory>
 
+#include "core/app_state.h"
+#include "gl/framebuffers.h"
+#include "gl/storage_buffers.h"
 
 struct Fluid {
-  Fluid(const unsigned int width, const unsigned int height, const GLfloat viscosity)
-  : fbo(width, height, 4) {
+  Fluid(const unsigned int width, const unsigned int height, const GLfloat viscosity, const SolverBackend backend)
+  : fbo(width, height, backend == SolverBackend::FragmentShader ? 4 : 2, "Fluid", backend == SolverBackend::FragmentShader) {
+    // The compute backends keep the distributions in storage buffers and only mirror
+    // the macroscopic quantities (velocity, force density, density) into fbo,
+    // which is never sampled by the pass writing it and so needs no second copy
+    if (backend != SolverBackend::FragmentShader) {
+      bool isDoubleBuffered = backend != SolverBackend::InPlaceComputeShader;
+      populations = std::make_unique<ReadWriteStorageBuffer>(DISTRIBUTION_COUNT * width * height * sizeof(GLfloat), "Fluid",
+                                                             isDoubleBuffered);
+    }
     setViscosity(viscosity);
   }
   ~Fluid() = default;
@@ -18,8 +29,10 @@ struct Fluid {
   }
   
   static constexpr GLfloat TRT_MAGIC = 1. / 4.;
+  static constexpr GLuint DISTRIBUTION_COUNT = 9;
 
   ReadWriteFramebuffer fbo;
+  std::unique_ptr<ReadWriteStorageBuffer> populations;
   GLfloat plusOmega;
   GLfloat minusOmega;
   GLfloat tau;
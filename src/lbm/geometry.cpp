@@ -0,0 +1,120 @@
+#include "geometry.h"
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+
+#include "core/app_state.h"
+#include "core/io.h"
+#include "lbm/lbm.h"
+
+namespace {
+
+bool isRawBitmap(const fs::path& path) {
+  const std::string extension = path.extension().string();
+  return extension == ".raw" || extension == ".bin";
+}
+
+bool readRawBitmap(const fs::path& path, const glm::ivec2& latticeSize, const GeometryOptions& options, glm::ivec2& size,
+                   std::vector<uint8_t>& walls, std::string& error) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    error = "Failed to open " + path.string();
+    return false;
+  }
+  const size_t fileSize = static_cast<size_t>(file.tellg());
+  size = options.rawSize;
+  if (size.x <= 0 || size.y <= 0) {
+    const size_t side = static_cast<size_t>(std::llround(std::sqrt(static_cast<double>(fileSize))));
+    size = (fileSize == static_cast<size_t>(latticeSize.x) * latticeSize.y) ? latticeSize : glm::ivec2(static_cast<int>(side));
+  }
+  if (static_cast<size_t>(size.x) * size.y != fileSize || fileSize == 0) {
+    error = path.string() + " does not hold " + std::to_string(size.x) + "x" + std::to_string(size.y) + " bytes";
+    return false;
+  }
+  walls.resize(fileSize);
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(walls.data()), walls.size());
+  for (uint8_t& wall : walls) {
+    wall = ((wall != 0) != options.isInverted) ? 1 : 0;
+  }
+  return true;
+}
+
+bool readImage(const fs::path& path, const GeometryOptions& options, glm::ivec2& size, std::vector<uint8_t>& walls, std::string& error) {
+  if (!loadLuminance(path, size.x, size.y, walls, error)) {
+    return false;
+  }
+  for (uint8_t& wall : walls) {
+    wall = ((wall < 128) != options.isInverted) ? 1 : 0;
+  }
+  return true;
+}
+
+} // namespace
+
+bool readGeometry(const fs::path& path, const glm::ivec2& latticeSize, const GeometryOptions& options, std::vector<GLfloat>& nodeIds,
+                  std::string& error) {
+  // One byte per pixel, 1 for walls, row by row from the top
+  glm::ivec2 maskSize;
+  std::vector<uint8_t> walls;
+  if (isRawBitmap(path) ? !readRawBitmap(path, latticeSize, options, maskSize, walls, error)
+                        : !readImage(path, options, maskSize, walls, error)) {
+    return false;
+  }
+
+  // Count the wall pixels in the footprint of every node, flipping the rows to start from the bottom
+  const size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+  std::vector<uint32_t> wallCounts(nodeCount, 0);
+  std::vector<uint32_t> pixelCounts(nodeCount, 0);
+  for (int y = 0; y < maskSize.y; y++) {
+    const int nodeY = latticeSize.y - 1 - static_cast<int>(static_cast<int64_t>(y) * latticeSize.y / maskSize.y);
+    for (int x = 0; x < maskSize.x; x++) {
+      const int nodeX = static_cast<int>(static_cast<int64_t>(x) * latticeSize.x / maskSize.x);
+      const size_t node = static_cast<size_t>(nodeY) * latticeSize.x + nodeX;
+      wallCounts[node] += walls[static_cast<size_t>(y) * maskSize.x + x];
+      pixelCounts[node]++;
+    }
+  }
+
+  // Nodes that no pixel falls into take the pixel at their centre
+  nodeIds.resize(nodeCount);
+  for (int nodeY = 0; nodeY < latticeSize.y; nodeY++) {
+    for (int nodeX = 0; nodeX < latticeSize.x; nodeX++) {
+      const size_t node = static_cast<size_t>(nodeY) * latticeSize.x + nodeX;
+      bool isWall;
+      if (pixelCounts[node] > 0) {
+        isWall = 2 * wallCounts[node] >= pixelCounts[node];
+      } else {
+        const int x = static_cast<int>((2 * static_cast<int64_t>(nodeX) + 1) * maskSize.x / (2 * latticeSize.x));
+        const int y = static_cast<int>((2 * static_cast<int64_t>(latticeSize.y - 1 - nodeY) + 1) * maskSize.y / (2 * latticeSize.y));
+        isWall = walls[static_cast<size_t>(y) * maskSize.x + x] != 0;
+      }
+      nodeIds[node] = isWall ? 1.f : 0.f;
+    }
+  }
+  return true;
+}
+
+bool loadGeometry(LBM& lbm, const fs::path& path, const GeometryOptions& options, std::string& error) {
+  const glm::ivec2 latticeSize = lbm.getLatticeSize();
+  std::vector<GLfloat> nodeIds;
+  if (!readGeometry(path, latticeSize, options, nodeIds, error)) {
+    return false;
+  }
+
+  // The boundary walls occupy the right column and the bottom row of the periodic lattice
+  bool isRightColumnClosed = true;
+  for (int y = 0; y < latticeSize.y; y++) {
+    isRightColumnClosed = isRightColumnClosed && nodeIds[static_cast<size_t>(y) * latticeSize.x + latticeSize.x - 1] > 0.5f;
+  }
+  bool isBottomRowClosed = true;
+  for (int x = 0; x < latticeSize.x; x++) {
+    isBottomRowClosed = isBottomRowClosed && nodeIds[x] > 0.5f;
+  }
+  AppState& appState = AppState::getInstance();
+  appState.hasVerticalWalls = isRightColumnClosed;
+  appState.hasHorizontalWalls = isBottomRowClosed;
+  lbm.replaceNodeIDs(nodeIds);
+  return true;
+}
@@ -0,0 +1,34 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+
+namespace fs = std::filesystem;
+
+class LBM;
+
+struct GeometryOptions {
+  glm::ivec2 rawSize = {0, 0}; // Of raw bitmaps, inferred from the file size if zero
+  bool isInverted = false;     // Bright pixels and zero bytes are walls
+};
+
+// Reads a wall mask and resamples it to the lattice, stretching it to cover the whole lattice. Node IDs are returned
+// row by row from the bottom of the lattice, as they are uploaded to the GPU.
+// Files ending in .raw or .bin are raw bitmaps of one byte per pixel, row by row from the top, where non-zero bytes
+// are walls. Their size is the lattice size or a square if it is not given. Any other file is an image in one of the
+// formats stb_image reads, such as PNG or binary PGM, where dark pixels are walls and transparent pixels fluid.
+// Every node becomes a wall if at least half of the pixels it covers are walls, or the pixel at its centre when the
+// mask is coarser than the lattice.
+bool readGeometry(const fs::path& path, const glm::ivec2& latticeSize, const GeometryOptions& options, std::vector<GLfloat>& nodeIds,
+                  std::string& error);
+
+// Reads a wall mask and replaces the walls of the simulation with it while the flow goes on. The boundary walls are
+// enabled if the mask closes the corresponding edge, as the node ID pass rewrites the edge rows every step.
+bool loadGeometry(LBM& lbm, const fs::path& path, const GeometryOptions& options, std::string& error);
+
+#endif // GEOMETRY_H
@@ -0,0 +1,76 @@
+#ifndef KERNEL_COSTS_H
+#define KERNEL_COSTS_H
+
+#include <glad/glad.h>
+
+#include "core/app_state.h"
+#include "gl/gpu_profiler.h"
+
+// Analytical per-node cost of the simulation kernels, used to turn measured pass times into
+// achieved bandwidth and arithmetic throughput.
+// Bytes are the compulsory traffic: every texel or storage element a kernel touches is counted once,
+// at the size of its format, assuming that fetches of neighbouring nodes are served from cache.
+// Flops are estimated from the shader arithmetic, counting a multiply-add as two operations.
+struct KernelCosts {
+  using PassCost = GPUProfiler::PassCost;
+
+  static constexpr double TEXEL_SIZE = 4 * sizeof(GLfloat); // RGBA32F attachments and images
+  static constexpr double DISTRIBUTIONS_SIZE = 9 * sizeof(GLfloat);
+  static constexpr double STENCIL_SIZE = 4;                  // DEPTH24_STENCIL8 renderbuffer
+
+  static constexpr double NODE_ID_FLOPS = 15.;
+  static constexpr double FLUID_COLLISION_FLOPS = 310.;      // Moments, forcing and TRT relaxation of 9 distributions
+  static constexpr double SOLUTE_COLLISION_FLOPS = 275.;     // Concentration, source term and TRT relaxation of 9 distributions
+  static constexpr double REACTION_FLOPS_PER_REACTANT = 2.;
+  static constexpr double OCCUPANCY_FLOPS = 12.;
+  static constexpr double OUTPUT_FLOPS = 50.;
+
+  static PassCost getNodeIDCost() {
+    // Read and write the node ID texel
+    return {TEXEL_SIZE, TEXEL_SIZE, NODE_ID_FLOPS};
+  }
+
+  static PassCost getWallStencilCost() {
+    // Read the node ID texel and write the stencil, the wall resets touch wall nodes only and are ignored
+    return {TEXEL_SIZE, STENCIL_SIZE, 0.};
+  }
+
+  static PassCost getOccupancyCost(unsigned int soluteCount, unsigned int reductionFactor) {
+    // The finest level reads the first texel of every solute, coarser levels are negligible in comparison
+    double reducedNodes = 1. / (reductionFactor * reductionFactor);
+    return {soluteCount * TEXEL_SIZE + reducedNodes * TEXEL_SIZE, reducedNodes * TEXEL_SIZE, OCCUPANCY_FLOPS};
+  }
+
+  static PassCost getFluidCost(SolverBackend backend) {
+    if (backend == SolverBackend::FragmentShader) {
+      // Collision and streaming each read the node ID and 4 fluid texels and write 4 fluid texels
+      return {2 * (TEXEL_SIZE + 4 * TEXEL_SIZE), 2 * 4 * TEXEL_SIZE, FLUID_COLLISION_FLOPS};
+    }
+
+    // Fused update: read node ID and distributions, write distributions and 2 macroscopic texels
+    return {TEXEL_SIZE + DISTRIBUTIONS_SIZE, DISTRIBUTIONS_SIZE + 2 * TEXEL_SIZE, FLUID_COLLISION_FLOPS};
+  }
+
+  static PassCost getSoluteCost(SolverBackend backend, unsigned int soluteCount, unsigned int reactantCount) {
+    double reactionFlops = REACTION_FLOPS_PER_REACTANT * reactantCount;
+    if (backend == SolverBackend::FragmentShader) {
+      // Per solute, collision reads the node ID, 3 solute texels, 2 fluid texels and the concentration of
+      // every reactant, streaming reads the node ID and 3 solute texels; both write 3 solute texels
+      double bytesRead = (TEXEL_SIZE + 3 * TEXEL_SIZE + 2 * TEXEL_SIZE + reactantCount * TEXEL_SIZE) + (TEXEL_SIZE + 3 * TEXEL_SIZE);
+      double bytesWritten = 2 * 3 * TEXEL_SIZE;
+      return PassCost{bytesRead, bytesWritten, SOLUTE_COLLISION_FLOPS + reactionFlops} * soluteCount;
+    }
+
+    // Fused multi-solute update: node ID and 2 fluid texels are shared by all solutes
+    return {TEXEL_SIZE + 2 * TEXEL_SIZE + soluteCount * DISTRIBUTIONS_SIZE,
+            soluteCount * (DISTRIBUTIONS_SIZE + TEXEL_SIZE),
+            soluteCount * SOLUTE_COLLISION_FLOPS + reactionFlops};
+  }
+
+  static PassCost getOutputCost(unsigned int soluteCount) {
+    // Per output pixel: node ID, fluid and every solute are read once, one colour texel is written
+    return {(2 + soluteCount) * TEXEL_SIZE, TEXEL_SIZE, OUTPUT_FLOPS};
+  }
+};
+
+#endif // KERNEL_COSTS_H
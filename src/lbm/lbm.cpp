@@ -3,15 +3,23 @@
 
 LBM::LBM(const unsigned int width, const unsigned int height) :
   appState(AppState::getInstance()),
-  fluid(width, height, appState.fluidViscosity),
-  solutes{Solute(width, height, appState.soluteDiffusivities[0], appState.soluteColors[0]),
-          Solute(width, height, appState.soluteDiffusivities[1], appState.soluteColors[1]),
-          Solute(width, height, appState.soluteDiffusivities[2], appState.soluteColors[2])},
-  reaction(width, height, REACTION_MOLAR_MASSES, REACTION_STOICHIOMETRIC_COEFFS, appState.reactionRate)
+  backend(appState.solverBackend),
+  latticeSize(width, height),
+  fluid(width, height, appState.fluidViscosity, backend),
+  solutes{Solute(width, height, appState.soluteDiffusivities[0], appState.soluteColors[0], backend, "Solute 1"),
+          Solute(width, height, appState.soluteDiffusivities[1], appState.soluteColors[1], backend, "Solute 2"),
+          Solute(width, height, appState.soluteDiffusivities[2], appState.soluteColors[2], backend, "Solute 3")},
+  reaction(appState.reactionMolarMasses, appState.reactionStoichiometricCoeffs, appState.reactionRate),
+  occupancy(width, height)
 {
   createTriangles();
+  createTileQuad();
   createFBOs(width, height);
+  if (backend != SolverBackend::FragmentShader) {
+    createComputeShaderPrograms();
+  }
   createShaderPrograms();
+  updatePassCosts();
 
   // Clear all FBOs
   nodeIdFBO->clear(0.0, 0.0, 0.0, 0.0);
@@ -20,9 +28,16 @@ LBM::LBM(const unsigned int width, const unsigned int height) :
     solutes[i].fbo.clear(0.0, 0.0, 0.0, 0.0);
   }
   initFluid();
-  initSolute(0, INIT_SOLUTE_CENTER_0, INIT_SOLUTE_RADIUS_0);
-  initSolute(1, INIT_SOLUTE_CENTER_1, INIT_SOLUTE_RADIUS_1);
-  initSolute(2, INIT_SOLUTE_CENTER_2, INIT_SOLUTE_RADIUS_2);
+  for (int i = 0; i < 3; i++) {
+    initSolute(i);
+  }
+}
+
+LBM::~LBM() {
+  glDeleteVertexArrays(1, &vertexArray);
+  glDeleteBuffers(1, &vertexBuffer);
+  glDeleteVertexArrays(1, &tileVertexArray);
+  glDeleteBuffers(1, &tileVertexBuffer);
 }
 
 void LBM::createTriangles() {
@@ -50,9 +65,44 @@ void LBM::createTriangles() {
   glBindVertexArray(0);
 }
 
+void LBM::createTileQuad() {
+  GLfloat vertices[] = {
+      0.0f, 0.0f, 0.0f,  // Bottom Left
+      1.0f, 0.0f, 0.0f,  // Bottom Right
+      0.0f, 1.0f, 0.0f,  // Top Left
+      1.0f, 1.0f, 0.0f   // Top Right
+  };
+
+  // Generate and bind the VAO
+  glGenVertexArrays(1, &tileVertexArray);
+  glBindVertexArray(tileVertexArray);
+
+  // Generate and bind the VBO
+  glGenBuffers(1, &tileVertexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, tileVertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+  // Set the vertex attributes pointers
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+  glEnableVertexAttribArray(0);
+
+  // Unbind the VBO and VAO to make sure they're not accidentally modified
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
 void LBM::createFBOs(const unsigned int width, const unsigned int height) {
-  outputFBO = std::make_unique<Framebuffer>(width, height, 1);
-  nodeIdFBO = std::make_unique<ReadWriteFramebuffer>(width, height, 1);
+  outputFBO = std::make_unique<Framebuffer>(width, height, 1, "Output");
+  nodeIdFBO = std::make_unique<ReadWriteFramebuffer>(width, height, 1, "Node IDs");
+
+  // Wall nodes are mirrored into a stencil buffer so that the fragment passes can skip them
+  if (backend == SolverBackend::FragmentShader) {
+    wallStencil = std::make_unique<StencilBuffer>(width, height, "Wall stencil");
+    fluid.fbo.attachStencilBuffer(*wallStencil);
+    for (int i = 0; i < solutes.size(); i++) {
+      solutes[i].fbo.attachStencilBuffer(*wallStencil);
+    }
+  }
 }
 
 void LBM::createShaderPrograms() {
@@ -60,6 +110,53 @@ void LBM::createShaderPrograms() {
   fs::path shadersDir = executablePath.parent_path() / "shaders";
   fs::path vertexShaderPath = shadersDir / "vs_base.glsl";
 
+  fs::path nodeIDShaderPath = shadersDir / "fs_nodeid_update.glsl";
+  nodeIDShader = std::make_unique<ShaderProgram>(vertexShaderPath, nodeIDShaderPath);
+  nodeIDShader->validate(vertexArray);
+
+  fs::path outputShaderPath = shadersDir / "fs_output.glsl";
+  outputShader = std::make_unique<ShaderProgram>(vertexShaderPath, outputShaderPath);
+  outputShader->validate(vertexArray);
+
+  // Auto-checkpoints detect changed tiles and field output samples the fields on every backend
+  fs::path occupancyReductionShaderPath = shadersDir / "fs_occupancy_reduce.glsl";
+  occupancyReductionShader = std::make_unique<ShaderProgram>(vertexShaderPath, occupancyReductionShaderPath);
+  occupancyReductionShader->validate(vertexArray);
+
+  fs::path changeDetectShaderPath = shadersDir / "fs_change_detect.glsl";
+  changeDetectShader = std::make_unique<ShaderProgram>(vertexShaderPath, changeDetectShaderPath);
+  changeDetectShader->validate(vertexArray);
+
+  fs::path fieldSampleShaderPath = shadersDir / "fs_field_sample.glsl";
+  fieldSampleShader = std::make_unique<ShaderProgram>(vertexShaderPath, fieldSampleShaderPath);
+  fieldSampleShader->validate(vertexArray);
+
+  fs::path tileVertexShaderPath = shadersDir / "vs_tile.glsl";
+  fs::path changeReferenceShaderPath = shadersDir / "fs_change_reference.glsl";
+  changeReferenceShader = std::make_unique<ShaderProgram>(tileVertexShaderPath, changeReferenceShaderPath);
+  changeReferenceShader->validate(tileVertexArray);
+
+  // The remaining passes are replaced by compute dispatches on the compute backends
+  if (backend != SolverBackend::FragmentShader) {
+    return;
+  }
+
+  fs::path wallStencilShaderPath = shadersDir / "fs_wall_stencil.glsl";
+  wallStencilShader = std::make_unique<ShaderProgram>(vertexShaderPath, wallStencilShaderPath);
+  wallStencilShader->validate(vertexArray);
+
+  fs::path wallResetShaderPath = shadersDir / "fs_wall_reset.glsl";
+  wallResetShader = std::make_unique<ShaderProgram>(vertexShaderPath, wallResetShaderPath);
+  wallResetShader->validate(vertexArray);
+
+  fs::path soluteOccupancyShaderPath = shadersDir / "fs_occupancy_solutes.glsl";
+  soluteOccupancyShader = std::make_unique<ShaderProgram>(vertexShaderPath, soluteOccupancyShaderPath);
+  soluteOccupancyShader->validate(vertexArray);
+
+  fs::path occupancyDilationShaderPath = shadersDir / "fs_occupancy_dilate.glsl";
+  occupancyDilationShader = std::make_unique<ShaderProgram>(vertexShaderPath, occupancyDilationShaderPath);
+  occupancyDilationShader->validate(vertexArray);
+
   fs::path fluidInitShaderPath = shadersDir / "fs_fluid_init.glsl";
   fluidInitShader = std::make_unique<ShaderProgram>(vertexShaderPath, fluidInitShaderPath);
   fluidInitShader->validate(vertexArray);
@@ -72,29 +169,52 @@ void LBM::createShaderPrograms() {
   fluidCollisionShader = std::make_unique<ShaderProgram>(vertexShaderPath, fluidCollisionShaderPath);
   fluidCollisionShader->validate(vertexArray);
 
+  // The solute passes are only rasterised over tiles that contain solute
   fs::path soluteCollisionShaderPath = shadersDir / "fs_solute_collision.glsl";
-  soluteCollisionShader = std::make_unique<ShaderProgram>(vertexShaderPath, soluteCollisionShaderPath);
-  soluteCollisionShader->validate(vertexArray);
+  soluteCollisionShader = std::make_unique<ShaderProgram>(tileVertexShaderPath, soluteCollisionShaderPath);
+  soluteCollisionShader->validate(tileVertexArray);
 
   fs::path fluidStreamingShaderPath = shadersDir / "fs_fluid_streaming.glsl";
   fluidStreamingShader = std::make_unique<ShaderProgram>(vertexShaderPath, fluidStreamingShaderPath);
   fluidStreamingShader->validate(vertexArray);
 
   fs::path soluteStreamingShaderPath = shadersDir / "fs_solute_streaming.glsl";
-  soluteStreamingShader = std::make_unique<ShaderProgram>(vertexShaderPath, soluteStreamingShaderPath);
-  soluteStreamingShader->validate(vertexArray);
+  soluteStreamingShader = std::make_unique<ShaderProgram>(tileVertexShaderPath, soluteStreamingShaderPath);
+  soluteStreamingShader->validate(tileVertexArray);
+}
 
-  fs::path reactionShaderPath = shadersDir / "fs_reaction.glsl";
-  reactionShader = std::make_unique<ShaderProgram>(vertexShaderPath, reactionShaderPath);
-  reactionShader->validate(vertexArray);
+void LBM::createComputeShaderPrograms() {
+  fs::path executablePath = getExecutablePath();
+  fs::path shadersDir = executablePath.parent_path() / "shaders";
 
-  fs::path nodeIDShaderPath = shadersDir / "fs_nodeid_update.glsl";
-  nodeIDShader = std::make_unique<ShaderProgram>(vertexShaderPath, nodeIDShaderPath);
-  nodeIDShader->validate(vertexArray);
+  fluidInitComputeShader = std::make_unique<ShaderProgram>(shadersDir / "cs_fluid_init.glsl");
+  soluteInitComputeShader = std::make_unique<ShaderProgram>(shadersDir / "cs_solute_init.glsl");
+  tileGatherComputeShader = std::make_unique<ShaderProgram>(shadersDir / "cs_tile_gather.glsl");
+  if (backend == SolverBackend::InPlaceComputeShader) {
+    fluidInPlaceUpdateComputeShader = std::make_unique<ShaderProgram>(shadersDir / "cs_fluid_update_in_place.glsl");
+    soluteInPlaceUpdateComputeShader = std::make_unique<ShaderProgram>(shadersDir / "cs_solute_update_in_place.glsl");
+  } else {
+    fluidUpdateComputeShader = std::make_unique<ShaderProgram>(shadersDir / "cs_fluid_update.glsl");
+    soluteUpdateComputeShader = std::make_unique<ShaderProgram>(shadersDir / "cs_solute_update.glsl");
+  }
+}
 
-  fs::path outputShaderPath = shadersDir / "fs_output.glsl";
-  outputShader = std::make_unique<ShaderProgram>(vertexShaderPath, outputShaderPath);
-  outputShader->validate(vertexArray);
+void LBM::updatePassCosts() const {
+  // Scale the per-node kernel costs to the lattice and output image the passes cover
+  GPUProfiler& profiler = GPUProfiler::getInstance();
+  double nodeCount = static_cast<double>(latticeSize.x) * latticeSize.y;
+  glm::vec2 outputSize = 1.f / outputFBO->getTexelSize();
+  double pixelCount = static_cast<double>(outputSize.x) * outputSize.y;
+  unsigned int reactantCount = 0;
+  for (GLint coeff : reaction.stoichiometricCoeffs) {
+    reactantCount += (coeff < 0) ? 1 : 0;
+  }
+  profiler.setPassCost("Node IDs", KernelCosts::getNodeIDCost() * nodeCount);
+  profiler.setPassCost("Wall stencil", KernelCosts::getWallStencilCost() * nodeCount);
+  profiler.setPassCost("Occupancy", KernelCosts::getOccupancyCost(solutes.size(), MaxPyramid::REDUCTION_FACTOR) * nodeCount);
+  profiler.setPassCost("Fluid", KernelCosts::getFluidCost(backend) * nodeCount);
+  profiler.setPassCost("Solutes", KernelCosts::getSoluteCost(backend, solutes.size(), reactantCount) * nodeCount);
+  profiler.setPassCost("Output", KernelCosts::getOutputCost(solutes.size()) * pixelCount);
 }
 
 void LBM::setViscosity(GLfloat viscosity) {
@@ -113,16 +233,133 @@ void LBM::setReactionRate(GLfloat rate) {
   reaction.setReactionRate(rate);
 }
 
+void LBM::setSolutesEnabled(bool isEnabled) {
+  areSolutesEnabled = isEnabled;
+}
+
+void LBM::setBodyForce(const glm::vec2& force) {
+  bodyForce = force;
+}
+
+void LBM::setFluidVelocity(const std::vector<glm::vec2>& velocities) {
+  // Re-initialise the fluid at equilibrium with the given velocity field, the init pass adds it to the initial velocity
+  std::vector<glm::vec4> data;
+  data.reserve(velocities.size());
+  for (const glm::vec2& velocity : velocities) {
+    data.push_back({velocity, 0.f, 0.f});
+  }
+  fluid.fbo.clear(0.0, 0.0, 0.0, 0.0);
+  uploadTexture(fluid.fbo.getTexture(0), data);
+  initFluid();
+}
+
+void LBM::setSoluteConcentration(unsigned int soluteID, const std::vector<GLfloat>& concentrations) {
+  // Re-initialise the solute at equilibrium with the given concentration field and the current fluid velocity
+  std::vector<glm::vec4> data;
+  data.reserve(concentrations.size());
+  for (GLfloat concentration : concentrations) {
+    data.push_back({concentration, 0.f, 0.f, 0.f});
+  }
+  solutes[soluteID].fbo.clear(0.0, 0.0, 0.0, 0.0);
+  uploadTexture(solutes[soluteID].fbo.getTexture(0), data);
+  initSolute(soluteID);
+}
+
+void LBM::setNodeIDs(const std::vector<GLfloat>& nodeIds) {
+  // Only the red channel is read, and the node ID pass rewrites the other buffer from this one
+  uploadTexture(nodeIdFBO->getTexture(0), nodeIds);
+  isWallStencilDirty = true;
+  areAllTilesStale = true;
+}
+
+void LBM::replaceNodeIDs(const std::vector<GLfloat>& nodeIds) {
+  // The previous node IDs stay in the other buffer until the next node ID pass, so that the init passes only reset the
+  // nodes whose ID changed. They take the velocity and concentrations in place as their preset fields and write one
+  // buffer of each pair, so they run twice to leave both buffers consistent for the culled solute passes
+  uploadTexture(nodeIdFBO->getWriteTexture(0), nodeIds);
+  nodeIdFBO->swap();
+  isWallStencilDirty = true;
+  for (int i = 0; i < 2; i++) {
+    initFluid(true);
+    for (int j = 0; j < solutes.size(); j++) {
+      initSolute(j, true);
+    }
+  }
+}
+
+void LBM::loadScene(const Scene& scene) {
+  // The walls come first, as the fluid and solutes are only initialised on fluid nodes
+  setNodeIDs(scene.nodeIds);
+  setBodyForce(scene.bodyForce);
+  setFluidVelocity(scene.velocities);
+  for (int i = 0; i < 3; i++) {
+    setSoluteConcentration(i, scene.concentrations[i]);
+  }
+}
+
 void LBM::updateSimulation() {
+  GPUProfiler& profiler = GPUProfiler::getInstance();
+  profiler.addLatticeUpdates(static_cast<uint64_t>(latticeSize.x) * latticeSize.y);
+  stepCount++;
+  toolInput = getToolInput();
+  hasInjectedToolInput = false;
+
   // Perform all simulation updates in turn
+  profiler.beginPass("Node IDs");
   updateNodeIDs();
-  updateFluid();
-  react();
-  for (int i = 0; i < solutes.size(); i++) {
-    updateSolute(i);
+  profiler.endPass();
+  if (backend == SolverBackend::InPlaceComputeShader) {
+    profiler.beginPass("Fluid");
+    updateFluidInPlace();
+    profiler.endPass();
+    if (areSolutesEnabled) {
+      profiler.beginPass("Solutes");
+      updateSolutesInPlace();
+      profiler.endPass();
+    }
+    isOddInPlaceStep = !isOddInPlaceStep;
+  } else if (backend == SolverBackend::ComputeShader) {
+    profiler.beginPass("Fluid");
+    updateFluidCompute();
+    profiler.endPass();
+    if (areSolutesEnabled) {
+      profiler.beginPass("Solutes");
+      updateSolutesCompute();
+      profiler.endPass();
+    }
+  } else {
+    if (isWallStencilDirty) {
+      profiler.beginPass("Wall stencil");
+      updateWallStencil();
+      profiler.endPass();
+    }
+    if (areSolutesEnabled) {
+      profiler.beginPass("Occupancy");
+      updateOccupancy();
+      profiler.endPass();
+    }
+    setWallCulling(true);
+    profiler.beginPass("Fluid");
+    updateFluid();
+    profiler.endPass();
+
+    // All solutes collide before any of them stream, so that every inline
+    // reaction rate sees the concentrations from the start of the step
+    if (areSolutesEnabled) {
+      profiler.beginPass("Solutes");
+      for (int i = 0; i < solutes.size(); i++) {
+        collideSolute(i);
+      }
+      for (int i = 0; i < solutes.size(); i++) {
+        streamSolute(i);
+      }
+      profiler.endPass();
+    }
+    setWallCulling(false);
   }
 
   // Render output image
+  profiler.beginPass("Output", false);
   outputFBO->bind();
   outputShader->use();
   outputShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
@@ -147,25 +384,280 @@ void LBM::updateSimulation() {
   glBindVertexArray(0);
   glUseProgram(0);
   outputFBO->unbind();
+  profiler.endPass();
 }
 
 void LBM::updateAnimationPhase() {
   wallAnimationPhase = fmod(wallAnimationPhase - 0.1, 2 * M_PI);
 }
 
+void LBM::injectToolInput(const ToolInput& input) {
+  injectedToolInput = input;
+  hasInjectedToolInput = true;
+}
+
+LBM::ToolInput LBM::getToolInput() const {
+  if (hasInjectedToolInput) {
+    return injectedToolInput;
+  }
+  return {appState.isSimulationFocussed && appState.isCursorActive, appState.activeTool, appState.cursorPos, appState.cursorVel,
+          appState.activeSolute, appState.toolSize};
+}
+
 GLuint LBM::getOutputTexture() const {
   return outputFBO->getTexture(0);
   // return nodeIdFBO->getTexture(0);
 }
 
+glm::ivec2 LBM::getOutputSize() const {
+  return glm::ivec2(glm::round(1.f / outputFBO->getTexelSize()));
+}
+
+glm::ivec2 LBM::getLatticeSize() const {
+  return latticeSize;
+}
+
+SolverBackend LBM::getBackend() const {
+  return backend;
+}
+
+uint64_t LBM::getStepCount() const {
+  return stepCount;
+}
+
+std::vector<LBM::StateResource> LBM::getStateResources() const {
+  // Only the buffers read by the next step hold state. Restoring them leaves the write buffers stale, which is safe as
+  // setRestartState makes the next step update every tile, rewriting the write buffers before they are read
+  const size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+  const size_t textureSize = nodeCount * 4 * sizeof(GLfloat);
+  std::vector<StateResource> resources;
+  resources.push_back({"Node IDs", nodeIdFBO->getTexture(0), 0, GL_R32F, nodeCount * sizeof(GLfloat)});
+  if (backend == SolverBackend::FragmentShader) {
+    for (unsigned int i = 0; i < 4; i++) {
+      resources.push_back({"Fluid data " + std::to_string(i), fluid.fbo.getTexture(i), 0, GL_RGBA32F, textureSize});
+    }
+    for (unsigned int i = 0; i < solutes.size(); i++) {
+      for (unsigned int j = 0; j < 3; j++) {
+        resources.push_back({"Solute " + std::to_string(i + 1) + " data " + std::to_string(j), solutes[i].fbo.getTexture(j), 0,
+                             GL_RGBA32F, textureSize});
+      }
+    }
+    return resources;
+  }
+
+  // The compute backends mirror the macroscopic quantities into textures, the concentration source couples the next step
+  resources.push_back({"Fluid populations", 0, fluid.populations->getReadBuffer(), 0, static_cast<size_t>(fluid.populations->getSize())});
+  for (unsigned int i = 0; i < 2; i++) {
+    resources.push_back({"Fluid data " + std::to_string(i), fluid.fbo.getTexture(i), 0, GL_RGBA32F, textureSize});
+  }
+  for (unsigned int i = 0; i < solutes.size(); i++) {
+    std::string name = "Solute " + std::to_string(i + 1);
+    resources.push_back({name + " populations", 0, solutes[i].populations->getReadBuffer(), 0,
+                         static_cast<size_t>(solutes[i].populations->getSize())});
+    resources.push_back({name + " data", solutes[i].fbo.getTexture(0), 0, GL_RGBA32F, textureSize});
+  }
+  return resources;
+}
+
+std::vector<LBM::PopulationLayout> LBM::getPopulationLayouts() const {
+  // Resource indices follow the order of getStateResources()
+  const size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+  std::vector<PopulationLayout> layouts;
+  if (backend == SolverBackend::FragmentShader) {
+    // Fluid populations follow the density in the RGBA texels of fluid data 1 to 3, solute populations follow the
+    // concentration and its source in solute data 0 to 2
+    PopulationLayout fluidLayout = {"Fluid distribution", {}};
+    for (unsigned int q = 0; q < 9; q++) {
+      fluidLayout.slots[q] = {2 + (q + 1) / 4, (q + 1) % 4, 4};
+    }
+    layouts.push_back(fluidLayout);
+    for (unsigned int i = 0; i < solutes.size(); i++) {
+      PopulationLayout soluteLayout = {"Solute " + std::to_string(i + 1) + " distribution", {}};
+      for (unsigned int q = 0; q < 9; q++) {
+        soluteLayout.slots[q] = {5 + 3 * i + (q + 2) / 4, (q + 2) % 4, 4};
+      }
+      layouts.push_back(soluteLayout);
+    }
+    return layouts;
+  }
+
+  // The compute backends store each population as a plane of the storage buffer
+  PopulationLayout fluidLayout = {"Fluid distribution", {}};
+  for (unsigned int q = 0; q < 9; q++) {
+    fluidLayout.slots[q] = {1, q * nodeCount, 1};
+  }
+  layouts.push_back(fluidLayout);
+  for (unsigned int i = 0; i < solutes.size(); i++) {
+    PopulationLayout soluteLayout = {"Solute " + std::to_string(i + 1) + " distribution", {}};
+    for (unsigned int q = 0; q < 9; q++) {
+      soluteLayout.slots[q] = {4 + 2 * i, q * nodeCount, 1};
+    }
+    layouts.push_back(soluteLayout);
+  }
+  return layouts;
+}
+
+LBM::RestartState LBM::getRestartState() const {
+  return {stepCount, bodyForce, wallAnimationPhase, areSolutesEnabled, isOddInPlaceStep};
+}
+
+void LBM::setRestartState(const RestartState& state) {
+  stepCount = state.stepCount;
+  bodyForce = state.bodyForce;
+  wallAnimationPhase = state.wallAnimationPhase;
+  areSolutesEnabled = state.areSolutesEnabled;
+  isOddInPlaceStep = state.isOddInPlaceStep;
+
+  // The node IDs and populations were replaced, so the derived wall state and active tiles have to follow
+  hasVerticalWalls = appState.hasVerticalWalls;
+  hasHorizontalWalls = appState.hasHorizontalWalls;
+  isWallStencilDirty = true;
+  areAllTilesStale = true;
+}
+
+std::vector<glm::vec2> LBM::getFluidVelocity() const {
+  std::vector<glm::vec2> velocities;
+  for (const glm::vec4& texel : readTexture(fluid.fbo.getTexture(0))) {
+    velocities.push_back({texel.x, texel.y});
+  }
+  return velocities;
+}
+
+std::vector<GLfloat> LBM::getFluidDensity() const {
+  // Densities are stored as deviations from the rest density
+  std::vector<GLfloat> densities;
+  for (const glm::vec4& texel : readTexture(fluid.fbo.getTexture(1))) {
+    densities.push_back(INIT_FLUID_DENSITY + texel.x);
+  }
+  return densities;
+}
+
+std::vector<GLfloat> LBM::getSoluteConcentration(unsigned int soluteID) const {
+  std::vector<GLfloat> concentrations;
+  for (const glm::vec4& texel : readTexture(solutes[soluteID].fbo.getTexture(0))) {
+    concentrations.push_back(INIT_SOLUTE_CONCENTRATION + texel.x);
+  }
+  return concentrations;
+}
+
+void LBM::updateChangeMap(ChangeMap& changeMap) const {
+  std::vector<GLuint> fluidData = {fluid.fbo.getTexture(0), fluid.fbo.getTexture(1)};
+  std::vector<GLuint> soluteData;
+  for (int i = 0; i < solutes.size(); i++) {
+    soluteData.push_back(solutes[i].fbo.getTexture(0));
+  }
+  glBindVertexArray(vertexArray);
+
+  // Reduce the change of the macroscopic fields into the change pyramid
+  changeMap.pyramid.levels[0]->bind();
+  changeDetectShader->use();
+  changeDetectShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  changeDetectShader->setTextureUniform("uFluidData", fluidData);
+  changeDetectShader->setTextureUniform("uSoluteData", soluteData);
+  changeDetectShader->setTextureUniform("uReference", {changeMap.reference->getTexture(0), changeMap.reference->getTexture(1)});
+  changeDetectShader->setUniform("uReductionFactor", static_cast<GLint>(MaxPyramid::REDUCTION_FACTOR));
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  reduceMaxPyramid(changeMap.pyramid);
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+  Framebuffer::unbind();
+}
+
+void LBM::updateChangeReference(ChangeMap& changeMap) const {
+  std::vector<GLuint> soluteData;
+  for (int i = 0; i < solutes.size(); i++) {
+    soluteData.push_back(solutes[i].fbo.getTexture(0));
+  }
+
+  // Draw one instanced quad per tile, the vertex shader collapses the tiles that are not selected
+  changeMap.reference->bind();
+  changeReferenceShader->use();
+  changeReferenceShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  changeReferenceShader->setTextureUniform("uFluidData", {fluid.fbo.getTexture(0), fluid.fbo.getTexture(1)});
+  changeReferenceShader->setTextureUniform("uSoluteData", soluteData);
+  changeReferenceShader->setTextureUniform("uActiveTiles", changeMap.selectedTiles->getTexture(0));
+  changeReferenceShader->setUniform("uTileCount", changeMap.pyramid.tileCount);
+  changeReferenceShader->setUniform("uTileUVSize", changeMap.pyramid.tileUVSize);
+  glBindVertexArray(tileVertexArray);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, changeMap.pyramid.tileCount.x * changeMap.pyramid.tileCount.y);
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+  Framebuffer::unbind();
+}
+
+void LBM::sampleFields(Framebuffer& fields, const glm::ivec2& origin, GLint stride) const {
+  std::vector<GLuint> soluteData;
+  for (int i = 0; i < solutes.size(); i++) {
+    soluteData.push_back(solutes[i].fbo.getTexture(0));
+  }
+
+  // Every texel of the field framebuffer samples one node of the region
+  fields.bind();
+  fieldSampleShader->use();
+  fieldSampleShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  fieldSampleShader->setTextureUniform("uFluidData", {fluid.fbo.getTexture(0), fluid.fbo.getTexture(1)});
+  fieldSampleShader->setTextureUniform("uSoluteData", soluteData);
+  fieldSampleShader->setUniform("uOrigin", origin);
+  fieldSampleShader->setUniform("uStride", stride);
+  fieldSampleShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
+  fieldSampleShader->setUniform("uInitConcentration", INIT_SOLUTE_CONCENTRATION);
+  glBindVertexArray(vertexArray);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+  Framebuffer::unbind();
+}
+
+void LBM::gatherTile(const StateResource& resource, const glm::ivec4& rect, GLuint packedBuffer, size_t packedOffset) const {
+  // One invocation per node and plane of the tile, the caller synchronises the packed buffer with its readers
+  const size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+  const GLuint planeCount = static_cast<GLuint>(resource.size / (nodeCount * sizeof(GLfloat)));
+  tileGatherComputeShader->use();
+  tileGatherComputeShader->setStorageBuffer("Source", resource.buffer);
+  tileGatherComputeShader->setStorageBuffer("Packed", packedBuffer);
+  tileGatherComputeShader->setUniform("uLatticeSize", latticeSize);
+  tileGatherComputeShader->setUniform("uTileOrigin", glm::ivec2(rect.x, rect.y));
+  tileGatherComputeShader->setUniform("uTileSize", glm::ivec2(rect.z, rect.w));
+  tileGatherComputeShader->setUniform("uPackedOffset", static_cast<GLint>(packedOffset / sizeof(GLfloat)));
+  glDispatchCompute((rect.z + TILE_WORK_GROUP_SIZE_X - 1) / TILE_WORK_GROUP_SIZE_X,
+                    (rect.w + TILE_WORK_GROUP_SIZE_Y - 1) / TILE_WORK_GROUP_SIZE_Y, planeCount);
+  glUseProgram(0);
+}
+
 void LBM::resize() {
   outputFBO->resize(appState.viewportSize);
+  updatePassCosts();
 }
 
-void LBM::initFluid() {
+void LBM::initFluid(bool isChangedOnly) {
+  if (backend != SolverBackend::FragmentShader) {
+    fluidInitComputeShader->use();
+    fluidInitComputeShader->setStorageBuffer("Populations", fluid.populations->getReadBuffer());
+    fluidInitComputeShader->setStorageBuffer("UpdatedPopulations", fluid.populations->getWriteBuffer());
+    fluidInitComputeShader->setImageUniform("uUpdatedFluidData", {fluid.fbo.getWriteTexture(0), fluid.fbo.getWriteTexture(1)}, GL_READ_WRITE);
+    fluidInitComputeShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+    fluidInitComputeShader->setTextureUniform("uPreviousNodeIds", nodeIdFBO->getWriteTexture(0));
+    fluidInitComputeShader->setUniform("uIsChangedOnly", isChangedOnly);
+    fluidInitComputeShader->setUniform("uLatticeSize", latticeSize);
+    fluidInitComputeShader->setUniform("uIsLayoutSwapped", isOddInPlaceStep);
+    fluidInitComputeShader->setUniform("uInitVelocity", INIT_FLUID_VELOCITY);
+    fluidInitComputeShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
+    dispatchCompute(FLUID_WORK_GROUP_SIZE_X, FLUID_WORK_GROUP_SIZE_Y);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    glUseProgram(0);
+    fluid.populations->swap();
+    fluid.fbo.swap();
+    return;
+  }
+
   fluid.fbo.bind();
   fluidInitShader->use();
   fluidInitShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  fluidInitShader->setTextureUniform("uPreviousNodeIds", nodeIdFBO->getWriteTexture(0));
+  fluidInitShader->setUniform("uIsChangedOnly", isChangedOnly);
   fluidInitShader->setTextureUniform("uFluidData", fluid.fbo.getTextures());
   fluidInitShader->setUniform("uInitVelocity", INIT_FLUID_VELOCITY);
   fluidInitShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
@@ -176,30 +668,65 @@ void LBM::initFluid() {
   glUseProgram(0);
   fluid.fbo.unbind();
   fluid.fbo.swap();
+  isWallStencilDirty = true;
 }
 
-void LBM::initSolute(unsigned int soluteID, glm::vec2 center, GLfloat radius) {
+void LBM::initSolute(unsigned int soluteID, bool isChangedOnly) {
+  if (backend != SolverBackend::FragmentShader) {
+    soluteInitComputeShader->use();
+    soluteInitComputeShader->setStorageBuffer("Populations", solutes[soluteID].populations->getReadBuffer());
+    soluteInitComputeShader->setStorageBuffer("UpdatedPopulations", solutes[soluteID].populations->getWriteBuffer());
+    soluteInitComputeShader->setImageUniform("uUpdatedSoluteData", solutes[soluteID].fbo.getWriteTexture(0), GL_READ_WRITE);
+    soluteInitComputeShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+    soluteInitComputeShader->setTextureUniform("uPreviousNodeIds", nodeIdFBO->getWriteTexture(0));
+    soluteInitComputeShader->setUniform("uIsChangedOnly", isChangedOnly);
+    soluteInitComputeShader->setTextureUniform("uFluidData", fluid.fbo.getTextures());
+    soluteInitComputeShader->setUniform("uLatticeSize", latticeSize);
+    soluteInitComputeShader->setUniform("uIsLayoutSwapped", isOddInPlaceStep);
+    soluteInitComputeShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
+    soluteInitComputeShader->setUniform("uTau", solutes[soluteID].tau);
+    dispatchCompute(FLUID_WORK_GROUP_SIZE_X, FLUID_WORK_GROUP_SIZE_Y);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    glUseProgram(0);
+    solutes[soluteID].populations->swap();
+    solutes[soluteID].fbo.swap();
+    return;
+  }
+
+  // Only the read buffers hold the new state, so tiles skipped by the next step would keep stale write buffers.
+  // A pending full refresh is kept, only the occupancy update clears it
+  if (!isChangedOnly) {
+    areAllTilesStale = true;
+  }
+
   solutes[soluteID].fbo.bind();
   soluteInitShader->use();
   soluteInitShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  soluteInitShader->setTextureUniform("uPreviousNodeIds", nodeIdFBO->getWriteTexture(0));
+  soluteInitShader->setUniform("uIsChangedOnly", isChangedOnly);
   soluteInitShader->setTextureUniform("uFluidData", fluid.fbo.getTextures());
   soluteInitShader->setTextureUniform("uSoluteData", solutes[soluteID].fbo.getTextures());
-  soluteInitShader->setUniform("uCenter", center);
-  soluteInitShader->setUniform("uAspect", appState.aspectRatio);
   soluteInitShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
   soluteInitShader->setUniform("uTau", solutes[soluteID].tau);
-  soluteInitShader->setUniform("uRadius", radius);
   glBindVertexArray(vertexArray);
   glDrawArrays(GL_TRIANGLES, 0, 3);
   glBindVertexArray(0);
   glUseProgram(0);
   solutes[soluteID].fbo.unbind();
   solutes[soluteID].fbo.swap();
+  isWallStencilDirty = true;
 }
 
 void LBM::updateNodeIDs() {
-  bool isAddingWalls = appState.isSimulationFocussed && appState.isCursorActive && (appState.activeTool == ToolType::AddWall);
-  bool isRemovingWalls = appState.isSimulationFocussed && appState.isCursorActive && (appState.activeTool == ToolType::RemoveWall);
+  bool isAddingWalls = toolInput.isActive && toolInput.tool == ToolType::AddWall;
+  bool isRemovingWalls = toolInput.isActive && toolInput.tool == ToolType::RemoveWall;
+
+  // Track whether this update can change the node IDs
+  if (isAddingWalls || isRemovingWalls || hasVerticalWalls != appState.hasVerticalWalls || hasHorizontalWalls != appState.hasHorizontalWalls) {
+    isWallStencilDirty = true;
+  }
+  hasVerticalWalls = appState.hasVerticalWalls;
+  hasHorizontalWalls = appState.hasHorizontalWalls;
 
   nodeIdFBO->bind();
   nodeIDShader->use();
@@ -208,8 +735,8 @@ void LBM::updateNodeIDs() {
   nodeIDShader->setUniform("uIsRemovingWalls", isRemovingWalls);
   nodeIDShader->setUniform("uHasVerticalWalls", appState.hasVerticalWalls);
   nodeIDShader->setUniform("uHasHorizontalWalls", appState.hasHorizontalWalls);
-  nodeIDShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * appState.toolSize);
-  nodeIDShader->setUniform("uCursorPos", appState.cursorPos);
+  nodeIDShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
+  nodeIDShader->setUniform("uCursorPos", toolInput.position);
   nodeIDShader->setUniform("uAspect", appState.aspectRatio);
   nodeIDShader->setUniform("uTexelSize", nodeIdFBO->getTexelSize());
   glBindVertexArray(vertexArray);
@@ -220,18 +747,75 @@ void LBM::updateNodeIDs() {
   nodeIdFBO->swap();
 }
 
+void LBM::updateWallStencil() {
+  // Mirror the node IDs into the stencil buffer, the colour attachments are left untouched
+  fluid.fbo.bind();
+  glClearStencil(0);
+  glClear(GL_STENCIL_BUFFER_BIT);
+  glEnable(GL_STENCIL_TEST);
+  glStencilFunc(GL_ALWAYS, 1, 0xFF);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  wallStencilShader->use();
+  wallStencilShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  glBindVertexArray(vertexArray);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  glUseProgram(0);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glDisable(GL_STENCIL_TEST);
+  fluid.fbo.unbind();
+
+  // Culled wall nodes keep whatever they hold, so settle them at rest in both buffers
+  resetWalls(fluid.fbo, INIT_FLUID_DENSITY);
+  for (int i = 0; i < solutes.size(); i++) {
+    resetWalls(solutes[i].fbo, 0.f);
+  }
+  isWallStencilDirty = false;
+}
+
+void LBM::resetWalls(ReadWriteFramebuffer& fbo, GLfloat restDensity) {
+  glEnable(GL_STENCIL_TEST);
+  glStencilFunc(GL_EQUAL, 1, 0xFF);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+  wallResetShader->use();
+  wallResetShader->setUniform("uRestDensity", restDensity);
+  glBindVertexArray(vertexArray);
+  for (int i = 0; i < 2; i++) {
+    fbo.bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    fbo.unbind();
+    fbo.swap();
+  }
+  glBindVertexArray(0);
+  glUseProgram(0);
+  glDisable(GL_STENCIL_TEST);
+}
+
+void LBM::setWallCulling(bool isEnabled) const {
+  // Wall fragments fail the stencil test before they are shaded
+  if (isEnabled) {
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+  } else {
+    glDisable(GL_STENCIL_TEST);
+  }
+}
+
 void LBM::updateFluid() {
-  bool isApplyingForce = appState.isSimulationFocussed && appState.isCursorActive && (appState.activeTool == ToolType::Force);
+  bool isApplyingForce = toolInput.isActive && toolInput.tool == ToolType::Force;
 
   // Perform TRT collision
   fluid.fbo.bind();
   fluidCollisionShader->use();
   fluidCollisionShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
   fluidCollisionShader->setTextureUniform("uFluidData", fluid.fbo.getTextures());
-  fluidCollisionShader->setUniform("uCursorPos", appState.cursorPos);
-  fluidCollisionShader->setUniform("uCursorVel", appState.cursorVel);
+  fluidCollisionShader->setUniform("uCursorPos", toolInput.position);
+  fluidCollisionShader->setUniform("uCursorVel", toolInput.velocity);
+  fluidCollisionShader->setUniform("uBodyForce", bodyForce);
   fluidCollisionShader->setUniform("uAspect", appState.aspectRatio);
-  fluidCollisionShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * appState.toolSize);
+  fluidCollisionShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
   fluidCollisionShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
   fluidCollisionShader->setUniform("uPlusOmega", fluid.plusOmega);
   fluidCollisionShader->setUniform("uMinusOmega", fluid.minusOmega);
@@ -259,11 +843,72 @@ void LBM::updateFluid() {
   fluid.fbo.swap();
 }
 
-void LBM::updateSolute(unsigned int soluteID) {
-  bool isSoluteSelected = appState.activeSolute == soluteID;
-  bool isAddingConcentration = appState.isSimulationFocussed && appState.isCursorActive && isSoluteSelected && (appState.activeTool == ToolType::AddSolute);
-  bool isRemovingConcentration = appState.isSimulationFocussed && appState.isCursorActive && isSoluteSelected && (appState.activeTool == ToolType::RemoveSolute);
-  GLfloat concentrationSourcePolarity = (isAddingConcentration ? 1.f : 0.f) - (isRemovingConcentration ? 1.f : 0.f);
+void LBM::updateOccupancy() {
+  // Culled tiles keep whatever their buffers hold, which is only valid while both buffers were last written by a step
+  if (areAllTilesStale) {
+    occupancy.activeTiles->clear(1.0, 1.0, 1.0, 1.0);
+    areAllTilesStale = false;
+    return;
+  }
+
+  bool isAddingSolute = toolInput.isActive && toolInput.tool == ToolType::AddSolute;
+  std::vector<GLuint> soluteData;
+  for (int i = 0; i < solutes.size(); i++) {
+    soluteData.push_back(solutes[i].fbo.getTexture(0));
+  }
+  glBindVertexArray(vertexArray);
+
+  // Reduce the solute fields into the occupancy pyramid
+  occupancy.pyramid.levels[0]->bind();
+  soluteOccupancyShader->use();
+  soluteOccupancyShader->setTextureUniform("uSoluteData", soluteData);
+  soluteOccupancyShader->setUniform("uReductionFactor", static_cast<GLint>(MaxPyramid::REDUCTION_FACTOR));
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  reduceMaxPyramid(occupancy.pyramid);
+
+  // Dilate the coarsest level into the active tile map
+  occupancy.activeTiles->bind();
+  occupancyDilationShader->use();
+  occupancyDilationShader->setTextureUniform("uOccupancy", occupancy.pyramid.levels.back()->getTexture(0));
+  occupancyDilationShader->setUniform("uTileUVSize", occupancy.pyramid.tileUVSize);
+  occupancyDilationShader->setUniform("uCursorPos", toolInput.position);
+  occupancyDilationShader->setUniform("uAspect", appState.aspectRatio);
+  occupancyDilationShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
+  occupancyDilationShader->setUniform("uIsAddingSolute", isAddingSolute);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+  Framebuffer::unbind();
+}
+
+void LBM::reduceMaxPyramid(MaxPyramid& pyramid) const {
+  // Each level takes the maximum over the texels of the level below, starting from the first level the owner wrote
+  for (size_t i = 1; i < pyramid.levels.size(); i++) {
+    pyramid.levels[i]->bind();
+    occupancyReductionShader->use();
+    occupancyReductionShader->setTextureUniform("uOccupancy", pyramid.levels[i - 1]->getTexture(0));
+    occupancyReductionShader->setUniform("uReductionFactor", static_cast<GLint>(MaxPyramid::REDUCTION_FACTOR));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+}
+
+void LBM::drawActiveTiles(ShaderProgram& shader) {
+  // Draw one instanced quad per tile, the vertex shader collapses inactive tiles
+  shader.setTextureUniform("uActiveTiles", occupancy.activeTiles->getTexture(0));
+  shader.setUniform("uTileCount", occupancy.pyramid.tileCount);
+  shader.setUniform("uTileUVSize", occupancy.pyramid.tileUVSize);
+  glBindVertexArray(tileVertexArray);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, occupancy.pyramid.tileCount.x * occupancy.pyramid.tileCount.y);
+  glBindVertexArray(0);
+}
+
+void LBM::collideSolute(unsigned int soluteID) {
+  GLfloat concentrationSourcePolarity = getConcentrationSourcePolarity(soluteID);
+  std::vector<GLuint> concentrationData;
+  for (int i = 0; i < solutes.size(); i++) {
+    concentrationData.push_back(solutes[i].fbo.getTexture(0));
+  }
 
   // Perform TRT collision
   solutes[soluteID].fbo.bind();
@@ -271,10 +916,10 @@ void LBM::updateSolute(unsigned int soluteID) {
   soluteCollisionShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
   soluteCollisionShader->setTextureUniform("uFluidData", fluid.fbo.getTextures());
   soluteCollisionShader->setTextureUniform("uSoluteData", solutes[soluteID].fbo.getTextures());
-  soluteCollisionShader->setTextureUniform("uNodalReactionRate", reaction.fbo.getTexture(0));
-  soluteCollisionShader->setUniform("uCursorPos", appState.cursorPos);
+  soluteCollisionShader->setTextureUniform("uConcentrationData", concentrationData);
+  soluteCollisionShader->setUniform("uCursorPos", toolInput.position);
   soluteCollisionShader->setUniform("uAspect", appState.aspectRatio);
-  soluteCollisionShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * appState.toolSize);
+  soluteCollisionShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
   soluteCollisionShader->setUniform("uConcentrationSourcePolarity", concentrationSourcePolarity);
   soluteCollisionShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
   soluteCollisionShader->setUniform("uInitConcentration", INIT_SOLUTE_CONCENTRATION);
@@ -282,13 +927,15 @@ void LBM::updateSolute(unsigned int soluteID) {
   soluteCollisionShader->setUniform("uMinusOmega", solutes[soluteID].minusOmega);
   soluteCollisionShader->setUniform("uOneMinusInvTwoTau", solutes[soluteID].oneMinusInvTwoTau);
   soluteCollisionShader->setUniform("uMolMassTimesCoeff", reaction.molMassTimesCoeffs[soluteID]);
-  glBindVertexArray(vertexArray);
-  glDrawArrays(GL_TRIANGLES, 0, 3);
-  glBindVertexArray(0);
+  soluteCollisionShader->setUniform("uReactionRate", getReactionRate());
+  soluteCollisionShader->setUniform("uStoichiometricCoeffs", reaction.stoichiometricCoeffs);
+  drawActiveTiles(*soluteCollisionShader);
   glUseProgram(0);
   solutes[soluteID].fbo.unbind();
   solutes[soluteID].fbo.swap();
+}
 
+void LBM::streamSolute(unsigned int soluteID) {
   // Perform streaming
   solutes[soluteID].fbo.bind();
   soluteStreamingShader->use();
@@ -296,35 +943,189 @@ void LBM::updateSolute(unsigned int soluteID) {
   soluteStreamingShader->setTextureUniform("uSoluteData", solutes[soluteID].fbo.getTextures());
   soluteStreamingShader->setUniform("uTexelSize", solutes[soluteID].fbo.getTexelSize());
   soluteStreamingShader->setUniform("uInitConcentration", INIT_SOLUTE_CONCENTRATION);
-  glBindVertexArray(vertexArray);
-  glDrawArrays(GL_TRIANGLES, 0, 3);
-  glBindVertexArray(0);
+  drawActiveTiles(*soluteStreamingShader);
   glUseProgram(0);
   solutes[soluteID].fbo.unbind();
   solutes[soluteID].fbo.swap();
 }
 
-void LBM::react() {
-  reaction.fbo.bind();
-  reactionShader->use();
-  reactionShader->setTextureUniform("uNodalReactionRate", reaction.fbo.getTexture(0));
-  reactionShader->setTextureUniform("uSolute0Data", solutes[0].fbo.getTexture(0));
-  reactionShader->setTextureUniform("uSolute1Data", solutes[1].fbo.getTexture(0));
-  reactionShader->setTextureUniform("uSolute2Data", solutes[2].fbo.getTexture(0));
-  reactionShader->setUniform("uReactionRate", appState.isReactionEnabled ? reaction.reactionRate : 0.f);
-  reactionShader->setUniform("uStoichiometricCoeff0", reaction.stoichiometricCoeffs[0]);
-  reactionShader->setUniform("uStoichiometricCoeff1", reaction.stoichiometricCoeffs[1]);
-  reactionShader->setUniform("uStoichiometricCoeff2", reaction.stoichiometricCoeffs[2]);
-  glBindVertexArray(vertexArray);
-  glDrawArrays(GL_TRIANGLES, 0, 3);
-  glBindVertexArray(0);
+void LBM::updateFluidCompute() {
+  bool isApplyingForce = toolInput.isActive && toolInput.tool == ToolType::Force;
+
+  // Perform fused streaming and TRT collision
+  fluidUpdateComputeShader->use();
+  fluidUpdateComputeShader->setStorageBuffer("Populations", fluid.populations->getReadBuffer());
+  fluidUpdateComputeShader->setStorageBuffer("UpdatedPopulations", fluid.populations->getWriteBuffer());
+  fluidUpdateComputeShader->setImageUniform("uUpdatedFluidData", {fluid.fbo.getWriteTexture(0), fluid.fbo.getWriteTexture(1)}, GL_WRITE_ONLY);
+  fluidUpdateComputeShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  fluidUpdateComputeShader->setUniform("uLatticeSize", latticeSize);
+  fluidUpdateComputeShader->setUniform("uCursorPos", toolInput.position);
+  fluidUpdateComputeShader->setUniform("uCursorVel", toolInput.velocity);
+  fluidUpdateComputeShader->setUniform("uBodyForce", bodyForce);
+  fluidUpdateComputeShader->setUniform("uAspect", appState.aspectRatio);
+  fluidUpdateComputeShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
+  fluidUpdateComputeShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
+  fluidUpdateComputeShader->setUniform("uSpeedOfSound", SPEED_OF_SOUND);
+  fluidUpdateComputeShader->setUniform("uPlusOmega", fluid.plusOmega);
+  fluidUpdateComputeShader->setUniform("uMinusOmega", fluid.minusOmega);
+  fluidUpdateComputeShader->setUniform("uIsApplyingForce", isApplyingForce);
+  dispatchCompute(FLUID_WORK_GROUP_SIZE_X, FLUID_WORK_GROUP_SIZE_Y);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
   glUseProgram(0);
-  reaction.fbo.unbind();
-  reaction.fbo.swap();
+  fluid.populations->swap();
+  fluid.fbo.swap();
+}
+
+void LBM::updateSolutesCompute() {
+  // Gather per-solute resources and parameters for the fused multi-solute pass
+  std::vector<GLuint> populations, updatedPopulations, updatedSoluteData;
+  std::vector<GLfloat> concentrationSourcePolarities, plusOmegas, minusOmegas, oneMinusInvTwoTaus;
+  for (int i = 0; i < solutes.size(); i++) {
+    populations.push_back(solutes[i].populations->getReadBuffer());
+    updatedPopulations.push_back(solutes[i].populations->getWriteBuffer());
+    updatedSoluteData.push_back(solutes[i].fbo.getWriteTexture(0));
+    concentrationSourcePolarities.push_back(getConcentrationSourcePolarity(i));
+    plusOmegas.push_back(solutes[i].plusOmega);
+    minusOmegas.push_back(solutes[i].minusOmega);
+    oneMinusInvTwoTaus.push_back(solutes[i].oneMinusInvTwoTau);
+  }
+
+  // Perform fused streaming and TRT collision for all solutes
+  soluteUpdateComputeShader->use();
+  soluteUpdateComputeShader->setStorageBuffer("SolutePopulations", populations);
+  soluteUpdateComputeShader->setStorageBuffer("UpdatedSolutePopulations", updatedPopulations);
+  soluteUpdateComputeShader->setImageUniform("uUpdatedSoluteData", updatedSoluteData, GL_WRITE_ONLY);
+  soluteUpdateComputeShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  soluteUpdateComputeShader->setTextureUniform("uFluidData", fluid.fbo.getTextures());
+  soluteUpdateComputeShader->setUniform("uLatticeSize", latticeSize);
+  soluteUpdateComputeShader->setUniform("uCursorPos", toolInput.position);
+  soluteUpdateComputeShader->setUniform("uAspect", appState.aspectRatio);
+  soluteUpdateComputeShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
+  soluteUpdateComputeShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
+  soluteUpdateComputeShader->setUniform("uInitConcentration", INIT_SOLUTE_CONCENTRATION);
+  soluteUpdateComputeShader->setUniform("uConcentrationSourcePolarity", concentrationSourcePolarities);
+  soluteUpdateComputeShader->setUniform("uPlusOmega", plusOmegas);
+  soluteUpdateComputeShader->setUniform("uMinusOmega", minusOmegas);
+  soluteUpdateComputeShader->setUniform("uOneMinusInvTwoTau", oneMinusInvTwoTaus);
+  soluteUpdateComputeShader->setUniform("uMolMassTimesCoeff", reaction.molMassTimesCoeffs);
+  soluteUpdateComputeShader->setUniform("uReactionRate", getReactionRate());
+  soluteUpdateComputeShader->setUniform("uStoichiometricCoeffs", reaction.stoichiometricCoeffs);
+  dispatchCompute(SOLUTE_WORK_GROUP_SIZE_X, SOLUTE_WORK_GROUP_SIZE_Y);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+  glUseProgram(0);
+  for (int i = 0; i < solutes.size(); i++) {
+    solutes[i].populations->swap();
+    solutes[i].fbo.swap();
+  }
+}
+
+void LBM::updateFluidInPlace() {
+  bool isApplyingForce = toolInput.isActive && toolInput.tool == ToolType::Force;
+
+  // Perform fused streaming and TRT collision in place
+  fluidInPlaceUpdateComputeShader->use();
+  fluidInPlaceUpdateComputeShader->setStorageBuffer("Populations", fluid.populations->getReadBuffer());
+  fluidInPlaceUpdateComputeShader->setImageUniform("uUpdatedFluidData", {fluid.fbo.getWriteTexture(0), fluid.fbo.getWriteTexture(1)}, GL_WRITE_ONLY);
+  fluidInPlaceUpdateComputeShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  fluidInPlaceUpdateComputeShader->setUniform("uLatticeSize", latticeSize);
+  fluidInPlaceUpdateComputeShader->setUniform("uCursorPos", toolInput.position);
+  fluidInPlaceUpdateComputeShader->setUniform("uCursorVel", toolInput.velocity);
+  fluidInPlaceUpdateComputeShader->setUniform("uBodyForce", bodyForce);
+  fluidInPlaceUpdateComputeShader->setUniform("uAspect", appState.aspectRatio);
+  fluidInPlaceUpdateComputeShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
+  fluidInPlaceUpdateComputeShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
+  fluidInPlaceUpdateComputeShader->setUniform("uSpeedOfSound", SPEED_OF_SOUND);
+  fluidInPlaceUpdateComputeShader->setUniform("uPlusOmega", fluid.plusOmega);
+  fluidInPlaceUpdateComputeShader->setUniform("uMinusOmega", fluid.minusOmega);
+  fluidInPlaceUpdateComputeShader->setUniform("uIsApplyingForce", isApplyingForce);
+  fluidInPlaceUpdateComputeShader->setUniform("uIsOddStep", isOddInPlaceStep);
+  dispatchCompute(FLUID_WORK_GROUP_SIZE_X, FLUID_WORK_GROUP_SIZE_Y);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+  glUseProgram(0);
+}
+
+void LBM::updateSolutesInPlace() {
+  // Gather per-solute resources and parameters for the fused multi-solute pass
+  std::vector<GLuint> populations, updatedSoluteData;
+  std::vector<GLfloat> concentrationSourcePolarities, plusOmegas, minusOmegas, oneMinusInvTwoTaus;
+  for (int i = 0; i < solutes.size(); i++) {
+    populations.push_back(solutes[i].populations->getReadBuffer());
+    updatedSoluteData.push_back(solutes[i].fbo.getWriteTexture(0));
+    concentrationSourcePolarities.push_back(getConcentrationSourcePolarity(i));
+    plusOmegas.push_back(solutes[i].plusOmega);
+    minusOmegas.push_back(solutes[i].minusOmega);
+    oneMinusInvTwoTaus.push_back(solutes[i].oneMinusInvTwoTau);
+  }
+
+  // Perform fused streaming and TRT collision for all solutes in place
+  soluteInPlaceUpdateComputeShader->use();
+  soluteInPlaceUpdateComputeShader->setStorageBuffer("SolutePopulations", populations);
+  soluteInPlaceUpdateComputeShader->setImageUniform("uUpdatedSoluteData", updatedSoluteData, GL_WRITE_ONLY);
+  soluteInPlaceUpdateComputeShader->setTextureUniform("uNodeIds", nodeIdFBO->getTexture(0));
+  soluteInPlaceUpdateComputeShader->setTextureUniform("uFluidData", fluid.fbo.getTextures());
+  soluteInPlaceUpdateComputeShader->setUniform("uLatticeSize", latticeSize);
+  soluteInPlaceUpdateComputeShader->setUniform("uCursorPos", toolInput.position);
+  soluteInPlaceUpdateComputeShader->setUniform("uAspect", appState.aspectRatio);
+  soluteInPlaceUpdateComputeShader->setUniform("uToolSize", TOOL_SIZE_MULTIPLIER * toolInput.size);
+  soluteInPlaceUpdateComputeShader->setUniform("uInitDensity", INIT_FLUID_DENSITY);
+  soluteInPlaceUpdateComputeShader->setUniform("uInitConcentration", INIT_SOLUTE_CONCENTRATION);
+  soluteInPlaceUpdateComputeShader->setUniform("uConcentrationSourcePolarity", concentrationSourcePolarities);
+  soluteInPlaceUpdateComputeShader->setUniform("uPlusOmega", plusOmegas);
+  soluteInPlaceUpdateComputeShader->setUniform("uMinusOmega", minusOmegas);
+  soluteInPlaceUpdateComputeShader->setUniform("uOneMinusInvTwoTau", oneMinusInvTwoTaus);
+  soluteInPlaceUpdateComputeShader->setUniform("uMolMassTimesCoeff", reaction.molMassTimesCoeffs);
+  soluteInPlaceUpdateComputeShader->setUniform("uReactionRate", getReactionRate());
+  soluteInPlaceUpdateComputeShader->setUniform("uStoichiometricCoeffs", reaction.stoichiometricCoeffs);
+  soluteInPlaceUpdateComputeShader->setUniform("uIsOddStep", isOddInPlaceStep);
+  dispatchCompute(SOLUTE_WORK_GROUP_SIZE_X, SOLUTE_WORK_GROUP_SIZE_Y);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+  glUseProgram(0);
+}
+
+void LBM::dispatchCompute(unsigned int workGroupSizeX, unsigned int workGroupSizeY) const {
+  // Cover the whole lattice, partial work groups are masked in the shaders
+  glDispatchCompute((latticeSize.x + workGroupSizeX - 1) / workGroupSizeX,
+                    (latticeSize.y + workGroupSizeY - 1) / workGroupSizeY, 1);
+}
+
+GLfloat LBM::getConcentrationSourcePolarity(unsigned int soluteID) const {
+  bool isSoluteSelected = toolInput.isActive && toolInput.soluteID == soluteID;
+  bool isAddingConcentration = isSoluteSelected && toolInput.tool == ToolType::AddSolute;
+  bool isRemovingConcentration = isSoluteSelected && toolInput.tool == ToolType::RemoveSolute;
+  return (isAddingConcentration ? 1.f : 0.f) - (isRemovingConcentration ? 1.f : 0.f);
+}
+
+GLfloat LBM::getReactionRate() const {
+  return appState.isReactionEnabled ? reaction.reactionRate : 0.f;
+}
+
+void LBM::uploadTexture(GLuint texture, const std::vector<glm::vec4>& data) const {
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, latticeSize.x, latticeSize.y, GL_RGBA, GL_FLOAT, data.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void LBM::uploadTexture(GLuint texture, const std::vector<GLfloat>& data) const {
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, latticeSize.x, latticeSize.y, GL_RED, GL_FLOAT, data.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+std::vector<glm::vec4> LBM::readTexture(GLuint texture) const {
+  // Image stores of the compute passes must be visible to texture reads
+  if (backend != SolverBackend::FragmentShader) {
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+  }
+  std::vector<glm::vec4> data(static_cast<size_t>(latticeSize.x) * latticeSize.y);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, data.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return data;
 }
 
 void LBM::resetNodeIDs() {
   nodeIdFBO->clear(0.0, 0.0, 0.0, 0.0);
+  isWallStencilDirty = true;
 }
 
 void LBM::resetFluid() {
@@ -334,12 +1135,13 @@ void LBM::resetFluid() {
 
 void LBM::resetSolute(unsigned int soluteID) {
   solutes[soluteID].fbo.clear(0.0, 0.0, 0.0, 0.0);
-  initSolute(soluteID, {0, 0}, 0);
+  initSolute(soluteID);
 }
 
 void LBM::resetAll() {
-  // Reset everything
+  // Reset everything, the initial state is then loaded from a scene
   resetNodeIDs();
+  setBodyForce({0., 0.});
   setViscosity(appState.fluidViscosity);
   setReactionRate(appState.reactionRate);
   resetFluid();
@@ -348,10 +1150,4 @@ void LBM::resetAll() {
     setSoluteColor(i, appState.soluteColors[i]);
     resetSolute(i);
   }
-
-  // Re-initialise everything
-  initFluid();
-  initSolute(0, INIT_SOLUTE_CENTER_0, INIT_SOLUTE_RADIUS_0);
-  initSolute(1, INIT_SOLUTE_CENTER_1, INIT_SOLUTE_RADIUS_1);
-  initSolute(2, INIT_SOLUTE_CENTER_2, INIT_SOLUTE_RADIUS_2);
 }
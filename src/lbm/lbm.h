@@ -3,6 +3,8 @@
 
 #include <array>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm.hpp>
@@ -10,14 +12,63 @@
 #include "core/io.h"
 #include "core/app_state.h"
 #include "gl/framebuffers.h"
+#include "gl/gl_extensions.h"
+#include "gl/gpu_profiler.h"
 #include "gl/shader_program.h"
+#include "lbm/change_map.h"
 #include "lbm/fluid.h"
+#include "lbm/kernel_costs.h"
+#include "lbm/occupancy.h"
 #include "lbm/reaction.h"
+#include "lbm/scene.h"
 #include "lbm/solute.h"
 
 class LBM {
 public:
+  // GPU resource holding part of the simulation state, these are what a checkpoint stores
+  struct StateResource {
+    std::string name;
+    GLuint texture; // 0 for storage buffers
+    GLuint buffer;  // 0 for textures
+    GLenum format;  // Texel format the texture is transferred in (GL_RGBA32F or GL_R32F)
+    size_t size;    // Bytes
+  };
+
+  // Location of one D2Q9 population in the state resources: population q of node n is the float at
+  // offset + n * stride of the resource
+  struct PopulationSlot {
+    unsigned int resource; // Index into getStateResources()
+    size_t offset;         // Floats
+    size_t stride;         // Floats between consecutive nodes
+  };
+
+  // Populations of the fluid or of one solute, which a compact checkpoint encodes relative to their equilibrium
+  struct PopulationLayout {
+    std::string name;
+    std::array<PopulationSlot, 9> slots;
+  };
+
+  // Simulation state not held by the GPU resources or the AppState
+  struct RestartState {
+    uint64_t stepCount;
+    glm::vec2 bodyForce;
+    GLfloat wallAnimationPhase;
+    bool areSolutesEnabled;
+    bool isOddInPlaceStep;
+  };
+
+  // Tool applied to the lattice during a step, in the coordinates of the interactive viewport
+  struct ToolInput {
+    bool isActive;         // Is the tool held down on the simulation area
+    ToolType tool;
+    glm::vec2 position;
+    glm::vec2 velocity;
+    unsigned int soluteID; // Solute the solute tools act on
+    GLfloat size;
+  };
+
   LBM(const unsigned int width, const unsigned int height);
+  ~LBM();
 
   // Disallow copy and assignment to avoid multiple deletions of OpenGL objects
   LBM(const LBM&) = delete;
@@ -25,34 +76,82 @@ public:
 
   void updateSimulation();
   void updateAnimationPhase();
+  // Applies this tool instead of the cursor during the next step, leaving the cursor state of the AppState untouched
+  void injectToolInput(const ToolInput& input);
+  // Tool the next step applies, the injected one if any, the cursor otherwise
+  ToolInput getToolInput() const;
   void setViscosity(GLfloat viscosity);
   void setSoluteDiffusivity(unsigned int soluteID, GLfloat diffusivity);
   void setSoluteColor(unsigned int soluteID, const glm::vec3& color);
   void setReactionRate(GLfloat rate);
+  void setSolutesEnabled(bool isEnabled);
+  void setBodyForce(const glm::vec2& force);
+  void setFluidVelocity(const std::vector<glm::vec2>& velocities);
+  void setSoluteConcentration(unsigned int soluteID, const std::vector<GLfloat>& concentrations);
+  void setNodeIDs(const std::vector<GLfloat>& nodeIds);
+  // Replaces the walls while the flow goes on: the fluid and solutes on nodes whose ID changed are re-initialised at
+  // equilibrium with their current velocity and concentrations, and at rest on the walls
+  void replaceNodeIDs(const std::vector<GLfloat>& nodeIds);
+  void loadScene(const Scene& scene);
   void resize();
   void resetNodeIDs();
   void resetFluid();
   void resetSolute(unsigned int soluteID);
   void resetAll();
   GLuint getOutputTexture() const;
+  glm::ivec2 getOutputSize() const;
+  glm::ivec2 getLatticeSize() const;
+  SolverBackend getBackend() const;
+  uint64_t getStepCount() const;
+  std::vector<StateResource> getStateResources() const;
+  std::vector<PopulationLayout> getPopulationLayouts() const;
+  RestartState getRestartState() const;
+  void setRestartState(const RestartState& state);
+  std::vector<glm::vec2> getFluidVelocity() const;
+  std::vector<GLfloat> getFluidDensity() const;
+  std::vector<GLfloat> getSoluteConcentration(unsigned int soluteID) const;
+  // Passes of the auto-checkpoints: the change of every tile since its reference, the reference of the selected tiles,
+  // and the copy of one tile of a storage buffer resource to packedOffset bytes into a buffer, as the rows of each plane in turn
+  void updateChangeMap(ChangeMap& changeMap) const;
+  void updateChangeReference(ChangeMap& changeMap) const;
+  // Samples every stride-th node of the lattice from origin into the textures of a framebuffer, one per FieldType
+  void sampleFields(Framebuffer& fields, const glm::ivec2& origin, GLint stride) const;
+  void gatherTile(const StateResource& resource, const glm::ivec4& rect, GLuint packedBuffer, size_t packedOffset) const;
 
 private:
   // Simulation parameters
   const AppState& appState;
+  const SolverBackend backend;
+  const glm::ivec2 latticeSize;
   GLfloat wallAnimationPhase = 0.;
+  uint64_t stepCount = 0;
+  bool isOddInPlaceStep = false; // In-place streaming alternates between even and odd steps
+  bool isWallStencilDirty = true; // Wall stencil no longer mirrors the node IDs
+  bool areAllTilesStale = true;   // Solute state was replaced outside a step, so the next step updates every tile
+  bool hasVerticalWalls = false;  // Boundary walls last written into the node IDs
+  bool hasHorizontalWalls = false;
+  bool areSolutesEnabled = true;  // Solute passes can be skipped to run the fluid on its own
+  glm::vec2 bodyForce = {0., 0.}; // Uniform force density acting on all fluid nodes
+  ToolInput toolInput = {};       // Tool of the running step
+  ToolInput injectedToolInput = {};
+  bool hasInjectedToolInput = false;
 
   // LBM data structures
   Fluid fluid;
   std::array<Solute, 3> solutes;
   Reaction reaction;
+  Occupancy occupancy;
 
   // Vertex data
   GLuint vertexArray;
   GLuint vertexBuffer;
+  GLuint tileVertexArray;
+  GLuint tileVertexBuffer;
 
   // Frame buffer objects
   std::unique_ptr<Framebuffer> outputFBO;
   std::unique_ptr<ReadWriteFramebuffer> nodeIdFBO;
+  std::unique_ptr<StencilBuffer> wallStencil; // Shared by the fluid and solute FBOs (fragment backend only)
 
   // Shader programs
   std::unique_ptr<ShaderProgram> fluidInitShader;
@@ -61,19 +160,64 @@ private:
   std::unique_ptr<ShaderProgram> soluteCollisionShader;
   std::unique_ptr<ShaderProgram> fluidStreamingShader;
   std::unique_ptr<ShaderProgram> soluteStreamingShader;
-  std::unique_ptr<ShaderProgram> reactionShader;
   std::unique_ptr<ShaderProgram> nodeIDShader;
+  std::unique_ptr<ShaderProgram> wallStencilShader;
+  std::unique_ptr<ShaderProgram> wallResetShader;
+  std::unique_ptr<ShaderProgram> soluteOccupancyShader;
+  std::unique_ptr<ShaderProgram> occupancyReductionShader;
+  std::unique_ptr<ShaderProgram> occupancyDilationShader;
+  std::unique_ptr<ShaderProgram> changeDetectShader;
+  std::unique_ptr<ShaderProgram> changeReferenceShader;
+  std::unique_ptr<ShaderProgram> fieldSampleShader;
   std::unique_ptr<ShaderProgram> outputShader;
 
+  // Compute shader programs (compute backends only)
+  std::unique_ptr<ShaderProgram> fluidInitComputeShader;
+  std::unique_ptr<ShaderProgram> soluteInitComputeShader;
+  std::unique_ptr<ShaderProgram> fluidUpdateComputeShader;
+  std::unique_ptr<ShaderProgram> soluteUpdateComputeShader;
+  std::unique_ptr<ShaderProgram> fluidInPlaceUpdateComputeShader;
+  std::unique_ptr<ShaderProgram> soluteInPlaceUpdateComputeShader;
+  std::unique_ptr<ShaderProgram> tileGatherComputeShader;
+
+  // Compute work group dimensions, these must match the local sizes declared in the shaders
+  static constexpr unsigned int FLUID_WORK_GROUP_SIZE_X = 16;
+  static constexpr unsigned int FLUID_WORK_GROUP_SIZE_Y = 16;
+  static constexpr unsigned int SOLUTE_WORK_GROUP_SIZE_X = 16;
+  static constexpr unsigned int SOLUTE_WORK_GROUP_SIZE_Y = 8;
+  static constexpr unsigned int TILE_WORK_GROUP_SIZE_X = 16;
+  static constexpr unsigned int TILE_WORK_GROUP_SIZE_Y = 16;
+
   void createTriangles();
+  void createTileQuad();
   void createFBOs(const unsigned int width, const unsigned int height);
   void createShaderPrograms();
-  void initFluid();
-  void initSolute(unsigned int soluteID, glm::vec2 center, GLfloat radius);
+  void createComputeShaderPrograms();
+  void updatePassCosts() const;
+  // The init passes reset only the nodes whose ID differs from the other node ID buffer if isChangedOnly is set
+  void initFluid(bool isChangedOnly = false);
+  void initSolute(unsigned int soluteID, bool isChangedOnly = false);
   void updateNodeIDs();
+  void updateWallStencil();
+  void resetWalls(ReadWriteFramebuffer& fbo, GLfloat restDensity);
+  void setWallCulling(bool isEnabled) const;
   void updateFluid();
-  void updateSolute(unsigned int soluteID);
-  void react();
+  void updateOccupancy();
+  // Reduces the first level of the pyramid into the coarser ones, with the full-screen triangle bound
+  void reduceMaxPyramid(MaxPyramid& pyramid) const;
+  void drawActiveTiles(ShaderProgram& shader);
+  void collideSolute(unsigned int soluteID);
+  void streamSolute(unsigned int soluteID);
+  void updateFluidCompute();
+  void updateSolutesCompute();
+  void updateFluidInPlace();
+  void updateSolutesInPlace();
+  void dispatchCompute(unsigned int workGroupSizeX, unsigned int workGroupSizeY) const;
+  GLfloat getConcentrationSourcePolarity(unsigned int soluteID) const;
+  GLfloat getReactionRate() const;
+  void uploadTexture(GLuint texture, const std::vector<glm::vec4>& data) const;
+  void uploadTexture(GLuint texture, const std::vector<GLfloat>& data) const; // Into the red channel
+  std::vector<glm::vec4> readTexture(GLuint texture) const;
 };
 
 #endif // LBM_H
@@ -0,0 +1,40 @@
+#ifndef MAX_PYRAMID_H
+#define MAX_PYRAMID_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+#include "gl/framebuffers.h"
+
+// Pyramid of single-channel maps over the lattice in which every texel holds the largest value of the
+// REDUCTION_FACTOR x REDUCTION_FACTOR texels below it, so that the coarsest level holds one value per tile.
+// The owner writes the first level from the lattice, LBM::reduceMaxPyramid reduces it into the coarser ones.
+struct MaxPyramid {
+  MaxPyramid(const unsigned int width, const unsigned int height, const unsigned int levelCount, const std::string& owner) {
+    glm::ivec2 levelSize(width, height);
+    for (unsigned int i = 0; i < levelCount; i++) {
+      levelSize = (levelSize + glm::ivec2(REDUCTION_FACTOR - 1)) / glm::ivec2(REDUCTION_FACTOR);
+      levels.push_back(std::make_unique<Framebuffer>(levelSize.x, levelSize.y, 1, owner));
+      levels.back()->clear(0.0, 0.0, 0.0, 0.0);
+    }
+    tileCount = levelSize;
+    tileUVSize = glm::vec2(getTileSize(levelCount)) / glm::vec2(width, height);
+  }
+  ~MaxPyramid() = default;
+
+  static constexpr unsigned int REDUCTION_FACTOR = 4;
+
+  // Lattice nodes along the side of a tile of the coarsest level
+  static constexpr unsigned int getTileSize(const unsigned int levelCount) {
+    return levelCount == 0 ? 1 : REDUCTION_FACTOR * getTileSize(levelCount - 1);
+  }
+
+  std::vector<std::unique_ptr<Framebuffer>> levels;
+  glm::ivec2 tileCount;
+  glm::vec2 tileUVSize;
+};
+
+#endif // MAX_PYRAMID_H
@@ -0,0 +1,25 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <memory>
+
+#include "gl/framebuffers.h"
+#include "lbm/max_pyramid.h"
+
+// Coarse map of the lattice tiles that contain solute, used to restrict the solute passes to active tiles.
+// The coarsest level of the pyramid is dilated by one tile into activeTiles to leave a margin for advection and diffusion.
+struct Occupancy {
+  Occupancy(const unsigned int width, const unsigned int height) : pyramid(width, height, LEVEL_COUNT, "Occupancy") {
+    activeTiles = std::make_unique<Framebuffer>(pyramid.tileCount.x, pyramid.tileCount.y, 1, "Occupancy");
+    activeTiles->clear(1.0, 1.0, 1.0, 1.0);
+  }
+  ~Occupancy() = default;
+
+  static constexpr unsigned int LEVEL_COUNT = 2;
+  static constexpr unsigned int TILE_SIZE = MaxPyramid::getTileSize(LEVEL_COUNT);
+
+  MaxPyramid pyramid;
+  std::unique_ptr<Framebuffer> activeTiles;
+};
+
+#endif // OCCUPANCY_H
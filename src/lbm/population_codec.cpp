@@ -0,0 +1,404 @@
+#include "population_codec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+namespace {
+
+constexpr float WEIGHTS[9] = {4.f / 9.f, 1.f / 9.f, 1.f / 9.f, 1.f / 9.f, 1.f / 9.f, 1.f / 36.f, 1.f / 36.f, 1.f / 36.f, 1.f / 36.f};
+constexpr float VELOCITIES[9][2] = {{0.f, 0.f}, {1.f, 0.f}, {0.f, 1.f}, {-1.f, 0.f}, {0.f, -1.f},
+                                    {1.f, 1.f}, {-1.f, 1.f}, {-1.f, -1.f}, {1.f, -1.f}};
+constexpr size_t BLOCK_SIZE = PopulationCodec::BLOCK_SIZE;
+
+using BlockEncoder = std::function<void(size_t first, size_t count, std::vector<uint8_t>& bytes)>;
+using BlockDecoder = std::function<bool(size_t first, size_t count, const uint8_t* data, size_t size)>;
+
+void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body) {
+  // Splits [0, count) into one contiguous range per hardware thread
+  size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+  if (threadCount <= 1) {
+    if (count > 0) {
+      body(0, count);
+    }
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < threadCount; i++) {
+    threads.emplace_back(body, count * i / threadCount, count * (i + 1) / threadCount);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+class Writer {
+public:
+  explicit Writer(std::vector<uint8_t>& bytes) : bytes(bytes) {}
+
+  template <typename T>
+  void write(const T& value) {
+    append(&value, sizeof(T));
+  }
+
+  void append(const void* data, size_t size) {
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), begin, begin + size);
+  }
+
+  void writeCodes(const uint32_t* codes, size_t count, uint8_t bits) {
+    // Codes are packed from the least significant bit of each byte on
+    uint64_t buffer = 0;
+    unsigned int bufferBits = 0;
+    for (size_t i = 0; i < count; i++) {
+      buffer |= static_cast<uint64_t>(codes[i]) << bufferBits;
+      bufferBits += bits;
+      while (bufferBits >= 8) {
+        bytes.push_back(static_cast<uint8_t>(buffer));
+        buffer >>= 8;
+        bufferBits -= 8;
+      }
+    }
+    if (bufferBits > 0) {
+      bytes.push_back(static_cast<uint8_t>(buffer));
+    }
+  }
+
+private:
+  std::vector<uint8_t>& bytes;
+};
+
+class Reader {
+public:
+  Reader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+  template <typename T>
+  bool read(T& value) {
+    return read(&value, sizeof(T));
+  }
+
+  bool read(void* destination, size_t count) {
+    if (count > size - position) {
+      return false;
+    }
+    std::memcpy(destination, data + position, count);
+    position += count;
+    return true;
+  }
+
+  bool readCodes(uint32_t* codes, size_t count, uint8_t bits) {
+    size_t byteCount = (count * bits + 7) / 8;
+    if (byteCount > size - position) {
+      return false;
+    }
+    const uint8_t* bytes = data + position;
+    uint64_t buffer = 0;
+    unsigned int bufferBits = 0;
+    uint32_t mask = (1u << bits) - 1;
+    for (size_t i = 0; i < count; i++) {
+      while (bufferBits < bits) {
+        buffer |= static_cast<uint64_t>(*bytes++) << bufferBits;
+        bufferBits += 8;
+      }
+      codes[i] = static_cast<uint32_t>(buffer) & mask;
+      buffer >>= bits;
+      bufferBits -= bits;
+    }
+    position += byteCount;
+    return true;
+  }
+
+  bool isAtEnd() const {
+    return position == size;
+  }
+
+private:
+  const uint8_t* data;
+  size_t size;
+  size_t position = 0;
+};
+
+std::vector<uint8_t> encodeBlocks(size_t itemCount, const BlockEncoder& encodeBlock) {
+  // The stream holds the item count, the block count and the offset of every block after the offset table,
+  // so that blocks can be decoded independently
+  uint64_t blockCount = (itemCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  std::vector<std::vector<uint8_t>> blocks(blockCount);
+  parallelFor(blockCount, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      size_t first = i * BLOCK_SIZE;
+      encodeBlock(first, std::min(BLOCK_SIZE, itemCount - first), blocks[i]);
+    }
+  });
+
+  std::vector<uint8_t> bytes;
+  Writer writer(bytes);
+  writer.write(static_cast<uint64_t>(itemCount));
+  writer.write(blockCount);
+  uint64_t offset = 0;
+  for (const std::vector<uint8_t>& block : blocks) {
+    writer.write(offset);
+    offset += block.size();
+  }
+  writer.write(offset);
+  bytes.reserve(bytes.size() + offset);
+  for (const std::vector<uint8_t>& block : blocks) {
+    writer.append(block.data(), block.size());
+  }
+  return bytes;
+}
+
+bool decodeBlocks(const uint8_t* data, size_t size, size_t itemCount, const BlockDecoder& decodeBlock) {
+  Reader reader(data, size);
+  uint64_t storedItemCount = 0;
+  uint64_t blockCount = 0;
+  if (!reader.read(storedItemCount) || !reader.read(blockCount) || storedItemCount != itemCount ||
+      blockCount != (itemCount + BLOCK_SIZE - 1) / BLOCK_SIZE || (blockCount + 1) * sizeof(uint64_t) > size) {
+    return false;
+  }
+  std::vector<uint64_t> offsets(blockCount + 1);
+  if (!reader.read(offsets.data(), offsets.size() * sizeof(uint64_t))) {
+    return false;
+  }
+  const size_t tableSize = 2 * sizeof(uint64_t) + offsets.size() * sizeof(uint64_t);
+  if (offsets[0] != 0 || offsets[blockCount] != size - tableSize || !std::is_sorted(offsets.begin(), offsets.end())) {
+    return false;
+  }
+
+  std::atomic<bool> isValid = true;
+  parallelFor(blockCount, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end && isValid; i++) {
+      size_t first = i * BLOCK_SIZE;
+      if (!decodeBlock(first, std::min(BLOCK_SIZE, itemCount - first), data + tableSize + offsets[i], offsets[i + 1] - offsets[i])) {
+        isValid = false;
+      }
+    }
+  });
+  return isValid;
+}
+
+bool isSameFloat(float a, float b) {
+  // Bitwise, so that signed zeros and NaNs round trip
+  return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+void writeValues(Writer& writer, const float* values, size_t count) {
+  // A block holding a single value stores it once
+  bool isConstant = std::all_of(values, values + count, [&](float value) { return isSameFloat(value, values[0]); });
+  writer.write(static_cast<uint8_t>(isConstant));
+  writer.append(values, (isConstant ? 1 : count) * sizeof(float));
+}
+
+bool readValues(Reader& reader, float* values, size_t count) {
+  uint8_t isConstant = 0;
+  if (!reader.read(isConstant) || isConstant > 1) {
+    return false;
+  }
+  if (!isConstant) {
+    return reader.read(values, count * sizeof(float));
+  }
+  if (!reader.read(values[0])) {
+    return false;
+  }
+  std::fill(values + 1, values + count, values[0]);
+  return true;
+}
+
+// Populations and moments of one block, with the populations of each direction stored contiguously
+struct Block {
+  float populations[9][BLOCK_SIZE];
+  float moments[3][BLOCK_SIZE]; // Density and momentum
+};
+
+void computeMoments(Block& block, size_t count) {
+  for (size_t n = 0; n < count; n++) {
+    float density = 0.f;
+    float momentumX = 0.f;
+    float momentumY = 0.f;
+    for (unsigned int q = 0; q < 9; q++) {
+      density += block.populations[q][n];
+      momentumX += VELOCITIES[q][0] * block.populations[q][n];
+      momentumY += VELOCITIES[q][1] * block.populations[q][n];
+    }
+    block.moments[0][n] = density;
+    block.moments[1][n] = momentumX;
+    block.moments[2][n] = momentumY;
+  }
+}
+
+float getEquilibrium(const Block& block, unsigned int q, size_t n) {
+  // Second-order equilibrium, which for the solutes uses the flux in place of the momentum
+  float density = block.moments[0][n];
+  float momentumX = block.moments[1][n];
+  float momentumY = block.moments[2][n];
+  float cj = VELOCITIES[q][0] * momentumX + VELOCITIES[q][1] * momentumY;
+  float equilibrium = density + 3.f * cj;
+  if (density > 0.f) {
+    equilibrium += (4.5f * cj * cj - 1.5f * (momentumX * momentumX + momentumY * momentumY)) / density;
+  }
+  return WEIGHTS[q] * equilibrium;
+}
+
+uint8_t getInitialBits(const float* residuals, size_t count, float errorBound) {
+  // Fewest bits whose uniform quantization of the residual range has a step of at most twice the error bound
+  if (!(errorBound > 0.f)) {
+    return PopulationCodec::VERBATIM_BITS;
+  }
+  float minResidual = residuals[0];
+  float maxResidual = residuals[0];
+  for (size_t n = 0; n < count; n++) {
+    if (!std::isfinite(residuals[n])) {
+      return PopulationCodec::VERBATIM_BITS;
+    }
+    minResidual = std::min(minResidual, residuals[n]);
+    maxResidual = std::max(maxResidual, residuals[n]);
+  }
+  double levelCount = std::ceil((static_cast<double>(maxResidual) - minResidual) / (2. * errorBound)) + 1.;
+  double bits = std::ceil(std::log2(levelCount));
+  return bits > PopulationCodec::MAX_BITS ? PopulationCodec::VERBATIM_BITS : static_cast<uint8_t>(bits);
+}
+
+void writeResiduals(Writer& writer, const float* residuals, const float* populations, size_t count, uint8_t bits) {
+  writer.write(bits);
+  if (bits == PopulationCodec::VERBATIM_BITS) {
+    writer.append(populations, count * sizeof(float));
+    return;
+  }
+
+  // Residuals are quantized uniformly between their extremes in the block
+  float minResidual = *std::min_element(residuals, residuals + count);
+  float maxResidual = *std::max_element(residuals, residuals + count);
+  float base = bits == 0 ? 0.5f * (minResidual + maxResidual) : minResidual;
+  float step = bits == 0 ? 0.f : (maxResidual - minResidual) / static_cast<float>((1u << bits) - 1);
+  writer.write(base);
+  writer.write(step);
+  if (bits == 0) {
+    return;
+  }
+  uint32_t codes[BLOCK_SIZE];
+  uint32_t maxCode = (1u << bits) - 1;
+  for (size_t n = 0; n < count; n++) {
+    float code = step > 0.f ? std::round((residuals[n] - base) / step) : 0.f;
+    codes[n] = static_cast<uint32_t>(std::clamp(code, 0.f, static_cast<float>(maxCode)));
+  }
+  writer.writeCodes(codes, count, bits);
+}
+
+bool readBlock(Reader& reader, size_t count, Block& block) {
+  for (unsigned int i = 0; i < 3; i++) {
+    if (!readValues(reader, block.moments[i], count)) {
+      return false;
+    }
+  }
+
+  for (unsigned int q = 0; q < 9; q++) {
+    uint8_t bits = 0;
+    if (!reader.read(bits) || (bits > PopulationCodec::MAX_BITS && bits != PopulationCodec::VERBATIM_BITS)) {
+      return false;
+    }
+    if (bits == PopulationCodec::VERBATIM_BITS) {
+      if (!reader.read(block.populations[q], count * sizeof(float))) {
+        return false;
+      }
+      continue;
+    }
+    float base = 0.f;
+    float step = 0.f;
+    uint32_t codes[BLOCK_SIZE] = {};
+    if (!reader.read(base) || !reader.read(step) || (bits > 0 && !reader.readCodes(codes, count, bits))) {
+      return false;
+    }
+    for (size_t n = 0; n < count; n++) {
+      block.populations[q][n] = getEquilibrium(block, q, n) + (base + static_cast<float>(codes[n]) * step);
+    }
+  }
+  return true;
+}
+
+void encodePopulationBlock(const float* populations, size_t nodeCount, size_t first, size_t count, float errorBound,
+                           std::vector<uint8_t>& bytes) {
+  Block block;
+  for (unsigned int q = 0; q < 9; q++) {
+    std::copy_n(populations + q * nodeCount + first, count, block.populations[q]);
+  }
+  computeMoments(block, count);
+  float residuals[9][BLOCK_SIZE];
+  uint8_t bits[9];
+  for (unsigned int q = 0; q < 9; q++) {
+    for (size_t n = 0; n < count; n++) {
+      residuals[q][n] = block.populations[q][n] - getEquilibrium(block, q, n);
+    }
+    bits[q] = getInitialBits(residuals[q], count, errorBound);
+  }
+
+  // Rounding of the equilibrium can push a population past the bound, widen its quantization until the decoded
+  // block is within it
+  Block decoded;
+  for (;;) {
+    bytes.clear();
+    Writer writer(bytes);
+    for (unsigned int i = 0; i < 3; i++) {
+      writeValues(writer, block.moments[i], count);
+    }
+    for (unsigned int q = 0; q < 9; q++) {
+      writeResiduals(writer, residuals[q], block.populations[q], count, bits[q]);
+    }
+
+    Reader reader(bytes.data(), bytes.size());
+    readBlock(reader, count, decoded);
+    bool isWithinBound = true;
+    for (unsigned int q = 0; q < 9; q++) {
+      for (size_t n = 0; n < count; n++) {
+        float original = block.populations[q][n];
+        if (!isSameFloat(decoded.populations[q][n], original) && !(std::fabs(decoded.populations[q][n] - original) <= errorBound)) {
+          bits[q] = bits[q] < PopulationCodec::MAX_BITS ? bits[q] + 1 : PopulationCodec::VERBATIM_BITS;
+          isWithinBound = false;
+          break;
+        }
+      }
+    }
+    if (isWithinBound) {
+      return;
+    }
+  }
+}
+
+} // namespace
+
+std::vector<uint8_t> PopulationCodec::encodePopulations(const std::vector<float>& populations, size_t nodeCount, float errorBound) {
+  return encodeBlocks(nodeCount, [&](size_t first, size_t count, std::vector<uint8_t>& bytes) {
+    encodePopulationBlock(populations.data(), nodeCount, first, count, errorBound, bytes);
+  });
+}
+
+bool PopulationCodec::decodePopulations(const uint8_t* data, size_t size, size_t nodeCount, std::vector<float>& populations) {
+  populations.assign(9 * nodeCount, 0.f);
+  return decodeBlocks(data, size, nodeCount, [&](size_t first, size_t count, const uint8_t* blockData, size_t blockSize) {
+    Block block;
+    Reader reader(blockData, blockSize);
+    if (!readBlock(reader, count, block) || !reader.isAtEnd()) {
+      return false;
+    }
+    for (unsigned int q = 0; q < 9; q++) {
+      std::copy_n(block.populations[q], count, populations.data() + q * nodeCount + first);
+    }
+    return true;
+  });
+}
+
+std::vector<uint8_t> PopulationCodec::encodePlane(const std::vector<float>& values) {
+  return encodeBlocks(values.size(), [&](size_t first, size_t count, std::vector<uint8_t>& bytes) {
+    Writer writer(bytes);
+    writeValues(writer, values.data() + first, count);
+  });
+}
+
+bool PopulationCodec::decodePlane(const uint8_t* data, size_t size, size_t valueCount, std::vector<float>& values) {
+  values.assign(valueCount, 0.f);
+  return decodeBlocks(data, size, valueCount, [&](size_t first, size_t count, const uint8_t* blockData, size_t blockSize) {
+    Reader reader(blockData, blockSize);
+    return readValues(reader, values.data() + first, count) && reader.isAtEnd();
+  });
+}
@@ -0,0 +1,29 @@
+#ifndef POPULATION_CODEC_H
+#define POPULATION_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encoding of D2Q9 populations for compact checkpoints.
+// Every node keeps its zeroth and first moments (density and momentum, or concentration and flux) in full precision,
+// while the remainder of each population from the equilibrium these moments define is quantized. Nodes are encoded
+// in independent blocks, each with its own quantization range and bit width per population, so that blocks close to
+// equilibrium take a few bits per population and blocks at rest none at all. Blocks are encoded and decoded on all
+// hardware threads.
+struct PopulationCodec {
+  static constexpr size_t BLOCK_SIZE = 256;   // Nodes or values per block
+  static constexpr uint8_t MAX_BITS = 24;     // Wider quantization stores the populations of a block verbatim
+  static constexpr uint8_t VERBATIM_BITS = 32;
+
+  // Encodes populations stored as 9 consecutive planes of nodeCount floats.
+  // Every decoded population lies within errorBound of its original value.
+  static std::vector<uint8_t> encodePopulations(const std::vector<float>& populations, size_t nodeCount, float errorBound);
+  static bool decodePopulations(const uint8_t* data, size_t size, size_t nodeCount, std::vector<float>& populations);
+
+  // Lossless encoding of a plane of floats, in which blocks holding a single value are stored as that value only
+  static std::vector<uint8_t> encodePlane(const std::vector<float>& values);
+  static bool decodePlane(const uint8_t* data, size_t size, size_t valueCount, std::vector<float>& values);
+};
+
+#endif // POPULATION_CODEC_H
@@ -4,14 +4,14 @@
 #include <vector>
 #include "imgui.h"
 #include "glm.hpp"
-#include "gl/framebuffers.h"
+#include <glad/glad.h>
 
+// The nodal reaction rate is evaluated inline by the solute collision passes
 struct Reaction {
-  Reaction(const unsigned int width, const unsigned int height,
-           const std::vector<GLfloat>& molarMasses,
+  Reaction(const std::vector<GLfloat>& molarMasses,
            const std::vector<GLint>& stoichiometricCoeffs,
            const GLfloat reactionRate)
-  : fbo(width, height, 1), stoichiometricCoeffs(stoichiometricCoeffs),
+  : stoichiometricCoeffs(stoichiometricCoeffs),
     reactionRate(reactionRate)
   {
     // Store premultiplied coeffs.
@@ -26,7 +26,6 @@ struct Reaction {
     reactionRate = r;
   }
 
-  ReadWriteFramebuffer fbo;
   GLfloat reactionRate;
   std::vector<GLfloat> molMassTimesCoeffs;
   std::vector<GLint> stoichiometricCoeffs;
@@ -0,0 +1,295 @@
+#include "scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "lbm/lbm.h"
+
+namespace {
+
+struct SceneInfo {
+  SceneType type;
+  const char* name;
+};
+
+const SceneInfo SCENES[] = {
+  {SceneType::Blobs, "blobs"},
+  {SceneType::CylinderWake, "cylinder"},
+  {SceneType::ShearDrivenCavity, "cavity"},
+  {SceneType::PorousPacking, "porous"},
+  {SceneType::ChannelNetwork, "channels"},
+  {SceneType::MixingChamber, "mixing"},
+};
+
+const unsigned int MAX_PACKING_ATTEMPTS = 100000;
+
+// std::mt19937 is fully specified by the standard, the distributions are not, so map its output ourselves
+class Random {
+public:
+  explicit Random(unsigned int seed) : engine(seed) {}
+
+  float uniform(float min, float max) {
+    return min + (max - min) * static_cast<float>(engine() * (1. / 4294967296.));
+  }
+
+private:
+  std::mt19937 engine;
+};
+
+size_t getIndex(const Scene& scene, int x, int y) {
+  // Wrap around the periodic lattice
+  x = (x % scene.latticeSize.x + scene.latticeSize.x) % scene.latticeSize.x;
+  y = (y % scene.latticeSize.y + scene.latticeSize.y) % scene.latticeSize.y;
+  return static_cast<size_t>(y) * scene.latticeSize.x + x;
+}
+
+bool isWall(const Scene& scene, int x, int y) {
+  return scene.nodeIds[getIndex(scene, x, y)] > 0.5f;
+}
+
+void fillRect(Scene& scene, int x0, int y0, int x1, int y1, GLfloat nodeId) {
+  for (int y = y0; y < y1; y++) {
+    for (int x = x0; x < x1; x++) {
+      scene.nodeIds[getIndex(scene, x, y)] = nodeId;
+    }
+  }
+}
+
+size_t fillDisc(Scene& scene, float centerX, float centerY, float radius) {
+  // Returns the number of fluid nodes the disc turned into walls
+  size_t count = 0;
+  for (int y = static_cast<int>(std::floor(centerY - radius)); y <= static_cast<int>(std::ceil(centerY + radius)); y++) {
+    for (int x = static_cast<int>(std::floor(centerX - radius)); x <= static_cast<int>(std::ceil(centerX + radius)); x++) {
+      float dx = x - centerX;
+      float dy = y - centerY;
+      if (dx * dx + dy * dy <= radius * radius && !isWall(scene, x, y)) {
+        scene.nodeIds[getIndex(scene, x, y)] = 1.f;
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+void fillConcentration(Scene& scene, unsigned int soluteID, int x0, int y0, int x1, int y1) {
+  for (int y = y0; y < y1; y++) {
+    for (int x = x0; x < x1; x++) {
+      if (!isWall(scene, x, y)) {
+        scene.concentrations[soluteID][getIndex(scene, x, y)] = 1.f;
+      }
+    }
+  }
+}
+
+void addBoundaryWalls(Scene& scene, bool hasVerticalWalls, bool hasHorizontalWalls) {
+  // Mirrors what the node ID pass writes for the boundary wall toggles
+  scene.hasVerticalWalls = hasVerticalWalls;
+  scene.hasHorizontalWalls = hasHorizontalWalls;
+  if (hasVerticalWalls) {
+    fillRect(scene, scene.latticeSize.x - 1, 0, scene.latticeSize.x, scene.latticeSize.y, 1.f);
+  }
+  if (hasHorizontalWalls) {
+    fillRect(scene, 0, 0, scene.latticeSize.x, 1, 1.f);
+  }
+}
+
+GLfloat getChannelForce(const SceneParameters& parameters, GLfloat viscosity, float channelHeight) {
+  // Force density giving a Poiseuille flow with the target peak velocity
+  return 8.f * viscosity * parameters.flowSpeed / (channelHeight * channelHeight);
+}
+
+void setChannelProfile(Scene& scene, int y0, int y1, float peakVelocity) {
+  // Poiseuille profile between bounce-back walls lying half way between nodes y0 - 1, y0 and y1 - 1, y1
+  float height = static_cast<float>(y1 - y0);
+  for (int y = y0; y < y1; y++) {
+    float distance = y - y0 + 0.5f;
+    float velocity = 4.f * peakVelocity * distance * (height - distance) / (height * height);
+    for (int x = 0; x < scene.latticeSize.x; x++) {
+      if (!isWall(scene, x, y)) {
+        scene.velocities[getIndex(scene, x, y)] = {velocity, 0.f};
+      }
+    }
+  }
+}
+
+void buildBlobs(Scene& scene, const SceneParameters& parameters, const glm::vec2& aspect) {
+  // Open periodic box with discs of solute, later blobs of the same solute replacing earlier ones where they overlap
+  addBoundaryWalls(scene, false, false);
+  for (int y = 0; y < scene.latticeSize.y; y++) {
+    for (int x = 0; x < scene.latticeSize.x; x++) {
+      glm::vec2 uv = (glm::vec2(x, y) + 0.5f) / glm::vec2(scene.latticeSize);
+      for (const SoluteBlob& blob : parameters.blobs) {
+        if (blob.soluteID < scene.concentrations.size() && glm::length((blob.center - uv) * aspect) < blob.radius) {
+          scene.concentrations[blob.soluteID][getIndex(scene, x, y)] = blob.concentration;
+        }
+      }
+    }
+  }
+}
+
+void buildCylinderWake(Scene& scene, const SceneParameters& parameters, GLfloat viscosity) {
+  // Cylinder of featureSize * height in diameter, slightly off the channel axis so that vortex shedding sets in early
+  const glm::ivec2& size = scene.latticeSize;
+  addBoundaryWalls(scene, false, true);
+  float radius = std::max(2.f, 0.5f * parameters.featureSize * size.y);
+  fillDisc(scene, 0.25f * size.x, 0.5f * size.y + 0.5f, radius);
+  scene.bodyForce.x = getChannelForce(parameters, viscosity, size.y - 1.f);
+  setChannelProfile(scene, 1, size.y, parameters.flowSpeed);
+
+  // Dye line upstream of the cylinder
+  int dyeWidth = std::max(1, size.x / 64);
+  fillConcentration(scene, 0, size.x / 8 - dyeWidth, 1, size.x / 8 + dyeWidth, size.y);
+}
+
+void buildShearDrivenCavity(Scene& scene, const SceneParameters& parameters, GLfloat viscosity) {
+  // A square cavity in the lower half, driven by the channel flow above it rather than by a moving lid,
+  // the uniform body force is balanced by pressure inside the closed cavity
+  const glm::ivec2& size = scene.latticeSize;
+  addBoundaryWalls(scene, false, true);
+  int channelStart = size.y / 2;
+  int cavitySize = channelStart - 1;
+  int cavityStart = (size.x - cavitySize) / 2;
+  fillRect(scene, 0, 0, size.x, channelStart, 1.f);
+  fillRect(scene, cavityStart, 1, cavityStart + cavitySize, channelStart, 0.f);
+  scene.bodyForce.x = getChannelForce(parameters, viscosity, static_cast<float>(size.y - channelStart));
+  setChannelProfile(scene, channelStart, size.y, parameters.flowSpeed);
+
+  // Fill the cavity with solute to show its exchange with the channel
+  fillConcentration(scene, 0, cavityStart, 1, cavityStart + cavitySize, channelStart);
+}
+
+void buildPorousPacking(Scene& scene, const SceneParameters& parameters, GLfloat viscosity) {
+  // Overlapping discs of featureSize * height / 2 in diameter are added at random until the porosity is reached
+  const glm::ivec2& size = scene.latticeSize;
+  addBoundaryWalls(scene, false, true);
+  Random random(parameters.seed);
+  float porosity = std::clamp(parameters.porosity, 0.1f, 1.f);
+  float radius = std::max(1.5f, 0.25f * parameters.featureSize * size.y);
+  size_t fluidNodes = static_cast<size_t>(size.x) * (size.y - 1);
+  size_t targetNodes = static_cast<size_t>(porosity * fluidNodes);
+  for (unsigned int i = 0; i < MAX_PACKING_ATTEMPTS && fluidNodes > targetNodes; i++) {
+    float x = random.uniform(0.f, static_cast<float>(size.x));
+    float y = random.uniform(1.f, static_cast<float>(size.y - 1));
+    fluidNodes -= fillDisc(scene, x, y, radius);
+  }
+
+  // Drive the flow by the typical pore width rather than the channel height, so that open lanes stay stable
+  float poreWidth = std::clamp(2.f * radius * porosity / std::max(1.f - porosity, 0.01f), 2.f, size.y - 1.f);
+  scene.bodyForce.x = getChannelForce(parameters, viscosity, poreWidth);
+  fillConcentration(scene, 0, 0, 1, std::max(1, size.x / 16), size.y);
+}
+
+void buildChannelNetwork(Scene& scene, const SceneParameters& parameters, GLfloat viscosity) {
+  // Parallel channels of featureSize * height / 2 in width, with two cross-links at random positions between neighbours
+  const glm::ivec2& size = scene.latticeSize;
+  Random random(parameters.seed);
+  int width = std::max(3, static_cast<int>(0.5f * parameters.featureSize * size.y));
+  int channelCount = std::max(2, static_cast<int>(std::lround(0.5f / parameters.featureSize)));
+  int pitch = size.y / channelCount;
+  width = std::min(width, pitch - 2);
+  fillRect(scene, 0, 0, size.x, size.y, 1.f);
+  addBoundaryWalls(scene, false, true);
+  for (int i = 0; i < channelCount; i++) {
+    int channelStart = i * pitch + (pitch - width) / 2;
+    fillRect(scene, 0, channelStart, size.x, channelStart + width, 0.f);
+    if (i + 1 < channelCount) {
+      for (int link = 0; link < 2; link++) {
+        int x = static_cast<int>(random.uniform(0.f, static_cast<float>(size.x - width)));
+        fillRect(scene, x, channelStart + width / 2, x + width, channelStart + pitch + width / 2, 0.f);
+      }
+    }
+  }
+  scene.bodyForce.x = getChannelForce(parameters, viscosity, static_cast<float>(width));
+  for (int i = 0; i < channelCount; i++) {
+    int channelStart = i * pitch + (pitch - width) / 2;
+    setChannelProfile(scene, channelStart, channelStart + width, parameters.flowSpeed);
+  }
+  fillConcentration(scene, 0, 0, 1, std::max(1, size.x / 16), size.y);
+}
+
+void buildMixingChamber(Scene& scene, const SceneParameters& parameters, GLfloat viscosity) {
+  // Three stacked solute streams flowing through staggered baffles that leave 40% of the height open
+  const glm::ivec2& size = scene.latticeSize;
+  addBoundaryWalls(scene, false, true);
+  const int baffleCount = 3;
+  int thickness = std::max(2, static_cast<int>(0.25f * parameters.featureSize * size.y));
+  int baffleHeight = static_cast<int>(0.6f * size.y);
+  for (int i = 0; i < baffleCount; i++) {
+    int x = (i + 1) * size.x / (baffleCount + 1);
+    if (i % 2 == 0) {
+      fillRect(scene, x, 1, x + thickness, 1 + baffleHeight, 1.f);
+    } else {
+      fillRect(scene, x, size.y - baffleHeight, x + thickness, size.y, 1.f);
+    }
+  }
+  scene.bodyForce.x = getChannelForce(parameters, viscosity, 0.4f * size.y);
+
+  // Reactants A and B are adjacent, so that the reaction runs along their interface
+  int inletWidth = std::max(1, size.x / 8);
+  for (unsigned int i = 0; i < scene.concentrations.size(); i++) {
+    fillConcentration(scene, i, 0, 1 + i * (size.y - 1) / 3, inletWidth, 1 + (i + 1) * (size.y - 1) / 3);
+  }
+}
+
+} // namespace
+
+float Scene::getPorosity() const {
+  size_t fluidNodes = std::count(nodeIds.begin(), nodeIds.end(), 0.f);
+  return nodeIds.empty() ? 0.f : static_cast<float>(fluidNodes) / nodeIds.size();
+}
+
+Scene buildScene(SceneType type, const glm::ivec2& latticeSize, const SceneParameters& parameters, GLfloat viscosity,
+                 const glm::vec2& aspect) {
+  Scene scene;
+  size_t nodeCount = static_cast<size_t>(latticeSize.x) * latticeSize.y;
+  scene.latticeSize = latticeSize;
+  scene.nodeIds.assign(nodeCount, 0.f);
+  scene.velocities.assign(nodeCount, {0.f, 0.f});
+  for (auto& concentrations : scene.concentrations) {
+    concentrations.assign(nodeCount, 0.f);
+  }
+
+  SceneParameters clamped = parameters;
+  clamped.featureSize = std::clamp(parameters.featureSize, 0.02f, 0.5f);
+  switch (type) {
+    case SceneType::Blobs: buildBlobs(scene, parameters, aspect); break;
+    case SceneType::CylinderWake: buildCylinderWake(scene, clamped, viscosity); break;
+    case SceneType::ShearDrivenCavity: buildShearDrivenCavity(scene, clamped, viscosity); break;
+    case SceneType::PorousPacking: buildPorousPacking(scene, clamped, viscosity); break;
+    case SceneType::ChannelNetwork: buildChannelNetwork(scene, clamped, viscosity); break;
+    case SceneType::MixingChamber: buildMixingChamber(scene, clamped, viscosity); break;
+  }
+  return scene;
+}
+
+void loadScene(LBM& lbm) {
+  AppState& appState = AppState::getInstance();
+  SceneParameters parameters{appState.scenePorosity, appState.sceneFeatureSize, appState.sceneFlowSpeed, appState.sceneSeed,
+                             appState.sceneBlobs};
+  Scene scene = buildScene(appState.scene, lbm.getLatticeSize(), parameters, appState.fluidViscosity, appState.aspectRatio);
+
+  // The node ID pass rewrites the boundary rows every step, so the toggles have to match the scene
+  appState.hasVerticalWalls = scene.hasVerticalWalls;
+  appState.hasHorizontalWalls = scene.hasHorizontalWalls;
+  lbm.loadScene(scene);
+}
+
+const char* getSceneName(SceneType type) {
+  for (const SceneInfo& scene : SCENES) {
+    if (scene.type == type) {
+      return scene.name;
+    }
+  }
+  return "unknown";
+}
+
+bool parseSceneName(const std::string& name, SceneType& type) {
+  for (const SceneInfo& scene : SCENES) {
+    if (name == scene.name) {
+      type = scene.type;
+      return true;
+    }
+  }
+  return false;
+}
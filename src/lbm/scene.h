@@ -0,0 +1,47 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm.hpp"
+
+#include "core/app_state.h"
+
+class LBM;
+
+struct SceneParameters {
+  GLfloat porosity = INIT_SCENE_POROSITY;
+  GLfloat featureSize = INIT_SCENE_FEATURE_SIZE;
+  GLfloat flowSpeed = INIT_SCENE_FLOW_SPEED;
+  unsigned int seed = INIT_SCENE_SEED;
+  std::vector<SoluteBlob> blobs = INIT_SCENE_BLOBS;
+};
+
+// Initial state of a procedurally generated scene. The fields are stored row by row from the bottom of the lattice,
+// as they are uploaded to the GPU. Scenes are generated from integer arithmetic and their own random number mapping
+// only, so that a scene is identical across builds, standard libraries and machines.
+struct Scene {
+  glm::ivec2 latticeSize = {0, 0};
+  std::vector<GLfloat> nodeIds;        // 1 marks a wall node, 0 a fluid node
+  std::vector<glm::vec2> velocities;   // Initial fluid velocity
+  std::array<std::vector<GLfloat>, 3> concentrations; // Initial solute concentrations
+  glm::vec2 bodyForce = {0.f, 0.f};    // Force density driving the flow
+  bool hasVerticalWalls = false;       // Boundary walls on the right (and thus left) edge of the periodic lattice
+  bool hasHorizontalWalls = false;     // Boundary walls on the bottom (and thus top) edge of the periodic lattice
+
+  float getPorosity() const; // Fluid fraction of the lattice
+};
+
+Scene buildScene(SceneType type, const glm::ivec2& latticeSize, const SceneParameters& parameters, GLfloat viscosity,
+                 const glm::vec2& aspect = {1.f, 1.f});
+
+// Builds the scene selected in the AppState and loads it into the simulation, including its boundary walls
+void loadScene(LBM& lbm);
+
+const char* getSceneName(SceneType type);
+bool parseSceneName(const std::string& name, SceneType& type);
+
+#endif // SCENE_H
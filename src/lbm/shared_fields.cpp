@@ -0,0 +1,136 @@
+#include "lbm/shared_fields.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+const unsigned int MAX_READ_ATTEMPTS = 8;
+
+} // namespace
+
+size_t SharedFields::getSlotOffset(const Header& header, unsigned int slot) {
+  return sizeof(Header) + static_cast<size_t>(slot) * header.slotSize;
+}
+
+size_t SharedFields::getMappingSize(const Header& header) {
+  return getSlotOffset(header, header.slotCount);
+}
+
+uint64_t SharedFields::load(const uint64_t& word) {
+  // Lock-free 64-bit atomics are address-free, so they synchronise across processes. Loads do not write, so this is
+  // safe on read-only mappings.
+  return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(word)).load(std::memory_order_acquire);
+}
+
+void SharedFields::store(uint64_t& word, uint64_t value) {
+  std::atomic_ref<uint64_t>(word).store(value, std::memory_order_release);
+}
+
+SharedFieldReader::~SharedFieldReader() {
+  close();
+}
+
+bool SharedFieldReader::open(const std::string& name, std::string& error) {
+  close();
+#if defined(_WIN32)
+  error = "Shared field rings require POSIX shared memory";
+  return false;
+#else
+  int descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+  if (descriptor < 0) {
+    error = "Failed to open shared memory " + name + ": " + std::strerror(errno);
+    return false;
+  }
+  struct stat info;
+  bool isValid = fstat(descriptor, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedFields::Header);
+  void* data = isValid ? mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+  ::close(descriptor);
+  if (data == MAP_FAILED) {
+    error = "Failed to map shared memory " + name;
+    return false;
+  }
+  mapping = static_cast<const uint8_t*>(data);
+  mappingSize = info.st_size;
+
+  const SharedFields::Header& header = getHeader();
+  if (std::memcmp(header.magic, SharedFields::MAGIC, sizeof(header.magic)) != 0 || header.version != SharedFields::VERSION ||
+      header.slotCount == 0 || SharedFields::getMappingSize(header) > mappingSize) {
+    close();
+    error = name + " is not a shared field ring";
+    return false;
+  }
+  return true;
+#endif
+}
+
+void SharedFieldReader::close() {
+#if !defined(_WIN32)
+  if (mapping != nullptr) {
+    munmap(const_cast<uint8_t*>(mapping), mappingSize);
+  }
+#endif
+  mapping = nullptr;
+  mappingSize = 0;
+}
+
+const SharedFields::Header& SharedFieldReader::getHeader() const {
+  return *reinterpret_cast<const SharedFields::Header*>(mapping);
+}
+
+uint64_t SharedFieldReader::getPublishedCount() const {
+  return SharedFields::load(getHeader().publishedCount);
+}
+
+bool SharedFieldReader::isWriterOpen() const {
+  return std::atomic_ref<uint32_t>(const_cast<uint32_t&>(getHeader().isOpen)).load(std::memory_order_acquire) != 0;
+}
+
+const void* SharedFieldReader::beginRead(unsigned int slot, uint64_t& sequence, uint64_t& stepCount, uint64_t& index) const {
+  const uint8_t* slotData = mapping + SharedFields::getSlotOffset(getHeader(), slot);
+  const SharedFields::SlotHeader& slotHeader = *reinterpret_cast<const SharedFields::SlotHeader*>(slotData);
+  sequence = SharedFields::load(slotHeader.sequence);
+  if (sequence % 2 != 0) {
+    return nullptr;
+  }
+  stepCount = slotHeader.stepCount;
+  index = slotHeader.index;
+  return slotData + sizeof(SharedFields::SlotHeader);
+}
+
+bool SharedFieldReader::endRead(unsigned int slot, uint64_t sequence) const {
+  // Order the reads of the snapshot before the second load of the sequence
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint8_t* slotData = mapping + SharedFields::getSlotOffset(getHeader(), slot);
+  return SharedFields::load(reinterpret_cast<const SharedFields::SlotHeader*>(slotData)->sequence) == sequence;
+}
+
+bool SharedFieldReader::readLatest(uint64_t& lastIndex, uint64_t& stepCount, std::vector<uint8_t>& data) const {
+  const SharedFields::Header& header = getHeader();
+  for (unsigned int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+    const uint64_t publishedCount = getPublishedCount();
+    if (publishedCount <= lastIndex) {
+      return false;
+    }
+    const unsigned int slot = static_cast<unsigned int>((publishedCount - 1) % header.slotCount);
+    uint64_t sequence, index;
+    const void* snapshot = beginRead(slot, sequence, stepCount, index);
+    if (snapshot == nullptr) {
+      continue;
+    }
+    data.resize(header.dataSize);
+    std::memcpy(data.data(), snapshot, header.dataSize);
+    if (endRead(slot, sequence) && index > lastIndex) {
+      lastIndex = index;
+      return true;
+    }
+  }
+  return false;
+}
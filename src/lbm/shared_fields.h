@@ -0,0 +1,86 @@
+#ifndef SHARED_FIELDS_H
+#define SHARED_FIELDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lbm/field_series.h"
+
+// Ring of field snapshots in a POSIX shared memory object, which other local processes map to watch the simulation
+// live. The FieldPublisher writes it, readers never block the writer and the writer never waits for readers.
+//
+// Layout (native byte order): a Header followed by slotCount slots of slotSize bytes, each a SlotHeader followed by
+// the sampled fields of one snapshot as laid out in a FieldSeries chunk, the selected fields one after the other in
+// FieldType order. Snapshot n (counting from 1) is written to slot (n - 1) % slotCount.
+//
+// Every slot is guarded by a sequence lock: its sequence is odd while the writer fills it and advances to the next
+// even number once the snapshot is complete, after which Header::publishedCount is raised to n. A reader loads the
+// sequence, reads the snapshot in place if it is even, then loads the sequence again; if it changed the slot was
+// overwritten meanwhile and the snapshot has to be discarded. Both counters are 64-bit words accessed atomically.
+struct SharedFields {
+  static constexpr char MAGIC[8] = {'L', 'B', 'M', 'S', 'H', 'A', 'R', 'E'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr size_t ALIGNMENT = 64; // Of the slots and their data
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint64_t slotSize;         // Bytes from one slot to the next, including the slot header
+    uint64_t dataSize;         // Bytes of field data in every slot
+    uint64_t publishedCount;   // Snapshots completed so far
+    uint32_t isOpen;           // Cleared when the publisher stops, the object is then unlinked
+    uint8_t reserved[20];
+    FieldSeries::Header grid;  // Sampled region, stride, grid size and selected fields
+  };
+
+  struct SlotHeader {
+    uint64_t sequence;         // Odd while the slot is written
+    uint64_t stepCount;        // Of the snapshot in the slot
+    uint64_t index;            // Of the snapshot in the slot, counting from 1
+    uint8_t reserved[40];
+  };
+
+  static size_t getSlotOffset(const Header& header, unsigned int slot);
+  static size_t getMappingSize(const Header& header);
+
+  // Atomic access to the counters of a mapping shared with other processes
+  static uint64_t load(const uint64_t& word);
+  static void store(uint64_t& word, uint64_t value);
+};
+
+static_assert(sizeof(SharedFields::Header) == 128, "The shared field ring header layout is shared with other processes");
+static_assert(sizeof(SharedFields::SlotHeader) == SharedFields::ALIGNMENT, "The shared field ring slot layout is shared with other processes");
+
+// Maps a shared field ring read-only and reads snapshots without copying them through the simulator
+class SharedFieldReader {
+public:
+  SharedFieldReader() = default;
+  ~SharedFieldReader();
+
+  SharedFieldReader(const SharedFieldReader&) = delete;
+  SharedFieldReader& operator=(const SharedFieldReader&) = delete;
+
+  bool open(const std::string& name, std::string& error);
+  void close();
+
+  const SharedFields::Header& getHeader() const;
+  uint64_t getPublishedCount() const;
+  bool isWriterOpen() const;
+
+  // Returns the data of the snapshot in a slot and the sequence to validate it with, or nullptr while it is written
+  const void* beginRead(unsigned int slot, uint64_t& sequence, uint64_t& stepCount, uint64_t& index) const;
+  // Returns whether the snapshot read since beginRead is intact
+  bool endRead(unsigned int slot, uint64_t sequence) const;
+
+  // Copies the newest snapshot if it is newer than lastIndex, retrying if it is overwritten while being copied
+  bool readLatest(uint64_t& lastIndex, uint64_t& stepCount, std::vector<uint8_t>& data) const;
+
+private:
+  const uint8_t* mapping = nullptr;
+  size_t mappingSize = 0;
+};
+
+#endif // SHARED_FIELDS_H
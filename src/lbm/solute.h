@@ -1,13 +1,26 @@
 #ifndef SOLUTE_H
 #define SOLUTE_H
 
+#include <memory>
+#include <string>
+
 #include "imgui.h"
 #include "glm.hpp"
+#include "core/app_state.h"
 #include "gl/framebuffers.h"
+#include "gl/storage_buffers.h"
 
 struct Solute {
-  Solute(const unsigned int width, const unsigned int height, const GLfloat diffusivity, const glm::vec3& color)
-  : fbo(width, height, 3) {
+  Solute(const unsigned int width, const unsigned int height, const GLfloat diffusivity, const glm::vec3& color, const SolverBackend backend,
+         const std::string& name)
+  : fbo(width, height, backend == SolverBackend::FragmentShader ? 3 : 1, name, backend == SolverBackend::FragmentShader) {
+    // The compute backends keep the distributions in storage buffers and only mirror
+    // the concentration and concentration source into fbo
+    if (backend != SolverBackend::FragmentShader) {
+      bool isDoubleBuffered = backend != SolverBackend::InPlaceComputeShader;
+      populations = std::make_unique<ReadWriteStorageBuffer>(DISTRIBUTION_COUNT * width * height * sizeof(GLfloat), name,
+                                                             isDoubleBuffered);
+    }
     setDiffusivity(diffusivity);
     setColor(color);
   }
@@ -25,8 +38,10 @@ struct Solute {
   }
 
   static constexpr GLfloat TRT_MAGIC = 1. / 4.;
+  static constexpr GLuint DISTRIBUTION_COUNT = 9;
 
   ReadWriteFramebuffer fbo;
+  std::unique_ptr<ReadWriteStorageBuffer> populations;
   GLfloat plusOmega;
   GLfloat minusOmega;
   GLfloat tau;
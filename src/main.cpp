@@ -7,12 +7,27 @@
 // - Documentation        https://dearimgui.com/docs (same as your local docs/ folder).
 // - Introduction, links and more at the top of imgui.cpp
 
+#include <iostream>
+#include <string>
+
 #include "core/app.h"
+#include "core/batch_run.h"
 #include "core/io.h"
+#include "core/run_config.h"
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
-  App app;
+  RunConfig config;
+  std::string error;
+  if (!parseRunConfig(argc, argv, config, error)) {
+    std::cerr << (error.empty() ? getRunConfigUsage() : error + "\n");
+    return error.empty() ? 0 : 1;
+  }
+  if (config.isHeadless) {
+    return runBatch(config);
+  }
+
+  App app(config);
   app.run();
   return 0;
 }
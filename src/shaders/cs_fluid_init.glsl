@@ -0,0 +1,61 @@
+#version 430 core
+// Initialises macroscopic fluid velocity, density and the equilibrium distributions in storage buffers
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+const float weights[9] = float[9](4. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 36., 1. / 36., 1. / 36., 1. / 36.);
+const vec2 velocities[9] = vec2[9](vec2(0., 0.), vec2(1., 0.), vec2(0., 1.), vec2(-1., 0.), vec2(0., -1.),
+                                   vec2(1., 1.), vec2(-1., 1.), vec2(-1., -1.), vec2(1., -1.));
+const int opposite[9] = int[9](0, 3, 4, 1, 2, 7, 8, 5, 6);
+
+layout(std430) readonly buffer Populations {
+  float populations[];
+};
+
+layout(std430) writeonly buffer UpdatedPopulations {
+  float updatedPopulations[];
+};
+
+layout(rgba32f) uniform image2D uUpdatedFluidData[2]; // The velocity may hold a preset field
+uniform sampler2D uNodeIds;
+uniform sampler2D uPreviousNodeIds;
+uniform bool uIsChangedOnly; // Keep the nodes whose ID did not change as they are
+uniform ivec2 uLatticeSize;
+uniform bool uIsLayoutSwapped;
+uniform vec2 uInitVelocity;
+uniform float uInitDensity;
+
+void main(void) {
+  ivec2 node = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(node, uLatticeSize))) {
+    return;
+  }
+  int nodeCount = uLatticeSize.x * uLatticeSize.y;
+  int nodeIndex = node.y * uLatticeSize.x + node.x;
+  int nodeId = int(texelFetch(uNodeIds, node, 0).x + 0.5);
+  if (uIsChangedOnly && nodeId == int(texelFetch(uPreviousNodeIds, node, 0).x + 0.5)) {
+    for (int i = 0; i < 9; i++) {
+      updatedPopulations[i * nodeCount + nodeIndex] = populations[i * nodeCount + nodeIndex];
+    }
+    return;
+  }
+
+  // Set initial macroscopic velocity and density
+  vec2 presetVelocity = imageLoad(uUpdatedFluidData[0], node).xy;
+  vec2 velocity = (nodeId == 0) ? uInitVelocity + presetVelocity : vec2(0.);
+  float density = 0.;
+
+  // Calculate equilibrium distributions around the rest density, so that the first
+  // streaming step of the fused update already sees a fully populated lattice
+  float nodalDensity = uInitDensity + density;
+  float nodalVelMagSquared = dot(velocity, velocity);
+  for (int i = 0; i < 9; i++) {
+    float cu = dot(velocities[i], velocity);
+    // In-place streaming expects the distributions in opposite slots after an even step
+    int slot = uIsLayoutSwapped ? opposite[i] : i;
+    updatedPopulations[slot * nodeCount + nodeIndex] = weights[i] * nodalDensity * (1. + 3. * cu + 4.5 * cu * cu - 1.5 * nodalVelMagSquared);
+  }
+
+  imageStore(uUpdatedFluidData[0], node, vec4(velocity, 0., 0.));
+  imageStore(uUpdatedFluidData[1], node, vec4(density, 0., 0., 0.));
+}
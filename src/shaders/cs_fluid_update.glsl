@@ -0,0 +1,138 @@
+#version 430 core
+// Performs fused fluid streaming and TRT collision on storage buffers
+// Each work group stages its tile plus a one-node halo in shared memory before streaming
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+const float weights[9] = float[9](4. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 36., 1. / 36., 1. / 36., 1. / 36.);
+const ivec2 velocities[9] = ivec2[9](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(-1, 0), ivec2(0, -1),
+                                     ivec2(1, 1), ivec2(-1, 1), ivec2(-1, -1), ivec2(1, -1));
+const int opposite[9] = int[9](0, 3, 4, 1, 2, 7, 8, 5, 6);
+const float forceLimit = 0.01;
+const float forceStrength = 5.;
+
+const ivec2 tileSize = ivec2(gl_WorkGroupSize.xy) + 2;
+const int tileNodeCount = tileSize.x * tileSize.y;
+
+layout(std430) readonly buffer Populations {
+  float populations[];
+};
+
+layout(std430) writeonly buffer UpdatedPopulations {
+  float updatedPopulations[];
+};
+
+layout(rgba32f) uniform writeonly image2D uUpdatedFluidData[2];
+uniform sampler2D uNodeIds;
+uniform ivec2 uLatticeSize;
+uniform vec2 uCursorPos;
+uniform vec2 uCursorVel;
+uniform vec2 uBodyForce;
+uniform vec2 uAspect;
+uniform float uToolSize;
+uniform float uInitDensity;
+uniform float uSpeedOfSound;
+uniform float uPlusOmega;
+uniform float uMinusOmega;
+uniform bool uIsApplyingForce;
+
+shared float tilePopulations[9][tileNodeCount];
+shared bool tileWalls[tileNodeCount];
+
+int getTileIndex(ivec2 tileNode) {
+  return tileNode.y * tileSize.x + tileNode.x;
+}
+
+void loadTile(int nodeCount) {
+  // Cooperatively copy the tile and its halo (with periodic wrapping) into shared memory
+  ivec2 tileOrigin = ivec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy) - 1;
+  int invocationCount = int(gl_WorkGroupSize.x * gl_WorkGroupSize.y);
+  for (int i = int(gl_LocalInvocationIndex); i < tileNodeCount; i += invocationCount) {
+    ivec2 node = (tileOrigin + ivec2(i % tileSize.x, i / tileSize.x) + uLatticeSize) % uLatticeSize;
+    int nodeIndex = node.y * uLatticeSize.x + node.x;
+    for (int q = 0; q < 9; q++) {
+      tilePopulations[q][i] = populations[q * nodeCount + nodeIndex];
+    }
+    tileWalls[i] = int(texelFetch(uNodeIds, node, 0).x + 0.5) == 1;
+  }
+  barrier();
+}
+
+void main(void) {
+  int nodeCount = uLatticeSize.x * uLatticeSize.y;
+  loadTile(nodeCount);
+
+  ivec2 node = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(node, uLatticeSize))) {
+    return;
+  }
+  int nodeIndex = node.y * uLatticeSize.x + node.x;
+  ivec2 tileNode = ivec2(gl_LocalInvocationID.xy) + 1;
+  int tileIndex = getTileIndex(tileNode);
+
+  // Stream (pull), bouncing back from walls
+  // Diagonal links are blocked if any of the three nodes they pass are walls
+  float dist[9];
+  for (int i = 0; i < 9; i++) {
+    ivec2 c = velocities[i];
+    bool isBlocked = tileWalls[getTileIndex(tileNode - c)] ||
+                     tileWalls[getTileIndex(tileNode - ivec2(c.x, 0))] ||
+                     tileWalls[getTileIndex(tileNode - ivec2(0, c.y))];
+    dist[i] = (isBlocked && i > 0) ? tilePopulations[opposite[i]][tileIndex] : tilePopulations[i][getTileIndex(tileNode - c)];
+  }
+
+  // Calculate macroscopic density and velocity
+  vec2 velocity = vec2(0.);
+  vec2 forceDensity = vec2(0.);
+  float density = 0.;
+  bool isWall = tileWalls[tileIndex];
+  if (!isWall) {
+    float distSum = 0.;
+    vec2 momentum = vec2(0.);
+    for (int i = 0; i < 9; i++) {
+      distSum += dist[i];
+      momentum += dist[i] * vec2(velocities[i]);
+    }
+    density = max(-1., -uInitDensity + distSum);
+    velocity = momentum / (uInitDensity + density);
+
+    // Ensure velocity is subsonic
+    float velocityMag = length(velocity);
+    if (velocityMag > uSpeedOfSound) {
+      velocity = velocity * (uSpeedOfSound / velocityMag);
+    }
+
+    // Update force density
+    vec2 UV = (vec2(node) + 0.5) / vec2(uLatticeSize);
+    float distanceFromCursor = length((uAspect * uCursorPos) - (uAspect * UV));
+    if (uIsApplyingForce && distanceFromCursor <= uToolSize) {
+      float coeff = forceStrength * (1. - distanceFromCursor / uToolSize);
+      forceDensity = coeff * clamp(uCursorVel, -forceLimit, forceLimit);
+    }
+    forceDensity += uBodyForce;
+
+    // Perform TRT collision
+    float nodalDensity = uInitDensity + density;
+    vec2 nodalVelPlus = velocity + (forceDensity / (uPlusOmega * nodalDensity));
+    vec2 nodalVelMinus = velocity + (forceDensity / (uMinusOmega * nodalDensity));
+    float nodalVelPlusMagSquared = dot(nodalVelPlus, nodalVelPlus);
+    float postCollisionDist[9];
+    for (int i = 0; i < 9; i++) {
+      float cuPlus = dot(vec2(velocities[i]), nodalVelPlus);
+      float cuMinus = dot(vec2(velocities[i]), nodalVelMinus);
+      float plusEqDistFunc = weights[i] * nodalDensity * (1. + 4.5 * cuPlus * cuPlus - 1.5 * nodalVelPlusMagSquared);
+      float minusEqDistFunc = weights[i] * nodalDensity * 3. * cuMinus;
+      float plusDistFunc = 0.5 * (dist[i] + dist[opposite[i]]);
+      float minusDistFunc = 0.5 * (dist[i] - dist[opposite[i]]);
+      postCollisionDist[i] = max(0., dist[i] - uPlusOmega * (plusDistFunc - plusEqDistFunc) - uMinusOmega * (minusDistFunc - minusEqDistFunc));
+    }
+    dist = postCollisionDist;
+  }
+
+  // Wall nodes keep their streamed distributions so that removed walls rejoin the flow smoothly
+  for (int i = 0; i < 9; i++) {
+    updatedPopulations[i * nodeCount + nodeIndex] = dist[i];
+  }
+  imageStore(uUpdatedFluidData[0], node, vec4(velocity, forceDensity));
+  imageStore(uUpdatedFluidData[1], node, vec4(density, 0., 0., 0.));
+}
@@ -0,0 +1,130 @@
+#version 430 core
+// Performs fused fluid streaming and TRT collision in place on a single storage buffer (AA pattern)
+// Even steps only touch their own node and store the post-collision distributions in opposite slots,
+// odd steps pull from and push to the neighbouring nodes, which restores the natural layout
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+const float weights[9] = float[9](4. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 36., 1. / 36., 1. / 36., 1. / 36.);
+const ivec2 velocities[9] = ivec2[9](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(-1, 0), ivec2(0, -1),
+                                     ivec2(1, 1), ivec2(-1, 1), ivec2(-1, -1), ivec2(1, -1));
+const int opposite[9] = int[9](0, 3, 4, 1, 2, 7, 8, 5, 6);
+const float forceLimit = 0.01;
+const float forceStrength = 5.;
+
+layout(std430) buffer Populations {
+  float populations[];
+};
+
+layout(rgba32f) uniform writeonly image2D uUpdatedFluidData[2];
+uniform sampler2D uNodeIds;
+uniform ivec2 uLatticeSize;
+uniform vec2 uCursorPos;
+uniform vec2 uCursorVel;
+uniform vec2 uBodyForce;
+uniform vec2 uAspect;
+uniform float uToolSize;
+uniform float uInitDensity;
+uniform float uSpeedOfSound;
+uniform float uPlusOmega;
+uniform float uMinusOmega;
+uniform bool uIsApplyingForce;
+uniform bool uIsOddStep;
+
+ivec2 wrap(ivec2 node) {
+  return (node + uLatticeSize) % uLatticeSize;
+}
+
+bool isWallAt(ivec2 node) {
+  return int(texelFetch(uNodeIds, wrap(node), 0).x + 0.5) == 1;
+}
+
+int getSlotIndex(ivec2 node, int i) {
+  node = wrap(node);
+  return i * uLatticeSize.x * uLatticeSize.y + node.y * uLatticeSize.x + node.x;
+}
+
+void main(void) {
+  ivec2 node = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(node, uLatticeSize))) {
+    return;
+  }
+
+  // Determine which links are blocked by walls
+  // A link is blocked if either end, or for diagonal links either of the two nodes it passes, is a wall.
+  // This rule is symmetric, so every slot is read and written by exactly one node during an odd step
+  bool isWall = isWallAt(node);
+  bool isBlocked[9];
+  for (int i = 0; i < 9; i++) {
+    ivec2 c = velocities[i];
+    isBlocked[i] = i > 0 && (isWall || isWallAt(node - c) || isWallAt(node - ivec2(c.x, 0)) || isWallAt(node - ivec2(0, c.y)));
+  }
+
+  // Stream (pull), bouncing back from walls
+  float dist[9];
+  for (int i = 0; i < 9; i++) {
+    if (!uIsOddStep || isBlocked[i]) {
+      dist[i] = populations[getSlotIndex(node, i)];
+    } else {
+      dist[i] = populations[getSlotIndex(node - velocities[i], opposite[i])];
+    }
+  }
+
+  // Calculate macroscopic density and velocity
+  vec2 velocity = vec2(0.);
+  vec2 forceDensity = vec2(0.);
+  float density = 0.;
+  if (!isWall) {
+    float distSum = 0.;
+    vec2 momentum = vec2(0.);
+    for (int i = 0; i < 9; i++) {
+      distSum += dist[i];
+      momentum += dist[i] * vec2(velocities[i]);
+    }
+    density = max(-1., -uInitDensity + distSum);
+    velocity = momentum / (uInitDensity + density);
+
+    // Ensure velocity is subsonic
+    float velocityMag = length(velocity);
+    if (velocityMag > uSpeedOfSound) {
+      velocity = velocity * (uSpeedOfSound / velocityMag);
+    }
+
+    // Update force density
+    vec2 UV = (vec2(node) + 0.5) / vec2(uLatticeSize);
+    float distanceFromCursor = length((uAspect * uCursorPos) - (uAspect * UV));
+    if (uIsApplyingForce && distanceFromCursor <= uToolSize) {
+      float coeff = forceStrength * (1. - distanceFromCursor / uToolSize);
+      forceDensity = coeff * clamp(uCursorVel, -forceLimit, forceLimit);
+    }
+    forceDensity += uBodyForce;
+
+    // Perform TRT collision
+    float nodalDensity = uInitDensity + density;
+    vec2 nodalVelPlus = velocity + (forceDensity / (uPlusOmega * nodalDensity));
+    vec2 nodalVelMinus = velocity + (forceDensity / (uMinusOmega * nodalDensity));
+    float nodalVelPlusMagSquared = dot(nodalVelPlus, nodalVelPlus);
+    float postCollisionDist[9];
+    for (int i = 0; i < 9; i++) {
+      float cuPlus = dot(vec2(velocities[i]), nodalVelPlus);
+      float cuMinus = dot(vec2(velocities[i]), nodalVelMinus);
+      float plusEqDistFunc = weights[i] * nodalDensity * (1. + 4.5 * cuPlus * cuPlus - 1.5 * nodalVelPlusMagSquared);
+      float minusEqDistFunc = weights[i] * nodalDensity * 3. * cuMinus;
+      float plusDistFunc = 0.5 * (dist[i] + dist[opposite[i]]);
+      float minusDistFunc = 0.5 * (dist[i] - dist[opposite[i]]);
+      postCollisionDist[i] = max(0., dist[i] - uPlusOmega * (plusDistFunc - plusEqDistFunc) - uMinusOmega * (minusDistFunc - minusEqDistFunc));
+    }
+    dist = postCollisionDist;
+  }
+
+  // Store into the slots that were read, wall nodes keep their streamed distributions
+  for (int i = 0; i < 9; i++) {
+    if (!uIsOddStep || isBlocked[opposite[i]]) {
+      populations[getSlotIndex(node, opposite[i])] = dist[i];
+    } else {
+      populations[getSlotIndex(node + velocities[i], i)] = dist[i];
+    }
+  }
+  imageStore(uUpdatedFluidData[0], node, vec4(velocity, forceDensity));
+  imageStore(uUpdatedFluidData[1], node, vec4(density, 0., 0., 0.));
+}
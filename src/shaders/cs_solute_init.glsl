@@ -0,0 +1,66 @@
+#version 430 core
+// Initialises macroscopic solute concentration and the equilibrium distributions in storage buffers
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+const float weights[9] = float[9](4. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 36., 1. / 36., 1. / 36., 1. / 36.);
+const vec2 velocities[9] = vec2[9](vec2(0., 0.), vec2(1., 0.), vec2(0., 1.), vec2(-1., 0.), vec2(0., -1.),
+                                   vec2(1., 1.), vec2(-1., 1.), vec2(-1., -1.), vec2(1., -1.));
+const int opposite[9] = int[9](0, 3, 4, 1, 2, 7, 8, 5, 6);
+
+layout(std430) readonly buffer Populations {
+  float populations[];
+};
+
+layout(std430) writeonly buffer UpdatedPopulations {
+  float updatedPopulations[];
+};
+
+layout(rgba32f) uniform image2D uUpdatedSoluteData; // The concentration may hold a preset field
+uniform sampler2D uNodeIds;
+uniform sampler2D uPreviousNodeIds;
+uniform bool uIsChangedOnly; // Keep the nodes whose ID did not change as they are
+uniform sampler2D uFluidData[2];
+uniform ivec2 uLatticeSize;
+uniform bool uIsLayoutSwapped;
+uniform float uInitDensity;
+uniform float uTau;
+
+void main(void) {
+  ivec2 node = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(node, uLatticeSize))) {
+    return;
+  }
+  int nodeCount = uLatticeSize.x * uLatticeSize.y;
+  int nodeIndex = node.y * uLatticeSize.x + node.x;
+  int nodeId = int(texelFetch(uNodeIds, node, 0).x + 0.5);
+  if (uIsChangedOnly && nodeId == int(texelFetch(uPreviousNodeIds, node, 0).x + 0.5)) {
+    for (int i = 0; i < 9; i++) {
+      updatedPopulations[i * nodeCount + nodeIndex] = populations[i * nodeCount + nodeIndex];
+    }
+    return;
+  }
+
+  // Unpack required fluid data
+  vec4 fluidData0 = texelFetch(uFluidData[0], node, 0);
+  vec2 velocity = fluidData0.xy;
+  vec2 forceDensity = fluidData0.zw;
+  float density = texelFetch(uFluidData[1], node, 0).x;
+
+  // Set initial macroscopic solute concentration from the preset field, walls hold no solute
+  float isFluid = (nodeId == 0) ? 1. : 0.;
+  float concentration = isFluid * imageLoad(uUpdatedSoluteData, node).x;
+
+  // Calculate equilibrium distributions
+  float nodalDensity = uInitDensity + density;
+  vec2 nodalVel = velocity + (uTau / nodalDensity) * forceDensity;
+  float nodalVelMagSquared = dot(nodalVel, nodalVel);
+  for (int i = 0; i < 9; i++) {
+    float cu = dot(velocities[i], nodalVel);
+    // In-place streaming expects the distributions in opposite slots after an even step
+    int slot = uIsLayoutSwapped ? opposite[i] : i;
+    updatedPopulations[slot * nodeCount + nodeIndex] = weights[i] * concentration * (1. + 3. * cu + 4.5 * cu * cu - 1.5 * nodalVelMagSquared);
+  }
+
+  imageStore(uUpdatedSoluteData, node, vec4(concentration, 0., 0., 0.));
+}
@@ -0,0 +1,159 @@
+#version 430 core
+// Performs fused streaming and TRT collision for all solutes on storage buffers
+// Each work group stages its tile plus a one-node halo in shared memory before streaming
+
+layout(local_size_x = 16, local_size_y = 8) in;
+
+const float weights[9] = float[9](4. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 36., 1. / 36., 1. / 36., 1. / 36.);
+const ivec2 velocities[9] = ivec2[9](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(-1, 0), ivec2(0, -1),
+                                     ivec2(1, 1), ivec2(-1, 1), ivec2(-1, -1), ivec2(1, -1));
+const int opposite[9] = int[9](0, 3, 4, 1, 2, 7, 8, 5, 6);
+const float concentrationSourceStrength = 0.1;
+
+const int soluteCount = 3;
+const ivec2 tileSize = ivec2(gl_WorkGroupSize.xy) + 2;
+const int tileNodeCount = tileSize.x * tileSize.y;
+
+layout(std430) readonly buffer SolutePopulations {
+  float populations[];
+} solutePopulations[soluteCount];
+
+layout(std430) writeonly buffer UpdatedSolutePopulations {
+  float populations[];
+} updatedSolutePopulations[soluteCount];
+
+layout(rgba32f) uniform writeonly image2D uUpdatedSoluteData[soluteCount];
+uniform sampler2D uNodeIds;
+uniform sampler2D uFluidData[2];
+uniform ivec2 uLatticeSize;
+uniform vec2 uCursorPos;
+uniform vec2 uAspect;
+uniform float uToolSize;
+uniform float uInitDensity;
+uniform float uInitConcentration;
+uniform float uConcentrationSourcePolarity[soluteCount];
+uniform float uPlusOmega[soluteCount];
+uniform float uMinusOmega[soluteCount];
+uniform float uOneMinusInvTwoTau[soluteCount];
+uniform float uMolMassTimesCoeff[soluteCount];
+uniform float uReactionRate;
+uniform int uStoichiometricCoeffs[soluteCount];
+
+shared float tilePopulations[soluteCount * 9][tileNodeCount];
+shared bool tileWalls[tileNodeCount];
+
+int getTileIndex(ivec2 tileNode) {
+  return tileNode.y * tileSize.x + tileNode.x;
+}
+
+void loadTile(int nodeCount) {
+  // Cooperatively copy the tile and its halo (with periodic wrapping) into shared memory
+  ivec2 tileOrigin = ivec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy) - 1;
+  int invocationCount = int(gl_WorkGroupSize.x * gl_WorkGroupSize.y);
+  for (int i = int(gl_LocalInvocationIndex); i < tileNodeCount; i += invocationCount) {
+    ivec2 node = (tileOrigin + ivec2(i % tileSize.x, i / tileSize.x) + uLatticeSize) % uLatticeSize;
+    int nodeIndex = node.y * uLatticeSize.x + node.x;
+    for (int s = 0; s < soluteCount; s++) {
+      for (int q = 0; q < 9; q++) {
+        tilePopulations[s * 9 + q][i] = solutePopulations[s].populations[q * nodeCount + nodeIndex];
+      }
+    }
+    tileWalls[i] = int(texelFetch(uNodeIds, node, 0).x + 0.5) == 1;
+  }
+  barrier();
+}
+
+void main(void) {
+  int nodeCount = uLatticeSize.x * uLatticeSize.y;
+  loadTile(nodeCount);
+
+  ivec2 node = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(node, uLatticeSize))) {
+    return;
+  }
+  int nodeIndex = node.y * uLatticeSize.x + node.x;
+  ivec2 tileNode = ivec2(gl_LocalInvocationID.xy) + 1;
+  int tileIndex = getTileIndex(tileNode);
+  bool isWall = tileWalls[tileIndex];
+
+  // Determine which links are blocked by walls
+  // Diagonal links are blocked if any of the three nodes they pass are walls
+  bool isBlocked[9];
+  for (int i = 0; i < 9; i++) {
+    ivec2 c = velocities[i];
+    isBlocked[i] = i > 0 && (tileWalls[getTileIndex(tileNode - c)] ||
+                             tileWalls[getTileIndex(tileNode - ivec2(c.x, 0))] ||
+                             tileWalls[getTileIndex(tileNode - ivec2(0, c.y))]);
+  }
+
+  // Unpack required fluid data (shared by all solutes)
+  vec4 fluidData0 = texelFetch(uFluidData[0], node, 0);
+  vec2 velocity = fluidData0.xy;
+  vec2 forceDensity = fluidData0.zw;
+  float density = texelFetch(uFluidData[1], node, 0).x;
+  float nodalDensity = uInitDensity + density;
+
+  // Stream (pull) all solutes, bouncing back from walls
+  float dist[soluteCount][9];
+  for (int s = 0; s < soluteCount; s++) {
+    for (int i = 0; i < 9; i++) {
+      dist[s][i] = isBlocked[i] ? tilePopulations[s * 9 + opposite[i]][tileIndex]
+                                : tilePopulations[s * 9 + i][getTileIndex(tileNode - velocities[i])];
+    }
+  }
+
+  // Calculate macroscopic concentrations
+  float concentrations[soluteCount];
+  for (int s = 0; s < soluteCount; s++) {
+    float distSum = 0.;
+    for (int i = 0; i < 9; i++) {
+      distSum += dist[s][i];
+    }
+    concentrations[s] = isWall ? 0. : max(-1., -uInitConcentration + distSum);
+  }
+
+  // Calculate reaction rate from the current concentrations of all reactants
+  float nodalReactionRate = uReactionRate;
+  for (int s = 0; s < soluteCount; s++) {
+    nodalReactionRate *= (uStoichiometricCoeffs[s] < 0) ? concentrations[s] : 1.;
+  }
+
+  // Tool contribution to the concentration source
+  vec2 UV = (vec2(node) + 0.5) / vec2(uLatticeSize);
+  float distanceFromCursor = length((uAspect * uCursorPos) - (uAspect * UV));
+  float isWithinTool = (distanceFromCursor < uToolSize) ? 1. : 0.;
+  float toolStrength = concentrationSourceStrength * (1.0 - distanceFromCursor / uToolSize);
+
+  for (int s = 0; s < soluteCount; s++) {
+    float concentration = concentrations[s];
+    float concentrationSource = 0.;
+    if (!isWall) {
+      // Update concentration source
+      concentrationSource = uMolMassTimesCoeff[s] * nodalReactionRate + uConcentrationSourcePolarity[s] * isWithinTool * toolStrength;
+
+      // Perform TRT collision
+      float nodalConcentration = uInitConcentration + concentration;
+      vec2 nodalVelPlus = velocity + (forceDensity / (uPlusOmega[s] * nodalDensity));
+      vec2 nodalVelMinus = velocity + (forceDensity / (uMinusOmega[s] * nodalDensity));
+      float nodalVelPlusMagSquared = dot(nodalVelPlus, nodalVelPlus);
+      float postCollisionDist[9];
+      for (int i = 0; i < 9; i++) {
+        float cuPlus = dot(vec2(velocities[i]), nodalVelPlus);
+        float cuMinus = dot(vec2(velocities[i]), nodalVelMinus);
+        float plusEqDistFunc = weights[i] * nodalConcentration * (1. + 4.5 * cuPlus * cuPlus - 1.5 * nodalVelPlusMagSquared);
+        float minusEqDistFunc = weights[i] * nodalConcentration * 3. * cuMinus;
+        float plusDistFunc = 0.5 * (dist[s][i] + dist[s][opposite[i]]);
+        float minusDistFunc = 0.5 * (dist[s][i] - dist[s][opposite[i]]);
+        float nodalConcentrationSource = uOneMinusInvTwoTau[s] * concentrationSource * weights[i];
+        postCollisionDist[i] = max(0., dist[s][i] - uPlusOmega[s] * (plusDistFunc - plusEqDistFunc) - uMinusOmega[s] * (minusDistFunc - minusEqDistFunc) + nodalConcentrationSource);
+      }
+      dist[s] = postCollisionDist;
+    }
+
+    // Wall nodes keep their streamed distributions so that removed walls rejoin the flow smoothly
+    for (int i = 0; i < 9; i++) {
+      updatedSolutePopulations[s].populations[i * nodeCount + nodeIndex] = dist[s][i];
+    }
+    imageStore(uUpdatedSoluteData[s], node, vec4(concentration, concentrationSource, 0., 0.));
+  }
+}
@@ -0,0 +1,144 @@
+#version 430 core
+// Performs fused streaming and TRT collision for all solutes in place on single storage buffers (AA pattern)
+// Even steps only touch their own node and store the post-collision distributions in opposite slots,
+// odd steps pull from and push to the neighbouring nodes, which restores the natural layout
+
+layout(local_size_x = 16, local_size_y = 8) in;
+
+const float weights[9] = float[9](4. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 36., 1. / 36., 1. / 36., 1. / 36.);
+const ivec2 velocities[9] = ivec2[9](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(-1, 0), ivec2(0, -1),
+                                     ivec2(1, 1), ivec2(-1, 1), ivec2(-1, -1), ivec2(1, -1));
+const int opposite[9] = int[9](0, 3, 4, 1, 2, 7, 8, 5, 6);
+const float concentrationSourceStrength = 0.1;
+
+const int soluteCount = 3;
+
+layout(std430) buffer SolutePopulations {
+  float populations[];
+} solutePopulations[soluteCount];
+
+layout(rgba32f) uniform writeonly image2D uUpdatedSoluteData[soluteCount];
+uniform sampler2D uNodeIds;
+uniform sampler2D uFluidData[2];
+uniform ivec2 uLatticeSize;
+uniform vec2 uCursorPos;
+uniform vec2 uAspect;
+uniform float uToolSize;
+uniform float uInitDensity;
+uniform float uInitConcentration;
+uniform float uConcentrationSourcePolarity[soluteCount];
+uniform float uPlusOmega[soluteCount];
+uniform float uMinusOmega[soluteCount];
+uniform float uOneMinusInvTwoTau[soluteCount];
+uniform float uMolMassTimesCoeff[soluteCount];
+uniform float uReactionRate;
+uniform int uStoichiometricCoeffs[soluteCount];
+uniform bool uIsOddStep;
+
+ivec2 wrap(ivec2 node) {
+  return (node + uLatticeSize) % uLatticeSize;
+}
+
+bool isWallAt(ivec2 node) {
+  return int(texelFetch(uNodeIds, wrap(node), 0).x + 0.5) == 1;
+}
+
+int getSlotIndex(ivec2 node, int i) {
+  node = wrap(node);
+  return i * uLatticeSize.x * uLatticeSize.y + node.y * uLatticeSize.x + node.x;
+}
+
+void main(void) {
+  ivec2 node = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(node, uLatticeSize))) {
+    return;
+  }
+
+  // Determine which links are blocked by walls
+  // A link is blocked if either end, or for diagonal links either of the two nodes it passes, is a wall.
+  // This rule is symmetric, so every slot is read and written by exactly one node during an odd step
+  bool isWall = isWallAt(node);
+  bool isBlocked[9];
+  for (int i = 0; i < 9; i++) {
+    ivec2 c = velocities[i];
+    isBlocked[i] = i > 0 && (isWall || isWallAt(node - c) || isWallAt(node - ivec2(c.x, 0)) || isWallAt(node - ivec2(0, c.y)));
+  }
+
+  // Precompute the slots to read from and write to, these are shared by all solutes
+  int readSlots[9];
+  int writeSlots[9];
+  for (int i = 0; i < 9; i++) {
+    readSlots[i] = (!uIsOddStep || isBlocked[i]) ? getSlotIndex(node, i) : getSlotIndex(node - velocities[i], opposite[i]);
+    writeSlots[i] = (!uIsOddStep || isBlocked[opposite[i]]) ? getSlotIndex(node, opposite[i]) : getSlotIndex(node + velocities[i], i);
+  }
+
+  // Unpack required fluid data (shared by all solutes)
+  vec4 fluidData0 = texelFetch(uFluidData[0], node, 0);
+  vec2 velocity = fluidData0.xy;
+  vec2 forceDensity = fluidData0.zw;
+  float density = texelFetch(uFluidData[1], node, 0).x;
+  float nodalDensity = uInitDensity + density;
+
+  // Stream (pull) all solutes, bouncing back from walls
+  float dist[soluteCount][9];
+  for (int s = 0; s < soluteCount; s++) {
+    for (int i = 0; i < 9; i++) {
+      dist[s][i] = solutePopulations[s].populations[readSlots[i]];
+    }
+  }
+
+  // Calculate macroscopic concentrations
+  float concentrations[soluteCount];
+  for (int s = 0; s < soluteCount; s++) {
+    float distSum = 0.;
+    for (int i = 0; i < 9; i++) {
+      distSum += dist[s][i];
+    }
+    concentrations[s] = isWall ? 0. : max(-1., -uInitConcentration + distSum);
+  }
+
+  // Calculate reaction rate from the current concentrations of all reactants
+  float nodalReactionRate = uReactionRate;
+  for (int s = 0; s < soluteCount; s++) {
+    nodalReactionRate *= (uStoichiometricCoeffs[s] < 0) ? concentrations[s] : 1.;
+  }
+
+  // Tool contribution to the concentration source
+  vec2 UV = (vec2(node) + 0.5) / vec2(uLatticeSize);
+  float distanceFromCursor = length((uAspect * uCursorPos) - (uAspect * UV));
+  float isWithinTool = (distanceFromCursor < uToolSize) ? 1. : 0.;
+  float toolStrength = concentrationSourceStrength * (1.0 - distanceFromCursor / uToolSize);
+
+  for (int s = 0; s < soluteCount; s++) {
+    float concentration = concentrations[s];
+    float concentrationSource = 0.;
+    if (!isWall) {
+      // Update concentration source
+      concentrationSource = uMolMassTimesCoeff[s] * nodalReactionRate + uConcentrationSourcePolarity[s] * isWithinTool * toolStrength;
+
+      // Perform TRT collision
+      float nodalConcentration = uInitConcentration + concentration;
+      vec2 nodalVelPlus = velocity + (forceDensity / (uPlusOmega[s] * nodalDensity));
+      vec2 nodalVelMinus = velocity + (forceDensity / (uMinusOmega[s] * nodalDensity));
+      float nodalVelPlusMagSquared = dot(nodalVelPlus, nodalVelPlus);
+      float postCollisionDist[9];
+      for (int i = 0; i < 9; i++) {
+        float cuPlus = dot(vec2(velocities[i]), nodalVelPlus);
+        float cuMinus = dot(vec2(velocities[i]), nodalVelMinus);
+        float plusEqDistFunc = weights[i] * nodalConcentration * (1. + 4.5 * cuPlus * cuPlus - 1.5 * nodalVelPlusMagSquared);
+        float minusEqDistFunc = weights[i] * nodalConcentration * 3. * cuMinus;
+        float plusDistFunc = 0.5 * (dist[s][i] + dist[s][opposite[i]]);
+        float minusDistFunc = 0.5 * (dist[s][i] - dist[s][opposite[i]]);
+        float nodalConcentrationSource = uOneMinusInvTwoTau[s] * concentrationSource * weights[i];
+        postCollisionDist[i] = max(0., dist[s][i] - uPlusOmega[s] * (plusDistFunc - plusEqDistFunc) - uMinusOmega[s] * (minusDistFunc - minusEqDistFunc) + nodalConcentrationSource);
+      }
+      dist[s] = postCollisionDist;
+    }
+
+    // Store into the slots that were read, wall nodes keep their streamed distributions
+    for (int i = 0; i < 9; i++) {
+      solutePopulations[s].populations[writeSlots[i]] = dist[s][i];
+    }
+    imageStore(uUpdatedSoluteData[s], node, vec4(concentration, concentrationSource, 0., 0.));
+  }
+}
@@ -0,0 +1,30 @@
+#version 430 core
+// Gathers one tile of a storage buffer of population planes into a packed buffer, as the rows of each plane in turn
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(std430) readonly buffer Source {
+  float source[];
+};
+
+layout(std430) writeonly buffer Packed {
+  float packedValues[];
+};
+
+uniform ivec2 uLatticeSize;
+uniform ivec2 uTileOrigin;
+uniform ivec2 uTileSize;
+uniform int uPackedOffset; // Floats
+
+void main(void) {
+  ivec2 tileNode = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(tileNode, uTileSize))) {
+    return;
+  }
+  int plane = int(gl_GlobalInvocationID.z);
+  ivec2 node = uTileOrigin + tileNode;
+  int nodeCount = uLatticeSize.x * uLatticeSize.y;
+  int tileNodeCount = uTileSize.x * uTileSize.y;
+  packedValues[uPackedOffset + plane * tileNodeCount + tileNode.y * uTileSize.x + tileNode.x] =
+    source[plane * nodeCount + node.y * uLatticeSize.x + node.x];
+}
@@ -0,0 +1,10 @@
+#version 330 core
+// Copies one RGBA32F texel per fragment, used to measure the attainable memory bandwidth
+
+uniform sampler2D uSource;
+
+out vec4 copiedData;
+
+void main(void) {
+  copiedData = texelFetch(uSource, ivec2(gl_FragCoord.xy), 0);
+}
@@ -0,0 +1,33 @@
+#version 330 core
+// Reduces the change of the macroscopic fields since their auto-checkpoint reference into the first change level,
+// keeping the largest absolute change per block
+
+precision highp float;
+precision highp sampler2D;
+
+uniform sampler2D uNodeIds;
+uniform sampler2D uFluidData[2];
+uniform sampler2D uSoluteData[3];
+uniform sampler2D uReference[2];
+uniform int uReductionFactor;
+
+out vec4 change;
+
+void main(void) {
+  ivec2 latticeSize = textureSize(uNodeIds, 0);
+  ivec2 origin = ivec2(gl_FragCoord.xy) * uReductionFactor;
+  float maxChange = 0.;
+  for (int y = 0; y < uReductionFactor; y++) {
+    for (int x = 0; x < uReductionFactor; x++) {
+      ivec2 node = min(origin + ivec2(x, y), latticeSize - 1);
+      vec4 fields0 = vec4(texelFetch(uFluidData[0], node, 0).xy, texelFetch(uFluidData[1], node, 0).x, texelFetch(uNodeIds, node, 0).x);
+      vec4 fields1 = vec4(texelFetch(uSoluteData[0], node, 0).x, texelFetch(uSoluteData[1], node, 0).x,
+                          texelFetch(uSoluteData[2], node, 0).x, 0.);
+      vec4 change0 = abs(fields0 - texelFetch(uReference[0], node, 0));
+      vec4 change1 = abs(fields1 - texelFetch(uReference[1], node, 0));
+      vec4 maxChanges = max(change0, change1);
+      maxChange = max(maxChange, max(max(maxChanges.x, maxChanges.y), max(maxChanges.z, maxChanges.w)));
+    }
+  }
+  change = vec4(maxChange);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+// Copies the macroscopic fields of the checkpointed tiles into the auto-checkpoint reference
+
+precision highp float;
+precision highp sampler2D;
+
+uniform sampler2D uNodeIds;
+uniform sampler2D uFluidData[2];
+uniform sampler2D uSoluteData[3];
+
+layout(location = 0) out vec4 reference0;
+layout(location = 1) out vec4 reference1;
+
+void main(void) {
+  ivec2 node = ivec2(gl_FragCoord.xy);
+  reference0 = vec4(texelFetch(uFluidData[0], node, 0).xy, texelFetch(uFluidData[1], node, 0).x, texelFetch(uNodeIds, node, 0).x);
+  reference1 = vec4(texelFetch(uSoluteData[0], node, 0).x, texelFetch(uSoluteData[1], node, 0).x,
+                    texelFetch(uSoluteData[2], node, 0).x, 0.);
+}
@@ -0,0 +1,32 @@
+#version 330 core
+// Samples the macroscopic fields at every stride-th node of a region of the lattice, one field per output
+
+precision highp float;
+precision highp sampler2D;
+
+uniform sampler2D uNodeIds;
+uniform sampler2D uFluidData[2];
+uniform sampler2D uSoluteData[3];
+uniform ivec2 uOrigin;
+uniform int uStride;
+uniform float uInitDensity;
+uniform float uInitConcentration;
+
+layout(location = 0) out vec4 velocity;
+layout(location = 1) out vec4 density;
+layout(location = 2) out vec4 nodeId;
+layout(location = 3) out vec4 concentration1;
+layout(location = 4) out vec4 concentration2;
+layout(location = 5) out vec4 concentration3;
+
+void main(void) {
+  ivec2 node = min(uOrigin + ivec2(gl_FragCoord.xy) * uStride, textureSize(uNodeIds, 0) - 1);
+
+  // Densities and concentrations are stored as deviations from their initial values
+  velocity = vec4(texelFetch(uFluidData[0], node, 0).xy, 0., 0.);
+  density = vec4(uInitDensity + texelFetch(uFluidData[1], node, 0).x);
+  nodeId = vec4(texelFetch(uNodeIds, node, 0).x);
+  concentration1 = vec4(uInitConcentration + texelFetch(uSoluteData[0], node, 0).x);
+  concentration2 = vec4(uInitConcentration + texelFetch(uSoluteData[1], node, 0).x);
+  concentration3 = vec4(uInitConcentration + texelFetch(uSoluteData[2], node, 0).x);
+}
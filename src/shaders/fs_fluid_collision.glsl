@@ -14,6 +14,7 @@ uniform sampler2D uNodeIds;
 uniform sampler2D uFluidData[4];
 uniform vec2 uCursorPos;
 uniform vec2 uCursorVel;
+uniform vec2 uBodyForce;
 uniform vec2 uAspect;
 uniform float uToolSize;
 uniform float uInitDensity;
@@ -57,6 +58,7 @@ void main(void) {
   } else {
     forceDensity = vec2(0.);
   }
+  forceDensity += (nodeId == 0) ? uBodyForce : vec2(0.);
 
   // Perform TRT collision
   // Precalculate factors
@@ -9,7 +9,9 @@ const float prefactor1_4 = 1. / 18.;
 const float prefactor5_8 = 1. / 72.;
 
 uniform sampler2D uNodeIds;
+uniform sampler2D uPreviousNodeIds;
 uniform sampler2D uFluidData[4];
+uniform bool uIsChangedOnly; // Keep the nodes whose ID did not change as they are
 uniform vec2 uInitVelocity;
 uniform float uInitDensity;
 uniform float uTau;
@@ -22,13 +24,22 @@ layout(location = 2) out vec4 updatedFluidData2;
 layout(location = 3) out vec4 updatedFluidData3;
 
 void main(void) {
-  // Unpack required fluid data
+  int nodeId = int(texture(uNodeIds, UV).x + 0.5);
+  if (uIsChangedOnly && nodeId == int(texture(uPreviousNodeIds, UV).x + 0.5)) {
+    updatedFluidData0 = texture(uFluidData[0], UV);
+    updatedFluidData1 = texture(uFluidData[1], UV);
+    updatedFluidData2 = texture(uFluidData[2], UV);
+    updatedFluidData3 = texture(uFluidData[3], UV);
+    return;
+  }
+
+  // Unpack required fluid data, the velocity may hold a preset field
+  vec2 presetVelocity = texture(uFluidData[0], UV).xy;
   vec2 forceDensity = texture(uFluidData[0], UV).zw;
   float density =  texture(uFluidData[1], UV).x;
 
   // Set initial macroscopic velocity and density
-  int nodeId = int(texture(uNodeIds, UV).x + 0.5);
-  vec2 velocity = (nodeId == 0) ? uInitVelocity : vec2(0.);
+  vec2 velocity = (nodeId == 0) ? uInitVelocity + presetVelocity : vec2(0.);
 
   // Calculate equilibrium distributions
   // TODO: Pre-compute repeated factors
@@ -37,19 +48,19 @@ void main(void) {
   float nodalVelMagSquared = dot(nodalVel, nodalVel);
 
   // Rest component
-  float dist0 = prefactor0 * density * (2. - 3. * nodalVelMagSquared);
+  float dist0 = prefactor0 * nodalDensity * (2. - 3. * nodalVelMagSquared);
 
   // Main cartesian components
-  float dist1 = prefactor1_4 * density * (2. + 6. * nodalVel.x + 9. * nodalVel.x * nodalVel.x - 3. * nodalVelMagSquared);
-  float dist2 = prefactor1_4 * density * (2. + 6. * nodalVel.y + 9. * nodalVel.y * nodalVel.y - 3. * nodalVelMagSquared);
-  float dist3 = prefactor1_4 * density * (2. - 6. * nodalVel.x + 9. * nodalVel.x * nodalVel.x - 3. * nodalVelMagSquared);
-  float dist4 = prefactor1_4 * density * (2. - 6. * nodalVel.y + 9. * nodalVel.y * nodalVel.y - 3. * nodalVelMagSquared);
+  float dist1 = prefactor1_4 * nodalDensity * (2. + 6. * nodalVel.x + 9. * nodalVel.x * nodalVel.x - 3. * nodalVelMagSquared);
+  float dist2 = prefactor1_4 * nodalDensity * (2. + 6. * nodalVel.y + 9. * nodalVel.y * nodalVel.y - 3. * nodalVelMagSquared);
+  float dist3 = prefactor1_4 * nodalDensity * (2. - 6. * nodalVel.x + 9. * nodalVel.x * nodalVel.x - 3. * nodalVelMagSquared);
+  float dist4 = prefactor1_4 * nodalDensity * (2. - 6. * nodalVel.y + 9. * nodalVel.y * nodalVel.y - 3. * nodalVelMagSquared);
 
   // Diagonal components
-  float dist5 = prefactor5_8 * density * (2. + 6. * (nodalVel.x + nodalVel.y) + 9. * (nodalVel.x + nodalVel.y) * (nodalVel.x + nodalVel.y) - 3. * nodalVelMagSquared);
-  float dist6 = prefactor5_8 * density * (2. + 6. * (-nodalVel.x + nodalVel.y) + 9. * (-nodalVel.x + nodalVel.y) * (-nodalVel.x + nodalVel.y) - 3. * nodalVelMagSquared);
-  float dist7 = prefactor5_8 * density * (2. + 6. * (-nodalVel.x - nodalVel.y) + 9. * (-nodalVel.x - nodalVel.y) * (-nodalVel.x - nodalVel.y) - 3. * nodalVelMagSquared);
-  float dist8 = prefactor5_8 * density * (2. + 6. * (nodalVel.x - nodalVel.y) + 9. * (nodalVel.x - nodalVel.y) * (nodalVel.x - nodalVel.y) - 3. * nodalVelMagSquared);
+  float dist5 = prefactor5_8 * nodalDensity * (2. + 6. * (nodalVel.x + nodalVel.y) + 9. * (nodalVel.x + nodalVel.y) * (nodalVel.x + nodalVel.y) - 3. * nodalVelMagSquared);
+  float dist6 = prefactor5_8 * nodalDensity * (2. + 6. * (-nodalVel.x + nodalVel.y) + 9. * (-nodalVel.x + nodalVel.y) * (-nodalVel.x + nodalVel.y) - 3. * nodalVelMagSquared);
+  float dist7 = prefactor5_8 * nodalDensity * (2. + 6. * (-nodalVel.x - nodalVel.y) + 9. * (-nodalVel.x - nodalVel.y) * (-nodalVel.x - nodalVel.y) - 3. * nodalVelMagSquared);
+  float dist8 = prefactor5_8 * nodalDensity * (2. + 6. * (nodalVel.x - nodalVel.y) + 9. * (nodalVel.x - nodalVel.y) * (nodalVel.x - nodalVel.y) - 3. * nodalVelMagSquared);
 
   updatedFluidData0 = vec4(velocity, forceDensity);
   updatedFluidData1 = vec4(density, dist0, dist1, dist2);
@@ -0,0 +1,35 @@
+#version 330 core
+// Marks tiles as active if they or any neighbouring tile hold solute, or if the solute tool is adding solute to them
+
+precision mediump float;
+precision mediump sampler2D;
+
+const float occupancyThreshold = 1e-5;
+
+uniform sampler2D uOccupancy;
+uniform vec2 uTileUVSize;
+uniform vec2 uCursorPos;
+uniform vec2 uAspect;
+uniform float uToolSize;
+uniform bool uIsAddingSolute;
+
+out vec4 isActiveTile;
+
+void main(void) {
+  // Dilate by one tile (with periodic wrapping) to leave a margin for advection and diffusion
+  ivec2 tileCount = textureSize(uOccupancy, 0);
+  ivec2 tile = ivec2(gl_FragCoord.xy);
+  float maxValue = 0.;
+  for (int y = -1; y <= 1; y++) {
+    for (int x = -1; x <= 1; x++) {
+      maxValue = max(maxValue, texelFetch(uOccupancy, (tile + ivec2(x, y) + tileCount) % tileCount, 0).x);
+    }
+  }
+
+  // Check whether the tool overlaps this tile
+  vec2 tileMin = vec2(tile) * uTileUVSize;
+  vec2 closestPoint = clamp(uCursorPos, tileMin, tileMin + uTileUVSize);
+  bool isWithinTool = uIsAddingSolute && length(uAspect * (closestPoint - uCursorPos)) < uToolSize;
+
+  isActiveTile = vec4((maxValue > occupancyThreshold || isWithinTool) ? 1. : 0.);
+}
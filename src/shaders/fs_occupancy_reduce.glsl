@@ -0,0 +1,22 @@
+#version 330 core
+// Reduces an occupancy level into the next coarser one, keeping the largest value per block
+
+precision mediump float;
+precision mediump sampler2D;
+
+uniform sampler2D uOccupancy;
+uniform int uReductionFactor;
+
+out vec4 occupancy;
+
+void main(void) {
+  ivec2 levelSize = textureSize(uOccupancy, 0);
+  ivec2 origin = ivec2(gl_FragCoord.xy) * uReductionFactor;
+  float maxValue = 0.;
+  for (int y = 0; y < uReductionFactor; y++) {
+    for (int x = 0; x < uReductionFactor; x++) {
+      maxValue = max(maxValue, texelFetch(uOccupancy, min(origin + ivec2(x, y), levelSize - 1), 0).x);
+    }
+  }
+  occupancy = vec4(maxValue);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+// Reduces the solute fields into the first occupancy level, keeping the largest concentration or source per block
+
+precision mediump float;
+precision mediump sampler2D;
+
+uniform sampler2D uSoluteData[3];
+uniform int uReductionFactor;
+
+out vec4 occupancy;
+
+void main(void) {
+  ivec2 latticeSize = textureSize(uSoluteData[0], 0);
+  ivec2 origin = ivec2(gl_FragCoord.xy) * uReductionFactor;
+  float maxValue = 0.;
+  for (int y = 0; y < uReductionFactor; y++) {
+    for (int x = 0; x < uReductionFactor; x++) {
+      ivec2 node = min(origin + ivec2(x, y), latticeSize - 1);
+      vec2 soluteData0 = abs(texelFetch(uSoluteData[0], node, 0).xy);
+      vec2 soluteData1 = abs(texelFetch(uSoluteData[1], node, 0).xy);
+      vec2 soluteData2 = abs(texelFetch(uSoluteData[2], node, 0).xy);
+      maxValue = max(maxValue, max(max(soluteData0.x, soluteData0.y), max(soluteData1.x, soluteData1.y)));
+      maxValue = max(maxValue, max(soluteData2.x, soluteData2.y));
+    }
+  }
+  occupancy = vec4(maxValue);
+}
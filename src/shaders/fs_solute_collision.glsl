@@ -12,7 +12,7 @@ const float concentrationSourceStrength = 0.1;
 uniform sampler2D uNodeIds;
 uniform sampler2D uFluidData[4];
 uniform sampler2D uSoluteData[3];
-uniform sampler2D uNodalReactionRate;
+uniform sampler2D uConcentrationData[3];
 uniform vec2 uCursorPos;
 uniform vec2 uAspect;
 uniform float uToolSize;
@@ -23,6 +23,8 @@ uniform float uPlusOmega;
 uniform float uMinusOmega;
 uniform float uOneMinusInvTwoTau;
 uniform float uMolMassTimesCoeff;
+uniform float uReactionRate;
+uniform int uStoichiometricCoeffs[3];
 
 in vec2 UV;
 
@@ -52,8 +54,13 @@ void main(void) {
   vec2 forceDensity = texture(uFluidData[0], UV).zw;
   float density = texture(uFluidData[1], UV).x;
   
+  // Calculate reaction rate from the current concentrations of all reactants
+  float nodalReactionRate = uReactionRate;
+  nodalReactionRate *= (uStoichiometricCoeffs[0] < 0) ? texture(uConcentrationData[0], UV).x : 1.;
+  nodalReactionRate *= (uStoichiometricCoeffs[1] < 0) ? texture(uConcentrationData[1], UV).x : 1.;
+  nodalReactionRate *= (uStoichiometricCoeffs[2] < 0) ? texture(uConcentrationData[2], UV).x : 1.;
+
   // Update concentration source (we can disregard the nodeId here)
-  float nodalReactionRate = texture(uNodalReactionRate, UV).x;
   float distanceFromCursor = length((uAspect * uCursorPos) - (uAspect * UV));
   float isWithinTool = (distanceFromCursor < uToolSize) ? 1. : 0.;
   float toolStrength = concentrationSourceStrength * (1.0 - distanceFromCursor / uToolSize);
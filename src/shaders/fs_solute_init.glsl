@@ -9,13 +9,12 @@ const float prefactor1_4 = 1. / 18.;
 const float prefactor5_8 = 1. / 72.;
 
 uniform sampler2D uNodeIds;
+uniform sampler2D uPreviousNodeIds;
 uniform sampler2D uFluidData[4];
 uniform sampler2D uSoluteData[3];
-uniform vec2 uCenter;
-uniform vec2 uAspect;
+uniform bool uIsChangedOnly; // Keep the nodes whose ID did not change as they are
 uniform float uInitDensity;
 uniform float uTau;
-uniform float uRadius;
 
 in vec2 UV;
 
@@ -24,6 +23,14 @@ layout(location = 1) out vec4 updatedSoluteData1;
 layout(location = 2) out vec4 updatedSoluteData2;
 
 void main(void) {
+  int nodeId = int(texture(uNodeIds, UV).x + 0.5);
+  if (uIsChangedOnly && nodeId == int(texture(uPreviousNodeIds, UV).x + 0.5)) {
+    updatedSoluteData0 = texture(uSoluteData[0], UV);
+    updatedSoluteData1 = texture(uSoluteData[1], UV);
+    updatedSoluteData2 = texture(uSoluteData[2], UV);
+    return;
+  }
+
   // Unpack required fluid data
   vec2 velocity = texture(uFluidData[0], UV).xy;
   vec2 forceDensity = texture(uFluidData[0], UV).zw;
@@ -32,11 +39,9 @@ void main(void) {
   // Unpack required solute data
   float concentrationSource = texture(uSoluteData[0], UV).y;
 
-  // Set initial macroscopic solute concentration
-  float distanceFromCenter = length((uCenter - UV) * uAspect);
-  float isWithinCircle = (distanceFromCenter < uRadius) ? 1. : 0.;
-  float isFluid = (int(texture(uNodeIds, UV).x + 0.5) == 0) ? 1. : 0.;
-  float concentration = min(1., isFluid * isWithinCircle / distanceFromCenter);
+  // Set initial macroscopic solute concentration from the preset field, walls hold no solute
+  float isFluid = (nodeId == 0) ? 1. : 0.;
+  float concentration = isFluid * texture(uSoluteData[0], UV).x;
 
   // Calculate equilibrium distributions
   // TODO: Pre-compute repeated factors
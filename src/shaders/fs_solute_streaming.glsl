@@ -52,15 +52,23 @@ void main(void) {
   bool isWall_l  = int(texture(uNodeIds, UV_l).x + 0.5) == 1;
   bool isWall_tl = int(texture(uNodeIds, UV_tl).x + 0.5) == 1;
 
-  // Stream
-  dist1 = isWall_l ? dist3 : texture(uSoluteData[0], UV_l).w;
-  dist2 = isWall_b ? dist4 : texture(uSoluteData[1], UV_b).x;
-  dist3 = isWall_r ? dist1 : texture(uSoluteData[1], UV_r).y;
-  dist4 = isWall_t ? dist2 : texture(uSoluteData[1], UV_t).z; 
-  dist5 = (isWall_b || isWall_l || isWall_bl) ? dist7 : texture(uSoluteData[1], UV_bl).w;
-  dist6 = (isWall_b || isWall_r || isWall_br) ? dist8 : texture(uSoluteData[2], UV_br).x;
-  dist7 = (isWall_t || isWall_r || isWall_tr) ? dist5 : texture(uSoluteData[2], UV_tr).y;
-  dist8 = (isWall_t || isWall_l || isWall_tl) ? dist6 : texture(uSoluteData[2], UV_tl).z;
+  // Stream, walls reflect the post-collision distribution of the opposite direction
+  float reflectedDist1 = dist3;
+  float reflectedDist2 = dist4;
+  float reflectedDist3 = dist1;
+  float reflectedDist4 = dist2;
+  float reflectedDist5 = dist7;
+  float reflectedDist6 = dist8;
+  float reflectedDist7 = dist5;
+  float reflectedDist8 = dist6;
+  dist1 = isWall_l ? reflectedDist1 : texture(uSoluteData[0], UV_l).w;
+  dist2 = isWall_b ? reflectedDist2 : texture(uSoluteData[1], UV_b).x;
+  dist3 = isWall_r ? reflectedDist3 : texture(uSoluteData[1], UV_r).y;
+  dist4 = isWall_t ? reflectedDist4 : texture(uSoluteData[1], UV_t).z; 
+  dist5 = (isWall_b || isWall_l || isWall_bl) ? reflectedDist5 : texture(uSoluteData[1], UV_bl).w;
+  dist6 = (isWall_b || isWall_r || isWall_br) ? reflectedDist6 : texture(uSoluteData[2], UV_br).x;
+  dist7 = (isWall_t || isWall_r || isWall_tr) ? reflectedDist7 : texture(uSoluteData[2], UV_tr).y;
+  dist8 = (isWall_t || isWall_l || isWall_tl) ? reflectedDist8 : texture(uSoluteData[2], UV_tl).z;
 
   // Calculate macroscopic concentration
   int nodeId = int(texture(uNodeIds, UV).x + 0.5);
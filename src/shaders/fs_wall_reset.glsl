@@ -0,0 +1,21 @@
+#version 330 core
+// Resets wall nodes to rest equilibrium, as they are skipped by the stencil test during the simulation passes
+// Outputs follow the fluid data layout, a zero rest density clears any other field (e.g. solutes)
+
+precision mediump float;
+
+const float weights[9] = float[9](4. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 9., 1. / 36., 1. / 36., 1. / 36., 1. / 36.);
+
+uniform float uRestDensity;
+
+layout(location = 0) out vec4 updatedData0;
+layout(location = 1) out vec4 updatedData1;
+layout(location = 2) out vec4 updatedData2;
+layout(location = 3) out vec4 updatedData3;
+
+void main(void) {
+  updatedData0 = vec4(0.);
+  updatedData1 = vec4(0., weights[0], weights[1], weights[2]) * uRestDensity;
+  updatedData2 = vec4(weights[3], weights[4], weights[5], weights[6]) * uRestDensity;
+  updatedData3 = vec4(weights[7], weights[8], 0., 0.) * uRestDensity;
+}
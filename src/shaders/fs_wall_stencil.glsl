@@ -0,0 +1,16 @@
+#version 330 core
+// Marks wall nodes in the stencil buffer, all other fragments are discarded
+
+precision mediump float;
+precision mediump sampler2D;
+
+uniform sampler2D uNodeIds;
+
+in vec2 UV;
+
+void main(void) {
+  int nodeId = int(texture(uNodeIds, UV).x + 0.5);
+  if (nodeId != 1) {
+    discard;
+  }
+}
@@ -0,0 +1,16 @@
+#version 330 core
+// Emits one quad per lattice tile, inactive tiles collapse to a degenerate quad and produce no fragments
+
+in vec2 aPosition;
+out vec2 UV;
+
+uniform sampler2D uActiveTiles;
+uniform ivec2 uTileCount;
+uniform vec2 uTileUVSize;
+
+void main(void) {
+  ivec2 tile = ivec2(gl_InstanceID % uTileCount.x, gl_InstanceID / uTileCount.x);
+  bool isActive = texelFetch(uActiveTiles, tile, 0).x > 0.5;
+  UV = (vec2(tile) + aPosition) * uTileUVSize;
+  gl_Position = isActive ? vec4(UV * 2. - 1., 0.0, 1.0) : vec4(0.0, 0.0, 0.0, 1.0);
+}
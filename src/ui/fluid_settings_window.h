@@ -1,17 +1,34 @@
 #ifndef FLUID_SETTINGS_WINDOW_H
 #define FLUID_SETTINGS_WINDOW_H
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <memory>
+#include <array>
+#include <cstring>
+#include <string>
 
 #include "imgui.h"
+#include "imgui_toggle.h"
 
 #include "core/app_state.h"
+#include "core/input_trace.h"
 #include "ui/window.h"
+#include "lbm/auto_checkpoint.h"
+#include "lbm/checkpoint.h"
+#include "lbm/field_publisher.h"
+#include "lbm/field_writer.h"
+#include "lbm/geometry.h"
 #include "lbm/lbm.h"
 
 class FluidSettingsWindow : public Window {
 public:
-  FluidSettingsWindow(std::shared_ptr<LBM> lbm) : lbm(lbm) {}
+  FluidSettingsWindow(std::shared_ptr<LBM> lbm, std::shared_ptr<AutoCheckpoint> autoCheckpoint,
+                      std::shared_ptr<FieldWriter> fieldWriter, std::shared_ptr<FieldPublisher> fieldPublisher)
+    : lbm(lbm), autoCheckpoint(autoCheckpoint), fieldWriter(fieldWriter), fieldPublisher(fieldPublisher) {
+    std::strncpy(geometryPath.data(), GEOMETRY_FILE_NAME, geometryPath.size() - 1);
+  }
 
   void render() override {
     AppState& appState = AppState::getInstance();
@@ -54,21 +71,231 @@ public:
     ImGui::Separator();
     ImGui::Spacing();
 
+    // Procedural scenes, loaded with their boundary walls, driving force and initial solutes
+    ImGui::Text("Scene");
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+    if (ImGui::BeginCombo("##scene", SCENE_LABELS[static_cast<int>(appState.scene)])) {
+      for (int i = 0; i < IM_ARRAYSIZE(SCENE_LABELS); i++) {
+        if (ImGui::Selectable(SCENE_LABELS[i], static_cast<int>(appState.scene) == i)) {
+          appState.scene = static_cast<SceneType>(i);
+        }
+      }
+      ImGui::EndCombo();
+    }
+    if (appState.scene != SceneType::Blobs) {
+      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+      ImGui::SliderFloat("##sceneFeatureSize", &appState.sceneFeatureSize, 0.02f, 0.5f, "Feature size %.2f", ImGuiSliderFlags_AlwaysClamp);
+      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+      ImGui::SliderFloat("##sceneFlowSpeed", &appState.sceneFlowSpeed, 0.f, 0.15f, "Flow speed %.3f", ImGuiSliderFlags_AlwaysClamp);
+    }
+    if (appState.scene == SceneType::PorousPacking) {
+      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+      ImGui::SliderFloat("##scenePorosity", &appState.scenePorosity, 0.3f, 0.95f, "Porosity %.2f", ImGuiSliderFlags_AlwaysClamp);
+    }
+    if (appState.scene == SceneType::PorousPacking || appState.scene == SceneType::ChannelNetwork) {
+      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+      ImGui::InputScalar("##sceneSeed", ImGuiDataType_U32, &appState.sceneSeed);
+    }
+    if (ImGui::Button("Load Scene")) {
+      loadScene(*lbm);
+      InputTrace::getInstance().recordEvent(TraceEvent::LoadScene, static_cast<uint8_t>(appState.scene));
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Walls from a PNG or PGM mask or a raw bitmap, resampled to the lattice while the flow goes on
+    ImGui::Text("Geometry");
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+    ImGui::InputText("##geometryPath", geometryPath.data(), geometryPath.size());
+    ImGui::Checkbox("Invert", &geometryOptions.isInverted);
+    ImGui::SameLine();
+    if (ImGui::Button("Import Walls")) {
+      std::string error;
+      if (loadGeometry(*lbm, geometryPath.data(), geometryOptions, error)) {
+        InputTrace::getInstance().recordLoadGeometry(geometryPath.data(), geometryOptions);
+        geometryStatus = std::string("Imported ") + geometryPath.data();
+      } else {
+        geometryStatus = error;
+      }
+    }
+    if (!geometryStatus.empty()) {
+      ImGui::TextWrapped("%s", geometryStatus.c_str());
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
     // Reset section
     ImGui::Text("Reset");
     if (ImGui::Button("Reset Fluid")) {
       lbm->resetFluid();
+      InputTrace::getInstance().recordEvent(TraceEvent::ResetFluid);
     }
     ImGui::SameLine();
     if (ImGui::Button("Clear Walls")) {
       lbm->resetNodeIDs();
+      InputTrace::getInstance().recordEvent(TraceEvent::ResetNodeIDs);
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Checkpoint of the complete simulation state
+    ImGui::Text("Checkpoint");
+    if (ImGui::Button("Save")) {
+      std::string error;
+      auto start = std::chrono::steady_clock::now();
+      bool isSaved = isCheckpointCompact ? Checkpoint::saveCompact(*lbm, CHECKPOINT_FILE_NAME, checkpointErrorBound, error)
+                                         : Checkpoint::save(*lbm, CHECKPOINT_FILE_NAME, error);
+      checkpointStatus = isSaved ? formatStatus("Saved", start) : error;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+      std::string error;
+      auto start = std::chrono::steady_clock::now();
+      checkpointStatus = Checkpoint::load(*lbm, CHECKPOINT_FILE_NAME, error) ? formatStatus("Loaded", start) : error;
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Compact", &isCheckpointCompact);
+    if (isCheckpointCompact) {
+      ImGui::InputFloat("Error bound", &checkpointErrorBound, 0.f, 0.f, "%.1e");
+      checkpointErrorBound = std::max(checkpointErrorBound, 1e-9f);
+    }
+    if (!checkpointStatus.empty()) {
+      ImGui::TextWrapped("%s", checkpointStatus.c_str());
+    }
+
+    // Periodic tiled checkpoints written in the background, deltas hold the tiles that changed since their last one
+    ImGui::Checkbox("Auto-checkpoint", &appState.isAutoCheckpointEnabled);
+    if (appState.isAutoCheckpointEnabled) {
+      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+      ImGui::InputScalar("##autoCheckpointInterval", ImGuiDataType_U32, &appState.autoCheckpointInterval, nullptr, nullptr, "Every %u steps");
+      appState.autoCheckpointInterval = std::max(appState.autoCheckpointInterval, 1u);
+      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+      ImGui::InputScalar("##autoCheckpointKeyframeInterval", ImGuiDataType_U32, &appState.autoCheckpointKeyframeInterval, nullptr, nullptr,
+                         "Keyframe every %u");
+      appState.autoCheckpointKeyframeInterval = std::max(appState.autoCheckpointKeyframeInterval, 1u);
+      ImGui::InputFloat("Change threshold", &appState.autoCheckpointThreshold, 0.f, 0.f, "%.1e");
+      appState.autoCheckpointThreshold = std::max(appState.autoCheckpointThreshold, 0.f);
+    }
+    AutoCheckpoint::Status status = autoCheckpoint->getStatus();
+    if (status.hasCheckpoint) {
+      ImGui::TextWrapped("%s %llu at step %llu: %zu of %zu tiles, %.1f MB in %.0f ms, %llu unchanged", status.isKeyframe ? "Keyframe" : "Delta",
+                         static_cast<unsigned long long>(status.sequence), static_cast<unsigned long long>(status.stepCount), status.tileCount,
+                         status.totalTileCount, status.bytes / (1024. * 1024.), status.writeTime,
+                         static_cast<unsigned long long>(status.unchangedCount));
+    }
+    if (!status.error.empty()) {
+      ImGui::TextWrapped("%s", status.error.c_str());
+    }
+    if (ImGui::Button("Restore Latest")) {
+      std::string error;
+      auto start = std::chrono::steady_clock::now();
+      checkpointStatus = autoCheckpoint->restoreLatest(error) ? formatStatus("Restored", start) : error;
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Field snapshots for post-processing and live analysis, the parameters are fixed while recording or publishing
+    bool isRecordingFields = fieldWriter->isRecording();
+    bool isPublishingFields = fieldPublisher->isPublishing();
+    ImGui::Text("Record Fields");
+    if (ImGui::Toggle("##recordFields", &isRecordingFields)) {
+      std::string error;
+      if (!isRecordingFields) {
+        fieldWriter->stop();
+        fieldStatus.clear();
+      } else if (!fieldWriter->start(FIELD_OUTPUT_FILE_NAME, error)) {
+        fieldStatus = error;
+      } else {
+        fieldStatus = std::string("Recording to ") + FIELD_OUTPUT_FILE_NAME;
+      }
+    }
+    ImGui::Text("Publish Fields");
+    if (ImGui::Toggle("##publishFields", &isPublishingFields)) {
+      std::string error;
+      if (!isPublishingFields) {
+        fieldPublisher->stop();
+        publishStatus.clear();
+      } else if (!fieldPublisher->start(SHARED_FIELDS_NAME, error)) {
+        publishStatus = error;
+      } else {
+        publishStatus = std::string("Publishing to ") + SHARED_FIELDS_NAME;
+      }
+    }
+    ImGui::BeginDisabled(isRecordingFields || isPublishingFields);
+    for (unsigned int i = 0; i < FieldSeries::FIELD_COUNT; i++) {
+      ImGui::CheckboxFlags(FieldSeries::getFieldName(static_cast<FieldType>(i)), &appState.fieldOutputMask, 1u << i);
+    }
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+    ImGui::InputScalar("##fieldOutputInterval", ImGuiDataType_U32, &appState.fieldOutputInterval, nullptr, nullptr, "Every %u steps");
+    appState.fieldOutputInterval = std::max(appState.fieldOutputInterval, 1u);
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+    ImGui::InputScalar("##fieldOutputStride", ImGuiDataType_U32, &appState.fieldOutputStride, nullptr, nullptr, "Every %u nodes");
+    appState.fieldOutputStride = std::max(appState.fieldOutputStride, 1u);
+    ImGui::InputInt4("Region", &appState.fieldOutputRegion.x);
+    ImGui::InputFloat("Error bound##fieldOutput", &appState.fieldOutputErrorBound, 0.f, 0.f, "%.1e");
+    appState.fieldOutputErrorBound = std::max(appState.fieldOutputErrorBound, 0.f);
+    ImGui::EndDisabled();
+    FieldWriter::Status fieldWriterStatus = fieldWriter->getStatus();
+    if (isRecordingFields || fieldWriterStatus.snapshotCount > 0) {
+      ImGui::Text("%llu snapshots to step %llu, %.1f MB, %llu dropped", static_cast<unsigned long long>(fieldWriterStatus.snapshotCount),
+                  static_cast<unsigned long long>(fieldWriterStatus.lastStep), fieldWriterStatus.bytes / (1024. * 1024.),
+                  static_cast<unsigned long long>(fieldWriterStatus.droppedCount));
+      if (appState.fieldOutputErrorBound > 0.f && fieldWriterStatus.bytes > 0) {
+        ImGui::Text("%.1fx smaller than raw fields", static_cast<double>(fieldWriterStatus.fieldBytes) / fieldWriterStatus.bytes);
+      }
+    }
+    if (!fieldWriterStatus.error.empty()) {
+      ImGui::TextWrapped("%s", fieldWriterStatus.error.c_str());
+    } else if (!fieldStatus.empty()) {
+      ImGui::TextWrapped("%s", fieldStatus.c_str());
+    }
+    FieldPublisher::Status fieldPublisherStatus = fieldPublisher->getStatus();
+    if (isPublishingFields || fieldPublisherStatus.snapshotCount > 0) {
+      ImGui::Text("%llu snapshots published to step %llu, %llu dropped", static_cast<unsigned long long>(fieldPublisherStatus.snapshotCount),
+                  static_cast<unsigned long long>(fieldPublisherStatus.lastStep),
+                  static_cast<unsigned long long>(fieldPublisherStatus.droppedCount));
+    }
+    if (!fieldPublisherStatus.error.empty()) {
+      ImGui::TextWrapped("%s", fieldPublisherStatus.error.c_str());
+    } else if (!publishStatus.empty()) {
+      ImGui::TextWrapped("%s", publishStatus.c_str());
     }
 
     ImGui::End(); // End of the fluid settings window
   }
 
 private:
+  static constexpr const char* SCENE_LABELS[] = {"Solute blobs", "Cylinder wake", "Shear-driven cavity", "Porous packing",
+                                                 "Channel network", "Mixing chamber"};
+
   std::shared_ptr<LBM> lbm;
+  std::shared_ptr<AutoCheckpoint> autoCheckpoint;
+  std::shared_ptr<FieldWriter> fieldWriter;
+  std::shared_ptr<FieldPublisher> fieldPublisher;
+  std::string checkpointStatus;
+  std::string fieldStatus;
+  std::string publishStatus;
+  std::string geometryStatus;
+  std::array<char, 512> geometryPath = {};
+  GeometryOptions geometryOptions;
+  bool isCheckpointCompact = false;
+  float checkpointErrorBound = Checkpoint::DEFAULT_ERROR_BOUND;
+
+  std::string formatStatus(const char* action, std::chrono::steady_clock::time_point start) const {
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    char status[128];
+    std::snprintf(status, sizeof(status), "%s step %llu in %.0f ms", action, static_cast<unsigned long long>(lbm->getStepCount()),
+                  milliseconds);
+    return status;
+  }
 };
 
 #endif // FLUID_SETTINGS_WINDOW_H
@@ -0,0 +1,124 @@
+#ifndef FRAME_PACING_WINDOW_H
+#define FRAME_PACING_WINDOW_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+#include "core/app_state.h"
+#include "core/frame_stats.h"
+#include "ui/window.h"
+
+class FramePacingWindow : public Window {
+public:
+  FramePacingWindow() = default;
+
+  void render() override {
+    FrameStats& frameStats = FrameStats::getInstance();
+    ImGui::Begin("Frame Pacing", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysVerticalScrollbar);
+
+    // Percentiles of each part of the frame over the recorded history
+    ImGui::Text("Frame Times (%u frames)", frameStats.getFrameCount());
+    if (ImGui::BeginTable("##percentiles", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH)) {
+      ImGui::TableSetupColumn("ms");
+      ImGui::TableSetupColumn("p50");
+      ImGui::TableSetupColumn("p95");
+      ImGui::TableSetupColumn("p99");
+      ImGui::TableSetupColumn("Max");
+      ImGui::TableHeadersRow();
+      renderPercentiles("Frame", frameStats.getPercentiles(FrameStats::Metric::FrameTime));
+      renderPercentiles("CPU", frameStats.getPercentiles(FrameStats::Metric::CPUTime));
+      renderPercentiles("GPU", frameStats.getPercentiles(FrameStats::Metric::GPUTime));
+      renderPercentiles("Swap wait", frameStats.getPercentiles(FrameStats::Metric::SwapWait));
+      ImGui::EndTable();
+    }
+
+    // Frame time histogram, ranging a little past the 99th percentile so that hitches stay visible
+    FrameStats::Percentiles frameTimes = frameStats.getPercentiles(FrameStats::Metric::FrameTime);
+    float maxTime = std::max(2.f * frameTimes.p50, 1.25f * frameTimes.p99);
+    std::vector<float> histogram = frameStats.getHistogram(HISTOGRAM_BIN_COUNT, maxTime);
+    std::string overlay = "0 - " + std::to_string(static_cast<int>(std::ceil(maxTime))) + " ms";
+    ImGui::PlotHistogram("##frameTimeHistogram", histogram.data(), static_cast<int>(histogram.size()), 0, overlay.c_str(), 0.f, FLT_MAX,
+                         ImVec2(ImGui::GetContentRegionAvail().x, 60.f));
+
+    // Spacing for aesthetics
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Most recent hitches first, with the part of the frame or GPU pass they are attributed to
+    const auto& hitches = frameStats.getHitches();
+    ImGui::Text("Hitches (> %.1fx median)", FrameStats::HITCH_FACTOR);
+    if (hitches.empty()) {
+      ImGui::TextDisabled("None recorded");
+    } else if (ImGui::BeginTable("##hitches", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH | ImGuiTableFlags_ScrollY,
+                                 ImVec2(0.f, 160.f))) {
+      ImGui::TableSetupScrollFreeze(0, 1);
+      ImGui::TableSetupColumn("Frame");
+      ImGui::TableSetupColumn("ms");
+      ImGui::TableSetupColumn("CPU");
+      ImGui::TableSetupColumn("GPU");
+      ImGui::TableSetupColumn("Swap");
+      ImGui::TableSetupColumn("Cause");
+      ImGui::TableHeadersRow();
+      for (auto it = hitches.rbegin(); it != hitches.rend(); ++it) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(it->frame.frameIndex));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", it->frame.frameTime);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", it->frame.cpuTime);
+        ImGui::TableNextColumn();
+        if (it->frame.gpuTime >= 0.f) {
+          ImGui::Text("%.1f", it->frame.gpuTime);
+        }
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", it->frame.swapWait);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(it->cause.c_str());
+      }
+      ImGui::EndTable();
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Per-frame records as CSV, for comparing machines
+    if (ImGui::Button("Export CSV")) {
+      std::string renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+      exportStatus = frameStats.exportCSV(FRAME_STATS_FILE_NAME, renderer) ? std::string("Frames written to ") + FRAME_STATS_FILE_NAME
+                                                                            : "Failed to write frames";
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+      frameStats.reset();
+    }
+    if (!exportStatus.empty()) {
+      ImGui::TextWrapped("%s", exportStatus.c_str());
+    }
+
+    ImGui::End(); // End of the frame pacing window
+  }
+
+private:
+  static constexpr unsigned int HISTOGRAM_BIN_COUNT = 40;
+
+  std::string exportStatus;
+
+  static void renderPercentiles(const char* label, const FrameStats::Percentiles& percentiles) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(label);
+    for (float value : {percentiles.p50, percentiles.p95, percentiles.p99, percentiles.max}) {
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", value);
+    }
+  }
+};
+
+#endif // FRAME_PACING_WINDOW_H
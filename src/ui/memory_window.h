@@ -0,0 +1,143 @@
+#ifndef MEMORY_WINDOW_H
+#define MEMORY_WINDOW_H
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+#include "core/app_state.h"
+#include "gl/memory_tracker.h"
+#include "lbm/lbm.h"
+#include "ui/window.h"
+
+class MemoryWindow : public Window {
+public:
+  MemoryWindow(std::shared_ptr<LBM> lbm) : lbm(lbm) {}
+
+  void render() override {
+    MemoryTracker& tracker = MemoryTracker::getInstance();
+    ImGui::Begin("Memory", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysVerticalScrollbar);
+
+    // The vendor queries walk the extension list, so only refresh them occasionally
+    if (framesSinceQuery++ % DEVICE_QUERY_INTERVAL == 0) {
+      deviceMemory = tracker.queryDeviceMemory();
+    }
+
+    // Totals per kind of allocation
+    ImGui::Text("Allocated");
+    if (ImGui::BeginTable("##memoryTotals", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH)) {
+      ImGui::TableSetupColumn("Kind");
+      ImGui::TableSetupColumn("MiB");
+      ImGui::TableSetupColumn("Peak MiB");
+      ImGui::TableHeadersRow();
+      for (MemoryKind kind : {MemoryKind::Texture, MemoryKind::Renderbuffer, MemoryKind::Buffer, MemoryKind::Host}) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(MemoryTracker::getKindName(kind));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", toMiB(tracker.getTotalBytes(kind)));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", toMiB(tracker.getPeakBytes(kind)));
+      }
+      ImGui::EndTable();
+    }
+
+    // Spacing for aesthetics
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Lattice footprint and the largest square lattice the device memory would hold at the same cost per node
+    size_t deviceBytes = tracker.getDeviceBytes();
+    glm::ivec2 latticeSize = lbm->getLatticeSize();
+    double bytesPerNode = static_cast<double>(deviceBytes) / (static_cast<double>(latticeSize.x) * latticeSize.y);
+    ImGui::Text("Lattice %d x %d", latticeSize.x, latticeSize.y);
+    ImGui::Text("%.1f MiB on the GPU, %.0f bytes per node", toMiB(deviceBytes), bytesPerNode);
+    size_t budget = deviceMemory.totalBytes > 0 ? deviceMemory.totalBytes : deviceMemory.availableBytes + deviceBytes;
+    if (deviceMemory.availableBytes > 0 || deviceMemory.totalBytes > 0) {
+      ImGui::Text("Device: %.0f MiB total, %.0f MiB free", toMiB(deviceMemory.totalBytes), toMiB(deviceMemory.availableBytes));
+      double maxSize = std::floor(std::sqrt(budget / bytesPerNode));
+      ImGui::Text("Largest square lattice: ~%.0f x %.0f", maxSize, maxSize);
+    } else {
+      ImGui::TextWrapped("The driver does not report its video memory.");
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Allocations grouped by owner
+    ImGui::Text("Allocations");
+    if (ImGui::BeginTable("##allocations", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH)) {
+      ImGui::TableSetupColumn("Owner / name");
+      ImGui::TableSetupColumn("Format");
+      ImGui::TableSetupColumn("Size");
+      ImGui::TableSetupColumn("MiB");
+      ImGui::TableHeadersRow();
+      std::vector<MemoryTracker::Allocation> allocations = tracker.getAllocations();
+      for (const auto& owner : tracker.getBytesByOwner()) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        bool isOpen = ImGui::TreeNodeEx(owner.first.c_str(), ImGuiTreeNodeFlags_SpanFullWidth);
+        ImGui::TableNextColumn();
+        ImGui::TableNextColumn();
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", toMiB(owner.second));
+        if (!isOpen) {
+          continue;
+        }
+        for (const auto& allocation : allocations) {
+          if (allocation.owner != owner.first) {
+            continue;
+          }
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(allocation.name.c_str());
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(allocation.format.c_str());
+          ImGui::TableNextColumn();
+          if (allocation.height > 0) {
+            ImGui::Text("%u x %u", allocation.width, allocation.height);
+          } else {
+            ImGui::Text("%u", allocation.width);
+          }
+          ImGui::TableNextColumn();
+          ImGui::Text("%.2f", toMiB(allocation.bytes));
+        }
+        ImGui::TreePop();
+      }
+      ImGui::EndTable();
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    if (ImGui::Button("Export JSON")) {
+      exportStatus = tracker.exportJSON(MEMORY_FILE_NAME) ? std::string("Memory report written to ") + MEMORY_FILE_NAME
+                                                           : "Failed to write memory report";
+    }
+    if (!exportStatus.empty()) {
+      ImGui::TextWrapped("%s", exportStatus.c_str());
+    }
+
+    ImGui::End(); // End of the memory window
+  }
+
+private:
+  static constexpr unsigned int DEVICE_QUERY_INTERVAL = 60; // Frames
+
+  std::shared_ptr<LBM> lbm;
+  MemoryTracker::DeviceMemory deviceMemory;
+  unsigned int framesSinceQuery = 0;
+  std::string exportStatus;
+
+  static float toMiB(size_t bytes) {
+    return static_cast<float>(bytes) / (1024.f * 1024.f);
+  }
+};
+
+#endif // MEMORY_WINDOW_H
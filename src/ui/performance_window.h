@@ -0,0 +1,212 @@
+#ifndef PERFORMANCE_WINDOW_H
+#define PERFORMANCE_WINDOW_H
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "imgui.h"
+#include "imgui_toggle.h"
+
+#include "core/app_state.h"
+#include "core/frame_capture.h"
+#include "core/input_trace.h"
+#include "core/tracer.h"
+#include "gl/gpu_profiler.h"
+#include "lbm/lbm.h"
+#include "ui/window.h"
+
+class PerformanceWindow : public Window {
+public:
+  PerformanceWindow(std::shared_ptr<LBM> lbm, std::shared_ptr<FrameCapture> frameCapture) : lbm(lbm), frameCapture(frameCapture) {
+    std::strncpy(captureCommand.data(), INIT_CAPTURE_COMMAND, captureCommand.size() - 1);
+  }
+
+  void render() override {
+    const GPUProfiler& profiler = GPUProfiler::getInstance();
+    ImGui::Begin("Performance", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysVerticalScrollbar);
+
+    // Frame time and its recent history
+    float frameTime = profiler.getAverageFrameTime();
+    ImGui::Text("Frame Time");
+    ImGui::Text("%.2f ms (%.0f FPS)", frameTime, frameTime > 0.f ? 1000.f / frameTime : 0.f);
+    const auto& frameTimeHistory = profiler.getFrameTimeHistory();
+    ImGui::PlotLines("##frameTime", frameTimeHistory.data(), static_cast<int>(frameTimeHistory.size()), profiler.getFrameTimeHistoryOffset(),
+                     nullptr, 0.f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 40.f));
+
+    // Spacing for aesthetics
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Lattice update throughput
+    ImGui::Text("Throughput");
+    ImGui::Text("%.1f MLUPS (wall clock)", profiler.getEffectiveMLUPS());
+    if (profiler.isSupported()) {
+      ImGui::Text("%.1f MLUPS (GPU simulation time)", profiler.getSimulationMLUPS());
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Per-pass GPU timings, averaged over the recent history, with the achieved bandwidth and
+    // arithmetic throughput derived from the analytical kernel costs
+    float peakBandwidth = profiler.getPeakBandwidth();
+    ImGui::Text("GPU Passes");
+    if (peakBandwidth > 0.f) {
+      ImGui::Text("Probed bandwidth: %.1f GB/s", peakBandwidth);
+    }
+    if (!profiler.isSupported()) {
+      ImGui::TextWrapped("GPU timer queries require OpenGL 3.3 or newer.");
+    } else if (ImGui::BeginTable("##passTimings", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH)) {
+      ImGui::TableSetupColumn("Pass");
+      ImGui::TableSetupColumn("Avg (ms)");
+      ImGui::TableSetupColumn("Max (ms)");
+      ImGui::TableSetupColumn("GB/s");
+      ImGui::TableSetupColumn("GFLOP/s");
+      ImGui::TableSetupColumn("% Peak");
+      ImGui::TableHeadersRow();
+      for (const auto& pass : profiler.getPassTimings()) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(pass.name.c_str());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", profiler.getAveragePassTime(pass));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", profiler.getMaxPassTime(pass));
+        if (profiler.hasPassCost(pass)) {
+          float bandwidth = profiler.getAchievedBandwidth(pass);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.1f", bandwidth);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.1f", profiler.getAchievedFlops(pass));
+          if (peakBandwidth > 0.f) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", 100.f * bandwidth / peakBandwidth);
+          }
+        }
+      }
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted("Total");
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", profiler.getAverageGPUFrameTime());
+      ImGui::EndTable();
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // CPU/GPU timeline recording, written out as Chrome trace JSON
+    Tracer& tracer = Tracer::getInstance();
+    bool isTracing = tracer.isEnabled();
+    ImGui::Text("Record Trace");
+    if (ImGui::Toggle("##recordTrace", &isTracing)) {
+      tracer.setEnabled(isTracing);
+    }
+    if (ImGui::Button("Export Trace")) {
+      traceStatus = tracer.exportTrace(TRACE_FILE_NAME) ? std::string("Trace written to ") + TRACE_FILE_NAME : "Failed to write trace";
+    }
+    if (!traceStatus.empty()) {
+      ImGui::TextWrapped("%s", traceStatus.c_str());
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Per-step input recording, replayed step for step for reproducible benchmarks
+    InputTrace& inputTrace = InputTrace::getInstance();
+    bool isRecordingInput = inputTrace.isRecording();
+    bool isReplayingInput = inputTrace.isReplaying();
+    ImGui::Text("Record Input");
+    if (ImGui::Toggle("##recordInput", &isRecordingInput)) {
+      if (isRecordingInput) {
+        inputStatus = inputTrace.startRecording(INPUT_TRACE_FILE_NAME, lbm->getLatticeSize())
+                        ? std::string("Recording to ") + INPUT_TRACE_FILE_NAME : "Failed to open input trace";
+      } else {
+        inputStatus = "Recorded " + std::to_string(inputTrace.getStepCount()) + " steps";
+        inputTrace.stop();
+      }
+    }
+    ImGui::Text("Replay Input");
+    if (ImGui::Toggle("##replayInput", &isReplayingInput)) {
+      if (!isReplayingInput) {
+        inputTrace.stop();
+        inputStatus.clear();
+      } else if (!inputTrace.startReplay(INPUT_TRACE_FILE_NAME, true)) {
+        inputStatus = "Failed to read input trace";
+      } else if (inputTrace.getLatticeSize() != lbm->getLatticeSize()) {
+        inputStatus = "Input trace was recorded on a different lattice";
+      } else {
+        inputStatus.clear();
+      }
+    }
+    if (inputTrace.isReplaying()) {
+      ImGui::Text("Step %llu / %llu", static_cast<unsigned long long>(inputTrace.getStepIndex()),
+                  static_cast<unsigned long long>(inputTrace.getStepCount()));
+    }
+    if (!inputStatus.empty()) {
+      ImGui::TextWrapped("%s", inputStatus.c_str());
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Output image capture for demos and experiment videos, the target is fixed while capturing
+    AppState& appState = AppState::getInstance();
+    bool isCapturing = frameCapture->isCapturing();
+    ImGui::Text("Record Frames");
+    if (ImGui::Toggle("##recordFrames", &isCapturing)) {
+      std::string error;
+      if (!isCapturing) {
+        frameCapture->stop();
+        captureStatus.clear();
+      } else if (!((captureTarget == 1) ? frameCapture->startPipe(captureCommand.data(), error)
+                                        : frameCapture->startImages(CAPTURE_DIRECTORY, error))) {
+        captureStatus = error;
+      } else {
+        captureStatus = (captureTarget == 1) ? std::string("Streaming to the encoder") : std::string("Capturing to ") + CAPTURE_DIRECTORY;
+      }
+    }
+    ImGui::BeginDisabled(isCapturing);
+    ImGui::RadioButton("PNG Sequence", &captureTarget, 0); ImGui::SameLine();
+    ImGui::RadioButton("Encoder Pipe", &captureTarget, 1);
+    if (captureTarget == 1) {
+      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+      ImGui::InputText("##captureCommand", captureCommand.data(), captureCommand.size());
+    }
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+    ImGui::InputScalar("##captureInterval", ImGuiDataType_U32, &appState.captureInterval, nullptr, nullptr, "Every %u frames");
+    appState.captureInterval = std::max(appState.captureInterval, 1u);
+    ImGui::EndDisabled();
+    FrameCapture::Status frameCaptureStatus = frameCapture->getStatus();
+    if (isCapturing || frameCaptureStatus.frameCount > 0) {
+      ImGui::Text("%llu frames, %llu dropped", static_cast<unsigned long long>(frameCaptureStatus.frameCount),
+                  static_cast<unsigned long long>(frameCaptureStatus.droppedCount));
+    }
+    if (!frameCaptureStatus.error.empty()) {
+      ImGui::TextWrapped("%s", frameCaptureStatus.error.c_str());
+    } else if (!captureStatus.empty()) {
+      ImGui::TextWrapped("%s", captureStatus.c_str());
+    }
+
+    ImGui::End(); // End of the performance window
+  }
+
+private:
+  std::shared_ptr<LBM> lbm;
+  std::shared_ptr<FrameCapture> frameCapture;
+  std::string traceStatus;
+  std::string inputStatus;
+  std::string captureStatus;
+  int captureTarget = 0; // 0: PNG sequence, 1: encoder pipe
+  std::array<char, 512> captureCommand = {};
+};
+
+#endif // PERFORMANCE_WINDOW_H
@@ -8,6 +8,7 @@
 #include "imgui_toggle.h"
 
 #include "core/app_state.h"
+#include "core/input_trace.h"
 #include "ui/window.h"
 #include "lbm/lbm.h"
 
@@ -55,6 +56,7 @@ public:
     ImGui::Text("Reset");
     if (ImGui::Button("Clear Solute")) {
       lbm->resetSolute(soluteID);
+      InputTrace::getInstance().recordEvent(TraceEvent::ResetSolute, static_cast<uint8_t>(soluteID));
     }
 
     ImGui::End(); // End of the solute settings window
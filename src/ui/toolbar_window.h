@@ -9,6 +9,7 @@
 #include "imgui_internal.h"
 
 #include "core/app_state.h"
+#include "core/input_trace.h"
 #include "core/io.h"
 #include "ui/window.h"
 #include "lbm/lbm.h"
@@ -97,6 +98,8 @@ public:
     if (ImGui::Button(resetButtonLabel)) {
       appState.reset();
       lbm->resetAll();
+      loadScene(*lbm);
+      InputTrace::getInstance().recordEvent(TraceEvent::ResetAll, static_cast<uint8_t>(appState.scene));
     }
 
     ImGui::End(); // End of the toolbar
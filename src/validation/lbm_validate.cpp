@@ -0,0 +1,581 @@
+// Headless physics validation suite for the LBM solver.
+// Runs canonical cases with analytic solutions on every solver backend available on this GPU,
+// compares error norms against tolerances and exits with a non-zero status if any case fails.
+// Cases that do not involve the GPU, such as the round trips of the field and population codecs and the parsing of run
+// configurations, run once as the cpu backend.
+// The lattices are small enough to run on a software rasteriser such as llvmpipe.
+//
+// Usage: lbm_validate [--backend fragment|compute|inplace|cpu|all] [--case NAME|all] [--list]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include "core/app_state.h"
+#include "core/headless.h"
+#include "core/run_config.h"
+#include "gl/gl_extensions.h"
+#include "lbm/checkpoint.h"
+#include "lbm/field_codec.h"
+#include "lbm/lbm.h"
+#include "lbm/population_codec.h"
+
+struct ValidationOptions {
+  std::string backend = "all";
+  std::string caseName = "all";
+  bool isListing = false;
+};
+
+struct ValidationCase {
+  const char* name;
+  const char* description;
+  const char* metric;         // What run returns, such as the relative L2 error against the analytic solution
+  double tolerance;           // Upper bound on the metric
+  double (*run)();
+  bool isSolverCase;          // Runs on every backend, other cases run once on the CPU
+};
+
+static const double PI = 3.14159265358979323846;
+static const double INFINITE_ERROR = std::numeric_limits<double>::infinity();
+
+static void runSteps(LBM& lbm, unsigned int steps) {
+  for (unsigned int i = 0; i < steps; i++) {
+    lbm.updateSimulation();
+  }
+}
+
+static double getRelativeL2Error(const std::vector<double>& numerical, const std::vector<double>& analytical) {
+  double errorNorm = 0.;
+  double norm = 0.;
+  for (size_t i = 0; i < numerical.size(); i++) {
+    errorNorm += (numerical[i] - analytical[i]) * (numerical[i] - analytical[i]);
+    norm += analytical[i] * analytical[i];
+  }
+  return norm > 0. ? std::sqrt(errorNorm / norm) : std::sqrt(errorNorm);
+}
+
+// Largest deviation of the decoded values in units of the error bound. Values that no bound applies to, NaN and
+// infinities, have to decode to themselves.
+static double getBoundedError(const std::vector<float>& decoded, const std::vector<float>& original, float errorBound) {
+  if (decoded.size() != original.size()) {
+    return INFINITE_ERROR;
+  }
+  double maxError = 0.;
+  for (size_t i = 0; i < original.size(); i++) {
+    if (std::isnan(original[i]) || std::isinf(original[i])) {
+      bool isSame = std::isnan(original[i]) ? std::isnan(decoded[i]) : decoded[i] == original[i];
+      maxError = isSame ? maxError : INFINITE_ERROR;
+    } else {
+      maxError = std::max(maxError, std::fabs(static_cast<double>(decoded[i]) - original[i]) / errorBound);
+    }
+  }
+  return maxError;
+}
+
+static double getPeriodicDistance(double a, double b, double period) {
+  double distance = std::fmod(std::fabs(a - b), period);
+  return std::min(distance, period - distance);
+}
+
+static double runPoiseuille() {
+  // Force-driven channel flow between the bottom boundary wall and its periodic image.
+  // Bounce-back places both walls half a node away from the outermost fluid rows.
+  const unsigned int width = 16;
+  const unsigned int height = 33;
+  const unsigned int steps = 4000;
+  const GLfloat viscosity = 0.2f;
+  const double maxVelocity = 0.02;
+  const double channelWidth = height - 1;
+  const double force = 8. * viscosity * maxVelocity / (channelWidth * channelWidth);
+
+  AppState& appState = AppState::getInstance();
+  appState.hasHorizontalWalls = true;
+  appState.fluidViscosity = viscosity;
+  LBM lbm(width, height);
+  lbm.setSolutesEnabled(false);
+  lbm.setBodyForce({force, 0.});
+  runSteps(lbm, steps);
+
+  // Compare the physical velocity, which includes half of the force impulse of the step
+  std::vector<glm::vec2> velocities = lbm.getFluidVelocity();
+  std::vector<GLfloat> densities = lbm.getFluidDensity();
+  std::vector<double> numerical, analytical;
+  for (unsigned int y = 1; y < height; y++) {
+    double wallDistance = y - 0.5;
+    for (unsigned int x = 0; x < width; x++) {
+      unsigned int node = y * width + x;
+      numerical.push_back(velocities[node].x + 0.5 * force / densities[node]);
+      analytical.push_back(force / (2. * viscosity) * wallDistance * (channelWidth - wallDistance));
+    }
+  }
+  return getRelativeL2Error(numerical, analytical);
+}
+
+static double runTaylorGreen() {
+  // Periodic vortex array whose velocity decays as exp(-2 nu k^2 t)
+  const unsigned int size = 64;
+  const unsigned int steps = 500;
+  const GLfloat viscosity = 0.05f;
+  const double initVelocity = 0.03;
+  const double waveNumber = 2. * PI / size;
+
+  AppState& appState = AppState::getInstance();
+  appState.fluidViscosity = viscosity;
+  LBM lbm(size, size);
+  lbm.setSolutesEnabled(false);
+
+  auto getVelocity = [&](unsigned int x, unsigned int y, double decay) {
+    double kx = waveNumber * (x + 0.5);
+    double ky = waveNumber * (y + 0.5);
+    return glm::dvec2(-initVelocity * decay * std::cos(kx) * std::sin(ky), initVelocity * decay * std::sin(kx) * std::cos(ky));
+  };
+  std::vector<glm::vec2> initVelocities;
+  for (unsigned int y = 0; y < size; y++) {
+    for (unsigned int x = 0; x < size; x++) {
+      initVelocities.push_back(getVelocity(x, y, 1.));
+    }
+  }
+  lbm.setFluidVelocity(initVelocities);
+  runSteps(lbm, steps);
+
+  double decay = std::exp(-2. * viscosity * waveNumber * waveNumber * steps);
+  std::vector<glm::vec2> velocities = lbm.getFluidVelocity();
+  std::vector<double> numerical, analytical;
+  for (unsigned int y = 0; y < size; y++) {
+    for (unsigned int x = 0; x < size; x++) {
+      glm::dvec2 velocity = getVelocity(x, y, decay);
+      numerical.push_back(velocities[y * size + x].x);
+      numerical.push_back(velocities[y * size + x].y);
+      analytical.push_back(velocity.x);
+      analytical.push_back(velocity.y);
+    }
+  }
+  return getRelativeL2Error(numerical, analytical);
+}
+
+static double runAdvectionDiffusion() {
+  // Gaussian pulse carried by a uniform flow, spreading as sigma^2 = sigma0^2 + 2 D t
+  const unsigned int size = 64;
+  const unsigned int steps = 400;
+  const GLfloat diffusivity = 0.05f;
+  const glm::dvec2 velocity = {0.04, 0.02};
+  const glm::dvec2 initCenter = {20., 24.};
+  const double initVariance = 16.;
+
+  AppState& appState = AppState::getInstance();
+  appState.soluteDiffusivities[0] = diffusivity;
+  LBM lbm(size, size);
+  lbm.setFluidVelocity(std::vector<glm::vec2>(size * size, velocity));
+
+  auto getConcentration = [&](unsigned int x, unsigned int y, double time) {
+    glm::dvec2 center = initCenter + velocity * time;
+    double dx = getPeriodicDistance(x, center.x, size);
+    double dy = getPeriodicDistance(y, center.y, size);
+    double variance = initVariance + 2. * diffusivity * time;
+    return initVariance / variance * std::exp(-(dx * dx + dy * dy) / (2. * variance));
+  };
+  std::vector<GLfloat> initConcentrations;
+  for (unsigned int y = 0; y < size; y++) {
+    for (unsigned int x = 0; x < size; x++) {
+      initConcentrations.push_back(getConcentration(x, y, 0.));
+    }
+  }
+  lbm.setSoluteConcentration(0, initConcentrations);
+  lbm.setSoluteConcentration(1, std::vector<GLfloat>(size * size, 0.f));
+  lbm.setSoluteConcentration(2, std::vector<GLfloat>(size * size, 0.f));
+  runSteps(lbm, steps);
+
+  std::vector<GLfloat> concentrations = lbm.getSoluteConcentration(0);
+  std::vector<double> numerical, analytical;
+  for (unsigned int y = 0; y < size; y++) {
+    for (unsigned int x = 0; x < size; x++) {
+      numerical.push_back(concentrations[y * size + x]);
+      analytical.push_back(getConcentration(x, y, steps));
+    }
+  }
+  return getRelativeL2Error(numerical, analytical);
+}
+
+static double runReactionDecay() {
+  // Well-mixed A + B -> C with equal initial concentrations: A = B = A0 / (1 + k A0 t), C = A0 - A.
+  // The source term enters the distributions scaled by (1 - 1 / (2 tau)) while the concentration is their
+  // plain sum, so the scheme reacts at that fraction of the nominal rate k.
+  const unsigned int size = 16;
+  const unsigned int steps = 200;
+  const GLfloat diffusivity = 0.1f;
+  const GLfloat reactionRate = 0.02f;
+  const double initConcentration = 1.;
+
+  AppState& appState = AppState::getInstance();
+  appState.isReactionEnabled = true;
+  appState.reactionRate = reactionRate;
+  appState.soluteDiffusivities = {diffusivity, diffusivity, diffusivity};
+  LBM lbm(size, size);
+  lbm.setSoluteConcentration(0, std::vector<GLfloat>(size * size, initConcentration));
+  lbm.setSoluteConcentration(1, std::vector<GLfloat>(size * size, initConcentration));
+  lbm.setSoluteConcentration(2, std::vector<GLfloat>(size * size, 0.f));
+  runSteps(lbm, steps);
+
+  double tau = 3. * diffusivity + 0.5;
+  double effectiveRate = reactionRate * (1. - 0.5 / tau);
+  double reactant = initConcentration / (1. + effectiveRate * initConcentration * steps);
+  std::vector<double> analytical = {reactant, reactant, initConcentration - reactant};
+  std::vector<double> numerical;
+  for (unsigned int i = 0; i < 3; i++) {
+    double mean = 0.;
+    for (GLfloat concentration : lbm.getSoluteConcentration(i)) {
+      mean += concentration;
+    }
+    numerical.push_back(mean / (size * size));
+  }
+  return getRelativeL2Error(numerical, analytical);
+}
+
+static double runFieldCodec() {
+  // Smooth fields with sharp fronts, spikes, huge and tiny magnitudes and non-finite values on a grid that is not a
+  // multiple of the tile size, encoded with a coarse and a fine error bound
+  const uint32_t width = 150;
+  const uint32_t height = 70;
+  const uint32_t componentCount = 3;
+  std::vector<float> values(width * height * componentCount);
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      float* node = &values[(y * width + x) * componentCount];
+      node[0] = 0.5f * std::sin(0.07f * x) * std::cos(0.05f * y);
+      node[1] = (x < width / 3 ? 1.f : 0.f) + ((x + y) % 17 == 0 ? 1e3f : 0.f);
+      node[2] = (x % 11 == 0) ? ((y % 2 == 0) ? 3e38f : -3e38f) : 1e-3f * y;
+    }
+  }
+  values[5] = std::numeric_limits<float>::quiet_NaN();
+  values[100] = std::numeric_limits<float>::infinity();
+  values[101] = -std::numeric_limits<float>::infinity();
+  values[200] = 1e30f;
+  values[201] = -std::numeric_limits<float>::max();
+  values[300] = std::numeric_limits<float>::denorm_min();
+  values[301] = -1e-40f;
+
+  double maxError = 0.;
+  for (float errorBound : {1e-2f, 1e-6f}) {
+    std::vector<uint8_t> data = FieldCodec::encode(values, width, height, componentCount, errorBound);
+    std::vector<float> decoded;
+    if (!FieldCodec::decode(data.data(), data.size(), width, height, componentCount, decoded)) {
+      return INFINITE_ERROR;
+    }
+    maxError = std::max(maxError, getBoundedError(decoded, values, errorBound));
+  }
+  return maxError;
+}
+
+static double runPopulationCodec() {
+  // Populations around the lattice weights with non-equilibrium noise, a block at rest and outliers, over a node count
+  // that is not a multiple of the block size, plus lossless planes that mix uniform and noisy blocks
+  const size_t nodeCount = 1000;
+  const float errorBound = Checkpoint::DEFAULT_ERROR_BOUND;
+  const float WEIGHTS[9] = {4.f / 9.f, 1.f / 9.f, 1.f / 9.f, 1.f / 9.f, 1.f / 9.f, 1.f / 36.f, 1.f / 36.f, 1.f / 36.f, 1.f / 36.f};
+  std::vector<float> populations(9 * nodeCount);
+  for (size_t q = 0; q < 9; q++) {
+    for (size_t n = 0; n < nodeCount; n++) {
+      bool isAtRest = n < PopulationCodec::BLOCK_SIZE;
+      populations[q * nodeCount + n] = WEIGHTS[q] * (isAtRest ? 1.f : 1.f + 0.05f * std::sin(0.1f * n + q));
+    }
+  }
+  populations[3 * nodeCount + 700] = 1e20f;
+  populations[5 * nodeCount + 900] = std::numeric_limits<float>::quiet_NaN();
+  populations[8 * nodeCount + 999] = -std::numeric_limits<float>::infinity();
+
+  std::vector<uint8_t> data = PopulationCodec::encodePopulations(populations, nodeCount, errorBound);
+  std::vector<float> decoded;
+  if (!PopulationCodec::decodePopulations(data.data(), data.size(), nodeCount, decoded)) {
+    return INFINITE_ERROR;
+  }
+  double maxError = getBoundedError(decoded, populations, errorBound);
+
+  std::vector<float> plane(nodeCount, 0.25f);
+  for (size_t n = PopulationCodec::BLOCK_SIZE; n < nodeCount; n++) {
+    plane[n] = std::cos(0.37f * n) * 1e-3f * n;
+  }
+  plane[nodeCount - 1] = std::numeric_limits<float>::quiet_NaN();
+  data = PopulationCodec::encodePlane(plane);
+  if (!PopulationCodec::decodePlane(data.data(), data.size(), nodeCount, decoded) || decoded.size() != nodeCount ||
+      std::memcmp(decoded.data(), plane.data(), nodeCount * sizeof(float)) != 0) {
+    return INFINITE_ERROR;
+  }
+  return maxError;
+}
+
+// Largest absolute difference between the velocity, density and concentration fields of two lattices
+static double getStateDifference(LBM& lbm, LBM& reference) {
+  double difference = 0.;
+  auto compare = [&](const std::vector<GLfloat>& values, const std::vector<GLfloat>& referenceValues) {
+    for (size_t i = 0; i < values.size(); i++) {
+      difference = std::max(difference, std::fabs(static_cast<double>(values[i]) - referenceValues[i]));
+    }
+  };
+  std::vector<glm::vec2> velocities = lbm.getFluidVelocity();
+  std::vector<glm::vec2> referenceVelocities = reference.getFluidVelocity();
+  for (size_t i = 0; i < velocities.size(); i++) {
+    compare({velocities[i].x, velocities[i].y}, {referenceVelocities[i].x, referenceVelocities[i].y});
+  }
+  compare(lbm.getFluidDensity(), reference.getFluidDensity());
+  for (unsigned int i = 0; i < 3; i++) {
+    compare(lbm.getSoluteConcentration(i), reference.getSoluteConcentration(i));
+  }
+  return difference;
+}
+
+static double runRestart(bool isCompact) {
+  // A run saved part way through and restored into a new lattice has to continue like the uninterrupted run, up to the
+  // error bound of compact populations, which the result is given in units of
+  const unsigned int size = 48;
+  const unsigned int savedSteps = 30;
+  const unsigned int restartedSteps = 40;
+  const fs::path path = fs::temp_directory_path() / (isCompact ? "lbm_validate_compact.lbmc" : "lbm_validate.lbmc");
+
+  AppState& appState = AppState::getInstance();
+  appState.hasHorizontalWalls = true;
+  appState.fluidViscosity = 0.05f;
+  appState.isReactionEnabled = true;
+  appState.reactionRate = 0.02f;
+  LBM lbm(size, size);
+  lbm.setBodyForce({1e-5f, 0.f});
+  std::vector<glm::vec2> velocities;
+  std::vector<GLfloat> concentrations[3];
+  for (unsigned int y = 0; y < size; y++) {
+    for (unsigned int x = 0; x < size; x++) {
+      double kx = 2. * PI * x / size;
+      double ky = 2. * PI * y / size;
+      velocities.emplace_back(0.03 * std::sin(ky), 0.02 * std::sin(kx));
+      concentrations[0].push_back(std::exp(-((x - 16.) * (x - 16.) + (y - 20.) * (y - 20.)) / 20.));
+      concentrations[1].push_back(std::exp(-((x - 28.) * (x - 28.) + (y - 24.) * (y - 24.)) / 30.));
+      concentrations[2].push_back(0.f);
+    }
+  }
+  lbm.setFluidVelocity(velocities);
+  for (unsigned int i = 0; i < 3; i++) {
+    lbm.setSoluteConcentration(i, concentrations[i]);
+  }
+  runSteps(lbm, savedSteps);
+
+  std::string error;
+  bool isSaved = isCompact ? Checkpoint::saveCompact(lbm, path, Checkpoint::DEFAULT_ERROR_BOUND, error)
+                           : Checkpoint::save(lbm, path, error);
+  if (!isSaved) {
+    std::cerr << error << std::endl;
+    return INFINITE_ERROR;
+  }
+  runSteps(lbm, restartedSteps);
+
+  // Loading has to bring back the parameters as well
+  appState.reset();
+  LBM restored(size, size);
+  bool isLoaded = Checkpoint::load(restored, path, error);
+  std::error_code removeError;
+  fs::remove(path, removeError);
+  if (!isLoaded) {
+    std::cerr << error << std::endl;
+    return INFINITE_ERROR;
+  }
+  runSteps(restored, restartedSteps);
+  return getStateDifference(restored, lbm) / (isCompact ? Checkpoint::DEFAULT_ERROR_BOUND : 1.);
+}
+
+static double runCheckpoint() {
+  return runRestart(false);
+}
+
+static double runCompactCheckpoint() {
+  return runRestart(true);
+}
+
+static double runRunConfig() {
+  // A sample configuration file with flags overriding some of its settings, then arguments that have to be rejected.
+  // Returns the number of settings that came out wrong.
+  const fs::path path = fs::temp_directory_path() / "lbm_validate_config.json";
+  {
+    std::ofstream file(path);
+    file << R"({
+      "mode": "headless", "backend": "compute", "steps": 5000, "width": 320, "height": 160,
+      "scene": "porous", "porosity": 0.7, "seed": 42, "viscosity": 0.02, "diffusivities": [0.01, 0.02, 0.03],
+      "reaction": true, "reactionRate": 0.5, "stepsPerFrame": 8, "fieldOutput": "fields.lbmf", "fieldInterval": 25
+    })";
+  }
+
+  // The parameters become the defaults, which would leak into the cases that run after this one
+  AppState& appState = AppState::getInstance();
+  const glm::ivec2 latticeSize = appState.latticeSize;
+  const SimulationDefaults defaults = appState.defaults;
+  const SceneType scene = appState.scene;
+  const GLfloat scenePorosity = appState.scenePorosity;
+  const unsigned int sceneSeed = appState.sceneSeed;
+  const unsigned int fieldOutputInterval = appState.fieldOutputInterval;
+
+  auto parse = [&](std::vector<std::string> args, RunConfig& config, std::string& error) {
+    args.insert(args.begin(), "lbm");
+    std::vector<char*> argv;
+    for (std::string& arg : args) {
+      argv.push_back(arg.data());
+    }
+    return parseRunConfig(static_cast<int>(argv.size()), argv.data(), config, error);
+  };
+  unsigned int mismatchCount = 0;
+  auto expect = [&](bool isMatching, const char* setting) {
+    if (!isMatching) {
+      std::cerr << "run-config: unexpected " << setting << std::endl;
+      mismatchCount++;
+    }
+  };
+
+  RunConfig config;
+  std::string error;
+  bool isParsed = parse({path.string(), "--steps", "200", "--diffusivities", "0.04", "--capture-command", "ffmpeg -i - out.mp4"},
+                        config, error);
+  expect(isParsed, ("result of the sample configuration: " + error).c_str());
+  expect(config.isHeadless && config.backend == "compute", "mode or backend");
+  expect(config.steps == 200, "steps, the flag has to override the file");
+  expect(config.fieldOutputPath == "fields.lbmf" && config.captureCommand == "ffmpeg -i - out.mp4", "outputs");
+  expect(appState.latticeSize == glm::ivec2(320, 160), "lattice size");
+  expect(appState.scene == SceneType::PorousPacking && appState.scenePorosity == 0.7f && appState.sceneSeed == 42, "scene");
+  expect(appState.fieldOutputInterval == 25, "field interval");
+  expect(appState.fluidViscosity == 0.02f && appState.stepsPerFrame == 8, "viscosity or steps per frame");
+  expect(appState.isReactionEnabled && appState.reactionRate == 0.5f, "reaction");
+  expect(appState.soluteDiffusivities == std::vector<GLfloat>(3, 0.04f), "diffusivities, a scalar flag applies to all solutes");
+
+  const std::vector<std::vector<std::string>> invalidArgs = {
+    {"--viscosity", "-1"},
+    {"--diffusivities", "[0.01, 0.02]"},
+    {"--scene", "volcano"},
+    {"--unknown-setting", "1"},
+    {"--steps"},
+    {"--capture-directory", "frames", "--capture-command", "ffmpeg"},
+    {(fs::temp_directory_path() / "lbm_validate_missing.json").string()},
+  };
+  for (const std::vector<std::string>& args : invalidArgs) {
+    RunConfig invalidConfig;
+    error.clear();
+    bool isRejected = !parse(args, invalidConfig, error) && !error.empty();
+    expect(isRejected, ("acceptance of " + args[0]).c_str());
+  }
+
+  std::error_code removeError;
+  fs::remove(path, removeError);
+  appState.latticeSize = latticeSize;
+  appState.defaults = defaults;
+  appState.scene = scene;
+  appState.scenePorosity = scenePorosity;
+  appState.sceneSeed = sceneSeed;
+  appState.fieldOutputInterval = fieldOutputInterval;
+  appState.reset();
+  return mismatchCount;
+}
+
+static const ValidationCase CASES[] = {
+  {"poiseuille", "Force-driven channel flow with horizontal walls", "relative L2 error", 0.005, runPoiseuille, true},
+  {"taylor-green", "Periodic Taylor-Green vortex decay", "relative L2 error", 0.01, runTaylorGreen, true},
+  {"advection-diffusion", "Gaussian solute pulse in a uniform flow", "relative L2 error", 0.03, runAdvectionDiffusion, true},
+  {"reaction", "Well-mixed A + B -> C decay", "relative L2 error", 0.01, runReactionDecay, true},
+  {"checkpoint", "Restart from a checkpoint against an uninterrupted run", "max difference", 0., runCheckpoint, true},
+  // Every moment sums nine populations, each within the bound
+  {"compact-checkpoint", "Restart from a compact checkpoint against an uninterrupted run", "max difference / bound", 9.,
+   runCompactCheckpoint, true},
+  {"field-codec", "Field codec round trip of sharp, huge and non-finite values", "max error / bound", 1., runFieldCodec, false},
+  {"population-codec", "Population codec round trip with outliers and lossless planes", "max error / bound", 1.,
+   runPopulationCodec, false},
+  {"run-config", "Run configuration file with overriding flags and invalid arguments", "mismatches", 0., runRunConfig, false},
+};
+
+static bool parseOptions(int argc, char** argv, ValidationOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--backend" && hasValue) {
+      options.backend = argv[++i];
+    } else if (arg == "--case" && hasValue) {
+      options.caseName = argv[++i];
+    } else if (arg == "--list") {
+      options.isListing = true;
+    } else {
+      std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  ValidationOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    return 1;
+  }
+  if (options.isListing) {
+    for (const ValidationCase& validationCase : CASES) {
+      printf("%-20s %s\n", validationCase.name, validationCase.description);
+    }
+    return 0;
+  }
+
+  GLFWwindow* window = createHeadlessContext("lbm_validate");
+  if (window == nullptr) {
+    std::cerr << "Failed to create an OpenGL context" << std::endl;
+    return 1;
+  }
+  std::cerr << "GPU: " << glGetString(GL_RENDERER) << std::endl;
+  std::cerr << "Active OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+
+  AppState& appState = AppState::getInstance();
+  unsigned int caseCount = 0;
+  unsigned int failureCount = 0;
+  auto runCase = [&](const char* backendName, const ValidationCase& validationCase) {
+    double error = validationCase.run();
+    bool hasPassed = error <= validationCase.tolerance; // Also fails on NaN
+    printf("%-9s %-20s %s %.3e (tolerance %.1e)  %s\n", backendName, validationCase.name, validationCase.metric, error,
+           validationCase.tolerance, hasPassed ? "PASS" : "FAIL");
+    caseCount++;
+    failureCount += hasPassed ? 0 : 1;
+  };
+  for (SolverBackend backend : {SolverBackend::FragmentShader, SolverBackend::ComputeShader, SolverBackend::InPlaceComputeShader}) {
+    if (options.backend != "all" && options.backend != getBackendName(backend)) {
+      continue;
+    }
+    if (backend != SolverBackend::FragmentShader && !hasGLVersion(4, 3)) {
+      std::cerr << "Skipping " << getBackendName(backend) << " backend, it requires OpenGL 4.3" << std::endl;
+      continue;
+    }
+    for (const ValidationCase& validationCase : CASES) {
+      if (!validationCase.isSolverCase || (options.caseName != "all" && options.caseName != validationCase.name)) {
+        continue;
+      }
+      appState.reset();
+      appState.solverBackend = backend;
+      runCase(getBackendName(backend), validationCase);
+    }
+  }
+  if (options.backend == "all" || options.backend == "cpu") {
+    for (const ValidationCase& validationCase : CASES) {
+      if (validationCase.isSolverCase || (options.caseName != "all" && options.caseName != validationCase.name)) {
+        continue;
+      }
+      appState.reset();
+      runCase("cpu", validationCase);
+    }
+  }
+
+  if (caseCount == 0) {
+    std::cerr << "No validation case matches the requested backend and case" << std::endl;
+    failureCount++;
+  } else {
+    printf("%u of %u cases passed\n", caseCount - failureCount, caseCount);
+  }
+  destroyHeadlessContext(window);
+  return failureCount > 0 ? 1 : 0;
+}